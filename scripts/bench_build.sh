@@ -0,0 +1,55 @@
+#!/bin/bash
+
+# Compare the throughput of the legacy gfakluge parser with the chunked parallel
+# parser of odgi build, and check that both build the same graph.
+#
+# usage: bench_build.sh odgi input.gfa [threads]
+
+# path to the ODGI executable
+OG=$1
+# GFA to build from
+GFA=$2
+# number of threads for the parallel parser
+THREADS=${3:-$(nproc)}
+
+if [[ $# -lt 2 ]] ; then
+    echo "[bench_build] ERROR: Usage: bench_build.sh <odgi executable> <GFA> [threads]"
+    exit 1
+fi
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+SIZE=$(du -b "$GFA" | cut -f1)
+
+# time a build and print the elapsed seconds
+run_build() {
+    local start end
+    start=$(date +%s.%N)
+    "$OG" build -g "$GFA" -o "$1" -t "$2" "${@:3}" || exit 1
+    end=$(date +%s.%N)
+    echo "$end - $start" | bc -l
+}
+
+echo "[bench_build] INFO: Building $GFA ($SIZE bytes)."
+# run_build() exits only its own subshell on failure, so check its status here
+LEGACY=$(run_build "$TMP"/legacy.og 1 --legacy-parser) || exit 1
+PARALLEL_1=$(run_build "$TMP"/parallel_1.og 1) || exit 1
+PARALLEL_N=$(run_build "$TMP"/parallel_n.og "$THREADS") || exit 1
+
+printf "parser\tthreads\tseconds\tMB/s\n"
+for row in "legacy 1 $LEGACY" "parallel 1 $PARALLEL_1" "parallel $THREADS $PARALLEL_N"; do
+    set -- $row
+    printf "%s\t%s\t%.3f\t%.1f\n" "$1" "$2" "$3" "$(echo "$SIZE / 1000000 / $3" | bc -l)"
+done
+
+# both parsers must produce the same nodes, edges and paths
+for og in legacy parallel_1 parallel_n; do
+    "$OG" view -i "$TMP"/$og.og -g | grep -v '^H' | sort > "$TMP"/$og.gfa
+done
+if diff -q "$TMP"/legacy.gfa "$TMP"/parallel_1.gfa > /dev/null && diff -q "$TMP"/legacy.gfa "$TMP"/parallel_n.gfa > /dev/null; then
+    echo "[bench_build] SUCCESS: All parsers built the same graph."
+else
+    echo "[bench_build] FAILED: The parallel parser built a different graph than the legacy parser."
+    exit 1
+fi
@@ -0,0 +1,52 @@
+#!/bin/bash
+
+# Time the weakly connected components of odgi stats -W on 1, 2, 4, ... threads, and check
+# that all thread counts report the same components.
+#
+# usage: bench_components.sh odgi input.gfa [threads]
+
+# path to the ODGI executable
+OG=$1
+# GFA to analyze
+GFA=$2
+# largest number of threads to try
+THREADS=${3:-$(nproc)}
+
+if [[ $# -lt 2 ]] ; then
+    echo "[bench_components] ERROR: Usage: bench_components.sh <odgi executable> <GFA> [threads]"
+    exit 1
+fi
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+"$OG" build -g "$GFA" -o "$TMP"/graph.og -O -t "$THREADS" || exit 1
+
+# find the components with a number of threads, and print the elapsed seconds and the peak
+# resident memory in MB
+run() {
+    local start end
+    start=$(date +%s.%N)
+    /usr/bin/time -f %M -o "$TMP"/maxrss "$OG" stats -i "$TMP"/graph.og -W -t "$1" > "$TMP"/components."$1".tsv || exit 1
+    end=$(date +%s.%N)
+    printf "%.3f\t%.0f" "$(echo "$end - $start" | bc -l)" "$(echo "$(cat "$TMP"/maxrss) / 1024" | bc -l)"
+}
+
+# run() exits only its own subshell on failure, so check its status here
+printf "threads\tseconds\tmax_rss_mb\n"
+T=1
+while (( T < THREADS )); do
+    ROW=$(run "$T") || exit 1
+    printf "%s\t%s\n" "$T" "$ROW"
+    T=$(( T * 2 ))
+done
+ROW=$(run "$THREADS") || exit 1
+printf "%s\t%s\n" "$THREADS" "$ROW"
+
+for OUT in "$TMP"/components.*.tsv; do
+    if ! cmp -s "$TMP"/components.1.tsv "$OUT"; then
+        echo "[bench_components] FAILED: The components depend on the number of threads."
+        exit 1
+    fi
+done
+echo "[bench_components] SUCCESS: All thread counts report the same components."
@@ -0,0 +1,88 @@
+#!/bin/bash
+
+# Time odgi layout with the atomic and with the flat PG-SGD engine, and compare the stress
+# of their layouts: the mean squared relative error between the layout distance and the
+# path distance of step pairs sampled from the paths.
+#
+# usage: bench_layout.sh odgi input.gfa [threads]
+
+# path to the ODGI executable
+OG=$1
+# GFA to lay out
+GFA=$2
+# number of threads for the layouts
+THREADS=${3:-$(nproc)}
+
+if [[ $# -lt 2 ]] ; then
+    echo "[bench_layout] ERROR: Usage: bench_layout.sh <odgi executable> <GFA> [threads]"
+    exit 1
+fi
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+"$OG" build -g "$GFA" -o "$TMP"/graph.og -O -t "$THREADS" || exit 1
+"$OG" view -i "$TMP"/graph.og -g > "$TMP"/graph.gfa || exit 1
+"$OG" pathindex -i "$TMP"/graph.og -o "$TMP"/graph.xp -t "$THREADS" || exit 1
+
+# lay the graph out with an engine, and print the elapsed seconds
+run() {
+    local start end
+    start=$(date +%s.%N)
+    "$OG" layout -i "$TMP"/graph.og -X "$TMP"/graph.xp -T "$TMP"/"$1".tsv -t "$THREADS" -e "$1" || exit 1
+    end=$(date +%s.%N)
+    echo "$end - $start" | bc -l
+}
+
+# print the stress of a layout TSV over step pairs sampled from the paths of the GFA, taking
+# each step at the node end where it enters its node
+stress() {
+    awk -F'\t' '
+        BEGIN { srand(1) }
+        FNR == NR { if (FNR > 1) { x[$1] = $2; y[$1] = $3 }; next }
+        $1 == "S" { len[$2] = length($3) }
+        $1 == "P" {
+            n = split($3, steps, ",")
+            pos = 0
+            for (i = 1; i <= n; ++i) {
+                id = substr(steps[i], 1, length(steps[i]) - 1)
+                end[i] = 2 * (id - 1) + (substr(steps[i], length(steps[i])) == "-")
+                at[i] = pos
+                pos += len[id]
+            }
+            pairs = n < 1000 ? 10 * n : 10000
+            for (k = 0; n > 1 && k < pairs; ++k) {
+                i = 1 + int(rand() * n)
+                j = 1 + int(rand() * n)
+                d = at[i] - at[j]
+                if (d == 0) continue
+                if (d < 0) d = -d
+                dx = x[end[i]] - x[end[j]]
+                dy = y[end[i]] - y[end[j]]
+                e = (sqrt(dx * dx + dy * dy) - d) / d
+                sum += e * e
+                ++count
+            }
+        }
+        END { printf "%.6f", (count > 0 ? sum / count : 0) }
+    ' "$1" "$TMP"/graph.gfa
+}
+
+# run() exits only its own subshell on failure, so check its status here
+ATOMIC_SECONDS=$(run atomic) || exit 1
+FLAT_SECONDS=$(run flat) || exit 1
+ATOMIC_STRESS=$(stress "$TMP"/atomic.tsv)
+FLAT_STRESS=$(stress "$TMP"/flat.tsv)
+
+printf "engine\tthreads\tseconds\tstress\n"
+printf "atomic\t%s\t%.3f\t%s\n" "$THREADS" "$ATOMIC_SECONDS" "$ATOMIC_STRESS"
+printf "flat\t%s\t%.3f\t%s\n" "$THREADS" "$FLAT_SECONDS" "$FLAT_STRESS"
+printf "speedup\t%.2f\n" "$(echo "$ATOMIC_SECONDS / $FLAT_SECONDS" | bc -l)"
+
+# the flat engine must not lay the graph out much worse than the atomic one
+if (( $(echo "$FLAT_STRESS <= 1.1 * $ATOMIC_STRESS + 0.001" | bc -l) )); then
+    echo "[bench_layout] SUCCESS: The flat engine reaches the stress of the atomic engine."
+else
+    echo "[bench_layout] FAILED: The flat engine lays the graph out with a higher stress."
+    exit 1
+fi
@@ -0,0 +1,41 @@
+#!/bin/bash
+
+# Build odgi with the fixed-width and with the bit-packed node records, and run the node record
+# microbenchmarks (edge iteration, step lookup and path appends on a hub node) with each build.
+# odgi always writes its binary and libraries into bin/ and lib/ of the source tree, so both
+# builds run on a copy of the tree and the original is left untouched.
+#
+# usage: bench_node_records.sh odgi_source_dir [jobs]
+
+# path to the ODGI source tree
+SRC=$1
+# number of parallel build jobs
+JOBS=${2:-$(nproc)}
+
+if [[ $# -lt 1 ]] ; then
+    echo "[bench_node_records] ERROR: Usage: bench_node_records.sh <odgi source dir> [jobs]"
+    exit 1
+fi
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+mkdir "$TMP"/src
+tar -C "$SRC" --exclude=./bin --exclude=./lib --exclude=./build -cf - . | tar -C "$TMP"/src -xf - || exit 1
+
+# build odgi with FIXED_WIDTH_NODES set to ON or OFF and keep a copy of the binary
+build() {
+    local layout=$1 fixed=$2
+    cmake -S "$TMP"/src -B "$TMP"/build."$layout" -DFIXED_WIDTH_NODES="$fixed" > /dev/null || exit 1
+    cmake --build "$TMP"/build."$layout" -j "$JOBS" > /dev/null || exit 1
+    cp "$TMP"/src/bin/odgi "$TMP"/odgi."$layout" || exit 1
+}
+
+build fixed ON
+build packed OFF
+
+printf "layout\toperation\tseconds\n"
+for layout in packed fixed; do
+    "$TMP"/odgi."$layout" test "[node_records_bench]" > "$TMP"/bench."$layout" || exit 1
+    grep -P "^$layout\t" "$TMP"/bench."$layout"
+done
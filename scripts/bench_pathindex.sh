@@ -0,0 +1,50 @@
+#!/bin/bash
+
+# Time odgi pathindex with the disk-backed builder and with the in-memory builder on one
+# and on many threads, report their peak memory, and check that all of them write the
+# same index.
+#
+# usage: bench_pathindex.sh odgi input.gfa [threads]
+
+# path to the ODGI executable
+OG=$1
+# GFA to index
+GFA=$2
+# number of threads for the parallel run
+THREADS=${3:-$(nproc)}
+
+if [[ $# -lt 2 ]] ; then
+    echo "[bench_pathindex] ERROR: Usage: bench_pathindex.sh <odgi executable> <GFA> [threads]"
+    exit 1
+fi
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+"$OG" build -g "$GFA" -o "$TMP"/graph.og -O -t "$THREADS" || exit 1
+
+# run a command and print the elapsed seconds and the peak resident memory in MB
+run() {
+    local start end
+    start=$(date +%s.%N)
+    /usr/bin/time -f %M -o "$TMP"/maxrss "$@" || exit 1
+    end=$(date +%s.%N)
+    printf "%.3f\t%.0f" "$(echo "$end - $start" | bc -l)" "$(echo "$(cat "$TMP"/maxrss) / 1024" | bc -l)"
+}
+
+# run() exits only its own subshell on failure, so check its status here
+EXTERNAL=$(run "$OG" pathindex -i "$TMP"/graph.og -o "$TMP"/external.xp -t 1 -E) || exit 1
+IN_MEMORY_1=$(run "$OG" pathindex -i "$TMP"/graph.og -o "$TMP"/in_memory.1.xp -t 1) || exit 1
+IN_MEMORY_N=$(run "$OG" pathindex -i "$TMP"/graph.og -o "$TMP"/in_memory."$THREADS".xp -t "$THREADS") || exit 1
+
+printf "builder\tthreads\tseconds\tmax_rss_mb\n"
+printf "external\t1\t%s\n" "$EXTERNAL"
+printf "in-memory\t1\t%s\n" "$IN_MEMORY_1"
+printf "in-memory\t%s\t%s\n" "$THREADS" "$IN_MEMORY_N"
+
+if cmp -s "$TMP"/external.xp "$TMP"/in_memory.1.xp && cmp -s "$TMP"/external.xp "$TMP"/in_memory."$THREADS".xp; then
+    echo "[bench_pathindex] SUCCESS: All builders wrote the same index."
+else
+    echo "[bench_pathindex] FAILED: The builders wrote different indexes."
+    exit 1
+fi
@@ -0,0 +1,79 @@
+#!/bin/bash
+
+# Time odgi position on a large batch of GFF and BED records placed at random along
+# one path, single-threaded and multi-threaded, and check both give the same records.
+#
+# usage: bench_position.sh odgi input.gfa path_name [features] [threads]
+
+# path to the ODGI executable
+OG=$1
+# GFA holding the path
+GFA=$2
+# path to place the features on
+PATH_NAME=$3
+# number of features to lift
+FEATURES=${4:-1000000}
+# number of threads for the parallel run
+THREADS=${5:-$(nproc)}
+
+if [[ $# -lt 3 ]] ; then
+    echo "[bench_position] ERROR: Usage: bench_position.sh <odgi executable> <GFA> <path name> [features] [threads]"
+    exit 1
+fi
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+"$OG" build -g "$GFA" -o "$TMP"/graph.og -t "$THREADS" || exit 1
+
+# the length of the path, from the segment lengths of its steps
+LENGTH=$(awk -v path="$PATH_NAME" -F'\t' '
+    $1 == "S" { len[$2] = length($3) }
+    $1 == "P" && $2 == path { n = split($3, steps, ","); for (i = 1; i <= n; ++i) { sum += len[substr(steps[i], 1, length(steps[i]) - 1)] } }
+    END { print sum + 0 }' "$GFA")
+if [[ $LENGTH -lt 2 ]]; then
+    echo "[bench_position] ERROR: path $PATH_NAME not found or too short in $GFA"
+    exit 1
+fi
+
+# random features of up to 1kbp, the same for every run
+awk -v path="$PATH_NAME" -v len="$LENGTH" -v n="$FEATURES" -v gff="$TMP"/features.gff -v bed="$TMP"/features.bed 'BEGIN {
+    srand(42);
+    for (i = 0; i < n; ++i) {
+        start = int(rand() * (len - 1));
+        end = start + 1 + int(rand() * 1000);
+        if (end > len - 1) end = len - 1;
+        printf "%s\tbench\tgene\t%d\t%d\t.\t+\t.\tID=f%d\n", path, start + 1, end, i > gff;
+        printf "%s\t%d\t%d\tf%d\n", path, start, end, i > bed;
+    }
+}'
+
+# time a command writing to the given file and print the elapsed seconds
+run() {
+    local start end
+    start=$(date +%s.%N)
+    "${@:2}" > "$1" || exit 1
+    end=$(date +%s.%N)
+    echo "$end - $start" | bc -l
+}
+
+echo "[bench_position] INFO: Lifting $FEATURES features along $PATH_NAME ($LENGTH bp)."
+printf "input\tthreads\tseconds\tfeatures/s\n"
+for input in gff bed; do
+    for t in 1 "$THREADS"; do
+        if [[ $input == gff ]]; then
+            secs=$(run "$TMP"/out.$input.$t "$OG" position -i "$TMP"/graph.og -E "$TMP"/features.gff -t "$t") || exit 1
+        else
+            secs=$(run "$TMP"/out.$input.$t "$OG" position -i "$TMP"/graph.og -b "$TMP"/features.bed -r "$PATH_NAME" -t "$t") || exit 1
+        fi
+        printf "%s\t%s\t%.3f\t%.0f\n" "$input" "$t" "$secs" "$(echo "$FEATURES / $secs" | bc -l)"
+    done
+done
+
+# records are written in input order whatever the number of threads
+if diff -q "$TMP"/out.gff.1 "$TMP"/out.gff."$THREADS" > /dev/null && diff -q "$TMP"/out.bed.1 "$TMP"/out.bed."$THREADS" > /dev/null; then
+    echo "[bench_position] SUCCESS: Single- and multi-threaded runs gave the same records."
+else
+    echo "[bench_position] FAILED: Single- and multi-threaded runs gave different records."
+    exit 1
+fi
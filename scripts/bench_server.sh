@@ -0,0 +1,113 @@
+#!/bin/bash
+
+# Load-test odgi server on localhost: single GET lifts over keep-alive connections and
+# batched POST lifts, reporting throughput and latency percentiles, and check that the
+# batch endpoint agrees with the single one.
+#
+# usage: bench_server.sh odgi input.gfa path_name [requests] [batch] [clients] [threads] [port]
+
+# path to the ODGI executable
+OG=$1
+# GFA holding the path
+GFA=$2
+# path to query positions on
+PATH_NAME=$3
+# number of requests per test
+REQUESTS=${4:-20000}
+# number of positions per POST request
+BATCH=${5:-1000}
+# number of concurrent clients
+CLIENTS=${6:-8}
+# number of server worker threads
+THREADS=${7:-$(nproc)}
+# port to run the server under
+PORT=${8:-31337}
+
+if [[ $# -lt 3 ]] ; then
+    echo "[bench_server] ERROR: Usage: bench_server.sh <odgi executable> <GFA> <path name> [requests] [batch] [clients] [threads] [port]"
+    exit 1
+fi
+
+TMP=$(mktemp -d)
+URL=http://localhost:$PORT
+trap 'curl -s "$URL"/stop > /dev/null; rm -rf "$TMP"' EXIT
+
+"$OG" build -g "$GFA" -o "$TMP"/graph.og -O -t "$THREADS" || exit 1
+"$OG" pathindex -i "$TMP"/graph.og -o "$TMP"/graph.xp -t "$THREADS" || exit 1
+
+# the length of the path, from the segment lengths of its steps
+LENGTH=$(awk -v path="$PATH_NAME" -F'\t' '
+    $1 == "S" { len[$2] = length($3) }
+    $1 == "P" && $2 == path { n = split($3, steps, ","); for (i = 1; i <= n; ++i) { sum += len[substr(steps[i], 1, length(steps[i]) - 1)] } }
+    END { print sum + 0 }' "$GFA")
+if [[ $LENGTH -lt 1 ]]; then
+    echo "[bench_server] ERROR: path $PATH_NAME not found in $GFA"
+    exit 1
+fi
+
+"$OG" server -i "$TMP"/graph.xp -p "$PORT" -t "$THREADS" > "$TMP"/server.log 2>&1 &
+for i in $(seq 1 100); do
+    curl -s "$URL"/hi > /dev/null && break
+    sleep 0.1
+done
+if ! curl -s "$URL"/hi > /dev/null; then
+    echo "[bench_server] ERROR: server did not come up"
+    cat "$TMP"/server.log
+    exit 1
+fi
+
+# random 1-based positions along the path, the same for every run
+awk -v len="$LENGTH" -v n="$REQUESTS" -v b="$BATCH" -v path="$PATH_NAME" -v dir="$TMP" 'BEGIN {
+    srand(42);
+    for (i = 0; i < n; ++i) { print 1 + int(rand() * len) > dir "/positions" }
+    for (i = 0; i < b; ++i) { printf "%s\t%d\n", path, 1 + int(rand() * len) > dir "/batch.tsv" }
+}'
+
+# run the clients on the requests listed in the given url file, each client reusing its
+# connection, and print requests/s and latency percentiles in milliseconds
+load() {
+    local urls=$1
+    shift
+    split -n r/"$CLIENTS" "$urls" "$TMP"/client.
+    local start end
+    start=$(date +%s.%N)
+    for f in "$TMP"/client.*; do
+        sed 's|.*|url = "&"\noutput = /dev/null|' "$f" | curl -s -K - "$@" -w '%{time_total}\n' > "$f".times &
+    done
+    wait
+    end=$(date +%s.%N)
+    cat "$TMP"/client.*.times | sort -g > "$TMP"/times
+    rm -f "$TMP"/client.*
+    awk -v secs="$(echo "$end - $start" | bc -l)" '{ t[NR] = $1 } END {
+        printf "%.0f\t%.3f\t%.3f\t%.3f\n", NR / secs, t[int(NR * 0.5) + 1] * 1000, t[int(NR * 0.99) + 1] * 1000, t[NR] * 1000 }' "$TMP"/times
+}
+
+ENCODED=$(printf '%s' "$PATH_NAME" | sed 's/%/%25/g; s/#/%23/g; s/ /%20/g; s/?/%3F/g')
+
+echo "[bench_server] INFO: Querying $PATH_NAME ($LENGTH bp) with $CLIENTS clients against $THREADS worker threads."
+printf "test\trequests/s\tp50_ms\tp99_ms\tmax_ms\n"
+
+sed "s|^|$URL/$ENCODED/|" "$TMP"/positions > "$TMP"/get.urls
+printf "get\t%s\n" "$(load "$TMP"/get.urls)"
+
+sed "s|^|$URL/path_pos/|" "$TMP"/positions > "$TMP"/reverse.urls
+printf "get_reverse\t%s\n" "$(load "$TMP"/reverse.urls)"
+
+for i in $(seq 1 $(( (REQUESTS + BATCH - 1) / BATCH ))); do echo "$URL/pangenome_pos"; done > "$TMP"/post.urls
+printf "post_x%s\t%s\n" "$BATCH" "$(load "$TMP"/post.urls --data-binary @"$TMP"/batch.tsv)"
+
+# the server's own view of the load
+curl -s "$URL"/metrics | grep -E '^odgi_server_(request_seconds\{|index_bytes|resident_bytes)'
+
+# the batch endpoint answers like the single one
+curl -s --data-binary @"$TMP"/batch.tsv "$URL"/pangenome_pos > "$TMP"/batch.out
+head -n 100 "$TMP"/batch.tsv | cut -f 2 | while read -r pos; do
+    curl -s "$URL/$ENCODED/$pos"
+    echo
+done > "$TMP"/single.out
+if diff -q "$TMP"/single.out <(head -n 100 "$TMP"/batch.out) > /dev/null; then
+    echo "[bench_server] SUCCESS: Batch and single requests gave the same positions."
+else
+    echo "[bench_server] FAILED: Batch and single requests gave different positions."
+    exit 1
+fi
@@ -0,0 +1,81 @@
+#!/bin/bash
+
+# Time odgi viz with one and with many threads, in the default and in the compressed mode, on a
+# generated graph of 5000 paths through a chain of bubbles, and check that the PNGs are the same.
+#
+# usage: bench_viz.sh odgi [threads] [paths]
+
+# path to the ODGI executable
+OG=$1
+# number of threads for the parallel runs
+THREADS=${2:-$(nproc)}
+# number of paths in the generated graph
+PATHS=${3:-5000}
+
+if [[ $# -lt 1 ]] ; then
+    echo "[bench_viz] ERROR: Usage: bench_viz.sh <odgi executable> [threads] [paths]"
+    exit 1
+fi
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+# a chain of 2000 bubbles of 10 bp, each path taking a random side of every bubble
+awk -v paths="$PATHS" '
+    BEGIN {
+        srand(1)
+        bubbles = 2000
+        print "H\tVN:Z:1.0"
+        for (b = 0; b < bubbles; ++b) {
+            print "S\t" (3 * b + 1) "\tACGTACGTAC"
+            print "S\t" (3 * b + 2) "\tTTGCATGCAA"
+            print "S\t" (3 * b + 3) "\tGGCCAATTGG"
+            print "L\t" (3 * b + 1) "\t+\t" (3 * b + 2) "\t+\t0M"
+            print "L\t" (3 * b + 1) "\t+\t" (3 * b + 3) "\t+\t0M"
+            if (b + 1 < bubbles) {
+                print "L\t" (3 * b + 2) "\t+\t" (3 * b + 4) "\t+\t0M"
+                print "L\t" (3 * b + 3) "\t+\t" (3 * b + 4) "\t+\t0M"
+            }
+        }
+        for (p = 0; p < paths; ++p) {
+            steps = ""
+            for (b = 0; b < bubbles; ++b) {
+                steps = steps (b > 0 ? "," : "") (3 * b + 1) "+," (3 * b + 2 + int(rand() * 2)) "+"
+            }
+            print "P\tpath" p "\t" steps "\t*"
+        }
+    }' > "$TMP"/graph.gfa
+
+"$OG" build -g "$TMP"/graph.gfa -o "$TMP"/graph.og -O -t "$THREADS" || exit 1
+
+# render the graph with a number of threads and extra arguments, and print the elapsed seconds
+run() {
+    local threads=$1 png=$2 start end
+    shift 2
+    start=$(date +%s.%N)
+    "$OG" viz -i "$TMP"/graph.og -o "$TMP"/"$png" -x 1500 -y 5000 -t "$threads" "$@" || exit 1
+    end=$(date +%s.%N)
+    echo "$end - $start" | bc -l
+}
+
+# run() exits only its own subshell on failure, so check its status here
+DEFAULT_1=$(run 1 default.1.png) || exit 1
+DEFAULT_N=$(run "$THREADS" default.n.png) || exit 1
+COMPRESSED_1=$(run 1 compressed.1.png -O) || exit 1
+COMPRESSED_N=$(run "$THREADS" compressed.n.png -O) || exit 1
+
+printf "mode\tthreads\tseconds\n"
+printf "default\t1\t%.3f\n" "$DEFAULT_1"
+printf "default\t%s\t%.3f\n" "$THREADS" "$DEFAULT_N"
+printf "compressed\t1\t%.3f\n" "$COMPRESSED_1"
+printf "compressed\t%s\t%.3f\n" "$THREADS" "$COMPRESSED_N"
+printf "speedup\tdefault\t%.2f\n" "$(echo "$DEFAULT_1 / $DEFAULT_N" | bc -l)"
+printf "speedup\tcompressed\t%.2f\n" "$(echo "$COMPRESSED_1 / $COMPRESSED_N" | bc -l)"
+
+# the chunks of the PNG stream do not depend on the number of threads, so the files must match
+if cmp -s "$TMP"/default.1.png "$TMP"/default.n.png && cmp -s "$TMP"/compressed.1.png "$TMP"/compressed.n.png; then
+    echo "[bench_viz] SUCCESS: The parallel renderings are identical to the single-threaded ones."
+else
+    echo "[bench_viz] FAILED: The parallel renderings differ from the single-threaded ones."
+    exit 1
+fi
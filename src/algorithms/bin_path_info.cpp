@@ -1,4 +1,8 @@
 #include "bin_path_info.hpp"
+#include "ordered_output.hpp"
+
+#include <omp.h>
+#include <sstream>
 
 // #define  debug_bin_path_info
 
@@ -25,23 +29,23 @@ namespace odgi {
         void bin_path_info(const PathHandleGraph &graph,
                            const std::string &prefix_delimiter,
                            const std::function<void(const uint64_t &, const uint64_t &)> &handle_header,
-                           const std::function<void(const std::string &,
+                           const std::function<void(std::ostream &,
+                                                    const std::string &,
                                                     const std::vector<std::pair<uint64_t, uint64_t>> &,
-                                                    const std::map<uint64_t, algorithms::path_info_t> &)> &handle_path,
+                                                    const path_bins_t &)> &handle_path,
                            const std::function<void(const uint64_t &, const std::string &)> &handle_sequence,
+                           std::ostream &out,
                            uint64_t num_bins,
                            uint64_t bin_width,
                            bool drop_gap_links,
-                           bool progress) {
+                           bool progress,
+                           uint64_t num_threads) {
             // the graph must be compacted for this to work
             std::vector<uint64_t> position_map(graph.get_node_count() + 1);
             uint64_t len = 0;
-            std::string graph_seq;
             graph.for_each_handle([&](const handle_t &h) {
                 position_map[number_bool_packing::unpack_number(h)] = len;
-                uint64_t hl = graph.get_length(h);
-                graph_seq.append(graph.get_sequence(h));
-                len += hl;
+                len += graph.get_length(h);
             });
             if (!num_bins) {
                 num_bins = len / bin_width + (len % bin_width ? 1 : 0);
@@ -52,125 +56,185 @@ namespace odgi {
             position_map[position_map.size() - 1] = len;
             // write header
             handle_header(len, bin_width);
-            // collect bin sequences
-            for (uint64_t i = 0; i < num_bins; ++i) {
-                handle_sequence(i + 1, graph_seq.substr(i * bin_width, bin_width));
+            // hand over the bin sequences one by one
+            {
+                uint64_t bin_id = 0;
+                std::string bin_seq;
+                graph.for_each_handle([&](const handle_t &h) {
+                    const std::string seq = graph.get_sequence(h);
+                    uint64_t i = 0;
+                    while (i < seq.size()) {
+                        const uint64_t take = std::min(bin_width - bin_seq.size(), seq.size() - i);
+                        bin_seq.append(seq, i, take);
+                        i += take;
+                        if (bin_seq.size() == bin_width) {
+                            handle_sequence(++bin_id, bin_seq);
+                            bin_seq.clear();
+                        }
+                    }
+                });
+                if (!bin_seq.empty()) {
+                    handle_sequence(++bin_id, bin_seq);
+                }
             }
-            graph_seq.clear(); // clean up
-            std::unordered_map<path_handle_t, uint64_t> path_length;
+            std::vector<path_handle_t> paths;
+            paths.reserve(graph.get_path_count());
+            graph.for_each_path_handle([&](const path_handle_t &path) {
+                paths.push_back(path);
+            });
             uint64_t gap_links_removed = 0;
             uint64_t total_links = 0;
             std::unique_ptr<progress_meter::ProgressMeter> progress_meter;
             if (progress) {
                 progress_meter = std::make_unique<progress_meter::ProgressMeter>(
-                        graph.get_path_count(), "[odgi::bin] bin_path_info:");
+                        paths.size(), "[odgi::bin] bin_path_info:");
             }
-            graph.for_each_path_handle([&](const path_handle_t &path) {
-                std::vector<std::pair<uint64_t, uint64_t>> links;
-                std::map<uint64_t, path_info_t> bins;
-                // walk the path and aggregate
-                uint64_t path_pos = 0;
-                int64_t last_bin = 0; // flag meaning "null bin"
-                uint64_t last_pos_in_bin = 0;
-                uint64_t nucleotide_count = 0;
-                bool last_is_rev = false;
-                graph.for_each_step_in_path(path, [&](const step_handle_t &occ) {
-                    handle_t h = graph.get_handle_of_step(occ);
-                    bool is_rev = graph.get_is_reverse(h);
-                    uint64_t p = position_map[number_bool_packing::unpack_number(h)];
-                    uint64_t hl = graph.get_length(h);
-                    // detect bin crossings
-                    // make contects for the bases in the node
-                    for (uint64_t k = 0; k < hl; ++k) {
-                        int64_t curr_bin = (p + k) / bin_width + 1;
-                        uint64_t curr_pos_in_bin = (p + k) - (curr_bin * bin_width);
-                        if (curr_bin != last_bin && std::abs(curr_bin - last_bin) > 1 || last_bin == 0) {
-                            // bin cross!
-                            links.push_back(std::make_pair(last_bin, curr_bin));
-                        }
-                        ++bins[curr_bin].mean_depth;
-                        if (is_rev) {
-                            ++bins[curr_bin].mean_inv;
+            ordered_output_t output(out);
+#pragma omp parallel num_threads(num_threads) reduction(+:gap_links_removed,total_links)
+            {
+                // the bins of a path are counted in a table over the bins it spans, which the thread
+                // reuses and grows up to dense_limit slots, or in a map for paths spanning more bins
+                const uint64_t dense_limit = 1 << 16;
+                std::vector<path_info_t> table;
+                std::unordered_map<uint64_t, path_info_t> sparse;
+                // the bins the current path visits
+                std::vector<uint64_t> visited;
+#pragma omp for schedule(dynamic, 1)
+                for (uint64_t path_rank = 0; path_rank < paths.size(); ++path_rank) {
+                    const path_handle_t &path = paths[path_rank];
+                    // the bins are numbered from 1
+                    uint64_t min_bin = std::numeric_limits<uint64_t>::max();
+                    uint64_t max_bin = 0;
+                    graph.for_each_step_in_path(path, [&](const step_handle_t &occ) {
+                        handle_t h = graph.get_handle_of_step(occ);
+                        uint64_t p = position_map[number_bool_packing::unpack_number(h)];
+                        uint64_t hl = graph.get_length(h);
+                        if (hl) {
+                            min_bin = std::min(min_bin, p / bin_width + 1);
+                            max_bin = std::max(max_bin, (p + hl - 1) / bin_width + 1);
                         }
-                        bins[curr_bin].mean_pos += path_pos++;
-                        nucleotide_count += 1;
-                        if ((bins[curr_bin].ranges.size() == 0) ||
-                            ((nucleotide_count - bins[curr_bin].ranges.back().second) > 1 &&
-                             (nucleotide_count - bins[curr_bin].ranges.back().first) > 1) ||
-                            (is_rev != last_is_rev)) {
-                            std::pair<uint64_t, uint64_t> p = std::make_pair(0, 0);
+                    });
+                    const bool dense = min_bin <= max_bin && max_bin - min_bin < dense_limit;
+                    if (dense && table.size() < max_bin - min_bin + 1) {
+                        table.resize(max_bin - min_bin + 1, path_info_t{0, 0, 0, {}});
+                    }
+                    auto slot = [&](const uint64_t &bin_id) -> path_info_t & {
+                        return dense ? table[bin_id - min_bin] : sparse[bin_id];
+                    };
+                    std::vector<std::pair<uint64_t, uint64_t>> links;
+                    // walk the path and aggregate
+                    uint64_t path_pos = 0;
+                    int64_t last_bin = 0; // flag meaning "null bin"
+                    uint64_t last_pos_in_bin = 0;
+                    uint64_t nucleotide_count = 0;
+                    bool last_is_rev = false;
+                    graph.for_each_step_in_path(path, [&](const step_handle_t &occ) {
+                        handle_t h = graph.get_handle_of_step(occ);
+                        bool is_rev = graph.get_is_reverse(h);
+                        uint64_t p = position_map[number_bool_packing::unpack_number(h)];
+                        uint64_t hl = graph.get_length(h);
+                        // detect bin crossings
+                        // make contects for the bases in the node
+                        for (uint64_t k = 0; k < hl; ++k) {
+                            int64_t curr_bin = (p + k) / bin_width + 1;
+                            uint64_t curr_pos_in_bin = (p + k) - (curr_bin * bin_width);
+                            if (curr_bin != last_bin && std::abs(curr_bin - last_bin) > 1 || last_bin == 0) {
+                                // bin cross!
+                                links.push_back(std::make_pair(last_bin, curr_bin));
+                            }
+                            path_info_t &bin = slot(curr_bin);
+                            if (bin.mean_depth == 0) {
+                                visited.push_back(curr_bin);
+                            }
+                            ++bin.mean_depth;
                             if (is_rev) {
-                                std::get<0>(p) = nucleotide_count;
-                            } else {
-                                std::get<1>(p) = nucleotide_count;
+                                ++bin.mean_inv;
                             }
-                            bins[curr_bin].ranges.push_back(p);
+                            bin.mean_pos += path_pos++;
+                            nucleotide_count += 1;
+                            if ((bin.ranges.size() == 0) ||
+                                ((nucleotide_count - bin.ranges.back().second) > 1 &&
+                                 (nucleotide_count - bin.ranges.back().first) > 1) ||
+                                (is_rev != last_is_rev)) {
+                                std::pair<uint64_t, uint64_t> p = std::make_pair(0, 0);
+                                if (is_rev) {
+                                    std::get<0>(p) = nucleotide_count;
+                                } else {
+                                    std::get<1>(p) = nucleotide_count;
+                                }
+                                bin.ranges.push_back(p);
 #ifdef debug_bin_path_info
-                            std::cerr << "PUSHED PAIR: " << "<" << std::get<0>(p) << "," << std::get<1>(p) << ">"
-                                      << std::endl;
+                                std::cerr << "PUSHED PAIR: " << "<" << std::get<0>(p) << "," << std::get<1>(p) << ">"
+                                          << std::endl;
 #endif
-                        } else {
-                            std::pair<uint64_t, uint64_t> &p = bins[curr_bin].ranges.back();
-                            if (is_rev) {
-                                updatePair<0, 1>(p, nucleotide_count);
-                            }
-                            else {
-                                updatePair<1, 0>(p, nucleotide_count);
+                            } else {
+                                std::pair<uint64_t, uint64_t> &p = bin.ranges.back();
+                                if (is_rev) {
+                                    updatePair<0, 1>(p, nucleotide_count);
+                                }
+                                else {
+                                    updatePair<1, 0>(p, nucleotide_count);
+                                }
                             }
+                            last_bin = curr_bin;
+                            last_is_rev = is_rev;
+                            last_pos_in_bin = curr_pos_in_bin;
                         }
-                        last_bin = curr_bin;
-                        last_is_rev = is_rev;
-                        last_pos_in_bin = curr_pos_in_bin;
+                    });
+                    links.push_back(std::make_pair(last_bin, 0));
+                    uint64_t path_length = path_pos;
+                    // move the visited bins out of the table, leaving their slots empty for the next path
+                    std::sort(visited.begin(), visited.end());
+                    path_bins_t bins;
+                    bins.reserve(visited.size());
+                    for (auto &bin_id : visited) {
+                        auto &v = slot(bin_id);
+                        v.mean_inv /= (v.mean_depth ? v.mean_depth : 1);
+                        v.mean_depth /= bin_width;
+                        v.mean_pos /= bin_width * path_length * v.mean_depth;
+                        bins.emplace_back(bin_id, std::move(v));
+                        v = path_info_t{0, 0, 0, {}};
                     }
-                });
-                links.push_back(std::make_pair(last_bin, 0));
-                uint64_t path_length = path_pos;
-                uint64_t end_nucleotide = nucleotide_count;
-                for (auto &entry : bins) {
-                    auto &v = entry.second;
-                    v.mean_inv /= (v.mean_depth ? v.mean_depth : 1);
-                    v.mean_depth /= bin_width;
-                    v.mean_pos /= bin_width * path_length * v.mean_depth;
-                }
+                    sparse.clear();
 
-                if (drop_gap_links) {
-                    std::vector<uint64_t> bin_ids;
-                    for (const auto &entry: bins) {
-                        bin_ids.push_back(entry.first);
-                    }
-                    std::sort(bin_ids.begin(), bin_ids.end());
-                    total_links += links.size();
+                    if (drop_gap_links) {
+                        total_links += links.size();
 
-                    uint64_t fill_pos = 0;
+                        uint64_t fill_pos = 0;
 
-                    for (uint64_t i = 0; i < links.size(); ++i) {
-                        auto link = links[i];
+                        for (uint64_t i = 0; i < links.size(); ++i) {
+                            auto link = links[i];
 
-                        if (link.first == 0 || link.second == 0)
-                            continue;
+                            if (link.first == 0 || link.second == 0)
+                                continue;
 
-                        if (link.first > link.second) {
-                            links[fill_pos++] = link;
-                            continue;
-                        }
+                            if (link.first > link.second) {
+                                links[fill_pos++] = link;
+                                continue;
+                            }
 
-                        auto left_it = std::lower_bound(bin_ids.begin(), bin_ids.end(), link.first + 1);
-                        auto right_it = std::lower_bound(bin_ids.begin(), bin_ids.end(), link.second);
-                        if (right_it > left_it) {
-                            links[fill_pos++] = link;
+                            auto left_it = std::lower_bound(visited.begin(), visited.end(), link.first + 1);
+                            auto right_it = std::lower_bound(visited.begin(), visited.end(), link.second);
+                            if (right_it > left_it) {
+                                links[fill_pos++] = link;
+                            }
                         }
-                    }
 
-                    gap_links_removed += links.size() - fill_pos;
-                    links.resize(fill_pos);
-                }
+                        gap_links_removed += links.size() - fill_pos;
+                        links.resize(fill_pos);
+                    }
+                    visited.clear();
 
-                handle_path(graph.get_path_name(path), links, bins);
+                    std::stringstream ss;
+                    handle_path(ss, graph.get_path_name(path), links, bins);
+                    output.write(path_rank, ss.str());
 
-                if (progress) {
-                    progress_meter->increment(1);
+                    if (progress) {
+                        progress_meter->increment(1);
+                    }
                 }
-            });
+            }
+            output.finish();
 
             if (progress) {
                 progress_meter->finish();
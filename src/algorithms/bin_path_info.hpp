@@ -30,16 +30,27 @@ namespace odgi {
             // long int last_nucleotide;
         };
 
+        /// The bins a path visits with its information in each, sorted by bin id
+        typedef std::vector<std::pair<uint64_t, path_info_t>> path_bins_t;
+
+        /// Bin the pangenome sequence and the paths. The sequence of each bin is handed over as soon
+        /// as it is complete, without holding the whole pangenome sequence. The paths are binned in
+        /// parallel, each thread reusing a table over the bins a path spans (or a map, for paths
+        /// spanning very many bins), and handle_path writes the record of a path to the stream it
+        /// is given, from which the records reach out in path order.
         void bin_path_info(const PathHandleGraph &graph,
                            const std::string &prefix_delimiter,
                            const std::function<void(const uint64_t &, const uint64_t &)> &handle_header,
-                           const std::function<void(const std::string &,
+                           const std::function<void(std::ostream &,
+                                                    const std::string &,
                                                     const std::vector<std::pair<uint64_t, uint64_t>> &,
-                                                    const std::map<uint64_t, algorithms::path_info_t> &)> &handle_path,
+                                                    const path_bins_t &)> &handle_path,
                            const std::function<void(const uint64_t &, const std::string &)> &handle_sequence,
+                           std::ostream &out,
                            uint64_t num_bins = 0,
                            uint64_t bin_width = 0,
                            bool drop_gap_links = false,
-                           bool progress = false);
+                           bool progress = false,
+                           uint64_t num_threads = 1);
     }
 }
@@ -108,8 +108,10 @@ uint64_t break_cycles(
     DeletableHandleGraph& graph,
     const uint64_t& max_cycle_size,
     const uint64_t& max_search_bp,
-    const uint64_t& iter_max) {
+    const uint64_t& iter_max,
+    const uint64_t& num_threads) {
 
+    graph_t* odgi_graph = dynamic_cast<graph_t*>(&graph);
     uint64_t removed_edges = 0;
     for (uint64_t i = 0; i < iter_max; ++i) {
         std::vector<edge_t> edges_to_remove
@@ -119,8 +121,16 @@ uint64_t break_cycles(
         if (edges_to_remove.empty()) {
             break;
         }
-        for (auto& edge : edges_to_remove) {
-            graph.destroy_edge(edge);
+        if (odgi_graph != nullptr) {
+            edit_batch_t batch(*odgi_graph, num_threads);
+            for (auto& edge : edges_to_remove) {
+                batch.destroy_edge(edge);
+            }
+            batch.apply();
+        } else {
+            for (auto& edge : edges_to_remove) {
+                graph.destroy_edge(edge);
+            }
         }
         removed_edges += edges_to_remove.size();
     }
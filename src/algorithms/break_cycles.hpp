@@ -5,6 +5,7 @@
 #include <handlegraph/util.hpp>
 #include <vector>
 #include "odgi.hpp"
+#include "edit_batch.hpp"
 #include "bfs.hpp"
 
 namespace odgi {
@@ -18,12 +19,14 @@ std::vector<edge_t> edges_inducing_cycles(
     const uint64_t& max_cycle_size,
     const uint64_t& max_search_bp);
 
-// breaks cycles, returning how many edges we removed, iterating up to iter_max times
+// breaks cycles, returning how many edges we removed, iterating up to iter_max times;
+// the edges of each iteration are removed from a graph_t in one batch on num_threads threads
 uint64_t break_cycles(
     DeletableHandleGraph& graph,
     const uint64_t& max_cycle_size,
     const uint64_t& max_search_bp,
-    const uint64_t& iter_max);
+    const uint64_t& iter_max,
+    const uint64_t& num_threads = 1);
 
 }
 
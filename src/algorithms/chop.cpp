@@ -5,16 +5,56 @@
  */
 
 #include "chop.hpp"
+#include "odgi.hpp"
+#include "edit_batch.hpp"
 
 #include <vector>
 #include <iostream>
+#include <omp.h>
 #include <deps/ips4o/ips4o.hpp>
 
 namespace odgi {
     namespace algorithms {
 
+        /// Chop an odgi graph with one batch of divisions, which numbers the pieces of each node
+        /// consecutively in the order of the nodes, as divide_handle followed by a compacting
+        /// apply_ordering would, and writes the chopped graph in parallel.
+        static void chop_in_bulk(graph_t &graph, const uint64_t &max_node_length, const uint64_t &nthreads,
+                                 const bool &show_info) {
+            edit_batch_t batch(graph, nthreads);
+            uint64_t chopped_count = 0;
+            graph.for_each_handle([&](const handle_t &handle) {
+                const uint64_t length = graph.get_length(handle);
+                if (length > max_node_length) {
+                    std::vector<size_t> offsets;
+                    for (uint64_t i = max_node_length; i < length; i += max_node_length) {
+                        offsets.push_back(i);
+                    }
+                    batch.divide_handle(handle, offsets);
+                    ++chopped_count;
+                }
+            });
+
+            if (show_info) {
+                std::cerr << "[odgi::chop] " << chopped_count << " node(s) to chop." << std::endl;
+            }
+
+            if (chopped_count == 0) {
+                // the ids are compacted all the same
+                graph.optimize(true);
+            } else {
+                batch.apply();
+            }
+        }
+
         void chop(handlegraph::MutablePathDeletableHandleGraph &graph,
                   const uint64_t &max_node_length, const uint64_t &nthreads, const bool &show_info) {
+            graph_t* odgi_graph = dynamic_cast<graph_t*>(&graph);
+            if (odgi_graph != nullptr && odgi_graph->get_node_count() > 0) {
+                chop_in_bulk(*odgi_graph, max_node_length, nthreads, show_info);
+                return;
+            }
+
             std::vector<std::tuple<uint64_t, uint64_t, handle_t>> originalRank_inChoppedNodeRank_handle;
             std::vector<std::pair<uint64_t, handle_t>> originalRank_handleToChop;
             uint64_t rank = 0;
@@ -358,7 +358,7 @@ namespace odgi {
                         bool write_node_depth, std::string &node_depth,
                         const uint64_t& nthreads, const bool& ignore_paths, const bool& show_progress) {
             std::vector<ska::flat_hash_set<handlegraph::nid_t>> weak_components = algorithms::weakly_connected_components(
-                    &graph);
+                    &graph, nthreads);
 
             // Handle each component separately.
             size_t processed_components = 0;
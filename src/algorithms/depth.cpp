@@ -1,4 +1,9 @@
 #include "depth.hpp"
+#include "progress.hpp"
+#include "index_cache.hpp"
+
+#include <fstream>
+#include <sdsl/enc_vector.hpp>
 
 namespace odgi {
 namespace algorithms {
@@ -215,5 +220,167 @@ void for_each_path_range_depth(const PathHandleGraph& graph,
     }
 }
 
+/// "ODGINDEP" in a little-endian word, and the format version
+static const uint64_t node_depth_magic = 0x5045444e4947444full;
+static const uint64_t node_depth_version = 1;
+
+void node_depth_t::build(const PathHandleGraph& graph, const std::vector<bool>& paths_to_consider,
+                         const bool& progress) {
+    shift = graph.min_node_id();
+    const uint64_t span = graph.get_node_count() ? graph.max_node_id() - shift + 1 : 0;
+    depths.assign(span, 0);
+    unique_depths.assign(span, 0);
+
+    std::unique_ptr<progress_meter::ProgressMeter> progress_meter;
+    if (progress) {
+        progress_meter = std::make_unique<progress_meter::ProgressMeter>(
+                span, "[odgi::depth] computing the node depths");
+    }
+#pragma omp parallel
+    {
+        std::vector<uint64_t> paths_on_node;
+#pragma omp for schedule(dynamic, 1024)
+        for (uint64_t rank = 0; rank < span; ++rank) {
+            if (!graph.has_node(rank + shift)) {
+                continue;
+            }
+            paths_on_node.clear();
+            graph.for_each_step_on_handle(
+                graph.get_handle(rank + shift),
+                [&](const step_handle_t& s) {
+                    const uint64_t path = as_integer(graph.get_path_handle_of_step(s));
+                    if (paths_to_consider[path]) {
+                        paths_on_node.push_back(path);
+                    }
+                });
+            depths[rank] = paths_on_node.size();
+            std::sort(paths_on_node.begin(), paths_on_node.end());
+            unique_depths[rank] = std::unique(paths_on_node.begin(), paths_on_node.end()) - paths_on_node.begin();
+            if (progress) {
+                progress_meter->increment(1);
+            }
+        }
+    }
+    if (progress) {
+        progress_meter->finish();
+    }
+}
+
+uint64_t node_depth_t::fingerprint(const PathHandleGraph& graph, const std::vector<bool>& paths_to_consider) {
+    uint64_t paths = 0;
+    graph.for_each_path_handle([&](const path_handle_t& p) {
+        paths += mix64(mix64(as_integer(p)) ^ (uint64_t)paths_to_consider[as_integer(p)]);
+    });
+    return mix64(graph_fingerprint(graph)) ^ mix64(paths);
+}
+
+void node_depth_t::serialize(std::ostream& out, const uint64_t& fingerprint) const {
+    sdsl::write_member(node_depth_magic, out);
+    sdsl::write_member(node_depth_version, out);
+    sdsl::write_member(fingerprint, out);
+    sdsl::write_member(shift, out);
+    sdsl::write_member((uint64_t)depths.size(), out);
+    out.write(reinterpret_cast<const char*>(depths.data()), depths.size() * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(unique_depths.data()), unique_depths.size() * sizeof(uint32_t));
+}
+
+bool node_depth_t::load(std::istream& in, const uint64_t& fingerprint) {
+    uint64_t magic = 0, version = 0, stored_fingerprint = 0, span = 0;
+    sdsl::read_member(magic, in);
+    sdsl::read_member(version, in);
+    sdsl::read_member(stored_fingerprint, in);
+    if (!in || magic != node_depth_magic || version != node_depth_version
+        || stored_fingerprint != fingerprint) {
+        return false;
+    }
+    sdsl::read_member(shift, in);
+    sdsl::read_member(span, in);
+    depths.resize(span);
+    unique_depths.resize(span);
+    in.read(reinterpret_cast<char*>(depths.data()), depths.size() * sizeof(uint64_t));
+    in.read(reinterpret_cast<char*>(unique_depths.data()), unique_depths.size() * sizeof(uint32_t));
+    return (bool)in;
+}
+
+void load_or_build_node_depth(node_depth_t& node_depth,
+                              const PathHandleGraph& graph,
+                              const std::vector<bool>& paths_to_consider,
+                              const std::string& graph_file,
+                              const bool& progress) {
+    const uint64_t fingerprint = graph_file.empty() ? 0
+        : node_depth_t::fingerprint(graph, paths_to_consider);
+    const std::string cache_file = graph_file.empty() ? ""
+        : index_cache_file(graph_file, "depth", fingerprint);
+    if (!cache_file.empty()) {
+        std::ifstream in(cache_file, std::ios::binary);
+        if (in && node_depth.load(in, fingerprint)) {
+            if (progress) {
+                std::cerr << "[odgi::depth] loaded the node depths from " << cache_file << std::endl;
+            }
+            return;
+        }
+    }
+    node_depth.build(graph, paths_to_consider, progress);
+    if (!cache_file.empty()
+        && !write_index_cache(cache_file, [&](std::ostream& out) { node_depth.serialize(out, fingerprint); })) {
+        std::cerr << "[odgi::depth] warning: cannot write the node depths to "
+                  << cache_file << "." << std::endl;
+    }
+}
+
+std::vector<double> get_path_range_depths(const PathHandleGraph& graph,
+                                          const std::vector<path_range_t>& path_ranges,
+                                          const node_depth_t& node_depth) {
+    std::vector<double> range_depths(path_ranges.size(), -1);
+    // the ranges on each path
+    hash_map<uint64_t, uint64_t> path_ranks;
+    std::vector<std::vector<uint64_t>> ranges_by_path;
+    for (uint64_t i = 0; i < path_ranges.size(); ++i) {
+        const uint64_t path = as_integer(path_ranges[i].begin.path);
+        auto f = path_ranks.find(path);
+        if (f == path_ranks.end()) {
+            f = path_ranks.insert(std::make_pair(path, ranges_by_path.size())).first;
+            ranges_by_path.emplace_back();
+        }
+        ranges_by_path[f->second].push_back(i);
+    }
+#pragma omp parallel for schedule(dynamic, 1)
+    for (uint64_t rank = 0; rank < ranges_by_path.size(); ++rank) {
+        const path_handle_t path = path_ranges[ranges_by_path[rank].front()].begin.path;
+        // the end offset of each step, and the summed depth over the bases up to there
+        std::vector<uint64_t> ends;
+        std::vector<uint64_t> sums;
+        uint64_t offset = 0, sum = 0;
+        graph.for_each_step_in_path(path, [&](const step_handle_t& step) {
+            const handle_t h = graph.get_handle_of_step(step);
+            const uint64_t length = graph.get_length(h);
+            if (length) {
+                offset += length;
+                sum += node_depth.depth(graph.get_id(h)) * length;
+                ends.push_back(offset);
+                sums.push_back(sum);
+            }
+        });
+        // the summed depth over the bases before pos
+        auto prefix = [&](const uint64_t& pos) -> uint64_t {
+            const uint64_t i = std::upper_bound(ends.begin(), ends.end(), pos) - ends.begin();
+            if (i == ends.size()) {
+                return sum;
+            }
+            const uint64_t start = i ? ends[i - 1] : 0;
+            const uint64_t before = i ? sums[i - 1] : 0;
+            return before + (sums[i] - before) / (ends[i] - start) * (pos - start);
+        };
+        for (auto& i : ranges_by_path[rank]) {
+            const path_range_t& range = path_ranges[i];
+            if (range.begin.offset < offset) {
+                range_depths[i] = (double)(prefix(range.end.offset) - prefix(range.begin.offset))
+                    / (double)(range.end.offset - range.begin.offset);
+            }
+        }
+    }
+    return range_depths;
+}
+
 }
 }
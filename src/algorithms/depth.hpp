@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <string>
 #include <vector>
 #include <map>
 #include <algorithm>
@@ -39,6 +40,44 @@ void for_each_path_range_depth(const PathHandleGraph& graph,
                                const std::vector<bool>& paths_to_consider,
                                const std::function<void(const path_range_t&, const double&)>& func);
 
+/// The depth (steps of the considered paths) and the unique depth (distinct considered paths) of
+/// each node, indexed by id - min node id. It is built in one parallel pass over the nodes, so that
+/// queries do not walk the steps on a node again.
+class node_depth_t {
+public:
+    /// paths_to_consider is indexed by as_integer of the path handles
+    void build(const PathHandleGraph& graph, const std::vector<bool>& paths_to_consider, const bool& progress);
+
+    uint64_t depth(const nid_t& id) const { return depths[id - shift]; }
+    uint64_t unique_depth(const nid_t& id) const { return unique_depths[id - shift]; }
+
+    /// Summarizes the nodes and the considered paths the depths are built from, to check cached ones
+    static uint64_t fingerprint(const PathHandleGraph& graph, const std::vector<bool>& paths_to_consider);
+    void serialize(std::ostream& out, const uint64_t& fingerprint) const;
+    /// false if the stream does not hold depths with this fingerprint
+    bool load(std::istream& in, const uint64_t& fingerprint);
+
+private:
+    nid_t shift = 0;
+    std::vector<uint64_t> depths;
+    std::vector<uint32_t> unique_depths;
+};
+
+/// Load the depths from their cache next to graph_file if they were built for the same graph and
+/// paths, or else build them and, if graph_file is not empty, cache them there for the next run
+void load_or_build_node_depth(node_depth_t& node_depth,
+                              const PathHandleGraph& graph,
+                              const std::vector<bool>& paths_to_consider,
+                              const std::string& graph_file,
+                              const bool& progress);
+
+/// The mean depth of each path range, from prefix sums of the node depths along the paths that have
+/// ranges, so that each range costs a binary search. Ranges beginning beyond the end of their path
+/// get -1.
+std::vector<double> get_path_range_depths(const PathHandleGraph& graph,
+                                          const std::vector<path_range_t>& path_ranges,
+                                          const node_depth_t& node_depth);
+
 /// Destroy handles with more or less than the given path depth limits
 //void bound_depth(MutablePathDeletableHandleGraph& graph, uint64_t min_depth, uint64_t max_depth);
 
@@ -1,5 +1,8 @@
 #include "draw.hpp"
 #include "split.hpp"
+#include "parallel_deflate.hpp"
+
+#include <cstdlib>
 
 namespace odgi {
 
@@ -50,6 +53,36 @@ void encodeWithState(const char *filename, std::vector<unsigned char> &image, un
     if (error) std::cout << "encoder error " << error << ": " << lodepng_error_text(error) << std::endl;
 }
 
+/// lodepng's hook for a zlib compressor, with the thread count as its context
+static unsigned parallel_zlib(unsigned char **out, size_t *outsize, const unsigned char *in, size_t insize,
+                              const LodePNGCompressSettings *settings) {
+    const uint64_t num_threads = *static_cast<const uint64_t *>(settings->custom_context);
+    const std::vector<uint8_t> compressed = algorithms::parallel_zlib_compress(in, insize, num_threads);
+    // lodepng frees the buffer with free()
+    *out = static_cast<unsigned char *>(std::malloc(compressed.size()));
+    if (!*out) {
+        return 83;
+    }
+    std::copy(compressed.begin(), compressed.end(), *out);
+    *outsize = compressed.size();
+    return 0;
+}
+
+//Example 3 with a custom zlib: the pixel data is deflated by num_threads threads
+void encodeParallel(const char *filename, std::vector<unsigned char> &image, unsigned width, unsigned height,
+                    const uint64_t &num_threads) {
+    std::vector<unsigned char> png;
+    lodepng::State state;
+    state.encoder.zlibsettings.custom_zlib = parallel_zlib;
+    state.encoder.zlibsettings.custom_context = &num_threads;
+
+    unsigned error = lodepng::encode(png, image, width, height, state);
+    if (!error) error = lodepng::save_file(png, filename);
+
+    //if there's an error, display it
+    if (error) std::cout << "encoder error " << error << ": " << lodepng_error_text(error) << std::endl;
+}
+
 }
 
 namespace algorithms {
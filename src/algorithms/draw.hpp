@@ -24,6 +24,9 @@ namespace png {
 void encodeOneStep(const char *filename, std::vector<unsigned char> &image, unsigned width, unsigned height);
 void encodeTwoSteps(const char *filename, std::vector<unsigned char> &image, unsigned width, unsigned height);
 void encodeWithState(const char *filename, std::vector<unsigned char> &image, unsigned width, unsigned height);
+/// Like encodeOneStep, but the pixel data is deflated by num_threads threads
+void encodeParallel(const char *filename, std::vector<unsigned char> &image, unsigned width, unsigned height,
+                    const uint64_t &num_threads);
 
 }
 
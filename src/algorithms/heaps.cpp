@@ -9,7 +9,8 @@ void for_each_heap_permutation(const PathHandleGraph& graph,
                                const ska::flat_hash_map<path_handle_t, std::vector<interval_t>>& path_intervals,
                                uint64_t n_permutations,
                                uint64_t min_node_depth,
-                               const std::function<void(const std::vector<uint64_t>&, uint64_t)>& func) {
+                               const std::function<void(const std::vector<uint64_t>&, uint64_t)>& func,
+                               const path_presence_t* presence) {
     //const std::function<bool(const path_handle_t&, _t)>& in_range) {
     //std::vector<std::vector<path_handle_t>>
     auto get_permutation = [&](void) {
@@ -86,6 +87,47 @@ void for_each_heap_permutation(const PathHandleGraph& graph,
         }
     }
 
+    if (presence) {
+        // the target nodes of each group, with the node lengths to add up its newly seen bits
+        const uint64_t node_count = graph.get_node_count();
+        const uint64_t node_words = path_presence_t::words_for(node_count);
+        std::vector<uint64_t> group_nodes = presence->column_rows();
+        std::vector<uint64_t> node_lengths(node_count);
+#pragma omp parallel for
+        for (uint64_t w = 0; w < node_words; ++w) {
+            uint64_t target_word = 0;
+            for (uint64_t rank = w * 64; rank < std::min(node_count, (w + 1) * 64); ++rank) {
+                node_lengths[rank] = graph.get_length(graph.get_handle(rank + 1));
+                if (target_nodes[rank]) {
+                    target_word |= 1ull << (rank & 63);
+                }
+            }
+            for (uint64_t j = 0; j < path_groups.size(); ++j) {
+                group_nodes[j * node_words + w] &= target_word;
+            }
+        }
+#pragma omp parallel for
+        for (uint64_t i = 0; i < n_permutations; ++i) {
+            auto permutation = get_permutation();
+            std::vector<uint64_t> seen_nodes(node_words, 0);
+            uint64_t seen_bp = 0;
+            std::vector<uint64_t> vals;
+            for (auto& j : permutation) {
+                const uint64_t* nodes = &group_nodes[j * node_words];
+                for (uint64_t w = 0; w < node_words; ++w) {
+                    uint64_t new_nodes = nodes[w] & ~seen_nodes[w];
+                    seen_nodes[w] |= new_nodes;
+                    for (; new_nodes; new_nodes &= new_nodes - 1) {
+                        seen_bp += node_lengths[w * 64 + __builtin_ctzll(new_nodes)];
+                    }
+                }
+                vals.push_back(seen_bp);
+            }
+            func(vals, i);
+        }
+        return;
+    }
+
 #pragma omp parallel for
     for (uint64_t i = 0; i < n_permutations; ++i) {
         auto permutation = get_permutation();
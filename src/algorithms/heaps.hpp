@@ -15,6 +15,7 @@
 #include <handlegraph/handle_graph.hpp>
 #include <handlegraph/path_handle_graph.hpp>
 #include <atomic_bitvector.hpp>
+#include "path_presence.hpp"
 
 namespace odgi {
 
@@ -24,12 +25,14 @@ namespace algorithms {
 
 /// For each permutation of the path groups
 /// we call func with a vector that is the fraction of the pangenome covered when we've considered N groups in the permutation
+/// If a presence matrix with the groups as columns is given, the groups are added up on its bits instead of walking their paths
 void for_each_heap_permutation(const PathHandleGraph& graph,
                                const std::vector<std::vector<path_handle_t>>& path_groups,
                                const ska::flat_hash_map<path_handle_t, std::vector<interval_t>>& path_intervals,
                                uint64_t n_permutations,
                                uint64_t min_node_depth,
-                               const std::function<void(const std::vector<uint64_t>&, uint64_t)>& func);
+                               const std::function<void(const std::vector<uint64_t>&, uint64_t)>& func,
+                               const path_presence_t* presence = nullptr);
 
 }
 
@@ -0,0 +1,66 @@
+#include "index_cache.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <unistd.h>
+
+namespace odgi {
+
+namespace algorithms {
+
+uint64_t graph_fingerprint(const PathHandleGraph& graph) {
+    std::vector<handle_t> handles;
+    handles.reserve(graph.get_node_count());
+    graph.for_each_handle([&](const handle_t& h) {
+        handles.push_back(h);
+    });
+    uint64_t nodes = 0;
+#pragma omp parallel for reduction(+:nodes)
+    for (uint64_t i = 0; i < handles.size(); ++i) {
+        const handle_t& h = handles[i];
+        nodes += mix64(mix64(graph.get_id(h)) ^ graph.get_length(h) ^ ((uint64_t)graph.get_step_count(h) << 32));
+    }
+    // each path by the nodes and orientations it walks, in order, one path per thread
+    std::vector<path_handle_t> path_handles;
+    path_handles.reserve(graph.get_path_count());
+    graph.for_each_path_handle([&](const path_handle_t& p) {
+        path_handles.push_back(p);
+    });
+    uint64_t paths = 0;
+#pragma omp parallel for schedule(dynamic, 1) reduction(+:paths)
+    for (uint64_t i = 0; i < path_handles.size(); ++i) {
+        const path_handle_t& p = path_handles[i];
+        uint64_t walk = 0;
+        graph.for_each_step_in_path(p, [&](const step_handle_t& step) {
+            const handle_t h = graph.get_handle_of_step(step);
+            walk = mix64(walk ^ (((uint64_t)graph.get_id(h) << 1) | (uint64_t)graph.get_is_reverse(h)));
+        });
+        paths += mix64(mix64(as_integer(p)) ^ walk ^ ((uint64_t)graph.get_step_count(p) << 32));
+    }
+    return mix64(mix64(handles.size()) ^ graph.get_path_count()) ^ mix64(nodes) ^ mix64(paths);
+}
+
+std::string index_cache_file(const std::string& graph_file, const std::string& kind, const uint64_t& fingerprint) {
+    std::stringstream name;
+    name << graph_file << "." << kind << "." << std::hex << std::setw(16) << std::setfill('0') << fingerprint;
+    return name.str();
+}
+
+bool write_index_cache(const std::string& cache_file, const std::function<void(std::ostream&)>& serialize) {
+    const std::string tmp_file = cache_file + ".tmp." + std::to_string(getpid());
+    std::ofstream out(tmp_file, std::ios::binary);
+    serialize(out);
+    out.close();
+    if (!out || std::rename(tmp_file.c_str(), cache_file.c_str()) != 0) {
+        std::remove(tmp_file.c_str());
+        return false;
+    }
+    return true;
+}
+
+}
+
+}
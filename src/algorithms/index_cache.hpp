@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <handlegraph/types.hpp>
+#include <handlegraph/path_handle_graph.hpp>
+
+namespace odgi {
+
+namespace algorithms {
+
+using namespace handlegraph;
+
+/// The splitmix64 finalizer, which spreads ids and counts over all the bits of a word
+inline uint64_t mix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+/// Summarizes the nodes (id, length and step count) and the paths (handle and the oriented nodes
+/// they walk) of the graph, to tell an index cached for it from one cached for an edited graph
+uint64_t graph_fingerprint(const PathHandleGraph& graph);
+
+/// The file next to graph_file that caches an index of the given kind with this fingerprint, so
+/// that indexes built with other settings are kept apart rather than overwriting each other
+std::string index_cache_file(const std::string& graph_file, const std::string& kind, const uint64_t& fingerprint);
+
+/// Write an index to a temporary file next to cache_file and move it in place, so that concurrent
+/// runs never read half of it; false if it cannot be written
+bool write_index_cache(const std::string& cache_file, const std::function<void(std::ostream&)>& serialize);
+
+}
+
+}
@@ -1,4 +1,6 @@
 #include "inject.hpp"
+#include "odgi.hpp"
+#include "edit_batch.hpp"
 
 namespace odgi {
 
@@ -152,6 +154,28 @@ void inject_ranges(MutablePathDeletableHandleGraph& graph,
         }
     }
 
+    // the steps of the injected paths are queued while walking the paths, and written in one
+    // batch on a graph_t
+    graph_t* odgi_graph = dynamic_cast<graph_t*>(&graph);
+    std::unique_ptr<edit_batch_t> batch;
+    if (odgi_graph != nullptr) {
+        batch = std::make_unique<edit_batch_t>(*odgi_graph, odgi_graph->get_number_of_threads());
+    }
+    auto inject_steps = [&](const path_handle_t& p, step_handle_t c, const step_handle_t& end) {
+        std::vector<handle_t> handles;
+        do {
+            handles.push_back(graph.get_handle_of_step(c));
+            c = graph.get_next_step(c);
+        } while (c != end);
+        if (batch) {
+            batch->append_steps(p, handles);
+        } else {
+            for (auto& h : handles) {
+                graph.append_step(p, h);
+            }
+        }
+    };
+
     // then we iterate back through the sorted path intervals and add paths at the appropriate points
 #pragma omp parallel for
     for (auto& path : paths) {
@@ -193,12 +217,7 @@ void inject_ranges(MutablePathDeletableHandleGraph& graph,
                             assert(f != injected_paths.end());
                             p = f->second;
                         }
-                        auto& c = open_intervals_by_end.begin()->second;
-                        auto end = step;
-                        do {
-                            graph.append_step(p, graph.get_handle_of_step(c));
-                            c = graph.get_next_step(c);
-                        } while (c != end);
+                        inject_steps(p, open_intervals_by_end.begin()->second, step);
                         // clean up
                         open_intervals_by_end.erase(open_intervals_by_end.begin());
                     }
@@ -232,18 +251,17 @@ void inject_ranges(MutablePathDeletableHandleGraph& graph,
                     assert(f != injected_paths.end());
                     p = f->second;
                 }
-                auto& c = open_intervals_by_end.begin()->second;
-                auto end = graph.path_end(path);
-                do {
-                    graph.append_step(p, graph.get_handle_of_step(c));
-                    c = graph.get_next_step(c);
-                } while (c != end);
+                inject_steps(p, open_intervals_by_end.begin()->second, graph.path_end(path));
                 // clean up
                 open_intervals_by_end.erase(open_intervals_by_end.begin());
             }
         }
     }
 
+    if (batch) {
+        batch->apply();
+    }
+
     if (show_progress) {
         progress->finish();
     }
@@ -252,6 +270,17 @@ void inject_ranges(MutablePathDeletableHandleGraph& graph,
 void chop_at(MutablePathDeletableHandleGraph &graph,
              const ska::flat_hash_map<handle_t, std::vector<size_t>>& cut_points) {
 
+    // divide all nodes of a graph_t in one batch, which numbers the pieces in the same way
+    graph_t* odgi_graph = dynamic_cast<graph_t*>(&graph);
+    if (odgi_graph != nullptr && !cut_points.empty()) {
+        edit_batch_t batch(*odgi_graph, odgi_graph->get_number_of_threads());
+        for (auto& handle_offsets : cut_points) {
+            batch.divide_handle(handle_offsets.first, handle_offsets.second);
+        }
+        batch.apply();
+        return;
+    }
+
     std::vector<std::tuple<uint64_t, uint64_t, handle_t>> originalRank_inChoppedNodeRank_handle;
     std::vector<std::pair<uint64_t, handle_t>> originalRank_handleToChop;
 
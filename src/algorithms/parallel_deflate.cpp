@@ -0,0 +1,368 @@
+#include "parallel_deflate.hpp"
+
+#include <algorithm>
+#include <omp.h>
+#include <queue>
+
+namespace odgi {
+
+namespace algorithms {
+
+static const uint32_t adler_base = 65521;
+/// the most bytes whose sums fit in 32 bits before taking them modulo adler_base
+static const size_t adler_nmax = 5552;
+
+static const size_t window_size = 1 << 15;
+static const size_t window_mask = window_size - 1;
+static const size_t hash_bits = 15;
+static const size_t min_match = 3;
+static const size_t max_match = 258;
+/// how many earlier positions with the same hash we look at for a match
+static const uint64_t max_chain = 32;
+
+static const uint16_t length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+/// the order in which the lengths of the code length code are written
+static const uint8_t code_length_order[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+uint32_t adler32(const uint8_t* in, const size_t& size, uint32_t adler) {
+    uint32_t a = adler & 0xffff;
+    uint32_t b = adler >> 16;
+    for (size_t i = 0; i < size; ) {
+        const size_t end = std::min(size, i + adler_nmax);
+        for ( ; i < end; ++i) {
+            a += in[i];
+            b += a;
+        }
+        a %= adler_base;
+        b %= adler_base;
+    }
+    return a | (b << 16);
+}
+
+uint32_t adler32_combine(const uint32_t& adler1, const uint32_t& adler2, const size_t& length2) {
+    const uint64_t rem = length2 % adler_base;
+    uint64_t a = adler1 & 0xffff;
+    uint64_t b = (rem * a) % adler_base;
+    a += (adler2 & 0xffff) + adler_base - 1;
+    b += (adler1 >> 16) + (adler2 >> 16) + adler_base - rem;
+    a %= adler_base;
+    b %= adler_base;
+    return (uint32_t)(a | (b << 16));
+}
+
+/// A match of length len at distance dist, or a literal in dist when len is 0
+struct lz_token_t {
+    uint16_t len;
+    uint16_t dist;
+};
+
+class bit_writer_t {
+public:
+    explicit bit_writer_t(std::vector<uint8_t>& out) : out(out) { }
+    /// write the n low bits of value, the lowest first
+    void put(const uint32_t& value, const uint32_t& n) {
+        bits |= (uint64_t)value << count;
+        count += n;
+        while (count >= 8) {
+            out.push_back(bits & 0xff);
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+    void align() {
+        if (count) {
+            put(0, 8 - count);
+        }
+    }
+private:
+    std::vector<uint8_t>& out;
+    uint64_t bits = 0;
+    uint32_t count = 0;
+};
+
+static uint8_t length_code(const uint16_t& len) {
+    return std::upper_bound(length_base, length_base + 29, len) - length_base - 1;
+}
+
+static uint8_t dist_code(const uint16_t& dist) {
+    return std::upper_bound(dist_base, dist_base + 30, dist) - dist_base - 1;
+}
+
+/// Huffman code lengths of at most limit bits for the symbols with a non-zero frequency; there
+/// must be at least two of them
+static std::vector<uint8_t> huffman_lengths(std::vector<uint32_t> freq, const uint8_t& limit) {
+    const uint64_t n = freq.size();
+    std::vector<uint8_t> lengths(n, 0);
+    while (true) {
+        // the leaves are 0..n-1 and the inner nodes follow, each pointing to its parent
+        std::vector<uint64_t> parent(2 * n, 0);
+        typedef std::pair<uint64_t, uint64_t> item_t;
+        std::priority_queue<item_t, std::vector<item_t>, std::greater<item_t>> queue;
+        for (uint64_t i = 0; i < n; ++i) {
+            if (freq[i]) {
+                queue.push(std::make_pair(freq[i], i));
+            }
+        }
+        uint64_t next = n;
+        while (queue.size() > 1) {
+            const item_t a = queue.top(); queue.pop();
+            const item_t b = queue.top(); queue.pop();
+            parent[a.second] = next;
+            parent[b.second] = next;
+            queue.push(std::make_pair(a.first + b.first, next++));
+        }
+        const uint64_t root = next - 1;
+        // the inner nodes are created after their children, so their depths are known top down
+        std::vector<uint8_t> depth(2 * n, 0);
+        for (uint64_t i = root; i-- > n; ) {
+            depth[i] = depth[parent[i]] + 1;
+        }
+        uint8_t max_length = 0;
+        for (uint64_t i = 0; i < n; ++i) {
+            lengths[i] = freq[i] ? depth[parent[i]] + 1 : 0;
+            max_length = std::max(max_length, lengths[i]);
+        }
+        if (max_length <= limit) {
+            return lengths;
+        }
+        // flatten the frequencies until the tree is shallow enough
+        for (auto& f : freq) {
+            if (f) {
+                f = (f >> 1) | 1;
+            }
+        }
+    }
+}
+
+/// Canonical codes for the lengths, bit-reversed so that they can be written lowest bit first
+static std::vector<uint16_t> huffman_codes(const std::vector<uint8_t>& lengths) {
+    uint16_t count[16] = {0};
+    for (auto& l : lengths) {
+        ++count[l];
+    }
+    count[0] = 0;
+    uint16_t next_code[16] = {0};
+    uint16_t code = 0;
+    for (uint8_t bits = 1; bits < 16; ++bits) {
+        code = (code + count[bits - 1]) << 1;
+        next_code[bits] = code;
+    }
+    std::vector<uint16_t> codes(lengths.size(), 0);
+    for (uint64_t i = 0; i < lengths.size(); ++i) {
+        if (lengths[i]) {
+            const uint16_t c = next_code[lengths[i]]++;
+            uint16_t reversed = 0;
+            for (uint8_t b = 0; b < lengths[i]; ++b) {
+                reversed |= ((c >> b) & 1) << (lengths[i] - 1 - b);
+            }
+            codes[i] = reversed;
+        }
+    }
+    return codes;
+}
+
+/// make sure that at least two symbols get a code, which keeps every code complete
+static void ensure_two_symbols(std::vector<uint32_t>& freq) {
+    uint64_t used = 0;
+    for (auto& f : freq) {
+        used += f != 0;
+    }
+    for (uint64_t i = 0; used < 2 && i < freq.size(); ++i) {
+        if (!freq[i]) {
+            freq[i] = 1;
+            ++used;
+        }
+    }
+}
+
+/// LZ77-parse in[start, end), allowing matches that begin in the window before start
+static std::vector<lz_token_t> lz77_parse(const uint8_t* in, const size_t& size,
+                                          const size_t& start, const size_t& end) {
+    std::vector<lz_token_t> tokens;
+    std::vector<int64_t> head(1 << hash_bits, -1);
+    std::vector<int64_t> prev(window_size, -1);
+    auto hash = [&](const size_t& p) {
+        return ((in[p] << 10) ^ (in[p + 1] << 5) ^ in[p + 2]) & ((1 << hash_bits) - 1);
+    };
+    auto insert = [&](const size_t& p) {
+        if (p + min_match <= size) {
+            const uint32_t h = hash(p);
+            prev[p & window_mask] = head[h];
+            head[h] = p;
+        }
+    };
+    for (size_t p = start > window_size ? start - window_size : 0; p < start; ++p) {
+        insert(p);
+    }
+    size_t i = start;
+    while (i < end) {
+        const size_t longest = std::min(max_match, end - i);
+        size_t best_len = 0;
+        size_t best_dist = 0;
+        if (longest >= min_match) {
+            int64_t candidate = head[hash(i)];
+            for (uint64_t chain = 0; chain < max_chain && candidate >= 0
+                     && i - candidate <= window_size; ++chain) {
+                const uint8_t* a = in + candidate;
+                const uint8_t* b = in + i;
+                if (a[best_len] == b[best_len]) {
+                    size_t len = 0;
+                    while (len < longest && a[len] == b[len]) {
+                        ++len;
+                    }
+                    if (len > best_len) {
+                        best_len = len;
+                        best_dist = i - candidate;
+                        if (len == longest) {
+                            break;
+                        }
+                    }
+                }
+                const int64_t next = prev[candidate & window_mask];
+                if (next >= candidate) {
+                    break; // the slot was reused by a later position
+                }
+                candidate = next;
+            }
+        }
+        if (best_len >= min_match) {
+            tokens.push_back({(uint16_t)best_len, (uint16_t)best_dist});
+            for (size_t p = i; p < i + best_len; ++p) {
+                insert(p);
+            }
+            i += best_len;
+        } else {
+            tokens.push_back({0, in[i]});
+            insert(i);
+            ++i;
+        }
+    }
+    return tokens;
+}
+
+/// Compress in[start, end) into one dynamic Huffman block, ending on a byte boundary
+static std::vector<uint8_t> deflate_chunk(const uint8_t* in, const size_t& size,
+                                          const size_t& start, const size_t& end, const bool& last) {
+    const std::vector<lz_token_t> tokens = lz77_parse(in, size, start, end);
+    std::vector<uint32_t> lit_freq(286, 0);
+    std::vector<uint32_t> dist_freq(30, 0);
+    for (auto& t : tokens) {
+        if (t.len) {
+            ++lit_freq[257 + length_code(t.len)];
+            ++dist_freq[dist_code(t.dist)];
+        } else {
+            ++lit_freq[t.dist];
+        }
+    }
+    ++lit_freq[256];
+    ensure_two_symbols(lit_freq);
+    ensure_two_symbols(dist_freq);
+    const std::vector<uint8_t> lit_lengths = huffman_lengths(lit_freq, 15);
+    const std::vector<uint8_t> dist_lengths = huffman_lengths(dist_freq, 15);
+    const std::vector<uint16_t> lit_codes = huffman_codes(lit_lengths);
+    const std::vector<uint16_t> dist_codes = huffman_codes(dist_lengths);
+
+    uint32_t hlit = 286;
+    while (hlit > 257 && !lit_lengths[hlit - 1]) {
+        --hlit;
+    }
+    uint32_t hdist = 30;
+    while (hdist > 1 && !dist_lengths[hdist - 1]) {
+        --hdist;
+    }
+    // the code lengths are written literally, without the run-length symbols 16, 17 and 18
+    std::vector<uint8_t> all_lengths(lit_lengths.begin(), lit_lengths.begin() + hlit);
+    all_lengths.insert(all_lengths.end(), dist_lengths.begin(), dist_lengths.begin() + hdist);
+    std::vector<uint32_t> cl_freq(19, 0);
+    for (auto& l : all_lengths) {
+        ++cl_freq[l];
+    }
+    ensure_two_symbols(cl_freq);
+    const std::vector<uint8_t> cl_lengths = huffman_lengths(cl_freq, 7);
+    const std::vector<uint16_t> cl_codes = huffman_codes(cl_lengths);
+    uint32_t hclen = 19;
+    while (hclen > 4 && !cl_lengths[code_length_order[hclen - 1]]) {
+        --hclen;
+    }
+
+    std::vector<uint8_t> out;
+    out.reserve((end - start) / 4 + 1024);
+    bit_writer_t writer(out);
+    writer.put(last ? 1 : 0, 1);
+    writer.put(2, 2);
+    writer.put(hlit - 257, 5);
+    writer.put(hdist - 1, 5);
+    writer.put(hclen - 4, 4);
+    for (uint32_t i = 0; i < hclen; ++i) {
+        writer.put(cl_lengths[code_length_order[i]], 3);
+    }
+    for (auto& l : all_lengths) {
+        writer.put(cl_codes[l], cl_lengths[l]);
+    }
+    for (auto& t : tokens) {
+        if (t.len) {
+            const uint8_t lc = length_code(t.len);
+            writer.put(lit_codes[257 + lc], lit_lengths[257 + lc]);
+            writer.put(t.len - length_base[lc], length_extra[lc]);
+            const uint8_t dc = dist_code(t.dist);
+            writer.put(dist_codes[dc], dist_lengths[dc]);
+            writer.put(t.dist - dist_base[dc], dist_extra[dc]);
+        } else {
+            writer.put(lit_codes[t.dist], lit_lengths[t.dist]);
+        }
+    }
+    writer.put(lit_codes[256], lit_lengths[256]);
+    if (!last) {
+        // an empty stored block brings the chunk to a byte boundary
+        writer.put(0, 3);
+        writer.align();
+        writer.put(0x0000, 16);
+        writer.put(0xffff, 16);
+    } else {
+        writer.align();
+    }
+    return out;
+}
+
+std::vector<uint8_t> parallel_zlib_compress(const uint8_t* in, const size_t& size,
+                                            const uint64_t& num_threads,
+                                            const size_t& chunk_size) {
+    const size_t chunk_count = std::max((size_t)1, (size + chunk_size - 1) / chunk_size);
+    std::vector<std::vector<uint8_t>> chunks(chunk_count);
+    std::vector<uint32_t> adlers(chunk_count);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+    for (size_t c = 0; c < chunk_count; ++c) {
+        const size_t start = c * chunk_size;
+        const size_t end = std::min(size, start + chunk_size);
+        chunks[c] = deflate_chunk(in, size, start, end, c + 1 == chunk_count);
+        adlers[c] = adler32(in + start, end - start);
+    }
+    std::vector<uint8_t> out = {0x78, 0x9c};
+    uint32_t adler = 1;
+    for (size_t c = 0; c < chunk_count; ++c) {
+        out.insert(out.end(), chunks[c].begin(), chunks[c].end());
+        std::vector<uint8_t>().swap(chunks[c]);
+        const size_t start = c * chunk_size;
+        adler = adler32_combine(adler, adlers[c], std::min(size, start + chunk_size) - start);
+    }
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back((adler >> shift) & 0xff);
+    }
+    return out;
+}
+
+}
+
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace odgi {
+
+namespace algorithms {
+
+/// Compress the bytes into a zlib stream (RFC 1950) with num_threads threads. The input is cut
+/// into chunks that are compressed independently with LZ77 and a dynamic Huffman block each; a
+/// chunk may refer back into the 32 KiB before it, and all but the last are closed with an empty
+/// stored block, so that the chunks join on byte boundaries.
+std::vector<uint8_t> parallel_zlib_compress(const uint8_t* in, const size_t& size,
+                                            const uint64_t& num_threads,
+                                            const size_t& chunk_size = 1 << 20);
+
+/// The Adler-32 of the bytes, as zlib computes it
+uint32_t adler32(const uint8_t* in, const size_t& size, uint32_t adler = 1);
+
+/// The Adler-32 of two concatenated byte ranges from the Adler-32 of each and the length of the second
+uint32_t adler32_combine(const uint32_t& adler1, const uint32_t& adler2, const size_t& length2);
+
+}
+
+}
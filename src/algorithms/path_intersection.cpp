@@ -0,0 +1,274 @@
+#include "path_intersection.hpp"
+
+#include <algorithm>
+
+namespace odgi {
+
+namespace algorithms {
+
+path_intersection_matrix_t::path_intersection_matrix_t(const uint64_t& id_count, const uint64_t& shard_count,
+                                                       const uint64_t& dense_pair_limit)
+    : id_count(id_count), shard_count(std::max(shard_count, (uint64_t)1)) {
+    const uint64_t pair_count = id_count * (id_count + 1) / 2;
+    dense = pair_count <= dense_pair_limit;
+    if (dense) {
+        triangle.resize(pair_count, 0);
+    } else {
+        sparse.resize(this->shard_count);
+    }
+}
+
+uint64_t path_intersection_matrix_t::get(const uint32_t& a, const uint32_t& b) const {
+    const uint32_t lo = std::min(a, b);
+    const uint32_t hi = std::max(a, b);
+    if (dense) {
+        return triangle[triangle_index(lo, hi)];
+    }
+    const auto& shard = sparse[shard_of(lo)];
+    auto f = shard.find(((uint64_t)lo << 32) | hi);
+    return f == shard.end() ? 0 : f->second;
+}
+
+void path_intersection_matrix_t::for_each_pair(
+    const std::function<void(const uint32_t&, const uint32_t&, const uint64_t&)>& func) const {
+    if (dense) {
+        uint64_t i = 0;
+        for (uint32_t a = 0; a < id_count; ++a) {
+            for (uint32_t b = a; b < id_count; ++b, ++i) {
+                if (triangle[i]) {
+                    func(a, b, triangle[i]);
+                }
+            }
+        }
+    } else {
+        for (const auto& shard : sparse) {
+            for (const auto& pair : shard) {
+                func(pair.first >> 32, pair.first & 0xFFFFFFFF, pair.second);
+            }
+        }
+    }
+}
+
+void for_each_node_in_shards(const PathHandleGraph& graph,
+                             const std::vector<bool>& node_mask,
+                             const std::vector<uint32_t>& path_ids,
+                             const uint64_t& shard_count,
+                             const bool& progress,
+                             const std::string& banner,
+                             const std::function<void(const uint64_t&, const nid_t&, const uint64_t&,
+                                                      const std::vector<std::pair<uint32_t, uint64_t>>&)>& func) {
+    std::unique_ptr<progress_meter::ProgressMeter> progress_meter;
+    if (progress) {
+        progress_meter = std::make_unique<progress_meter::ProgressMeter>(graph.get_node_count(), banner);
+    }
+
+    // chunks of about this many (id, count) entries keep the gathered counts small on deep
+    // graphs while giving the threads enough work to share on shallow ones
+    const uint64_t chunk_entries = 1 << 22;
+    const uint64_t min_chunk_nodes = 64;
+    const uint64_t max_chunk_nodes = 1 << 16;
+
+    const nid_t min_id = graph.min_node_id();
+    const nid_t max_id = graph.max_node_id();
+    // the path ids and their step counts on each node of the chunk, sorted by id
+    std::vector<std::vector<std::pair<uint32_t, uint64_t>>> node_counts;
+    std::vector<uint64_t> node_lengths;
+    uint64_t chunk_nodes = min_chunk_nodes;
+    for (nid_t chunk_begin = min_id; chunk_begin <= max_id; ) {
+        const nid_t chunk_end = std::min(chunk_begin + (nid_t)chunk_nodes, max_id + 1);
+        const uint64_t chunk_size = chunk_end - chunk_begin;
+        node_counts.resize(std::max(node_counts.size(), chunk_size));
+        node_lengths.resize(node_counts.size());
+        uint64_t entries = 0;
+
+#pragma omp parallel for schedule(dynamic, 16) reduction(+:entries)
+        for (uint64_t i = 0; i < chunk_size; ++i) {
+            auto& counts = node_counts[i];
+            counts.clear();
+            const nid_t id = chunk_begin + i;
+            // Skip masked-out nodes
+            if (!graph.has_node(id) || !node_mask[id - 1]) {
+                continue;
+            }
+            const handle_t h = graph.get_handle(id);
+            node_lengths[i] = graph.get_length(h);
+            std::vector<uint32_t> ids;
+            graph.for_each_step_on_handle(
+                h,
+                [&](const step_handle_t& s) {
+                    ids.push_back(path_ids[as_integer(graph.get_path_handle_of_step(s))]);
+                });
+            std::sort(ids.begin(), ids.end());
+            for (const uint32_t& path_id : ids) {
+                if (counts.empty() || counts.back().first != path_id) {
+                    counts.push_back(std::make_pair(path_id, 0));
+                }
+                ++counts.back().second;
+            }
+            entries += counts.size();
+        }
+
+#pragma omp parallel for schedule(static, 1)
+        for (uint64_t shard = 0; shard < shard_count; ++shard) {
+            for (uint64_t i = 0; i < chunk_size; ++i) {
+                if (!node_counts[i].empty()) {
+                    func(shard, chunk_begin + i, node_lengths[i], node_counts[i]);
+                }
+            }
+        }
+
+        if (progress) {
+            progress_meter->increment(chunk_size);
+        }
+        chunk_begin = chunk_end;
+        chunk_nodes = std::min(std::max(chunk_entries * chunk_size / std::max(entries, (uint64_t)1),
+                                        min_chunk_nodes), max_chunk_nodes);
+    }
+
+    if (progress) {
+        progress_meter->finish();
+    }
+}
+
+void collect_path_intersections(const PathHandleGraph& graph,
+                                const std::vector<bool>& node_mask,
+                                const std::vector<uint32_t>& path_ids,
+                                path_intersection_matrix_t& matrix,
+                                const bool& progress) {
+    for_each_node_in_shards(
+        graph, node_mask, path_ids, matrix.get_shard_count(), progress,
+        "[odgi::similarity] collecting path intersection lengths",
+        [&](const uint64_t& shard, const nid_t& id, const uint64_t& length,
+            const std::vector<std::pair<uint32_t, uint64_t>>& counts) {
+            for (uint64_t j = 0; j < counts.size(); ++j) {
+                if (matrix.shard_of(counts[j].first) != shard) {
+                    continue;
+                }
+                for (uint64_t k = j; k < counts.size(); ++k) {
+                    matrix.add(counts[j].first, counts[k].first,
+                               length * std::min(counts[j].second, counts[k].second));
+                }
+            }
+        });
+}
+
+void collect_presence_intersections(const PathHandleGraph& graph,
+                                    const path_presence_t& presence,
+                                    const std::vector<bool>& nodes,
+                                    path_intersection_matrix_t& matrix) {
+    const uint64_t node_count = presence.get_node_count();
+    const uint64_t node_words = path_presence_t::words_for(node_count);
+    // plane p of word w holds the nodes of the word whose length has bit p set
+    uint64_t max_length = 0;
+    for (uint64_t rank = 0; rank < node_count; ++rank) {
+        if (nodes[rank]) {
+            max_length = std::max(max_length, (uint64_t)graph.get_length(graph.get_handle(rank + 1)));
+        }
+    }
+    uint64_t plane_count = 0;
+    while (max_length >> plane_count) {
+        ++plane_count;
+    }
+    std::vector<uint64_t> planes(node_words * plane_count, 0);
+#pragma omp parallel for schedule(static)
+    for (uint64_t w = 0; w < node_words; ++w) {
+        for (uint64_t rank = w * 64; rank < std::min(node_count, (w + 1) * 64); ++rank) {
+            if (nodes[rank]) {
+                const uint64_t length = graph.get_length(graph.get_handle(rank + 1));
+                for (uint64_t p = 0; p < plane_count; ++p) {
+                    if ((length >> p) & 1) {
+                        planes[w * plane_count + p] |= 1ull << (rank & 63);
+                    }
+                }
+            }
+        }
+    }
+
+    const std::vector<uint64_t> columns = presence.column_rows();
+    std::vector<uint32_t> active_columns;
+    for (uint64_t c = 0; c < presence.get_column_count(); ++c) {
+        const uint64_t* column = &columns[c * node_words];
+        if (std::any_of(column, column + node_words, [](const uint64_t& word) { return word != 0; })) {
+            active_columns.push_back(c);
+        }
+    }
+
+    const uint64_t shard_count = matrix.get_shard_count();
+#pragma omp parallel for schedule(static, 1)
+    for (uint64_t shard = 0; shard < shard_count; ++shard) {
+        for (uint64_t i = 0; i < active_columns.size(); ++i) {
+            const uint32_t a = active_columns[i];
+            if (matrix.shard_of(a) != shard) {
+                continue;
+            }
+            const uint64_t* column_a = &columns[a * node_words];
+            for (uint64_t j = i; j < active_columns.size(); ++j) {
+                const uint32_t b = active_columns[j];
+                const uint64_t* column_b = &columns[b * node_words];
+                uint64_t length = 0;
+                for (uint64_t w = 0; w < node_words; ++w) {
+                    const uint64_t both = column_a[w] & column_b[w];
+                    if (both) {
+                        const uint64_t* plane = &planes[w * plane_count];
+                        for (uint64_t p = 0; p < plane_count; ++p) {
+                            length += (uint64_t)__builtin_popcountll(both & plane[p]) << p;
+                        }
+                    }
+                }
+                if (length) {
+                    matrix.add(a, b, length);
+                }
+            }
+        }
+    }
+}
+
+void collect_path_intersections(const PathHandleGraph& graph,
+                                const std::vector<bool>& node_mask,
+                                const std::vector<uint32_t>& path_ids,
+                                const path_presence_t& presence,
+                                path_intersection_matrix_t& matrix,
+                                const bool& progress) {
+    const uint64_t node_count = presence.get_node_count();
+    std::vector<bool> presence_nodes(node_count, false);
+    std::vector<bool> pair_nodes(node_count, false);
+    // the pairs the nodes without repeats would add one by one, and the columns seen on them
+    uint64_t pair_work = 0;
+    std::vector<uint64_t> seen_columns(presence.get_words_per_node(), 0);
+    for (uint64_t rank = 0; rank < node_count; ++rank) {
+        if (!node_mask[rank]) {
+            continue;
+        }
+        if (presence.has_repeats(rank)) {
+            pair_nodes[rank] = true;
+            continue;
+        }
+        presence_nodes[rank] = true;
+        const uint64_t k = presence.column_count_on(rank);
+        pair_work += k * (k + 1) / 2;
+        const uint64_t* row = presence.node_row(rank);
+        for (uint64_t w = 0; w < seen_columns.size(); ++w) {
+            seen_columns[w] |= row[w];
+        }
+    }
+    uint64_t active = 0;
+    for (const uint64_t& word : seen_columns) {
+        active += __builtin_popcountll(word);
+    }
+    // every pair of columns takes a pass over the node words, with a few popcounts per
+    // shared word; assume about four planes of them are hit
+    const uint64_t presence_work = active * (active + 1) / 2 * path_presence_t::words_for(node_count) * 4;
+    if (presence_work >= pair_work) {
+        collect_path_intersections(graph, node_mask, path_ids, matrix, progress);
+        return;
+    }
+    if (progress) {
+        std::cerr << "[odgi::similarity] intersecting " << active << " paths or groups on the path presence matrix" << std::endl;
+    }
+    collect_presence_intersections(graph, presence, presence_nodes, matrix);
+    collect_path_intersections(graph, pair_nodes, path_ids, matrix, progress);
+}
+
+}
+
+}
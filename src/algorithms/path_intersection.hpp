@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include <handlegraph/types.hpp>
+#include <handlegraph/util.hpp>
+#include <handlegraph/path_handle_graph.hpp>
+#include "flat_hash_map.hpp"
+#include "progress.hpp"
+#include "path_presence.hpp"
+
+namespace odgi {
+
+namespace algorithms {
+
+using namespace handlegraph;
+
+/// The summed intersection lengths of pairs of ids (paths or groups of paths) below id_count.
+/// Only the pairs (a, b) with a <= b are stored, in a dense upper triangle when it fits in
+/// dense_pair_limit entries and in sparse maps otherwise. The rows are split into shards, and
+/// each shard is filled by a single thread, so that adding to the matrix needs no locks.
+class path_intersection_matrix_t {
+public:
+    /// 2^27 pairs take 1 GiB, enough for a dense matrix of about 16k paths
+    static constexpr uint64_t default_dense_pair_limit = 1ull << 27;
+
+    path_intersection_matrix_t(const uint64_t& id_count, const uint64_t& shard_count,
+                               const uint64_t& dense_pair_limit = default_dense_pair_limit);
+
+    bool is_dense() const { return dense; }
+    uint64_t get_shard_count() const { return shard_count; }
+    /// the shard holding the rows of id a
+    uint64_t shard_of(const uint32_t& a) const { return a % shard_count; }
+    /// add to the pair (a, b), with a <= b; only the thread filling shard_of(a) may call this
+    void add(const uint32_t& a, const uint32_t& b, const uint64_t& length) {
+        if (dense) {
+            triangle[triangle_index(a, b)] += length;
+        } else {
+            sparse[shard_of(a)][((uint64_t)a << 32) | b] += length;
+        }
+    }
+    /// the intersection of a and b, in either order
+    uint64_t get(const uint32_t& a, const uint32_t& b) const;
+    /// call func(a, b, intersection) with a <= b for each pair with a non-zero intersection
+    void for_each_pair(const std::function<void(const uint32_t&, const uint32_t&, const uint64_t&)>& func) const;
+
+private:
+    uint64_t id_count;
+    uint64_t shard_count;
+    bool dense;
+    std::vector<uint64_t> triangle;
+    std::vector<ska::flat_hash_map<uint64_t, uint64_t>> sparse;
+
+    uint64_t triangle_index(const uint64_t& a, const uint64_t& b) const {
+        return a * id_count - a * (a - 1) / 2 + (b - a);
+    }
+};
+
+/// Read the nodes that are not masked out in chunks. path_ids maps each path, by as_integer, to
+/// an id. The ids on each node of a chunk, with how often they step on it, are gathered in
+/// parallel, then func(shard, node id, node length, counts sorted by id) is called for each of
+/// them on one thread per shard, so that a thread can update what it owns without locks.
+void for_each_node_in_shards(const PathHandleGraph& graph,
+                             const std::vector<bool>& node_mask,
+                             const std::vector<uint32_t>& path_ids,
+                             const uint64_t& shard_count,
+                             const bool& progress,
+                             const std::string& banner,
+                             const std::function<void(const uint64_t&, const nid_t&, const uint64_t&,
+                                                      const std::vector<std::pair<uint32_t, uint64_t>>&)>& func);
+
+/// Add the intersection lengths of the paths on each node that is not masked out to the matrix,
+/// each thread adding up the pairs of the rows it owns. path_ids maps each path, by as_integer,
+/// to its row in the matrix.
+void collect_path_intersections(const PathHandleGraph& graph,
+                                const std::vector<bool>& node_mask,
+                                const std::vector<uint32_t>& path_ids,
+                                path_intersection_matrix_t& matrix,
+                                const bool& progress);
+
+/// Add the intersection lengths on the nodes that are set in nodes, on which each column of the
+/// presence matrix (a row of the intersection matrix) steps at most once. The node lengths are
+/// split into bit planes, so that the intersection of two columns is a sum of popcounts.
+void collect_presence_intersections(const PathHandleGraph& graph,
+                                    const path_presence_t& presence,
+                                    const std::vector<bool>& nodes,
+                                    path_intersection_matrix_t& matrix);
+
+/// As above, but the nodes that no column steps on twice go through the presence matrix when
+/// its popcounts cost less than adding up their pairs one by one.
+void collect_path_intersections(const PathHandleGraph& graph,
+                                const std::vector<bool>& node_mask,
+                                const std::vector<uint32_t>& path_ids,
+                                const path_presence_t& presence,
+                                path_intersection_matrix_t& matrix,
+                                const bool& progress);
+
+}
+
+}
@@ -0,0 +1,161 @@
+#include "path_presence.hpp"
+#include "index_cache.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sdsl/enc_vector.hpp>
+
+namespace odgi {
+
+namespace algorithms {
+
+/// "ODGIPPRS" in a little-endian word, and the format version
+static const uint64_t path_presence_magic = 0x535250504947444full;
+static const uint64_t path_presence_version = 2;
+
+/// the handles of the nodes, and the number of rows they need
+static std::vector<handle_t> node_handles(const PathHandleGraph& graph, uint64_t& row_count) {
+    std::vector<handle_t> handles;
+    handles.reserve(graph.get_node_count());
+    row_count = 0;
+    graph.for_each_handle([&](const handle_t& h) {
+        handles.push_back(h);
+        row_count = std::max(row_count, path_presence_t::rank_of(h) + 1);
+    });
+    return handles;
+}
+
+void path_presence_t::build(const PathHandleGraph& graph, const std::vector<uint64_t>& path_columns,
+                            const uint64_t& column_count, const bool& progress) {
+    const std::vector<handle_t> handles = node_handles(graph, node_count);
+    this->column_count = column_count;
+    words_per_node = words_for(column_count);
+    bits.assign(node_count * words_per_node, 0);
+    repeats.assign(node_count, 0);
+
+    std::unique_ptr<progress_meter::ProgressMeter> progress_meter;
+    if (progress) {
+        progress_meter = std::make_unique<progress_meter::ProgressMeter>(
+                handles.size(), "[odgi::path_presence] building the path presence matrix");
+    }
+    // each node's row is written by a single thread
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (uint64_t i = 0; i < handles.size(); ++i) {
+        const uint64_t rank = rank_of(handles[i]);
+        uint64_t* row = &bits[rank * words_per_node];
+        graph.for_each_step_on_handle(
+            handles[i],
+            [&](const step_handle_t& s) {
+                const uint64_t column = path_columns[as_integer(graph.get_path_handle_of_step(s))];
+                if (column == no_column) {
+                    return;
+                }
+                const uint64_t bit = 1ull << (column & 63);
+                if (row[column >> 6] & bit) {
+                    repeats[rank] = 1;
+                }
+                row[column >> 6] |= bit;
+            });
+        if (progress) {
+            progress_meter->increment(1);
+        }
+    }
+    if (progress) {
+        progress_meter->finish();
+    }
+}
+
+uint64_t path_presence_t::column_count_on(const uint64_t& rank) const {
+    const uint64_t* row = node_row(rank);
+    uint64_t count = 0;
+    for (uint64_t w = 0; w < words_per_node; ++w) {
+        count += __builtin_popcountll(row[w]);
+    }
+    return count;
+}
+
+std::vector<uint64_t> path_presence_t::column_rows() const {
+    const uint64_t words_per_column = words_for(node_count);
+    std::vector<uint64_t> columns(column_count * words_per_column, 0);
+    // blocks of 8 words of node bits, so that no two threads write to the same cache line
+    const uint64_t block_words = 8;
+#pragma omp parallel for schedule(dynamic, 1)
+    for (uint64_t block = 0; block < words_per_column; block += block_words) {
+        const uint64_t end = std::min(node_count, (block + block_words) * 64);
+        for (uint64_t rank = block * 64; rank < end; ++rank) {
+            for_each_column_on(rank, [&](const uint64_t& column) {
+                columns[column * words_per_column + (rank >> 6)] |= 1ull << (rank & 63);
+            });
+        }
+    }
+    return columns;
+}
+
+uint64_t path_presence_t::fingerprint(const PathHandleGraph& graph, const std::vector<uint64_t>& path_columns,
+                                      const uint64_t& column_count) {
+    uint64_t columns = 0;
+    graph.for_each_path_handle([&](const path_handle_t& p) {
+        columns += mix64(mix64(as_integer(p)) ^ path_columns[as_integer(p)]);
+    });
+    return mix64(graph_fingerprint(graph) ^ column_count) ^ mix64(columns);
+}
+
+void path_presence_t::serialize(std::ostream& out, const uint64_t& fingerprint) const {
+    sdsl::write_member(path_presence_magic, out);
+    sdsl::write_member(path_presence_version, out);
+    sdsl::write_member(fingerprint, out);
+    sdsl::write_member(node_count, out);
+    sdsl::write_member(column_count, out);
+    out.write(reinterpret_cast<const char*>(bits.data()), bits.size() * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(repeats.data()), repeats.size());
+}
+
+bool path_presence_t::load(std::istream& in, const uint64_t& fingerprint) {
+    uint64_t magic = 0, version = 0, stored_fingerprint = 0;
+    sdsl::read_member(magic, in);
+    sdsl::read_member(version, in);
+    sdsl::read_member(stored_fingerprint, in);
+    if (!in || magic != path_presence_magic || version != path_presence_version
+        || stored_fingerprint != fingerprint) {
+        return false;
+    }
+    sdsl::read_member(node_count, in);
+    sdsl::read_member(column_count, in);
+    words_per_node = words_for(column_count);
+    bits.resize(node_count * words_per_node);
+    repeats.resize(node_count);
+    in.read(reinterpret_cast<char*>(bits.data()), bits.size() * sizeof(uint64_t));
+    in.read(reinterpret_cast<char*>(repeats.data()), repeats.size());
+    return (bool)in;
+}
+
+void load_or_build_path_presence(path_presence_t& presence,
+                                 const PathHandleGraph& graph,
+                                 const std::vector<uint64_t>& path_columns,
+                                 const uint64_t& column_count,
+                                 const std::string& graph_file,
+                                 const bool& progress) {
+    const uint64_t fingerprint = graph_file.empty() ? 0
+        : path_presence_t::fingerprint(graph, path_columns, column_count);
+    const std::string cache_file = graph_file.empty() ? ""
+        : index_cache_file(graph_file, "presence", fingerprint);
+    if (!cache_file.empty()) {
+        std::ifstream in(cache_file, std::ios::binary);
+        if (in && presence.load(in, fingerprint)) {
+            if (progress) {
+                std::cerr << "[odgi::path_presence] loaded the path presence matrix from " << cache_file << std::endl;
+            }
+            return;
+        }
+    }
+    presence.build(graph, path_columns, column_count, progress);
+    if (!cache_file.empty()
+        && !write_index_cache(cache_file, [&](std::ostream& out) { presence.serialize(out, fingerprint); })) {
+        std::cerr << "[odgi::path_presence] warning: cannot write the path presence matrix to "
+                  << cache_file << "." << std::endl;
+    }
+}
+
+}
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include <handlegraph/types.hpp>
+#include <handlegraph/util.hpp>
+#include <handlegraph/path_handle_graph.hpp>
+#include "progress.hpp"
+
+namespace odgi {
+
+namespace algorithms {
+
+using namespace handlegraph;
+
+/// Which columns (paths or groups of paths) step on each node, as a bit matrix with one row per
+/// node. Nodes are ranked by the number in their handles, which is id - 1 on compacted graphs;
+/// the ranks that hold no node, on graphs with gaps in their ids, have empty rows.
+class path_presence_t {
+public:
+    /// the column of the paths that are left out
+    static constexpr uint64_t no_column = std::numeric_limits<uint64_t>::max();
+    /// the commands fall back to walking the paths when the matrix would need more than this
+    static constexpr uint64_t default_max_bytes = 1ull << 32;
+
+    static uint64_t words_for(const uint64_t& bit_count) { return (bit_count + 63) / 64; }
+    static uint64_t bytes_needed(const uint64_t& node_count, const uint64_t& column_count) {
+        return node_count * (words_for(column_count) * sizeof(uint64_t) + 1);
+    }
+
+    /// path_columns maps each path, by as_integer, to its column or to no_column
+    void build(const PathHandleGraph& graph, const std::vector<uint64_t>& path_columns,
+               const uint64_t& column_count, const bool& progress);
+
+    /// the row of the node of a handle
+    static uint64_t rank_of(const handle_t& handle) { return number_bool_packing::unpack_number(handle); }
+
+    /// the number of rows, one past the highest rank of a node
+    uint64_t get_node_count() const { return node_count; }
+    uint64_t get_column_count() const { return column_count; }
+    uint64_t get_words_per_node() const { return words_per_node; }
+    const uint64_t* node_row(const uint64_t& rank) const { return &bits[rank * words_per_node]; }
+    bool is_present(const uint64_t& rank, const uint64_t& column) const {
+        return (node_row(rank)[column >> 6] >> (column & 63)) & 1;
+    }
+    /// does a column step on the node more than once?
+    bool has_repeats(const uint64_t& rank) const { return repeats[rank]; }
+    /// how many columns step on the node
+    uint64_t column_count_on(const uint64_t& rank) const;
+    template<typename Func>
+    void for_each_column_on(const uint64_t& rank, const Func& func) const {
+        const uint64_t* row = node_row(rank);
+        for (uint64_t w = 0; w < words_per_node; ++w) {
+            for (uint64_t word = row[w]; word; word &= word - 1) {
+                func(w * 64 + __builtin_ctzll(word));
+            }
+        }
+    }
+
+    /// The transposed matrix, with one row of words_for(node count) words of node bits per column
+    std::vector<uint64_t> column_rows() const;
+
+    /// Summarizes the nodes, paths and columns the matrix is built from, to check a cached one
+    static uint64_t fingerprint(const PathHandleGraph& graph, const std::vector<uint64_t>& path_columns,
+                                const uint64_t& column_count);
+    void serialize(std::ostream& out, const uint64_t& fingerprint) const;
+    /// false if the stream does not hold a matrix with this fingerprint
+    bool load(std::istream& in, const uint64_t& fingerprint);
+
+private:
+    uint64_t node_count = 0;
+    uint64_t column_count = 0;
+    uint64_t words_per_node = 0;
+    std::vector<uint64_t> bits;
+    std::vector<uint8_t> repeats;
+};
+
+/// Load the matrix from its cache next to graph_file if one was built for the same graph and
+/// columns, or else build it and, if graph_file is not empty, cache it there for the next run
+void load_or_build_path_presence(path_presence_t& presence,
+                                 const PathHandleGraph& graph,
+                                 const std::vector<uint64_t>& path_columns,
+                                 const uint64_t& column_count,
+                                 const std::string& graph_file,
+                                 const bool& progress);
+
+}
+
+}
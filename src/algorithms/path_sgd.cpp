@@ -1,6 +1,7 @@
 #include "path_sgd.hpp"
 #include "dirty_zipfian_int_distribution.h"
 #include "layout.hpp"
+#include "sgd_term_batch.hpp"
 
 //#define debug_path_sgd
 // #define eval_path_sgd
@@ -28,7 +29,8 @@ namespace odgi {
                                             const bool &snapshot,
                                             std::vector<std::string> &snapshots,
 											const bool &target_sorting,
-											std::vector<bool>& target_nodes) {
+											std::vector<bool>& target_nodes,
+											const sgd_checkpointing_t &checkpointing) {
 #ifdef debug_path_sgd
             std::cerr << "iter_max: " << iter_max << std::endl;
             std::cerr << "min_term_updates: " << min_term_updates << std::endl;
@@ -157,6 +159,52 @@ namespace odgi {
                 work_todo.store(true);
                 // approximately what iteration we're on
                 uint64_t iteration = 0;
+                // pick up the coordinates, the schedule and the random states of the checkpoint
+                if (checkpointing.resume) {
+                    const sgd_checkpoint_t &resume = *checkpointing.resume;
+                    const std::string mismatch = resume.mismatch("path_linear_sgd", X.size(), 0, nthreads, etas.size());
+                    if (!mismatch.empty()) {
+                        std::cerr << "[odgi::path_linear_sgd] error: cannot resume: " << mismatch << std::endl;
+                        exit(1);
+                    }
+                    for (uint64_t i = 0; i < X.size(); ++i) {
+                        X[i].store(resume.X[i]);
+                    }
+                    etas = resume.etas;
+                    iteration = resume.iteration;
+                    eta.store(etas[iteration]);
+                    Delta_max.store(delta);
+                    if (iteration > first_cooling_iteration) {
+                        adj_theta.store(0.001);
+                        cooling.store(true);
+                    }
+                }
+                // are the workers handing their state to a checkpoint?
+                std::atomic<bool> checkpoint_in_progress;
+                checkpoint_in_progress.store(false);
+                std::atomic<uint64_t> workers_paused;
+                workers_paused.store(0);
+                std::vector<std::array<uint64_t, 4>> rng_states(nthreads);
+                bool checkpoint_due = false;
+                // pause the workers between two of their batches, and write what they left
+                auto write_checkpoint =
+                        [&]() {
+                            workers_paused.store(0);
+                            checkpoint_in_progress.store(true);
+                            while (workers_paused.load() < nthreads) {
+                                std::this_thread::sleep_for(1ms);
+                            }
+                            sgd_checkpoint_t checkpoint;
+                            checkpoint.engine = "path_linear_sgd";
+                            checkpoint.iteration = iteration;
+                            checkpoint.etas = etas;
+                            checkpoint.rng_states = rng_states;
+                            for (auto &x : X) {
+                                checkpoint.X.push_back(x.load());
+                            }
+                            checkpointing.write(checkpoint);
+                            checkpoint_in_progress.store(false);
+                        };
                 // launch a thread to update the learning rate, count iterations, and decide when to stop
                 auto checker_lambda =
                         [&]() {
@@ -191,22 +239,32 @@ namespace odgi {
                                     } else {
                                         eta.store(etas[iteration]); // update our learning rate
                                         Delta_max.store(delta); // set our delta max to the threshold
+                                        checkpoint_due = checkpointing.due(iteration) && iteration < iter_max;
                                         if (iteration > first_cooling_iteration) {
                                             adj_theta.store(0.001);
                                             cooling.store(true);
                                         }
                                     }
                                     term_updates.store(0);
+                                    if (checkpoint_due) {
+                                        write_checkpoint();
+                                        checkpoint_due = false;
+                                    }
                                 }
                                 std::this_thread::sleep_for(1ms);
                             }
                         };
 
+                // the term update for the vector instructions of this CPU
+                const sgd_term_batch_kernels_t &kernels = sgd_term_batch_kernels();
                 auto worker_lambda =
                         [&](uint64_t tid) {
                             // everyone tries to seed with their own random data
                             const std::uint64_t seed = 9399220 + tid;
                             XoshiroCpp::Xoshiro256Plus gen(seed); // a nice, fast PRNG
+                            if (checkpointing.resume) {
+                                gen.deserialize(checkpointing.resume->rng_states[tid]);
+                            }
                             // some references to literal bitvectors in the path index hmmm
                             const sdsl::bit_vector &np_bv = path_index.get_np_bv();
                             const sdsl::int_vector<> &nr_iv = path_index.get_nr_iv();
@@ -215,7 +273,53 @@ namespace odgi {
                             std::uniform_int_distribution<uint64_t> dis_step = std::uniform_int_distribution<uint64_t>(0, np_bv.size() - 1);
                             std::uniform_int_distribution<uint64_t> flip(0, 1);
                             uint64_t term_updates_local = 0;
+                            // terms are applied in batches: we gather the positions of their nodes,
+                            // compute all their updates in one vectorized kernel, and move the nodes
+                            sgd_term_batch_t batch;
+                            auto apply_batch = [&]() {
+                                if (batch.size == 0) {
+                                    return;
+                                }
+                                for (uint64_t k = 0; k < batch.size; ++k) {
+                                    // distance == magnitude in our 1D situation
+                                    batch.dx[k] = X[batch.i[k]].load() - X[batch.j[k]].load();
+                                }
+                                // check distances for early stopping
+                                double Delta_abs = kernels.update_1d(batch.size, eta.load(), batch.d, batch.dx, batch.r_x);
+                                // try until we succeed. risky.
+                                while (Delta_abs > Delta_max.load()) {
+                                    Delta_max.store(Delta_abs);
+                                }
+                                // update our positions (atomically)
+                                for (uint64_t k = 0; k < batch.size; ++k) {
+                                    if (batch.update_i[k]) {
+                                        X[batch.i[k]].store(X[batch.i[k]].load() - batch.r_x[k]);
+                                    }
+                                    if (batch.update_j[k]) {
+                                        X[batch.j[k]].store(X[batch.j[k]].load() + batch.r_x[k]);
+                                    }
+                                }
+                                term_updates_local += batch.size;
+                                batch.size = 0;
+                                if (term_updates_local >= 1000) {
+                                    term_updates += term_updates_local;
+                                    if (progress) {
+                                        progress_meter->increment(term_updates_local);
+                                    }
+                                    term_updates_local = 0;
+                                }
+                            };
                             while (work_todo.load()) {
+                                if (checkpoint_in_progress.load()) {
+                                    // hand our state to the checkpoint, and wait until it is written
+                                    apply_batch();
+                                    rng_states[tid] = gen.serialize();
+                                    workers_paused++;
+                                    while (checkpoint_in_progress.load()) {
+                                        std::this_thread::sleep_for(1ms);
+                                    }
+                                    continue;
+                                }
                                 if (!snapshot_in_progress.load()) {
                                     // sample the first node from all the nodes in the graph
                                     // pick a random position from all paths
@@ -330,18 +434,6 @@ namespace odgi {
 #ifdef debug_path_sgd
                                     std::cerr << "term_dist: " << term_dist << std::endl;
 #endif
-                                    double term_weight = 1.0 / term_dist;
-
-                                    double w_ij = term_weight;
-#ifdef debug_path_sgd
-                                    std::cerr << "w_ij = " << w_ij << std::endl;
-#endif
-                                    double mu = eta.load() * w_ij;
-                                    if (mu > 1) {
-                                        mu = 1;
-                                    }
-                                    // actual distance in graph
-                                    double d_ij = term_dist;
                                     // identities
                                     uint64_t i = number_bool_packing::unpack_number(term_i);
                                     uint64_t j = number_bool_packing::unpack_number(term_j);
@@ -349,61 +441,18 @@ namespace odgi {
                                     #pragma omp critical (cerr)
                                 std::cerr << "nodes are " << graph.get_id(term_i) << " and " << graph.get_id(term_j) << std::endl;
 #endif
-                                    // distance == magnitude in our 1D situation
-                                    double dx = X[i].load() - X[j].load();
-                                    if (dx == 0) {
-                                        dx = 1e-9; // avoid nan
-                                    }
-#ifdef debug_path_sgd
-                                    #pragma omp critical (cerr)
-                                std::cerr << "distance is " << dx << " but should be " << d_ij << std::endl;
-#endif
-                                    //double mag = dx; //sqrt(dx*dx + dy*dy);
-                                    double mag = std::abs(dx);
-#ifdef debug_path_sgd
-                                    std::cerr << "mu " << mu << " mag " << mag << " d_ij " << d_ij << std::endl;
-#endif
-                                    // check distances for early stopping
-                                    double Delta = mu * (mag - d_ij) / 2;
-                                    // try until we succeed. risky.
-                                    double Delta_abs = std::abs(Delta);
-#ifdef debug_path_sgd
-                                    #pragma omp critical (cerr)
-                                std::cerr << "Delta_abs " << Delta_abs << std::endl;
-#endif
-                                    while (Delta_abs > Delta_max.load()) {
-                                        Delta_max.store(Delta_abs);
-                                    }
-                                    // calculate update
-                                    double r = Delta / mag;
-                                    double r_x = r * dx;
-#ifdef debug_path_sgd
-                                    #pragma omp critical (cerr)
-                                std::cerr << "r_x is " << r_x << std::endl;
-#endif
-                                    // update our positions (atomically)
-#ifdef debug_path_sgd
-                                    std::cerr << "before X[i] " << X[i].load() << " X[j] " << X[j].load() << std::endl;
-#endif
-									if (update_term_i) {
-										X[i].store(X[i].load() - r_x);
-									}
-									if (update_term_j) {
-										X[j].store(X[j].load() + r_x);
-									}
-#ifdef debug_path_sgd
-                                    std::cerr << "after X[i] " << X[i].load() << " X[j] " << X[j].load() << std::endl;
-#endif
-                                    term_updates_local++;
-                                    if (term_updates_local >= 1000) {
-                                        term_updates += term_updates_local;
-                                        if (progress) {
-                                            progress_meter->increment(term_updates_local);
-                                        }
-                                        term_updates_local = 0;
+                                    // queue the term, and apply the batch once it is full
+                                    batch.i[batch.size] = i;
+                                    batch.j[batch.size] = j;
+                                    batch.update_i[batch.size] = update_term_i;
+                                    batch.update_j[batch.size] = update_term_j;
+                                    batch.d[batch.size] = term_dist;
+                                    if (++batch.size == sgd_term_batch_size) {
+                                        apply_batch();
                                     }
                                 }
                             }
+                            apply_batch();
                         };
 
                 auto snapshot_lambda =
@@ -523,7 +572,8 @@ namespace odgi {
                                                     const bool &write_layout,
                                                     const std::string &layout_out,
 													const bool &target_sorting,
-													std::vector<bool>& target_nodes) {
+													std::vector<bool>& target_nodes,
+													const sgd_checkpointing_t &checkpointing) {
             std::vector<string> snapshots;
             std::vector<double> layout = path_linear_sgd(graph,
                                                          path_index,
@@ -544,14 +594,15 @@ namespace odgi {
                                                          snapshot,
                                                          snapshots,
 														 target_sorting,
-														 target_nodes);
+														 target_nodes,
+														 checkpointing);
             // TODO move the following into its own function that we can reuse
 #ifdef debug_components
             std::cerr << "node count: " << graph.get_node_count() << std::endl;
 #endif
             // refine order by weakly connected components
             std::vector<ska::flat_hash_set<handlegraph::nid_t>> weak_components = algorithms::weakly_connected_components(
-                    &graph);
+                    &graph, nthreads);
 #ifdef debug_components
             std::cerr << "components count: " << weak_components.size() << std::endl;
 #endif
@@ -21,6 +21,7 @@
 #include "dirty_zipfian_int_distribution.h"
 #include "XoshiroCpp.hpp"
 #include "progress.hpp"
+#include "sgd_checkpoint.hpp"
 #include "utils.hpp"
 
 #include <fstream>
@@ -85,7 +86,8 @@ std::vector<handle_t> path_linear_sgd_order(const graph_t &graph,
                                             const bool &write_layout,
                                             const std::string &layout_out,
 											const bool &target_sorting,
-											std::vector<bool>& target_nodes);
+											std::vector<bool>& target_nodes,
+											const sgd_checkpointing_t &checkpointing = sgd_checkpointing_t());
 
 }
 
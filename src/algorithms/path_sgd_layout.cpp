@@ -1,5 +1,6 @@
 #include "path_sgd_layout.hpp"
 #include "algorithms/layout.hpp"
+#include "sgd_term_batch.hpp"
 
 namespace odgi {
     namespace algorithms {
@@ -23,7 +24,8 @@ namespace odgi {
                                     const bool &snapshot,
                                     const std::string &snapshot_prefix,
                                     std::vector<std::atomic<double>> &X,
-                                    std::vector<std::atomic<double>> &Y) {
+                                    std::vector<std::atomic<double>> &Y,
+                                    const sgd_checkpointing_t &checkpointing) {
 #ifdef debug_path_sgd
             std::cerr << "iter_max: " << iter_max << std::endl;
             std::cerr << "min_term_updates: " << min_term_updates << std::endl;
@@ -116,6 +118,56 @@ namespace odgi {
                 work_todo.store(true);
                 // approximately what iteration we're on
                 uint64_t iteration = 0;
+                // pick up the coordinates, the schedule and the random states of the checkpoint
+                if (checkpointing.resume) {
+                    const sgd_checkpoint_t &resume = *checkpointing.resume;
+                    const std::string mismatch = resume.mismatch("path_linear_sgd_layout", X.size(), Y.size(), nthreads, etas.size());
+                    if (!mismatch.empty()) {
+                        std::cerr << "[odgi::path_linear_sgd_layout] error: cannot resume: " << mismatch << std::endl;
+                        exit(1);
+                    }
+                    for (uint64_t i = 0; i < X.size(); ++i) {
+                        X[i].store(resume.X[i]);
+                        Y[i].store(resume.Y[i]);
+                    }
+                    etas = resume.etas;
+                    iteration = resume.iteration;
+                    eta.store(etas[iteration]);
+                    Delta_max.store(delta);
+                    if (iteration >= first_cooling_iteration) {
+                        adj_theta.store(0.001);
+                        cooling.store(true);
+                    }
+                }
+                // are the workers handing their state to a checkpoint?
+                std::atomic<bool> checkpoint_in_progress;
+                checkpoint_in_progress.store(false);
+                std::atomic<uint64_t> workers_paused;
+                workers_paused.store(0);
+                std::vector<std::array<uint64_t, 4>> rng_states(nthreads);
+                bool checkpoint_due = false;
+                // pause the workers between two of their batches, and write what they left
+                auto write_checkpoint =
+                        [&]() {
+                            workers_paused.store(0);
+                            checkpoint_in_progress.store(true);
+                            while (workers_paused.load() < nthreads) {
+                                std::this_thread::sleep_for(1ms);
+                            }
+                            sgd_checkpoint_t checkpoint;
+                            checkpoint.engine = "path_linear_sgd_layout";
+                            checkpoint.iteration = iteration;
+                            checkpoint.etas = etas;
+                            checkpoint.rng_states = rng_states;
+                            for (auto &x : X) {
+                                checkpoint.X.push_back(x.load());
+                            }
+                            for (auto &y : Y) {
+                                checkpoint.Y.push_back(y.load());
+                            }
+                            checkpointing.write(checkpoint);
+                            checkpoint_in_progress.store(false);
+                        };
                 // launch a thread to update the learning rate, count iterations, and decide when to stop
                 auto checker_lambda =
                         [&]() {
@@ -150,6 +202,7 @@ namespace odgi {
                                     } else {
                                         eta.store(etas[iteration]); // update our learning rate
                                         Delta_max.store(delta); // set our delta max to the threshold
+                                        checkpoint_due = checkpointing.due(iteration) && iteration < iter_max;
                                         if (iteration >= first_cooling_iteration) {
                                             //std::cerr << std::endl << "setting cooling!!" << std::endl;
                                             adj_theta.store(0.001);
@@ -157,16 +210,25 @@ namespace odgi {
                                         }
                                     }
                                     term_updates.store(0);
+                                    if (checkpoint_due) {
+                                        write_checkpoint();
+                                        checkpoint_due = false;
+                                    }
                                 }
                                 std::this_thread::sleep_for(1ms);
                             }
                         };
 
+                // the term update for the vector instructions of this CPU
+                const sgd_term_batch_kernels_t &kernels = sgd_term_batch_kernels();
                 auto worker_lambda =
                         [&](uint64_t tid) {
                             // everyone tries to seed with their own random data
                             const std::uint64_t seed = 9399220 + tid;
                             XoshiroCpp::Xoshiro256Plus gen(seed); // a nice, fast PRNG
+                            if (checkpointing.resume) {
+                                gen.deserialize(checkpointing.resume->rng_states[tid]);
+                            }
                             // some references to literal bitvectors in the path index hmmm
                             const sdsl::bit_vector &np_bv = path_index.get_np_bv();
                             const sdsl::int_vector<> &nr_iv = path_index.get_nr_iv();
@@ -175,7 +237,55 @@ namespace odgi {
                             std::uniform_int_distribution<uint64_t> dis_step = std::uniform_int_distribution<uint64_t>(0, np_bv.size() - 1);
                             std::uniform_int_distribution<uint64_t> flip(0, 1);
                             uint64_t term_updates_local = 0;
+                            // terms are applied in batches: we gather the coordinates of their node
+                            // ends, compute all their updates in one vectorized kernel, and move the ends
+                            sgd_term_batch_t batch;
+                            auto apply_batch = [&]() {
+                                if (batch.size == 0) {
+                                    return;
+                                }
+                                for (uint64_t k = 0; k < batch.size; ++k) {
+                                    // distance == magnitude in our 2D situation
+                                    batch.dx[k] = X[batch.i[k]].load() - X[batch.j[k]].load();
+                                    batch.dy[k] = Y[batch.i[k]].load() - Y[batch.j[k]].load();
+                                }
+                                // check distances for early stopping
+                                double Delta_abs = kernels.update_2d(batch.size, eta.load(), batch.d,
+                                                                     batch.dx, batch.dy, batch.r_x, batch.r_y);
+                                // todo use atomic compare and swap
+                                while (Delta_abs > Delta_max.load()) {
+                                    Delta_max.store(Delta_abs);
+                                }
+                                // update our positions (atomically)
+                                for (uint64_t k = 0; k < batch.size; ++k) {
+                                    const uint64_t i = batch.i[k];
+                                    const uint64_t j = batch.j[k];
+                                    X[i].store(X[i].load() - batch.r_x[k]);
+                                    Y[i].store(Y[i].load() - batch.r_y[k]);
+                                    X[j].store(X[j].load() + batch.r_x[k]);
+                                    Y[j].store(Y[j].load() + batch.r_y[k]);
+                                }
+                                term_updates_local += batch.size;
+                                batch.size = 0;
+                                if (term_updates_local >= 1000) {
+                                    term_updates += term_updates_local;
+                                    if (progress) {
+                                        progress_meter->increment(term_updates_local);
+                                    }
+                                    term_updates_local = 0;
+                                }
+                            };
                             while (work_todo.load()) {
+                                if (checkpoint_in_progress.load()) {
+                                    // hand our state to the checkpoint, and wait until it is written
+                                    apply_batch();
+                                    rng_states[tid] = gen.serialize();
+                                    workers_paused++;
+                                    while (checkpoint_in_progress.load()) {
+                                        std::this_thread::sleep_for(1ms);
+                                    }
+                                    continue;
+                                }
                                 if (!snapshot_in_progress.load()) {
                                     // sample the first node from all the nodes in the graph
                                     // pick a random position from all paths
@@ -291,18 +401,6 @@ namespace odgi {
 #ifdef debug_path_sgd
                                     std::cerr << "term_dist: " << term_dist << std::endl;
 #endif
-                                    double term_weight = 1.0 / (double) term_dist;
-
-                                    double w_ij = term_weight;
-#ifdef debug_path_sgd
-                                    std::cerr << "w_ij = " << w_ij << std::endl;
-#endif
-                                    double mu = eta.load() * w_ij;
-                                    if (mu > 1) {
-                                        mu = 1;
-                                    }
-                                    // actual distance in graph
-                                    double d_ij = term_dist;
                                     // identities
                                     uint64_t i = number_bool_packing::unpack_number(term_i);
                                     uint64_t j = number_bool_packing::unpack_number(term_j);
@@ -310,7 +408,6 @@ namespace odgi {
                                     #pragma omp critical (cerr)
                                 std::cerr << "nodes are " << graph.get_id(term_i) << " and " << graph.get_id(term_j) << std::endl;
 #endif
-                                    // distance == magnitude in our 2D situation
                                     uint64_t offset_i = 0;
                                     uint64_t offset_j = 0;
                                     if (use_other_end_a) {
@@ -319,61 +416,16 @@ namespace odgi {
                                     if (use_other_end_b) {
                                         offset_j += 1;
                                     }
-                                    double dx = X[2 * i + offset_i].load() - X[2 * j + offset_j].load();
-                                    double dy = Y[2 * i + offset_i].load() - Y[2 * j + offset_j].load();
-                                    if (dx == 0) {
-                                        dx = 1e-9; // avoid nan
-                                    }
-#ifdef debug_path_sgd
-                                    #pragma omp critical (cerr)
-                                std::cerr << "distance is " << dx << " but should be " << d_ij << std::endl;
-#endif
-                                    //double mag = dx; //sqrt(dx*dx + dy*dy);
-                                    double mag = sqrt(dx * dx + dy * dy);
-#ifdef debug_path_sgd
-                                    std::cerr << "mu " << mu << " mag " << mag << " d_ij " << d_ij << std::endl;
-#endif
-                                    // check distances for early stopping
-                                    double Delta = mu * (mag - d_ij) / 2;
-                                    // try until we succeed. risky.
-                                    double Delta_abs = std::abs(Delta);
-#ifdef debug_path_sgd
-                                    #pragma omp critical (cerr)
-                                std::cerr << "Delta_abs " << Delta_abs << std::endl;
-#endif
-                                    // todo use atomic compare and swap
-                                    while (Delta_abs > Delta_max.load()) {
-                                        Delta_max.store(Delta_abs);
-                                    }
-                                    // calculate update
-                                    double r = Delta / mag;
-                                    double r_x = r * dx;
-                                    double r_y = r * dy;
-#ifdef debug_path_sgd
-                                    #pragma omp critical (cerr)
-                                std::cerr << "r_x is " << r_x << std::endl;
-#endif
-                                    // update our positions (atomically)
-#ifdef debug_path_sgd
-                                    std::cerr << "before X[i] " << X[i].load() << " X[j] " << X[j].load() << std::endl;
-#endif
-                                    X[2 * i + offset_i].store(X[2 * i + offset_i].load() - r_x);
-                                    Y[2 * i + offset_i].store(Y[2 * i + offset_i].load() - r_y);
-                                    X[2 * j + offset_j].store(X[2 * j + offset_j].load() + r_x);
-                                    Y[2 * j + offset_j].store(Y[2 * j + offset_j].load() + r_y);
-#ifdef debug_path_sgd
-                                    std::cerr << "after X[i] " << X[i].load() << " X[j] " << X[j].load() << std::endl;
-#endif
-                                    term_updates_local++;
-                                    if (term_updates_local >= 1000) {
-                                        term_updates += term_updates_local;
-                                        if (progress) {
-                                            progress_meter->increment(term_updates_local);
-                                        }
-                                        term_updates_local = 0;
+                                    // queue the term, and apply the batch once it is full
+                                    batch.i[batch.size] = 2 * i + offset_i;
+                                    batch.j[batch.size] = 2 * j + offset_j;
+                                    batch.d[batch.size] = term_dist;
+                                    if (++batch.size == sgd_term_batch_size) {
+                                        apply_batch();
                                     }
                                 }
                             }
+                            apply_batch();
                         };
 
                 auto snapshot_lambda =
@@ -19,6 +19,7 @@
 #include "dirty_zipfian_int_distribution.h"
 #include "XoshiroCpp.hpp"
 #include "progress.hpp"
+#include "sgd_checkpoint.hpp"
 #ifdef USE_GPU
 #include "cuda/layout.h"
 #endif
@@ -48,7 +49,8 @@ namespace odgi {
                                     const bool &snapshot,
                                     const std::string &snapshot_prefix,
                                     std::vector<std::atomic<double>> &X,
-                                    std::vector<std::atomic<double>> &Y);
+                                    std::vector<std::atomic<double>> &Y,
+                                    const sgd_checkpointing_t &checkpointing = sgd_checkpointing_t());
 
 /// our learning schedule
         std::vector<double> path_linear_sgd_layout_schedule(const double &w_min,
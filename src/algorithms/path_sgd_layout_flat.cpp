@@ -0,0 +1,372 @@
+#include "path_sgd_layout_flat.hpp"
+#include "path_sgd_layout.hpp"
+#include "sgd_term_batch.hpp"
+#include "algorithms/layout.hpp"
+#include "progress.hpp"
+#include "dirty_zipfian_int_distribution.h"
+#include "XoshiroCpp.hpp"
+
+#include <omp.h>
+#include <cmath>
+#include <memory>
+#include <fstream>
+#include <limits>
+
+namespace odgi {
+    namespace algorithms {
+
+        namespace flat_sgd {
+
+            void build_layout_data(layout_data_t &data,
+                                   const PathHandleGraph &graph,
+                                   const xp::XP &path_index,
+                                   const std::vector<path_handle_t> &path_sgd_use_paths,
+                                   const std::vector<std::atomic<double>> &X,
+                                   const std::vector<std::atomic<double>> &Y,
+                                   const uint64_t &nthreads) {
+                const uint64_t node_count = graph.get_node_count();
+                if (node_count > std::numeric_limits<uint32_t>::max()
+                    || path_sgd_use_paths.size() > std::numeric_limits<uint32_t>::max()) {
+                    std::cerr << "[odgi::path_linear_sgd_layout_flat] error: the flat layout engine supports up to "
+                              << std::numeric_limits<uint32_t>::max() << " nodes and paths." << std::endl;
+                    exit(1);
+                }
+
+                // nodes, with the coordinates of both ends
+                data.nodes = std::vector<node_t>(node_count);
+                graph.for_each_handle([&](const handle_t &h) {
+                    const uint64_t i = number_bool_packing::unpack_number(h);
+                    node_t &node = data.nodes[i];
+                    node.seq_length = graph.get_length(h);
+                    node.coords[0].store(X[2 * i].load(), std::memory_order_relaxed);
+                    node.coords[1].store(Y[2 * i].load(), std::memory_order_relaxed);
+                    node.coords[2].store(X[2 * i + 1].load(), std::memory_order_relaxed);
+                    node.coords[3].store(Y[2 * i + 1].load(), std::memory_order_relaxed);
+                }, true);
+
+                // paths that can give a term, and where their steps go
+                std::vector<path_handle_t> paths;
+                data.paths.clear();
+                uint64_t step_count = 0;
+                for (auto &path : path_sgd_use_paths) {
+                    const uint64_t path_step_count = path_index.get_path_step_count(path);
+                    if (path_step_count > 1) {
+                        paths.push_back(path);
+                        data.paths.push_back({path_step_count, step_count});
+                        step_count += path_step_count;
+                    }
+                }
+
+                // the steps, with their nodes and positions from the path index
+                data.steps.resize(step_count);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads)
+                for (uint64_t p = 0; p < paths.size(); ++p) {
+                    const path_t &path = data.paths[p];
+                    step_handle_t step;
+                    as_integers(step)[0] = as_integer(paths[p]);
+                    for (uint64_t j = 0; j < path.step_count; ++j) {
+                        as_integers(step)[1] = j;
+                        const handle_t h = path_index.get_handle_of_step(step);
+                        // 1-based, so that the sign marks the strand of every step
+                        const int64_t pos = path_index.get_position_of_step(step) + 1;
+                        path_element_t &element = data.steps[path.first_step + j];
+                        element.pidx = p;
+                        element.node_id = number_bool_packing::unpack_number(h);
+                        element.pos = number_bool_packing::unpack_bit(h) ? -pos : pos;
+                    }
+                }
+            }
+
+            void get_coordinates(const layout_data_t &data,
+                                 std::vector<double> &X,
+                                 std::vector<double> &Y) {
+                X.resize(2 * data.nodes.size());
+                Y.resize(2 * data.nodes.size());
+                for (uint64_t i = 0; i < data.nodes.size(); ++i) {
+                    for (uint64_t end = 0; end < 2; ++end) {
+                        X[2 * i + end] = data.nodes[i].coords[2 * end].load(std::memory_order_relaxed);
+                        Y[2 * i + end] = data.nodes[i].coords[2 * end + 1].load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            void store_coordinates(const layout_data_t &data,
+                                   std::vector<std::atomic<double>> &X,
+                                   std::vector<std::atomic<double>> &Y) {
+                for (uint64_t i = 0; i < data.nodes.size(); ++i) {
+                    const node_t &node = data.nodes[i];
+                    X[2 * i].store(node.coords[0].load(std::memory_order_relaxed));
+                    Y[2 * i].store(node.coords[1].load(std::memory_order_relaxed));
+                    X[2 * i + 1].store(node.coords[2].load(std::memory_order_relaxed));
+                    Y[2 * i + 1].store(node.coords[3].load(std::memory_order_relaxed));
+                }
+            }
+
+            /// Terms sampled in one go, before their updates. Sampling prefetches the node ends,
+            /// so that they are in cache when the block is applied.
+            static const uint64_t term_block_size = 64;
+            struct term_block_t {
+                std::atomic<float> *a[term_block_size]; // x and y of the first node end
+                std::atomic<float> *b[term_block_size]; // x and y of the second node end
+                alignas(64) double d[term_block_size];  // their distance in the path
+                alignas(64) double dx[term_block_size];
+                alignas(64) double dy[term_block_size];
+                alignas(64) double r_x[term_block_size];
+                alignas(64) double r_y[term_block_size];
+            };
+
+            /// A worker's random stream, on its own cache line
+            struct alignas(64) worker_t {
+                XoshiroCpp::Xoshiro256Plus gen;
+            };
+
+            /// Sample a block of terms as path_linear_sgd_layout does: a uniform step, and a
+            /// second step of the same path at a Zipf-distributed distance, or anywhere on the
+            /// path before cooling starts
+            static void sample_terms(layout_data_t &data,
+                                     const std::vector<double> &zetas,
+                                     const double &theta,
+                                     const uint64_t &space,
+                                     const uint64_t &space_max,
+                                     const uint64_t &space_quantization_step,
+                                     const bool &cooling,
+                                     XoshiroCpp::Xoshiro256Plus &gen,
+                                     term_block_t &block,
+                                     const uint64_t &count) {
+                std::uniform_int_distribution<uint64_t> dis_step(0, data.steps.size() - 1);
+                auto flip = [&gen]() { return (gen() >> 63) == 1; }; // the high bits are the strong ones
+                for (uint64_t k = 0; k < count; ++k) {
+                    const uint64_t step_index = dis_step(gen);
+                    const path_t &path = data.paths[data.steps[step_index].pidx];
+                    const uint64_t s_rank = step_index - path.first_step;
+                    uint64_t t_rank;
+                    if (cooling || flip()) {
+                        const bool backward = s_rank > 0 && flip() || s_rank == path.step_count - 1;
+                        const uint64_t jump_space = std::min(space, backward ? s_rank : path.step_count - s_rank - 1);
+                        uint64_t space_index = jump_space;
+                        if (jump_space > space_max) {
+                            space_index = space_max + (jump_space - space_max) / space_quantization_step + 1;
+                        }
+                        dirtyzipf::dirty_zipfian_int_distribution<uint64_t>::param_type z_p(1, jump_space, theta, zetas[space_index]);
+                        dirtyzipf::dirty_zipfian_int_distribution<uint64_t> z(z_p);
+                        const uint64_t z_i = z(gen);
+                        t_rank = backward ? s_rank - z_i : s_rank + z_i;
+                    } else {
+                        std::uniform_int_distribution<uint64_t> rando(0, path.step_count - 1);
+                        t_rank = rando(gen);
+                    }
+
+                    // pick an end of each node, and measure the distance between the ends in the path
+                    const path_element_t &step_a = data.steps[step_index];
+                    const path_element_t &step_b = data.steps[path.first_step + t_rank];
+                    uint64_t pos_a = std::abs(step_a.pos);
+                    uint64_t pos_b = std::abs(step_b.pos);
+                    bool use_other_end_a = flip();
+                    if (use_other_end_a) {
+                        pos_a += data.nodes[step_a.node_id].seq_length;
+                        use_other_end_a = step_a.pos > 0;
+                    } else {
+                        use_other_end_a = step_a.pos < 0;
+                    }
+                    bool use_other_end_b = flip();
+                    if (use_other_end_b) {
+                        pos_b += data.nodes[step_b.node_id].seq_length;
+                        use_other_end_b = step_b.pos > 0;
+                    } else {
+                        use_other_end_b = step_b.pos < 0;
+                    }
+                    double term_dist = std::abs((double) pos_a - (double) pos_b);
+                    if (term_dist == 0) {
+                        term_dist = 1e-9;
+                    }
+                    block.a[k] = &data.nodes[step_a.node_id].coords[use_other_end_a ? 2 : 0];
+                    block.b[k] = &data.nodes[step_b.node_id].coords[use_other_end_b ? 2 : 0];
+                    block.d[k] = term_dist;
+                    __builtin_prefetch(block.a[k], 1);
+                    __builtin_prefetch(block.b[k], 1);
+                }
+            }
+
+            /// Move the node ends of each term towards their distance in the path, and return
+            /// the largest move
+            static double update_terms(const sgd_term_batch_kernels_t &kernels, term_block_t &block,
+                                       const uint64_t &count, const double &eta) {
+                for (uint64_t k = 0; k < count; ++k) {
+                    block.dx[k] = (double) block.a[k][0].load(std::memory_order_relaxed)
+                        - (double) block.b[k][0].load(std::memory_order_relaxed);
+                    block.dy[k] = (double) block.a[k][1].load(std::memory_order_relaxed)
+                        - (double) block.b[k][1].load(std::memory_order_relaxed);
+                }
+                const double Delta_max = kernels.update_2d(count, eta, block.d, block.dx, block.dy, block.r_x, block.r_y);
+                for (uint64_t k = 0; k < count; ++k) {
+                    std::atomic<float> *a = block.a[k];
+                    std::atomic<float> *b = block.b[k];
+                    a[0].store(a[0].load(std::memory_order_relaxed) - block.r_x[k], std::memory_order_relaxed);
+                    a[1].store(a[1].load(std::memory_order_relaxed) - block.r_y[k], std::memory_order_relaxed);
+                    b[0].store(b[0].load(std::memory_order_relaxed) + block.r_x[k], std::memory_order_relaxed);
+                    b[1].store(b[1].load(std::memory_order_relaxed) + block.r_y[k], std::memory_order_relaxed);
+                }
+                return Delta_max;
+            }
+
+        }
+
+        void path_linear_sgd_layout_flat(const PathHandleGraph &graph,
+                                         const xp::XP &path_index,
+                                         const std::vector<path_handle_t> &path_sgd_use_paths,
+                                         const uint64_t &iter_max,
+                                         const uint64_t &iter_with_max_learning_rate,
+                                         const uint64_t &min_term_updates,
+                                         const double &delta,
+                                         const double &eps,
+                                         const double &eta_max,
+                                         const double &theta,
+                                         const uint64_t &space,
+                                         const uint64_t &space_max,
+                                         const uint64_t &space_quantization_step,
+                                         const double &cooling_start,
+                                         const uint64_t &nthreads,
+                                         const bool &progress,
+                                         const bool &snapshot,
+                                         const std::string &snapshot_prefix,
+                                         std::vector<std::atomic<double>> &X,
+                                         std::vector<std::atomic<double>> &Y,
+                                         const sgd_checkpointing_t &checkpointing) {
+            using namespace flat_sgd;
+
+            const uint64_t first_cooling_iteration = std::floor(cooling_start * (double)iter_max);
+
+            const double w_min = (double) 1.0 / (double) (eta_max);
+            const double w_max = 1.0;
+            // get our schedule
+            std::vector<double> etas = path_linear_sgd_layout_schedule(w_min, w_max, iter_max,
+                                                                       iter_with_max_learning_rate,
+                                                                       eps);
+
+            // pick up the coordinates, the schedule and the random states of the checkpoint
+            uint64_t first_iteration = 0;
+            if (checkpointing.resume) {
+                const sgd_checkpoint_t &resume = *checkpointing.resume;
+                const std::string mismatch = resume.mismatch("path_linear_sgd_layout_flat", X.size(), Y.size(),
+                                                             nthreads, etas.size());
+                if (!mismatch.empty()) {
+                    std::cerr << "[odgi::path_linear_sgd_layout_flat] error: cannot resume: " << mismatch << std::endl;
+                    exit(1);
+                }
+                for (uint64_t i = 0; i < X.size(); ++i) {
+                    X[i].store(resume.X[i]);
+                    Y[i].store(resume.Y[i]);
+                }
+                etas = resume.etas;
+                first_iteration = resume.iteration;
+            }
+
+            layout_data_t data;
+            build_layout_data(data, graph, path_index, path_sgd_use_paths, X, Y, nthreads);
+            if (data.steps.empty()) {
+                // no path with more than one step to sample terms from
+                return;
+            }
+
+            std::unique_ptr<progress_meter::ProgressMeter> progress_meter;
+            if (progress) {
+                progress_meter = std::make_unique<progress_meter::ProgressMeter>(
+                    (iter_max - first_iteration) * min_term_updates, "[odgi::path_linear_sgd_layout_flat] 2D path-guided SGD:");
+            }
+
+            // cache zipf zetas for our full path space
+            std::vector<double> zetas((space <= space_max ? space : space_max + (space - space_max) / space_quantization_step + 1)+1);
+            double zeta_tmp = 0.0;
+            for (uint64_t i = 1; i < space + 1; i++) {
+                zeta_tmp += dirtyzipf::fast_precise_pow(1.0 / i, theta);
+                if (i <= space_max) {
+                    zetas[i] = zeta_tmp;
+                }
+                if (i >= space_max && (i - space_max) % space_quantization_step == 0) {
+                    zetas[space_max + 1 + (i - space_max) / space_quantization_step] = zeta_tmp;
+                }
+            }
+
+            // the term update for the vector instructions of this CPU
+            const sgd_term_batch_kernels_t &kernels = sgd_term_batch_kernels();
+
+            // one stream per thread, jumped apart from a single seed so that they never overlap
+            std::vector<worker_t> workers(nthreads);
+            XoshiroCpp::Xoshiro256Plus gen(9399220);
+            for (auto &worker : workers) {
+                worker.gen = gen;
+                gen.jump();
+            }
+            if (checkpointing.resume) {
+                for (uint64_t t = 0; t < nthreads; ++t) {
+                    workers[t].gen.deserialize(checkpointing.resume->rng_states[t]);
+                }
+            }
+
+            for (uint64_t iteration = first_iteration; iteration < iter_max; ++iteration) {
+                const double eta = etas[iteration];
+                const bool cooling = iteration >= first_cooling_iteration;
+                double Delta_max = 0;
+#pragma omp parallel num_threads(nthreads) reduction(max:Delta_max)
+                {
+                    const uint64_t tid = omp_get_thread_num();
+                    const uint64_t threads = omp_get_num_threads();
+                    uint64_t todo = min_term_updates / threads + (tid < min_term_updates % threads ? 1 : 0);
+                    XoshiroCpp::Xoshiro256Plus &gen = workers[tid].gen;
+                    term_block_t block;
+                    uint64_t term_updates_local = 0;
+                    while (todo > 0) {
+                        const uint64_t count = std::min(todo, term_block_size);
+                        sample_terms(data, zetas, theta, space, space_max, space_quantization_step,
+                                     cooling, gen, block, count);
+                        Delta_max = std::max(Delta_max, update_terms(kernels, block, count, eta));
+                        todo -= count;
+                        term_updates_local += count;
+                        if (progress && term_updates_local >= 1000) {
+                            progress_meter->increment(term_updates_local);
+                            term_updates_local = 0;
+                        }
+                    }
+                    if (progress) {
+                        progress_meter->increment(term_updates_local);
+                    }
+                }
+
+                if (snapshot && iteration + 1 < iter_max) {
+                    std::vector<double> X_iter, Y_iter;
+                    get_coordinates(data, X_iter, Y_iter);
+                    algorithms::layout::Layout layout(X_iter, Y_iter);
+                    std::ofstream snapshot_out(snapshot_prefix + std::to_string(iteration + 1));
+                    layout.serialize(snapshot_out);
+                }
+
+                if (Delta_max <= delta) { // nb: this will also break at 0
+                    if (progress) {
+                        std::cerr << "[odgi::path_linear_sgd_layout_flat] delta_max: " << Delta_max
+                                  << " <= delta: " << delta << ". Threshold reached, therefore ending iterations."
+                                  << std::endl;
+                    }
+                    break;
+                }
+
+                if (checkpointing.due(iteration + 1) && iteration + 1 < iter_max) {
+                    sgd_checkpoint_t checkpoint;
+                    checkpoint.engine = "path_linear_sgd_layout_flat";
+                    checkpoint.iteration = iteration + 1;
+                    checkpoint.etas = etas;
+                    for (auto &worker : workers) {
+                        checkpoint.rng_states.push_back(worker.gen.serialize());
+                    }
+                    get_coordinates(data, checkpoint.X, checkpoint.Y);
+                    checkpointing.write(checkpoint);
+                }
+            }
+
+            store_coordinates(data, X, Y);
+
+            if (progress) {
+                progress_meter->finish();
+            }
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <handlegraph/path_handle_graph.hpp>
+#include <handlegraph/handle_graph.hpp>
+#include "xp.hpp"
+#include "sgd_checkpoint.hpp"
+
+namespace odgi {
+    namespace algorithms {
+
+        using namespace handlegraph;
+
+        namespace flat_sgd {
+
+            /// A node of the layout: x and y of its start, then x and y of its end, next to
+            /// its length, like the nodes of the GPU layout
+            struct node_t {
+                std::atomic<float> coords[4];
+                uint32_t seq_length;
+            };
+
+            /// A path step: the path it is on, the rank of its node, and its 1-based position
+            /// in the path, which is negative if the step is on the reverse strand
+            struct path_element_t {
+                uint32_t pidx;
+                uint32_t node_id;
+                int64_t pos;
+            };
+
+            /// A path, as a range of the step array
+            struct path_t {
+                uint64_t step_count;
+                uint64_t first_step;
+            };
+
+            /// The nodes and the path steps of the graph in flat arrays, so that sampling a
+            /// term and updating its coordinates touch a few cache lines
+            struct layout_data_t {
+                std::vector<node_t> nodes;
+                std::vector<path_t> paths;
+                std::vector<path_element_t> steps;
+            };
+
+            /// Copy the coordinates and the steps of the given paths that have more than one
+            /// step into flat arrays, path by path in parallel
+            void build_layout_data(layout_data_t &data,
+                                   const PathHandleGraph &graph,
+                                   const xp::XP &path_index,
+                                   const std::vector<path_handle_t> &path_sgd_use_paths,
+                                   const std::vector<std::atomic<double>> &X,
+                                   const std::vector<std::atomic<double>> &Y,
+                                   const uint64_t &nthreads);
+
+            /// Copy the coordinates of the flat nodes into X and Y
+            void get_coordinates(const layout_data_t &data,
+                                 std::vector<double> &X,
+                                 std::vector<double> &Y);
+
+            /// Copy the coordinates of the flat nodes back
+            void store_coordinates(const layout_data_t &data,
+                                   std::vector<std::atomic<double>> &X,
+                                   std::vector<std::atomic<double>> &Y);
+
+        }
+
+/// path guided 2D SGD on flat arrays of nodes and path steps: every iteration, each thread
+/// samples and applies its share of the terms in blocks, drawing from its own Xoshiro stream,
+/// and updates float coordinates. This takes the parameters of path_linear_sgd_layout, but
+/// samples only from the given paths. Runs resumed from a checkpoint on one thread continue
+/// exactly like the run that wrote it.
+        void path_linear_sgd_layout_flat(const PathHandleGraph &graph,
+                                         const xp::XP &path_index,
+                                         const std::vector<path_handle_t> &path_sgd_use_paths,
+                                         const uint64_t &iter_max,
+                                         const uint64_t &iter_with_max_learning_rate,
+                                         const uint64_t &min_term_updates,
+                                         const double &delta,
+                                         const double &eps,
+                                         const double &eta_max,
+                                         const double &theta,
+                                         const uint64_t &space,
+                                         const uint64_t &space_max,
+                                         const uint64_t &space_quantization_step,
+                                         const double &cooling_start,
+                                         const uint64_t &nthreads,
+                                         const bool &progress,
+                                         const bool &snapshot,
+                                         const std::string &snapshot_prefix,
+                                         std::vector<std::atomic<double>> &X,
+                                         std::vector<std::atomic<double>> &Y,
+                                         const sgd_checkpointing_t &checkpointing = sgd_checkpointing_t());
+
+    }
+}
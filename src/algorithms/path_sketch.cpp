@@ -0,0 +1,92 @@
+#include "path_sketch.hpp"
+#include "path_intersection.hpp"
+#include "index_cache.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace odgi {
+
+namespace algorithms {
+
+path_sketches_t::path_sketches_t(const uint64_t& id_count, const uint64_t& bin_count)
+    : bin_count(bin_count),
+      bins(id_count * bin_count, empty_bin),
+      thresholds(id_count, empty_bin),
+      empty_bins(id_count, bin_count) { }
+
+void path_sketches_t::add(const uint32_t& id, const nid_t& node, const uint64_t& length, const uint64_t& copies) {
+    uint64_t* sketch = &bins[(uint64_t)id * bin_count];
+    uint64_t& threshold = thresholds[id];
+    uint64_t& empty = empty_bins[id];
+    const uint64_t node_seed = mix64(node);
+    for (uint64_t copy = 0; copy < copies; ++copy) {
+        const uint64_t seed = mix64(node_seed + copy);
+        // the order statistics of length uniform keys, drawn one after the other
+        double u = 0;
+        for (uint64_t i = 0; i < length; ++i) {
+            const uint64_t r = mix64(seed + i * 0x9e3779b97f4a7c15ull);
+            const double v = (double)(mix64(r) >> 11) * 0x1.0p-53;
+            u += (1 - u) * -std::expm1(std::log1p(-v) / (double)(length - i));
+            const uint64_t key = u < 1 ? (uint64_t)std::ldexp(u, 64) : empty_bin - 1;
+            if (key >= threshold) {
+                break;
+            }
+            uint64_t& bin = sketch[r % bin_count];
+            if (key < bin) {
+                const bool was_threshold = bin == threshold;
+                if (bin == empty_bin) {
+                    --empty;
+                }
+                bin = key;
+                if (empty == 0 && (was_threshold || threshold == empty_bin)) {
+                    threshold = *std::max_element(sketch, sketch + bin_count);
+                }
+            }
+        }
+    }
+}
+
+double path_sketches_t::jaccard(const uint32_t& a, const uint32_t& b) const {
+    const uint64_t* sketch_a = &bins[(uint64_t)a * bin_count];
+    const uint64_t* sketch_b = &bins[(uint64_t)b * bin_count];
+    uint64_t matches = 0;
+    uint64_t both_empty = 0;
+    for (uint64_t i = 0; i < bin_count; ++i) {
+        matches += sketch_a[i] == sketch_b[i];
+        both_empty += (sketch_a[i] & sketch_b[i]) == empty_bin;
+    }
+    // bins that are empty in both sketches say nothing about them
+    matches -= both_empty;
+    return both_empty == bin_count ? 0 : (double)matches / (double)(bin_count - both_empty);
+}
+
+uint64_t path_sketches_t::intersection(const uint32_t& a, const uint32_t& b,
+                                       const uint64_t& length_a, const uint64_t& length_b) const {
+    // J = I / (|A| + |B| - I)
+    const double j = jaccard(a, b);
+    return (uint64_t)std::llround(j * (double)(length_a + length_b) / (1.0 + j));
+}
+
+void build_path_sketches(const PathHandleGraph& graph,
+                         const std::vector<bool>& node_mask,
+                         const std::vector<uint32_t>& path_ids,
+                         path_sketches_t& sketches,
+                         const uint64_t& shard_count,
+                         const bool& progress) {
+    for_each_node_in_shards(
+        graph, node_mask, path_ids, shard_count, progress,
+        "[odgi::similarity] sketching the paths",
+        [&](const uint64_t& shard, const nid_t& id, const uint64_t& length,
+            const std::vector<std::pair<uint32_t, uint64_t>>& counts) {
+            for (auto& count : counts) {
+                if (count.first % shard_count == shard) {
+                    sketches.add(count.first, id, length, count.second);
+                }
+            }
+        });
+}
+
+}
+
+}
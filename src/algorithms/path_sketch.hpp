@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <handlegraph/types.hpp>
+#include <handlegraph/util.hpp>
+#include <handlegraph/path_handle_graph.hpp>
+
+namespace odgi {
+
+namespace algorithms {
+
+using namespace handlegraph;
+
+/// One-permutation MinHash sketches of ids (paths or groups of paths) below id_count, over their
+/// base pairs: an id stepping c times on a node of length l holds the units (node, copy, bp) for
+/// each copy < c and bp < l, so that the Jaccard of two sketches estimates the sum of the shared
+/// lengths over the sum of the united ones. Each unit hashes to a bin and a key, and a bin keeps
+/// the smallest key. The units of a node copy are drawn in increasing key order, so that a long
+/// node stops as soon as its keys cannot enter the sketch.
+class path_sketches_t {
+public:
+    path_sketches_t(const uint64_t& id_count, const uint64_t& bin_count);
+
+    uint64_t get_bin_count() const { return bin_count; }
+    /// add the units of copies [0, copies) of the node to the sketch of the id; only one thread
+    /// at a time may add to an id
+    void add(const uint32_t& id, const nid_t& node, const uint64_t& length, const uint64_t& copies);
+    /// the estimated weighted Jaccard of two ids, whose standard error is about
+    /// sqrt(J * (1 - J) / bin count)
+    double jaccard(const uint32_t& a, const uint32_t& b) const;
+    /// the shared length of two ids of these lengths implied by their estimated Jaccard
+    uint64_t intersection(const uint32_t& a, const uint32_t& b,
+                          const uint64_t& length_a, const uint64_t& length_b) const;
+
+private:
+    static constexpr uint64_t empty_bin = std::numeric_limits<uint64_t>::max();
+    uint64_t bin_count;
+    /// bin_count bins for each id
+    std::vector<uint64_t> bins;
+    /// the largest key in the bins of each id, or empty_bin while some of them are empty
+    std::vector<uint64_t> thresholds;
+    std::vector<uint64_t> empty_bins;
+};
+
+/// Add the nodes that are not masked out to the sketches, with one thread per shard of the ids.
+/// path_ids maps each path, by as_integer, to its id.
+void build_path_sketches(const PathHandleGraph& graph,
+                         const std::vector<bool>& node_mask,
+                         const std::vector<uint32_t>& path_ids,
+                         path_sketches_t& sketches,
+                         const uint64_t& shard_count,
+                         const bool& progress);
+
+}
+
+}
@@ -5,7 +5,7 @@ namespace algorithms {
 
 using namespace handlegraph;
 
-void remove_high_degree_nodes(DeletableHandleGraph& g, int max_degree) {
+void remove_high_degree_nodes(DeletableHandleGraph& g, int max_degree, const uint64_t& num_threads) {
     std::vector<handle_t> to_remove;
     g.for_each_handle([&](const handle_t& h) {
             int edge_count = 0;
@@ -20,8 +20,17 @@ void remove_high_degree_nodes(DeletableHandleGraph& g, int max_degree) {
             }
         });
     // now destroy the high degree nodes
-    for (auto& h : to_remove) {
-        g.destroy_handle(h);
+    graph_t* odgi_graph = dynamic_cast<graph_t*>(&g);
+    if (odgi_graph != nullptr) {
+        edit_batch_t batch(*odgi_graph, num_threads);
+        for (auto& h : to_remove) {
+            batch.destroy_handle(h);
+        }
+        batch.apply();
+    } else {
+        for (auto& h : to_remove) {
+            g.destroy_handle(h);
+        }
     }
 }
 
@@ -10,13 +10,17 @@
 #include <handlegraph/deletable_handle_graph.hpp>
 #include <vector>
 #include <iostream>
+#include "odgi.hpp"
+#include "edit_batch.hpp"
 
 namespace odgi {
 namespace algorithms {
 
 using namespace handlegraph;
 
-void remove_high_degree_nodes(DeletableHandleGraph& g, int max_degree);
+/// Remove the nodes with more than max_degree edges; from a graph_t they are removed in one
+/// batch on num_threads threads.
+void remove_high_degree_nodes(DeletableHandleGraph& g, int max_degree, const uint64_t& num_threads = 1);
 
 }
 }
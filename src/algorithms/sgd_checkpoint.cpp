@@ -0,0 +1,98 @@
+#include "sgd_checkpoint.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sdsl/enc_vector.hpp>
+
+namespace odgi {
+    namespace algorithms {
+
+        /// "PGSGDCKP" in a little-endian word, and the format version
+        static const uint64_t sgd_checkpoint_magic = 0x504b434447534750ull;
+        static const uint64_t sgd_checkpoint_version = 1;
+
+        template<typename T>
+        static void write_array(const std::vector<T> &v, std::ostream &out) {
+            const uint64_t size = v.size();
+            sdsl::write_member(size, out);
+            out.write(reinterpret_cast<const char *>(v.data()), size * sizeof(T));
+        }
+
+        template<typename T>
+        static bool read_array(std::vector<T> &v, std::istream &in) {
+            uint64_t size = 0;
+            sdsl::read_member(size, in);
+            if (!in) {
+                return false;
+            }
+            v.resize(size);
+            in.read(reinterpret_cast<char *>(v.data()), size * sizeof(T));
+            return (bool) in;
+        }
+
+        void sgd_checkpoint_t::serialize(std::ostream &out) const {
+            sdsl::write_member(sgd_checkpoint_magic, out);
+            sdsl::write_member(sgd_checkpoint_version, out);
+            write_array(std::vector<char>(engine.begin(), engine.end()), out);
+            sdsl::write_member(iteration, out);
+            write_array(etas, out);
+            write_array(rng_states, out);
+            write_array(X, out);
+            write_array(Y, out);
+        }
+
+        bool sgd_checkpoint_t::load(std::istream &in) {
+            uint64_t magic = 0, version = 0;
+            sdsl::read_member(magic, in);
+            sdsl::read_member(version, in);
+            if (!in || magic != sgd_checkpoint_magic || version != sgd_checkpoint_version) {
+                return false;
+            }
+            std::vector<char> engine_name;
+            if (!read_array(engine_name, in)) {
+                return false;
+            }
+            engine.assign(engine_name.begin(), engine_name.end());
+            sdsl::read_member(iteration, in);
+            return read_array(etas, in)
+                && read_array(rng_states, in)
+                && read_array(X, in)
+                && read_array(Y, in);
+        }
+
+        std::string sgd_checkpoint_t::mismatch(const std::string &run_engine,
+                                               const uint64_t &x_size,
+                                               const uint64_t &y_size,
+                                               const uint64_t &nthreads,
+                                               const uint64_t &etas_size) const {
+            if (engine != run_engine) {
+                return "the checkpoint was written by " + engine + ", not by " + run_engine + ".";
+            }
+            if (X.size() != x_size || Y.size() != y_size) {
+                return "the checkpoint holds " + std::to_string(X.size() + Y.size())
+                    + " coordinates, but the graph needs " + std::to_string(x_size + y_size) + ".";
+            }
+            if (rng_states.size() != nthreads) {
+                return "the checkpoint was written by " + std::to_string(rng_states.size())
+                    + " threads, please resume it with as many.";
+            }
+            if (etas.size() != etas_size || iteration >= etas_size) {
+                return "the checkpoint was written for a different number of iterations.";
+            }
+            return "";
+        }
+
+        void sgd_checkpointing_t::write(const sgd_checkpoint_t &checkpoint) const {
+            const std::string tmp_file = file + ".tmp";
+            std::ofstream out(tmp_file, std::ios::binary);
+            checkpoint.serialize(out);
+            out.close();
+            if (!out || std::rename(tmp_file.c_str(), file.c_str()) != 0) {
+                std::cerr << "[odgi::" << checkpoint.engine << "] error: cannot write the checkpoint "
+                          << file << "." << std::endl;
+                exit(1);
+            }
+        }
+
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace odgi {
+    namespace algorithms {
+
+        /// The state of a PG-SGD run between two of its iterations, from which it can be resumed
+        struct sgd_checkpoint_t {
+            /// the engine that wrote it, e.g. path_linear_sgd_layout
+            std::string engine;
+            /// the next iteration to run
+            uint64_t iteration = 0;
+            /// the learning rate schedule, indexed by iteration
+            std::vector<double> etas;
+            /// the random state of each worker thread
+            std::vector<std::array<uint64_t, 4>> rng_states;
+            /// the coordinates: X only for 1D runs, X and Y of the node ends for 2D runs
+            std::vector<double> X;
+            std::vector<double> Y;
+
+            void serialize(std::ostream &out) const;
+            /// false if the stream does not hold a checkpoint
+            bool load(std::istream &in);
+            /// why a run of this engine with these coordinates, threads and schedule cannot resume
+            /// from the checkpoint, or an empty string if it can
+            std::string mismatch(const std::string &run_engine,
+                                 const uint64_t &x_size,
+                                 const uint64_t &y_size,
+                                 const uint64_t &nthreads,
+                                 const uint64_t &etas_size) const;
+        };
+
+        /// Where a PG-SGD run writes its checkpoints, how often, and the checkpoint it resumes from
+        struct sgd_checkpointing_t {
+            /// write a checkpoint to this file, if it is not empty
+            std::string file;
+            /// after every this many iterations
+            uint64_t every = 1;
+            /// continue the run from this checkpoint, if it is set
+            const sgd_checkpoint_t *resume = nullptr;
+
+            /// is a checkpoint due before the given iteration?
+            bool due(const uint64_t &iteration) const {
+                return !file.empty() && every > 0 && iteration > 0 && iteration % every == 0;
+            }
+
+            /// Write the checkpoint next to the file, then move it in place, so that a run killed
+            /// while writing leaves the previous checkpoint intact
+            void write(const sgd_checkpoint_t &checkpoint) const;
+        };
+
+    }
+}
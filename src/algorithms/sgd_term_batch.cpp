@@ -0,0 +1,181 @@
+#include "sgd_term_batch.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define SGD_TERM_BATCH_X86
+#include <immintrin.h>
+#endif
+
+namespace odgi {
+    namespace algorithms {
+
+        static double update_1d_scalar(const uint64_t n, const double eta,
+                                       const double *d, const double *dx, double *r_x) {
+            double Delta_max = 0;
+            for (uint64_t k = 0; k < n; ++k) {
+                const double mu = std::min(eta / d[k], 1.0);
+                const double x = dx[k] == 0 ? 1e-9 : dx[k]; // avoid nan
+                const double mag = std::abs(x);
+                const double Delta = mu * (mag - d[k]) / 2;
+                Delta_max = std::max(Delta_max, std::abs(Delta));
+                r_x[k] = Delta / mag * x;
+            }
+            return Delta_max;
+        }
+
+        static double update_2d_scalar(const uint64_t n, const double eta,
+                                       const double *d, const double *dx, const double *dy,
+                                       double *r_x, double *r_y) {
+            double Delta_max = 0;
+            for (uint64_t k = 0; k < n; ++k) {
+                const double mu = std::min(eta / d[k], 1.0);
+                const double x = dx[k] == 0 ? 1e-9 : dx[k]; // avoid nan
+                const double y = dy[k];
+                const double mag = std::sqrt(x * x + y * y);
+                const double Delta = mu * (mag - d[k]) / 2;
+                Delta_max = std::max(Delta_max, std::abs(Delta));
+                const double r = Delta / mag;
+                r_x[k] = r * x;
+                r_y[k] = r * y;
+            }
+            return Delta_max;
+        }
+
+#ifdef SGD_TERM_BATCH_X86
+        // The vector kernels do the operations of the scalar ones in the same order, and leave
+        // the terms that do not fill a vector to them.
+
+        __attribute__((target("avx2")))
+        static double update_1d_avx2(const uint64_t n, const double eta,
+                                     const double *d, const double *dx, double *r_x) {
+            const __m256d zero = _mm256_setzero_pd();
+            const __m256d one = _mm256_set1_pd(1.0);
+            const __m256d half = _mm256_set1_pd(0.5);
+            const __m256d tiny = _mm256_set1_pd(1e-9);
+            const __m256d sign = _mm256_set1_pd(-0.0);
+            const __m256d eta_v = _mm256_set1_pd(eta);
+            __m256d Delta_max_v = zero;
+            uint64_t k = 0;
+            for (; k + 4 <= n; k += 4) {
+                const __m256d d_v = _mm256_loadu_pd(d + k);
+                __m256d x = _mm256_loadu_pd(dx + k);
+                x = _mm256_blendv_pd(x, tiny, _mm256_cmp_pd(x, zero, _CMP_EQ_OQ));
+                const __m256d mu = _mm256_min_pd(_mm256_div_pd(eta_v, d_v), one);
+                const __m256d mag = _mm256_andnot_pd(sign, x);
+                const __m256d Delta = _mm256_mul_pd(_mm256_mul_pd(mu, _mm256_sub_pd(mag, d_v)), half);
+                Delta_max_v = _mm256_max_pd(Delta_max_v, _mm256_andnot_pd(sign, Delta));
+                _mm256_storeu_pd(r_x + k, _mm256_mul_pd(_mm256_div_pd(Delta, mag), x));
+            }
+            double lanes[4];
+            _mm256_storeu_pd(lanes, Delta_max_v);
+            const double Delta_max = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+            return std::max(Delta_max, update_1d_scalar(n - k, eta, d + k, dx + k, r_x + k));
+        }
+
+        __attribute__((target("avx2")))
+        static double update_2d_avx2(const uint64_t n, const double eta,
+                                     const double *d, const double *dx, const double *dy,
+                                     double *r_x, double *r_y) {
+            const __m256d zero = _mm256_setzero_pd();
+            const __m256d one = _mm256_set1_pd(1.0);
+            const __m256d half = _mm256_set1_pd(0.5);
+            const __m256d tiny = _mm256_set1_pd(1e-9);
+            const __m256d sign = _mm256_set1_pd(-0.0);
+            const __m256d eta_v = _mm256_set1_pd(eta);
+            __m256d Delta_max_v = zero;
+            uint64_t k = 0;
+            for (; k + 4 <= n; k += 4) {
+                const __m256d d_v = _mm256_loadu_pd(d + k);
+                __m256d x = _mm256_loadu_pd(dx + k);
+                const __m256d y = _mm256_loadu_pd(dy + k);
+                x = _mm256_blendv_pd(x, tiny, _mm256_cmp_pd(x, zero, _CMP_EQ_OQ));
+                const __m256d mu = _mm256_min_pd(_mm256_div_pd(eta_v, d_v), one);
+                const __m256d mag = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y)));
+                const __m256d Delta = _mm256_mul_pd(_mm256_mul_pd(mu, _mm256_sub_pd(mag, d_v)), half);
+                Delta_max_v = _mm256_max_pd(Delta_max_v, _mm256_andnot_pd(sign, Delta));
+                const __m256d r = _mm256_div_pd(Delta, mag);
+                _mm256_storeu_pd(r_x + k, _mm256_mul_pd(r, x));
+                _mm256_storeu_pd(r_y + k, _mm256_mul_pd(r, y));
+            }
+            double lanes[4];
+            _mm256_storeu_pd(lanes, Delta_max_v);
+            const double Delta_max = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+            return std::max(Delta_max, update_2d_scalar(n - k, eta, d + k, dx + k, dy + k, r_x + k, r_y + k));
+        }
+
+        __attribute__((target("avx512f")))
+        static double update_1d_avx512(const uint64_t n, const double eta,
+                                       const double *d, const double *dx, double *r_x) {
+            const __m512d zero = _mm512_setzero_pd();
+            const __m512d one = _mm512_set1_pd(1.0);
+            const __m512d half = _mm512_set1_pd(0.5);
+            const __m512d tiny = _mm512_set1_pd(1e-9);
+            const __m512d eta_v = _mm512_set1_pd(eta);
+            __m512d Delta_max_v = zero;
+            uint64_t k = 0;
+            for (; k + 8 <= n; k += 8) {
+                const __m512d d_v = _mm512_loadu_pd(d + k);
+                __m512d x = _mm512_loadu_pd(dx + k);
+                x = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(x, zero, _CMP_EQ_OQ), x, tiny);
+                const __m512d mu = _mm512_min_pd(_mm512_div_pd(eta_v, d_v), one);
+                const __m512d mag = _mm512_abs_pd(x);
+                const __m512d Delta = _mm512_mul_pd(_mm512_mul_pd(mu, _mm512_sub_pd(mag, d_v)), half);
+                Delta_max_v = _mm512_max_pd(Delta_max_v, _mm512_abs_pd(Delta));
+                _mm512_storeu_pd(r_x + k, _mm512_mul_pd(_mm512_div_pd(Delta, mag), x));
+            }
+            const double Delta_max = _mm512_reduce_max_pd(Delta_max_v);
+            return std::max(Delta_max, update_1d_scalar(n - k, eta, d + k, dx + k, r_x + k));
+        }
+
+        __attribute__((target("avx512f")))
+        static double update_2d_avx512(const uint64_t n, const double eta,
+                                       const double *d, const double *dx, const double *dy,
+                                       double *r_x, double *r_y) {
+            const __m512d zero = _mm512_setzero_pd();
+            const __m512d one = _mm512_set1_pd(1.0);
+            const __m512d half = _mm512_set1_pd(0.5);
+            const __m512d tiny = _mm512_set1_pd(1e-9);
+            const __m512d eta_v = _mm512_set1_pd(eta);
+            __m512d Delta_max_v = zero;
+            uint64_t k = 0;
+            for (; k + 8 <= n; k += 8) {
+                const __m512d d_v = _mm512_loadu_pd(d + k);
+                __m512d x = _mm512_loadu_pd(dx + k);
+                const __m512d y = _mm512_loadu_pd(dy + k);
+                x = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(x, zero, _CMP_EQ_OQ), x, tiny);
+                const __m512d mu = _mm512_min_pd(_mm512_div_pd(eta_v, d_v), one);
+                const __m512d mag = _mm512_sqrt_pd(_mm512_add_pd(_mm512_mul_pd(x, x), _mm512_mul_pd(y, y)));
+                const __m512d Delta = _mm512_mul_pd(_mm512_mul_pd(mu, _mm512_sub_pd(mag, d_v)), half);
+                Delta_max_v = _mm512_max_pd(Delta_max_v, _mm512_abs_pd(Delta));
+                const __m512d r = _mm512_div_pd(Delta, mag);
+                _mm512_storeu_pd(r_x + k, _mm512_mul_pd(r, x));
+                _mm512_storeu_pd(r_y + k, _mm512_mul_pd(r, y));
+            }
+            const double Delta_max = _mm512_reduce_max_pd(Delta_max_v);
+            return std::max(Delta_max, update_2d_scalar(n - k, eta, d + k, dx + k, dy + k, r_x + k, r_y + k));
+        }
+#endif
+
+        std::vector<sgd_term_batch_kernels_t> supported_sgd_term_batch_kernels() {
+            std::vector<sgd_term_batch_kernels_t> kernels = {{"scalar", update_1d_scalar, update_2d_scalar}};
+#ifdef SGD_TERM_BATCH_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) {
+                kernels.push_back({"avx2", update_1d_avx2, update_2d_avx2});
+            }
+            if (__builtin_cpu_supports("avx512f")) {
+                kernels.push_back({"avx512", update_1d_avx512, update_2d_avx512});
+            }
+#endif
+            return kernels;
+        }
+
+        const sgd_term_batch_kernels_t &sgd_term_batch_kernels() {
+            static const sgd_term_batch_kernels_t kernels = supported_sgd_term_batch_kernels().back();
+            return kernels;
+        }
+
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace odgi {
+    namespace algorithms {
+
+        /// PG-SGD workers sample this many terms before they apply them
+        static const uint64_t sgd_term_batch_size = 16;
+
+        /// A batch of sampled terms: the coordinates of their node (ends), whether to move them,
+        /// their distance in the path, and, once they are gathered, their distance in the layout
+        /// and the moves the kernels compute from them
+        struct sgd_term_batch_t {
+            uint64_t size = 0;
+            uint64_t i[sgd_term_batch_size];
+            uint64_t j[sgd_term_batch_size];
+            bool update_i[sgd_term_batch_size];
+            bool update_j[sgd_term_batch_size];
+            alignas(64) double d[sgd_term_batch_size];
+            alignas(64) double dx[sgd_term_batch_size];
+            alignas(64) double dy[sgd_term_batch_size];
+            alignas(64) double r_x[sgd_term_batch_size];
+            alignas(64) double r_y[sgd_term_batch_size];
+        };
+
+        /// Compute the moves r_x of n 1D terms from their path distances d and their layout
+        /// distances dx at learning rate eta, and return the largest |Delta| among them
+        typedef double (*sgd_term_batch_1d_t)(const uint64_t n, const double eta,
+                                              const double *d, const double *dx, double *r_x);
+
+        /// Compute the moves r_x, r_y of n 2D terms from their path distances d and their layout
+        /// distances dx, dy at learning rate eta, and return the largest |Delta| among them
+        typedef double (*sgd_term_batch_2d_t)(const uint64_t n, const double eta,
+                                              const double *d, const double *dx, const double *dy,
+                                              double *r_x, double *r_y);
+
+        /// The term update of path_linear_sgd and path_linear_sgd_layout for one instruction set
+        struct sgd_term_batch_kernels_t {
+            std::string name;
+            sgd_term_batch_1d_t update_1d;
+            sgd_term_batch_2d_t update_2d;
+        };
+
+        /// The kernels for the widest vector instructions of this CPU, chosen on first use
+        const sgd_term_batch_kernels_t &sgd_term_batch_kernels();
+
+        /// All the kernels this CPU can run, the scalar ones first
+        std::vector<sgd_term_batch_kernels_t> supported_sgd_term_batch_kernels();
+
+    }
+}
@@ -24,7 +24,12 @@ step_index_t::step_index_t(const PathHandleGraph& graph,
 		collecting_steps_progress_meter = std::make_unique<algorithms::progress_meter::ProgressMeter>(
 				paths.size(), "[odgi::algorithms::stepindex] Collecting Steps Progress:");
 	}
-	path_len.resize(paths.size());
+	// path lengths are indexed by path handle, which may be sparse when indexing a subset of the paths
+	uint64_t max_path = 0;
+	for (auto& path : paths) {
+		max_path = std::max(max_path, (uint64_t)as_integer(path));
+	}
+	path_len.resize(max_path);
 #pragma omp parallel for schedule(dynamic,1)
     for (auto& path : paths) {
         std::vector<step_handle_t> my_steps;
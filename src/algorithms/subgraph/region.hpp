@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <handlegraph/path_handle_graph.hpp>
 #include "position.hpp"
 
 namespace odgi {
@@ -38,7 +39,7 @@ namespace odgi {
             std::vector<std::string> *out_names = nullptr);
 
     void add_bed_range(std::vector<odgi::path_range_t>& path_ranges,
-                       const odgi::graph_t &graph,
+                       const handlegraph::PathHandleGraph &graph,
                        const std::string &buffer);
 }
 
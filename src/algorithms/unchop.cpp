@@ -5,6 +5,10 @@
  */
 
 #include "unchop.hpp"
+#include "odgi.hpp"
+#include "edit_batch.hpp"
+
+#include <omp.h>
 
 namespace odgi {
     namespace algorithms {
@@ -256,6 +260,177 @@ namespace odgi {
             return combined;
         }
 
+        /// Merge the simple components of an odgi graph by building the merged graph in one pass,
+        /// numbering the nodes as the serial merge followed by apply_ordering would. The node
+        /// records are written in parallel, each component concatenated by one thread; the edges
+        /// and path steps are queued in an edit batch, which writes the records of each node from
+        /// one thread, so the merged graph does not depend on the number of threads. Returns
+        /// false, leaving the graph untouched, if a path begins inside a component, as circular
+        /// paths may.
+        static bool unchop_in_bulk(graph_t &graph, const std::vector<std::vector<handle_t>> &components,
+                                   ska::flat_hash_map<nid_t, uint64_t> &node_rank,
+                                   const uint64_t &nthreads, const bool &show_info) {
+            const uint64_t no_component = std::numeric_limits<uint64_t>::max();
+            const nid_t min_id = graph.min_node_id();
+            const uint64_t id_count = graph.max_node_id() - min_id + 1;
+
+            // where each node lies in its component, and whether it is walked in reverse there
+            std::vector<uint64_t> component_of(id_count, no_component);
+            std::vector<uint64_t> position(id_count, 0);
+            std::vector<uint8_t> reverse_in_component(id_count, 0);
+#pragma omp parallel for schedule(dynamic, 1 << 10) num_threads(nthreads)
+            for (uint64_t c = 0; c < components.size(); ++c) {
+                if (components[c].size() < 2) {
+                    continue;
+                }
+                for (uint64_t j = 0; j < components[c].size(); ++j) {
+                    const uint64_t i = graph.get_id(components[c][j]) - min_id;
+                    component_of[i] = c;
+                    position[i] = j;
+                    reverse_in_component[i] = graph.get_is_reverse(components[c][j]);
+                }
+            }
+
+            // a step of a path enters a component if it is on the first node in the orientation of
+            // the component, or on the last one against it
+            auto enters_component = [&](const handle_t &handle) {
+                const uint64_t i = graph.get_id(handle) - min_id;
+                const bool along = graph.get_is_reverse(handle) == (bool) reverse_in_component[i];
+                return along ? position[i] == 0 : position[i] + 1 == components[component_of[i]].size();
+            };
+
+            std::vector<path_handle_t> paths;
+            graph.for_each_path_handle([&](const path_handle_t &path) {
+                paths.push_back(path);
+            });
+            for (auto &path : paths) {
+                if (!graph.is_empty(path)) {
+                    const handle_t first = graph.get_handle_of_step(graph.path_begin(path));
+                    if (component_of[graph.get_id(first) - min_id] != no_component && !enters_component(first)) {
+                        return false;
+                    }
+                }
+            }
+
+            // order the untouched nodes by their rank and the merged nodes by the mean rank of their
+            // parts, breaking ties as the handles of the serial merge would compare
+            std::vector<std::tuple<double, bool, uint64_t>> ordered_nodes;
+            graph.for_each_handle([&](const handle_t &handle) {
+                const uint64_t i = graph.get_id(handle) - min_id;
+                if (component_of[i] == no_component) {
+                    ordered_nodes.emplace_back(node_rank[graph.get_id(handle)], false, i);
+                }
+            });
+            uint64_t num_node_unchopped = 0;
+            uint64_t num_new_nodes = 0;
+            for (uint64_t c = 0; c < components.size(); ++c) {
+                if (components[c].size() < 2) {
+                    continue;
+                }
+                double rank_sum = 0;
+                for (auto &handle : components[c]) {
+                    rank_sum += node_rank[graph.get_id(handle)];
+                }
+                ordered_nodes.emplace_back(rank_sum / components[c].size(), true, c);
+                num_node_unchopped += components[c].size();
+                ++num_new_nodes;
+            }
+
+            if (show_info) {
+                std::cerr << "[odgi::unchop] unchopped " << num_node_unchopped << " nodes into " << num_new_nodes
+                          << " new nodes." << std::endl;
+            }
+
+            ips4o::parallel::sort(ordered_nodes.begin(), ordered_nodes.end(), std::less<>(), nthreads);
+
+            std::vector<nid_t> node_new_id(id_count, 0);
+            std::vector<nid_t> component_new_id(components.size(), 0);
+#pragma omp parallel for schedule(static) num_threads(nthreads)
+            for (uint64_t k = 0; k < ordered_nodes.size(); ++k) {
+                if (std::get<1>(ordered_nodes[k])) {
+                    component_new_id[std::get<2>(ordered_nodes[k])] = k + 1;
+                } else {
+                    node_new_id[std::get<2>(ordered_nodes[k])] = k + 1;
+                }
+            }
+
+            graph_t merged;
+            merged.set_number_of_threads(graph.get_number_of_threads());
+            merged.reserve_node_ids(ordered_nodes.size());
+#pragma omp parallel for schedule(dynamic, 1 << 10) num_threads(nthreads)
+            for (uint64_t k = 0; k < ordered_nodes.size(); ++k) {
+                const uint64_t index = std::get<2>(ordered_nodes[k]);
+                if (std::get<1>(ordered_nodes[k])) {
+                    std::string sequence;
+                    for (auto &handle : components[index]) {
+                        sequence.append(graph.get_sequence(handle));
+                    }
+                    merged.create_reserved_handle(sequence, k + 1);
+                } else {
+                    merged.create_reserved_handle(graph.get_sequence(graph.get_handle(min_id + (nid_t)index)), k + 1);
+                }
+            }
+            merged.sync_reserved_node_ids();
+
+            // the merged handle of a handle of the graph
+            auto merged_handle = [&](const handle_t &handle) {
+                const uint64_t i = graph.get_id(handle) - min_id;
+                if (component_of[i] == no_component) {
+                    return merged.get_handle(node_new_id[i], graph.get_is_reverse(handle));
+                }
+                return merged.get_handle(component_new_id[component_of[i]],
+                                         graph.get_is_reverse(handle) != (bool) reverse_in_component[i]);
+            };
+
+            edit_batch_t batch(merged, nthreads);
+            // carry over every edge but those joining the parts of a component, from the end with the smaller id
+#pragma omp parallel for schedule(dynamic, 1 << 10) num_threads(nthreads)
+            for (uint64_t i = 0; i < id_count; ++i) {
+                const nid_t id = min_id + (nid_t)i;
+                if (!graph.has_node(id)) {
+                    continue;
+                }
+                for (const bool is_reverse : {false, true}) {
+                    const handle_t handle = graph.get_handle(id, is_reverse);
+                    const bool along = is_reverse == (bool) reverse_in_component[i];
+                    graph.follow_edges(handle, false, [&](const handle_t &next) {
+                        const uint64_t n = graph.get_id(next) - min_id;
+                        if (n < i) {
+                            return;
+                        }
+                        if (component_of[i] != no_component && component_of[n] == component_of[i]
+                            && along == (graph.get_is_reverse(next) == (bool) reverse_in_component[n])
+                            && (along ? position[n] == position[i] + 1 : position[n] + 1 == position[i])) {
+                            return;
+                        }
+                        batch.create_edge(merged_handle(handle), merged_handle(next));
+                    });
+                }
+            }
+
+            // paths keep their order, and a walk through a component becomes a single step
+            std::vector<path_handle_t> merged_paths;
+            for (auto &path : paths) {
+                merged_paths.push_back(merged.create_path_handle(graph.get_path_name(path),
+                                                                 graph.get_is_circular(path)));
+            }
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads)
+            for (uint64_t p = 0; p < paths.size(); ++p) {
+                std::vector<handle_t> steps;
+                graph.for_each_step_in_path(paths[p], [&](const step_handle_t &step) {
+                    const handle_t handle = graph.get_handle_of_step(step);
+                    if (component_of[graph.get_id(handle) - min_id] == no_component || enters_component(handle)) {
+                        steps.push_back(merged_handle(handle));
+                    }
+                });
+                batch.append_steps(merged_paths[p], steps);
+            }
+            batch.apply();
+
+            graph.swap(merged);
+            return true;
+        }
+
         bool unchop(handlegraph::MutablePathDeletableHandleGraph &graph) {
             return unchop(graph, 1, false);
         }
@@ -294,64 +469,67 @@ namespace odgi {
             });
 
             auto components = simple_components(graph, 2, true, nthreads);
-            ska::flat_hash_set<nid_t> to_merge;
-            for (auto &comp : components) {
-                for (auto &handle : comp) {
-                    to_merge.insert(graph.get_id(handle));
+            graph_t* odgi_graph = dynamic_cast<graph_t*>(&graph);
+            if (odgi_graph == nullptr || !unchop_in_bulk(*odgi_graph, components, node_rank, nthreads, show_info)) {
+                ska::flat_hash_set<nid_t> to_merge;
+                for (auto &comp : components) {
+                    for (auto &handle : comp) {
+                        to_merge.insert(graph.get_id(handle));
+                    }
                 }
-            }
-            std::vector<std::pair<double, handle_t>> ordered_handles;
-            graph.for_each_handle(
-                    [&](const handle_t &handle) {
-                        if (!to_merge.count(graph.get_id(handle))) {
-                            ordered_handles.push_back(std::make_pair(
-                                    node_rank[graph.get_id(handle)],
-                                    handle));
-                        }
-                    });
+                std::vector<std::pair<double, handle_t>> ordered_handles;
+                graph.for_each_handle(
+                        [&](const handle_t &handle) {
+                            if (!to_merge.count(graph.get_id(handle))) {
+                                ordered_handles.push_back(std::make_pair(
+                                        node_rank[graph.get_id(handle)],
+                                        handle));
+                            }
+                        });
 
-            uint64_t num_node_unchopped = 0;
-            uint64_t num_new_nodes = 0;
-            for (auto &comp : components) {
+                uint64_t num_node_unchopped = 0;
+                uint64_t num_new_nodes = 0;
+                for (auto &comp : components) {
 #ifdef debug
-                std::cerr << "Unchop " << comp.size() << " nodes together" << std::endl;
+                    std::cerr << "Unchop " << comp.size() << " nodes together" << std::endl;
 #endif
-                if (comp.size() >= 2) {
-                    // sort by lowest rank to maintain order
-                    double rank_sum = 0;
-                    for (auto &handle : comp) {
-                        rank_sum += node_rank[graph.get_id(handle)];
-                    }
-                    double rank_v = rank_sum / comp.size();
-                    handle_t n = concat_nodes(graph, comp);
-                    ordered_handles.push_back(std::make_pair(rank_v, n));
-                    //node_order.push_back(graph.get_id(n));
-                    num_node_unchopped += comp.size();
-                    num_new_nodes++;
-                } else {
-                    for (auto &c : comp) {
-                        ordered_handles.push_back(std::make_pair(node_rank[graph.get_id(c)], c));
+                    if (comp.size() >= 2) {
+                        // sort by lowest rank to maintain order
+                        double rank_sum = 0;
+                        for (auto &handle : comp) {
+                            rank_sum += node_rank[graph.get_id(handle)];
+                        }
+                        double rank_v = rank_sum / comp.size();
+                        handle_t n = concat_nodes(graph, comp);
+                        ordered_handles.push_back(std::make_pair(rank_v, n));
+                        //node_order.push_back(graph.get_id(n));
+                        num_node_unchopped += comp.size();
+                        num_new_nodes++;
+                    } else {
+                        for (auto &c : comp) {
+                            ordered_handles.push_back(std::make_pair(node_rank[graph.get_id(c)], c));
+                        }
                     }
                 }
-            }
 
-            // todo try sorting again
+                // todo try sorting again
 
-            if (show_info) {
-                std::cerr << "[odgi::unchop] unchopped " << num_node_unchopped << " nodes into " << num_new_nodes
-                          << " new nodes." << std::endl;
-            }
+                if (show_info) {
+                    std::cerr << "[odgi::unchop] unchopped " << num_node_unchopped << " nodes into " << num_new_nodes
+                              << " new nodes." << std::endl;
+                }
 
-            assert(graph.get_node_count() == ordered_handles.size());
+                assert(graph.get_node_count() == ordered_handles.size());
 
-            ips4o::parallel::sort(ordered_handles.begin(), ordered_handles.end(), std::less<>(), nthreads);
+                ips4o::parallel::sort(ordered_handles.begin(), ordered_handles.end(), std::less<>(), nthreads);
 
-            std::vector<handle_t> handle_order;
-            for (auto &h : ordered_handles) {
-                handle_order.push_back(h.second);
-            }
+                std::vector<handle_t> handle_order;
+                for (auto &h : ordered_handles) {
+                    handle_order.push_back(h.second);
+                }
 
-            graph.apply_ordering(handle_order, true);
+                graph.apply_ordering(handle_order, true);
+            }
 
             std::atomic<bool> ok(true);
 
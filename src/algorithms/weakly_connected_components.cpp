@@ -5,58 +5,97 @@ namespace algorithms {
 
 using namespace handlegraph;
 
-std::vector<ska::flat_hash_set<handlegraph::nid_t>> weakly_connected_components(const HandleGraph* graph) {
-    std::vector<ska::flat_hash_set<handlegraph::nid_t>> to_return;
-    
-    // This only holds locally forward handles
-    ska::flat_hash_set<handle_t> traversed;
-    
-    graph->for_each_handle([&](const handle_t& handle) {
-        
-        // Only think about it in the forward orientation
-        auto forward = graph->forward(handle);
-        
-        if (traversed.count(forward)) {
-            // Already have this node, so don't start a search from it.
-            return;
-        }
-        
-        // The stack only holds locally forward handles
-        std::vector<handle_t> stack{forward};
-        to_return.emplace_back();
-        while (!stack.empty()) {
-            handle_t here = stack.back();
-            stack.pop_back();
-            
-            traversed.insert(here);
-            to_return.back().insert(graph->get_id(here));
-            
-            // We have a function to handle all connected handles
-            auto handle_other = [&](const handle_t& other) {
-                // Again, make it forward
-                auto other_forward = graph->forward(other);
-                
-                if (!traversed.count(other_forward)) {
-                    stack.push_back(other_forward);
+weak_components_t weakly_connected_component_labels(const HandleGraph* graph, const uint64_t& num_threads) {
+    weak_components_t components;
+    if (graph->get_node_count() == 0) {
+        return components;
+    }
+    const nid_t min_id = graph->min_node_id();
+    const uint64_t id_count = graph->max_node_id() - min_id + 1;
+    components.min_id = min_id;
+    components.component.resize(id_count, weak_components_t::no_component);
+
+    {
+        std::vector<std::atomic<DisjointSets::Aint>> dset_data(id_count);
+        DisjointSets dset(dset_data.data(), dset_data.size());
+
+        // every edge is seen from both of its nodes, so each node only unites with larger IDs
+#pragma omp parallel for schedule(dynamic, 1 << 12) num_threads(num_threads)
+        for (uint64_t i = 0; i < id_count; ++i) {
+            const nid_t id = min_id + (nid_t)i;
+            if (!graph->has_node(id)) {
+                continue;
+            }
+            auto unite_other = [&](const handle_t& other) {
+                const nid_t other_id = graph->get_id(other);
+                if (other_id > id) {
+                    dset.unite(i, other_id - min_id);
                 }
             };
-            
-            // Look at edges in both directions
-            graph->follow_edges(here, false, handle_other);
-            graph->follow_edges(here, true, handle_other);
-            
+            const handle_t handle = graph->get_handle(id);
+            graph->follow_edges(handle, false, unite_other);
+            graph->follow_edges(handle, true, unite_other);
+        }
+
+#pragma omp parallel for schedule(static, 1 << 12) num_threads(num_threads)
+        for (uint64_t i = 0; i < id_count; ++i) {
+            if (graph->has_node(min_id + (nid_t)i)) {
+                components.component[i] = dset.find(i);
+            }
         }
+    }
+
+    // number the roots in the order of for_each_handle, and count the nodes of each component
+    std::vector<uint64_t> root_component(id_count, weak_components_t::no_component);
+    std::vector<uint64_t> counts;
+    graph->for_each_handle([&](const handle_t& handle) {
+        const uint64_t i = graph->get_id(handle) - min_id;
+        uint64_t& c = root_component[components.component[i]];
+        if (c == weak_components_t::no_component) {
+            c = counts.size();
+            counts.push_back(0);
+        }
+        ++counts[c];
     });
+
+    components.offsets.resize(counts.size() + 1);
+    for (uint64_t c = 0; c < counts.size(); ++c) {
+        components.offsets[c + 1] = components.offsets[c] + counts[c];
+        counts[c] = components.offsets[c];
+    }
+    components.node_ids.resize(components.offsets.back());
+    for (uint64_t i = 0; i < id_count; ++i) {
+        uint64_t& c = components.component[i];
+        if (c != weak_components_t::no_component) {
+            c = root_component[c];
+            components.node_ids[counts[c]++] = min_id + (nid_t)i;
+        }
+    }
+    return components;
+}
+
+std::vector<ska::flat_hash_set<handlegraph::nid_t>> weakly_connected_components(const HandleGraph* graph, const uint64_t& num_threads) {
+    const weak_components_t components = weakly_connected_component_labels(graph, num_threads);
+    std::vector<ska::flat_hash_set<handlegraph::nid_t>> to_return(components.size());
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+    for (uint64_t c = 0; c < components.size(); ++c) {
+        auto& component = to_return[c];
+        component.reserve(components.size(c));
+        component.insert(components.node_ids.begin() + components.offsets[c],
+                         components.node_ids.begin() + components.offsets[c + 1]);
+    }
     return to_return;
 }
 
-std::vector<std::vector<handlegraph::handle_t>> weakly_connected_component_vectors(const HandleGraph* graph) {
-    std::vector<std::vector<handlegraph::handle_t>> components;
-    for (auto& component : weakly_connected_components(graph)) {
-        components.emplace_back();
-        auto& v = components.back();
-        for (auto& id : component) {
-            v.push_back(graph->get_handle(id));
+std::vector<std::vector<handlegraph::handle_t>> weakly_connected_component_vectors(const HandleGraph* graph, const uint64_t& num_threads) {
+    const weak_components_t components = weakly_connected_component_labels(graph, num_threads);
+    std::vector<std::vector<handlegraph::handle_t>> to_return(components.size());
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+    for (uint64_t c = 0; c < components.size(); ++c) {
+        auto& v = to_return[c];
+        v.reserve(components.size(c));
+        for (uint64_t j = components.offsets[c]; j < components.offsets[c + 1]; ++j) {
+            v.push_back(graph->get_handle(components.node_ids[j]));
         }
         std::sort(v.begin(), v.end(),
                   [](const handle_t& a,
@@ -64,11 +103,11 @@ std::vector<std::vector<handlegraph::handle_t>> weakly_connected_component_vecto
                       return as_integer(a) < as_integer(b);
                   });
     }
-    return components;
+    return to_return;
 }
 
 std::vector<std::pair<ska::flat_hash_set<handlegraph::nid_t>, std::vector<handle_t>>> weakly_connected_components_with_tips(const HandleGraph* graph) {
-    // TODO: deduplicate with above
+    // TODO: deduplicate with weakly_connected_component_labels
     
     std::vector<std::pair<ska::flat_hash_set<handlegraph::nid_t>, std::vector<handle_t>>> to_return;
     
@@ -9,23 +9,53 @@
 #include <handlegraph/handle_graph.hpp>
 #include <handlegraph/util.hpp>
 #include "hash_map.hpp"
+#include "dset64.hpp"
+#include <omp.h>
 #include <vector>
 #include <algorithm>
+#include <limits>
 
 namespace odgi {
 namespace algorithms {
 
 using namespace handlegraph;
 
+/// The weakly connected components of a graph as dense arrays. The components are numbered in
+/// the order in which for_each_handle first reaches them, and the IDs of component c are
+/// node_ids[offsets[c]] to node_ids[offsets[c + 1] - 1], in ascending order.
+struct weak_components_t {
+    /// the smallest node ID of the graph
+    nid_t min_id = 0;
+    /// the component of each node by its ID - min_id, or no_component for IDs not in the graph
+    std::vector<uint64_t> component;
+    /// where the IDs of each component begin in node_ids, with the node count as the last entry
+    std::vector<uint64_t> offsets = {0};
+    /// the node IDs grouped by component
+    std::vector<nid_t> node_ids;
+
+    static constexpr uint64_t no_component = std::numeric_limits<uint64_t>::max();
+
+    /// the number of components
+    uint64_t size() const { return offsets.size() - 1; }
+    /// the number of nodes in the component
+    uint64_t size(const uint64_t& c) const { return offsets[c + 1] - offsets[c]; }
+    /// the component of the node
+    uint64_t component_of(const nid_t& id) const { return component[id - min_id]; }
+};
+
+/// Label the weakly connected components with num_threads threads, uniting the ends of every
+/// edge in a wait-free union-find over the node IDs.
+weak_components_t weakly_connected_component_labels(const HandleGraph* graph, const uint64_t& num_threads = 1);
+
 /// Returns sets of IDs defining components that are connected by any series
 /// of nodes and edges, even if it is not a valid bidirected walk. TODO: It
 /// might make sense to have a handle-returning version, but the consumers of
 /// weakly connected components right now want IDs, and membership in a weakly
 /// connected component is orientation-independent.
-std::vector<ska::flat_hash_set<handlegraph::nid_t>> weakly_connected_components(const HandleGraph* graph);
+std::vector<ska::flat_hash_set<handlegraph::nid_t>> weakly_connected_components(const HandleGraph* graph, const uint64_t& num_threads = 1);
 
 /// Returns a vector of handles, one for each component, which can be easier to use in some cases
-std::vector<std::vector<handlegraph::handle_t>> weakly_connected_component_vectors(const HandleGraph* graph);
+std::vector<std::vector<handlegraph::handle_t>> weakly_connected_component_vectors(const HandleGraph* graph, const uint64_t& num_threads = 1);
 
 /// Return pairs of weakly connected component ID sets and the handles that are
 /// their tips, oriented inward. If a node is both a head and a tail, it will
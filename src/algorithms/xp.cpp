@@ -1,5 +1,13 @@
 #include "xp.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 // #define debug_load
 // #define debug_np
 namespace xp {
@@ -10,6 +18,19 @@ namespace xp {
     // Here is XP
     ////////////////////////////////////////////////////////////////////////////
 
+    /// An output buffer that only counts the bytes written to it
+    struct byte_counter_t : public std::streambuf {
+        uint64_t count = 0;
+        int_type overflow(int_type c) override {
+            ++count;
+            return c;
+        }
+        std::streamsize xsputn(const char *, std::streamsize n) override {
+            count += n;
+            return n;
+        }
+    };
+
     XP::~XP() {
         // Clean up any created XPPaths
         while (!paths.empty()) {
@@ -17,15 +38,22 @@ namespace xp {
             paths.pop_back();
         }
         path_count = 0;
+        close_lazy();
+        unmap_flat();
     }
 
     /// build the graph from a graph handle
-    void XP::from_handle_graph(odgi::graph_t &graph, const uint64_t& nthreads) {
+    void XP::from_handle_graph(odgi::graph_t &graph, const uint64_t& nthreads, const bool& external) {
         std::string basename;
-        from_handle_graph(graph, basename, nthreads);
+        from_handle_graph(graph, basename, nthreads, external);
     }
 
-    void XP::from_handle_graph(odgi::graph_t &graph, std::string basename, const uint64_t& nthreads) {
+    void XP::from_handle_graph(odgi::graph_t &graph, std::string basename, const uint64_t& nthreads,
+                               const bool& external) {
+        if (!external) {
+            from_handle_graph_in_memory(graph, nthreads);
+            return;
+        }
         // create temporary file for path names
         if (basename.empty()) {
             basename = temp_file::get_dir() + '/';
@@ -34,6 +62,87 @@ namespace xp {
         temp_file::cleanup(); // clean up our temporary files
     }
 
+    void XP::from_handle_graph_in_memory(odgi::graph_t &graph, const uint64_t& nthreads) {
+        if (!graph.is_optimized()) {
+            std::cerr << "error [xp]: Graph to index is not optimized. Please run 'odgi sort' using -O, --optimize." << std::endl;
+            exit(1);
+        }
+        const uint64_t node_count = graph.get_node_count();
+
+        // node lengths and step counts, then their prefix sums give the pangenome start
+        // of each node and the start of its steps in the node->path vectors
+        sdsl::int_vector<> position_map;
+        sdsl::util::assign(position_map, sdsl::int_vector<>(node_count + 1));
+        std::vector<uint64_t> np_offset(node_count + 1, 0);
+        graph.for_each_handle([&](const handle_t &h) {
+            const uint64_t i = number_bool_packing::unpack_number(h);
+            position_map[i + 1] = graph.get_length(h);
+            np_offset[i + 1] = graph.get_step_count(h);
+        }, true);
+        for (uint64_t i = 0; i < node_count; ++i) {
+            position_map[i + 1] += position_map[i];
+            np_offset[i + 1] += np_offset[i];
+        }
+        const uint64_t np_size = np_offset[node_count];
+        sdsl::util::assign(pos_map_iv, sdsl::enc_vector<>(position_map));
+
+        sdsl::util::assign(nr_iv, sdsl::int_vector<>(np_size));
+        sdsl::util::assign(np_bv, sdsl::bit_vector(np_size));
+        sdsl::util::assign(npi_iv, sdsl::int_vector<>(np_size));
+        for (uint64_t i = 0; i < node_count; ++i) {
+            if (np_offset[i] < np_size) {
+                np_bv[np_offset[i]] = 1; // mark node start
+            }
+        }
+        index_node_path_starts();
+
+        std::vector<path_handle_t> path_handles;
+        graph.for_each_path_handle([&](const path_handle_t &path) {
+            path_handles.push_back(path);
+        });
+        path_count = path_handles.size();
+        paths.resize(path_count, nullptr);
+
+        // A step's slot in the node->path vectors follows from its rank among the steps
+        // on its node, in the order the disk-backed builder sorts them, so every path
+        // can fill its slots independently. Before bit compression, every slot is a
+        // separate 64-bit word.
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads)
+        for (uint64_t i = 0; i < path_count; ++i) {
+            const path_handle_t path = path_handles[i];
+            std::vector<handle_t> p;
+            p.reserve(graph.get_step_count(path));
+            uint64_t handle_rank_in_path = 0;
+            graph.for_each_step_in_path(path, [&](const step_handle_t &occ) {
+                const handle_t h = graph.get_handle_of_step(occ);
+                p.push_back(h);
+                ++handle_rank_in_path; // handle ranks in path are 1-based
+                const uint64_t slot = np_offset[number_bool_packing::unpack_number(h)] + as_integers(occ)[1];
+                nr_iv[slot] = handle_rank_in_path;
+                npi_iv[slot] = as_integer(path);
+            });
+            paths[i] = new XPPath(graph.get_path_name(path), p, false, graph);
+        }
+        sdsl::util::bit_compress(nr_iv);
+        sdsl::util::bit_compress(npi_iv);
+
+        std::string path_names;
+        for (auto& path : path_handles) {
+            path_names += start_marker + graph.get_path_name(path) + end_marker;
+        }
+        sdsl::util::assign(pn_iv, sdsl::int_vector<>(path_names.size()));
+        sdsl::util::assign(pn_bv, sdsl::bit_vector(path_names.size()));
+        for (size_t i = 0; i < path_names.size(); ++i) {
+            pn_iv[i] = path_names[i];
+            if (path_names[i] == start_marker) {
+                pn_bv[i] = 1; // register name start
+            }
+        }
+        sdsl::util::assign(pn_bv_rank, sdsl::rank_support_v<1>(&pn_bv));
+        sdsl::util::assign(pn_bv_select, sdsl::bit_vector::select_1_type(&pn_bv));
+        sdsl::construct_im(pn_csa, path_names, 1);
+    }
+
     void XP::from_handle_graph_impl(odgi::graph_t &graph, const std::string& basename, const uint64_t& nthreads) {
     	if (!graph.is_optimized()) {
 			std::cerr << "error [xp]: Graph to index is not optimized. Please run 'odgi sort' using -O, --optimize." << std::endl;
@@ -123,7 +232,9 @@ namespace xp {
         // fill the node->path vectors
         uint64_t  np_offset = 0;
         for (int64_t i = 0; i < graph.get_node_count(); i++) {
-            np_bv[np_offset] = 1; // mark node start
+            if (np_offset < np_size) {
+                np_bv[np_offset] = 1; // mark node start
+            }
             uint64_t has_steps = false;
             node_path_ms.for_values_of(i+1, [&](const std::tuple<uint64_t, uint64_t, uint64_t, uint64_t>& v) {
                 nr_iv[np_offset] = std::get<3>(v); // handle_rank_of_path
@@ -135,7 +246,7 @@ namespace xp {
         sdsl::util::bit_compress(nr_iv);
         sdsl::util::bit_compress(npi_iv);
         // sdsl::util::assign(np_bv_rank, sdsl::rank_support_v<1>(&np_bv));
-        // sdsl::util::assign(np_bv_select, sdsl::bit_vector::select_1_type(&np_bv));
+        index_node_path_starts();
 #ifdef debug_np
         std::cerr << "number of nodes and paths: " << np_size << std::endl;
         std::cerr << "np_bv: ";
@@ -161,10 +272,14 @@ namespace xp {
     }
 
     std::vector<XPPath *> XP::get_paths() const {
+        load_all_paths();
         return this->paths;
     }
 
     std::string XP::get_path_name(const handlegraph::path_handle_t &path_handle) const {
+        if (flat_header) {
+            return std::string(flat_path_name(as_integer(path_handle)));
+        }
         uint64_t rank = as_integer(path_handle);
         size_t start = pn_bv_select(rank) + 1; // step past '#'
         size_t end = rank == path_count ? pn_iv.size() : pn_bv_select(rank + 1);
@@ -189,6 +304,7 @@ namespace xp {
         // Do the magic number
         out << "XP";
         written += 2;
+        written += sdsl::write_member(path_directory_marker, out, child, "path_directory_marker");
 
         // POSITION MAP STUFF
         written += pos_map_iv.serialize(out, child, "position_map");
@@ -206,18 +322,29 @@ namespace xp {
         paths_written += pn_bv_select.serialize(out, paths_child, "path_names_starts_select");
         paths_written += pi_iv.serialize(out, paths_child, "path_ids");
 
-        for (size_t i = 0; i < paths.size(); i++) {
-            XPPath *path = paths[i];
-            paths_written += path->serialize(out, paths_child,
-                                             "path:" + XP::get_path_name(handlegraph::as_path_handle(i + 1)));
-        }
-
         paths_written += np_bv.serialize(out, paths_child, "node_path_mapping_starts");
         // paths_written += np_bv_rank.serialize(out, paths_child, "node_path_mapping_sarts_rank");
         // paths_written += np_bv_select.serialize(out, paths_child, "node_path_mapping_starts_select");
         paths_written += nr_iv.serialize(out, paths_child, "node_path_rank");
         paths_written += npi_iv.serialize(out, paths_child, "node_path_id");
 
+        // the path directory, so that a reader can seek to any one path
+        sdsl::int_vector<> offsets(path_count + 1);
+        offsets[0] = 0;
+        for (size_t i = 0; i < path_count; i++) {
+            byte_counter_t counter;
+            std::ostream counted(&counter);
+            path(i + 1).serialize(counted);
+            offsets[i + 1] = offsets[i] + counter.count;
+        }
+        sdsl::util::bit_compress(offsets);
+        paths_written += offsets.serialize(out, paths_child, "path_directory");
+
+        for (size_t i = 0; i < path_count; i++) {
+            paths_written += path(i + 1).serialize(out, paths_child,
+                                                   "path:" + XP::get_path_name(handlegraph::as_path_handle(i + 1)));
+        }
+
         sdsl::structure_tree::add_size(paths_child, paths_written);
         written += paths_written;
 
@@ -231,19 +358,45 @@ namespace xp {
     }
 
     void XP::load(std::istream &in) {
+        if (load_members(in)) {
+            try {
+                for (size_t i = 0; i < path_count; ++i) {
+                    auto path = new XPPath;
+                    path->load(in);
+                    paths.push_back(path);
+                }
+            } catch (const std::bad_alloc &e) {
+                throw XPFormatError("XP input data not in XP version " + std::to_string(42) + " format (" + e.what() + ")");
+            }
+        }
+    }
+
+    bool XP::load_members(std::istream &in) {
 
         if (!in.good()) {
             throw XPFormatError("Index file does not exist or index stream cannot be read");
         }
 
         // We need to look for the magic value
+        bool has_path_directory = false;
         char buffer;
         in.get(buffer);
         if (buffer == 'X') {
             in.get(buffer);
             if (buffer == 'P') {
-                // We found the magic value!
-
+                // We found the magic value! Newer indexes follow it with the marker
+                // of the path directory.
+                uint64_t marker = 0;
+                in.read((char*)&marker, sizeof(marker));
+                if (in.gcount() == sizeof(marker) && marker == path_directory_marker) {
+                    has_path_directory = true;
+                } else {
+                    in.clear();
+                    in.seekg(-(std::streamoff)in.gcount(), std::ios::cur);
+                    if (!in.good()) {
+                        throw XPFormatError("Index stream cannot be rewound after the magic value");
+                    }
+                }
             } else {
                 // Put back both characters
                 in.unget();
@@ -264,13 +417,15 @@ namespace xp {
             pn_bv_select.load(in, &pn_bv);
             pi_iv.load(in);
 
-            for (size_t i = 0; i < path_count; ++i) {
-                auto path = new XPPath;
-                // Load the path, giving it the file version and a
-                // rank-to-ID comversion function for format upgrade
-                // purposes.
-                path->load(in);
-                paths.push_back(path);
+            if (!has_path_directory) {
+                for (size_t i = 0; i < path_count; ++i) {
+                    auto path = new XPPath;
+                    // Load the path, giving it the file version and a
+                    // rank-to-ID comversion function for format upgrade
+                    // purposes.
+                    path->load(in);
+                    paths.push_back(path);
+                }
             }
             // load node path rank vectors
             np_bv.load(in);
@@ -278,6 +433,14 @@ namespace xp {
             // np_bv_select.load(in, &np_bv);
             nr_iv.load(in);
             npi_iv.load(in);
+            index_node_path_starts();
+            if (has_path_directory) {
+                path_offsets.load(in);
+                if (path_offsets.size() != path_count + 1) {
+                    throw XPFormatError("XP path directory lists " + std::to_string(path_offsets.size())
+                                        + " offsets for " + std::to_string(path_count) + " paths");
+                }
+            }
 #ifdef debug_load
             std::cerr << "np_bv: ";
             for (uint64_t i = 0; i < np_bv.size(); i++) {
@@ -307,6 +470,13 @@ namespace xp {
                       << " XP format?" << std::endl;
             throw e;
         }
+        return has_path_directory;
+    }
+
+    void XP::index_node_path_starts() {
+        sdsl::util::assign(np_bv_select, sdsl::bit_vector::select_1_type(&np_bv));
+        const uint64_t node_count = pos_map_iv.size() > 0 ? pos_map_iv.size() - 1 : 0;
+        np_bv_marks_every_node = sdsl::util::cnt_one_bits(np_bv) == node_count;
     }
 
     void XP::clean() {
@@ -316,9 +486,14 @@ namespace xp {
             paths.pop_back();
         }
         path_count = 0;
+        close_lazy();
+        unmap_flat();
     }
 
     bool XP::has_path(const std::string& path_name) const {
+        if (flat_header) {
+            return get_path_handle(path_name) != as_path_handle(0);
+        }
         // find the name in the csa
         std::string query = start_marker + path_name + end_marker;
         auto occs = locate(pn_csa, query);
@@ -330,6 +505,10 @@ namespace xp {
     }
 
     bool XP::has_position(const std::string& path_name, size_t nuc_pos) const {
+        if (flat_header) {
+            const path_handle_t p_h = get_path_handle(path_name);
+            return p_h != as_path_handle(0) && get_path_length(p_h) > nuc_pos;
+        }
         if (has_path(path_name)) {
             const XPPath& xppath = get_path(path_name);
             return xppath.offsets.size() > nuc_pos;
@@ -339,6 +518,15 @@ namespace xp {
     }
 
     path_handle_t XP::get_path_handle(const std::string& path_name) const {
+        if (flat_header) {
+            // binary search the path ids sorted by name
+            const uint64_t* begin = flat_path_by_name;
+            const uint64_t* end = flat_path_by_name + flat_header->path_count;
+            const uint64_t* f = std::lower_bound(begin, end, path_name, [&](const uint64_t& id, const std::string& name) {
+                return flat_path_name(id) < name;
+            });
+            return (f != end && flat_path_name(*f) == path_name) ? as_path_handle(*f) : as_path_handle(0);
+        }
         // find the name in the csa
         std::string query = start_marker + path_name + end_marker;
         auto occs = locate(pn_csa, query);
@@ -355,11 +543,17 @@ namespace xp {
     }
 
     size_t XP::get_path_length(const path_handle_t& path_handle) const {
-        return paths[as_integer(path_handle) - 1]->offsets.size();
+        if (flat_header) {
+            return flat_path_length[as_integer(path_handle) - 1];
+        }
+        return path(as_integer(path_handle)).offsets.size();
     }
 
     size_t XP::get_path_step_count(const handlegraph::path_handle_t& path_handle) const {
-        return paths[as_integer(path_handle) - 1]->handles.size();
+        if (flat_header) {
+            return flat_path_step_offset[as_integer(path_handle)] - flat_path_step_offset[as_integer(path_handle) - 1];
+        }
+        return path(as_integer(path_handle)).handles.size();
     }
 
     /// Get the step at a given position
@@ -369,15 +563,25 @@ namespace xp {
                                 get_path_name(path) + " of length " + std::to_string(get_path_length(path)));
         }
 
-        const auto& xppath = *paths[as_integer(path) - 1];
         step_handle_t step;
         as_integers(step)[0] = as_integer(path);
+        if (flat_header) {
+            // the last step starting at or before the position
+            const uint64_t* begin = flat_step_pos + flat_path_step_offset[as_integer(path) - 1];
+            const uint64_t* end = flat_step_pos + flat_path_step_offset[as_integer(path)];
+            as_integers(step)[1] = std::upper_bound(begin, end, position) - begin - 1;
+            return step;
+        }
+        const auto& xppath = this->path(as_integer(path));
         as_integers(step)[1] = xppath.step_rank_at_position(position);
         return step;
     }
 
     size_t XP::get_position_of_step(const step_handle_t& step_handle) const {
-        const auto& xppath = *paths[as_integer(get_path_handle_of_step(step_handle)) - 1];
+        if (flat_header) {
+            return flat_step_pos[flat_path_step_offset[as_integers(step_handle)[0] - 1] + as_integers(step_handle)[1]];
+        }
+        const auto& xppath = path(as_integer(get_path_handle_of_step(step_handle)));
         auto& step_rank = as_integers(step_handle)[1];
         return xppath.positions[step_rank];
     }
@@ -387,13 +591,16 @@ namespace xp {
     }
 
     handle_t XP::get_handle_of_step(const step_handle_t& step_handle) const {
-        const auto& xppath = *paths[as_integer(get_path_handle_of_step(step_handle)) - 1];
+        if (flat_header) {
+            return as_handle(flat_steps[flat_path_step_offset[as_integers(step_handle)[0] - 1] + as_integers(step_handle)[1]]);
+        }
+        const auto& xppath = path(as_integer(get_path_handle_of_step(step_handle)));
         return xppath.handle(as_integers(step_handle)[1]);
     }
 
     const XPPath& XP::get_path(const std::string &name) const {
         handlegraph::path_handle_t p_h = get_path_handle(name);
-        return *paths[as_integer(p_h) - 1];
+        return path(as_integer(p_h));
     }
 
     const sdsl::enc_vector<>& XP::get_pos_map_iv() const {
@@ -441,13 +648,27 @@ namespace xp {
             std::cerr << "[XP] error: The given path name " << path_name << " is not in the index." << std::endl;
             exit(1);
         }
-        const XPPath& xppath = get_path(path_name);
         // Is the nucleotide position there?!
-        if (xppath.offsets.size() <= nuc_pos) {
+        if (get_path_length(p_h) <= nuc_pos) {
             std::cerr << "[XP] error: The given path " << path_name << " with nucleotide position " << nuc_pos << " is not in the index." << std::endl;
             exit(1);
         }
 
+        return get_pangenome_pos(p_h, nuc_pos);
+    }
+
+    size_t XP::get_pangenome_pos(const handlegraph::path_handle_t &p_h, const size_t &nuc_pos) const {
+        if (flat_header) {
+            const step_handle_t step = get_step_at_position(p_h, nuc_pos);
+            const handle_t h = get_handle_of_step(step);
+            const uint64_t rank = number_bool_packing::unpack_number(h);
+            uint64_t offset_in_handle = nuc_pos - get_position_of_step(step);
+            if (number_bool_packing::unpack_bit(h)) {
+                offset_in_handle = node_start(rank + 1) - node_start(rank) - offset_in_handle - 1;
+            }
+            return node_start(rank) + offset_in_handle;
+        }
+        const XPPath& xppath = path(as_integer(p_h));
         step_handle_t step_handle = get_step_at_position(p_h, nuc_pos);
 #ifdef debug_get_pangenome_pos
         std::cerr << "[GET_PANGENOME_POS]: step_handle: path_handle_t: " << as_integers(step_handle)[0] << " step_rank_at_position: " << as_integers(step_handle)[1] << std::endl;
@@ -502,6 +723,364 @@ namespace xp {
         return pos_in_pangenome;
     }
 
+    size_t XP::get_pangenome_length() const {
+        return node_start(node_count());
+    }
+
+    size_t XP::get_length(const handle_t &handle) const {
+        const uint64_t rank = number_bool_packing::unpack_number(handle);
+        return node_start(rank + 1) - node_start(rank);
+    }
+
+    uint64_t XP::node_start(const uint64_t &rank) const {
+        return flat_header ? flat_pos_map[rank] : pos_map_iv[rank];
+    }
+
+    uint64_t XP::node_count() const {
+        if (flat_header) {
+            return flat_header->node_count;
+        }
+        return pos_map_iv.size() ? pos_map_iv.size() - 1 : 0;
+    }
+
+    handle_t XP::get_handle_at_pangenome_pos(const size_t &pan_pos, size_t &offset_in_handle) const {
+        // the last node whose start is not past the position
+        uint64_t lo = 0;
+        uint64_t hi = node_count();
+        while (hi - lo > 1) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            if (node_start(mid) <= pan_pos) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        offset_in_handle = pan_pos - node_start(lo);
+        return number_bool_packing::pack(lo, false);
+    }
+
+    void XP::for_each_path_pos_at_pangenome_pos(const size_t &pan_pos,
+                                                const std::function<void(const path_handle_t &,
+                                                                         const size_t &)> &func) const {
+        size_t offset_in_handle = 0;
+        const uint64_t node_rank = number_bool_packing::unpack_number(get_handle_at_pangenome_pos(pan_pos, offset_in_handle));
+        const uint64_t node_length = node_start(node_rank + 1) - node_start(node_rank);
+        if (flat_header) {
+            for (uint64_t i = flat_np_offset[node_rank]; i < flat_np_offset[node_rank + 1]; ++i) {
+                step_handle_t step;
+                as_integers(step)[0] = flat_np_path[i];
+                as_integers(step)[1] = flat_np_rank[i];
+                const size_t offset_in_step = number_bool_packing::unpack_bit(get_handle_of_step(step))
+                                              ? node_length - offset_in_handle - 1
+                                              : offset_in_handle;
+                func(get_path_handle_of_step(step), get_position_of_step(step) + offset_in_step);
+            }
+            return;
+        }
+        // the node->path vectors list the steps node by node
+        auto step_of_entry = [&](const uint64_t &i) {
+            step_handle_t step;
+            as_integers(step)[0] = npi_iv[i];
+            as_integers(step)[1] = nr_iv[i] - 1; // handle ranks in path are 1-based
+            return step;
+        };
+        if (np_bv_marks_every_node) {
+            // the start bits give the entries of our node, so only the paths that step on it are read
+            const uint64_t begin = np_bv_select(node_rank + 1);
+            const uint64_t end = node_rank + 2 < pos_map_iv.size() ? np_bv_select(node_rank + 2) : nr_iv.size();
+            for (uint64_t i = begin; i < end; ++i) {
+                const step_handle_t step = step_of_entry(i);
+                const handle_t h = get_handle_of_step(step);
+                const size_t offset_in_step = number_bool_packing::unpack_bit(h)
+                                              ? node_length - offset_in_handle - 1
+                                              : offset_in_handle;
+                func(get_path_handle_of_step(step), get_position_of_step(step) + offset_in_step);
+            }
+            return;
+        }
+        // some nodes have no steps and share their start bit with the next node, so find the
+        // steps of our node by looking at the handle each entry points to
+        uint64_t lo = 0;
+        uint64_t hi = nr_iv.size();
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            if (number_bool_packing::unpack_number(get_handle_of_step(step_of_entry(mid))) < node_rank) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        for (uint64_t i = lo; i < nr_iv.size(); ++i) {
+            const step_handle_t step = step_of_entry(i);
+            const handle_t h = get_handle_of_step(step);
+            if (number_bool_packing::unpack_number(h) != node_rank) {
+                break;
+            }
+            const size_t offset_in_step = number_bool_packing::unpack_bit(h)
+                                          ? node_length - offset_in_handle - 1
+                                          : offset_in_handle;
+            func(get_path_handle_of_step(step), get_position_of_step(step) + offset_in_step);
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Here is lazy path loading
+    ////////////////////////////////////////////////////////////////////////////
+
+    const XPPath& XP::path(const uint64_t &path_id) const {
+        if (lazy_fd == -1) {
+            return *paths[path_id - 1];
+        }
+        std::call_once(path_loaded[path_id - 1], [&]() {
+            const uint64_t begin = path_offsets[path_id - 1];
+            const uint64_t size = path_offsets[path_id] - begin;
+            std::string buffer(size, '\0');
+            uint64_t read = 0;
+            while (read < size) {
+                const ssize_t r = pread(lazy_fd, &buffer[read], size - read, lazy_paths_begin + begin + read);
+                if (r <= 0) {
+                    throw XPFormatError("Path " + std::to_string(path_id) + " cannot be read from the index file");
+                }
+                read += r;
+            }
+            std::istringstream in(buffer);
+            auto xppath = new XPPath;
+            xppath->load(in);
+            paths[path_id - 1] = xppath;
+            ++lazy_loaded_paths;
+        });
+        return *paths[path_id - 1];
+    }
+
+    void XP::load_all_paths() const {
+        if (lazy_fd == -1) {
+            return;
+        }
+        for (uint64_t i = 1; i <= path_count; ++i) {
+            path(i);
+        }
+    }
+
+    size_t XP::loaded_path_count() const {
+        if (lazy_fd == -1) {
+            return flat_header ? 0 : paths.size();
+        }
+        return lazy_loaded_paths;
+    }
+
+    void XP::close_lazy() {
+        if (lazy_fd != -1) {
+            close(lazy_fd);
+            lazy_fd = -1;
+        }
+        lazy_paths_begin = 0;
+        sdsl::util::clear(path_offsets);
+        path_loaded.reset();
+        lazy_loaded_paths = 0;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Here is the flat layout of XP
+    ////////////////////////////////////////////////////////////////////////////
+
+    bool XP::is_flat(const std::string &filename) {
+        std::ifstream in(filename.c_str(), std::ios::binary);
+        uint64_t magic = 0;
+        in.read((char*)&magic, sizeof(magic));
+        return in.gcount() == sizeof(magic) && magic == flat_magic_number;
+    }
+
+    bool XP::is_mapped() const {
+        return flat_header != nullptr;
+    }
+
+    uint64_t XP::flat_layout_size(const flat_header_t &h) {
+        const uint64_t words = (h.node_count + 1)      // pos_map
+            + (h.path_count + 1)                       // path_step_offset
+            + h.path_count                             // path_length
+            + (h.path_count + 1)                       // path_name_offset
+            + h.path_count                             // path_by_name
+            + 2 * h.step_count                         // steps, step_pos
+            + (h.node_count + 1)                       // np_offset
+            + 2 * h.np_count;                          // np_path, np_rank
+        return sizeof(flat_header_t) + words * sizeof(uint64_t) + h.name_length;
+    }
+
+    void XP::set_flat_sections(const char *base) {
+        flat_header = (const flat_header_t*)base;
+        const flat_header_t& h = *flat_header;
+        const uint64_t* p = (const uint64_t*)(base + sizeof(flat_header_t));
+        flat_pos_map = p;          p += h.node_count + 1;
+        flat_path_step_offset = p; p += h.path_count + 1;
+        flat_path_length = p;      p += h.path_count;
+        flat_path_name_offset = p; p += h.path_count + 1;
+        flat_path_by_name = p;     p += h.path_count;
+        flat_steps = p;            p += h.step_count;
+        flat_step_pos = p;         p += h.step_count;
+        flat_np_offset = p;        p += h.node_count + 1;
+        flat_np_path = p;          p += h.np_count;
+        flat_np_rank = p;          p += h.np_count;
+        flat_names = (const char*)p;
+    }
+
+    std::string_view XP::flat_path_name(const uint64_t &path_id) const {
+        return std::string_view(flat_names + flat_path_name_offset[path_id - 1],
+                                flat_path_name_offset[path_id] - flat_path_name_offset[path_id - 1]);
+    }
+
+    void XP::load(const std::string &filename) {
+        if (!is_flat(filename)) {
+            clean();
+            std::ifstream in(filename.c_str(), std::ios::binary);
+            if (!load_members(in)) {
+                return;
+            }
+            // leave the paths in the file until they are queried
+            lazy_paths_begin = in.tellg();
+            lazy_fd = open(filename.c_str(), O_RDONLY);
+            if (lazy_fd == -1) {
+                throw XPFormatError("Index file " + filename + " cannot be read");
+            }
+            struct stat st;
+            if (fstat(lazy_fd, &st) == -1
+                || (uint64_t)st.st_size != lazy_paths_begin + path_offsets[path_count]) {
+                throw XPFormatError("Index file " + filename + " is truncated or corrupted");
+            }
+            paths.assign(path_count, nullptr);
+            path_loaded.reset(new std::once_flag[path_count]);
+            return;
+        }
+        clean();
+        flat_fd = open(filename.c_str(), O_RDONLY);
+        if (flat_fd == -1) {
+            throw XPFormatError("Index file " + filename + " cannot be read");
+        }
+        struct stat st;
+        if (fstat(flat_fd, &st) == -1 || st.st_size < (off_t)sizeof(flat_header_t)) {
+            throw XPFormatError("Index file " + filename + " is too small to be a flat XP index");
+        }
+        flat_mapped_size = st.st_size;
+        void* m = mmap(nullptr, flat_mapped_size, PROT_READ, MAP_SHARED, flat_fd, 0);
+        if (m == MAP_FAILED) {
+            throw XPFormatError("Index file " + filename + " cannot be memory-mapped");
+        }
+        flat_mapped = (char*)m;
+        const flat_header_t* h = (const flat_header_t*)flat_mapped;
+        if (h->magic != flat_magic_number || h->version != flat_layout_version) {
+            throw XPFormatError("Index file " + filename + " is not a flat XP index of layout version "
+                                + std::to_string(flat_layout_version));
+        }
+        if (flat_layout_size(*h) != flat_mapped_size) {
+            throw XPFormatError("Index file " + filename + " is truncated or corrupted");
+        }
+        // queries jump around the steps of many paths
+        madvise(flat_mapped, flat_mapped_size, MADV_RANDOM);
+        set_flat_sections(flat_mapped);
+        path_count = h->path_count;
+    }
+
+    void XP::unmap_flat() {
+        if (flat_mapped != nullptr) {
+            munmap(flat_mapped, flat_mapped_size);
+            flat_mapped = nullptr;
+            flat_mapped_size = 0;
+        }
+        if (flat_fd != -1) {
+            close(flat_fd);
+            flat_fd = -1;
+        }
+        flat_header = nullptr;
+        flat_pos_map = flat_path_step_offset = flat_path_length = flat_path_name_offset = nullptr;
+        flat_path_by_name = flat_steps = flat_step_pos = nullptr;
+        flat_np_offset = flat_np_path = flat_np_rank = nullptr;
+        flat_names = nullptr;
+    }
+
+    void XP::serialize_flat(std::ostream &out) const {
+        if (flat_header) {
+            out.write(flat_mapped, flat_mapped_size);
+            return;
+        }
+        flat_header_t h;
+        h.magic = flat_magic_number;
+        h.version = flat_layout_version;
+        h.node_count = node_count();
+        h.path_count = path_count;
+
+        // path metadata
+        std::vector<uint64_t> path_step_offset(path_count + 1, 0);
+        std::vector<uint64_t> path_length(path_count);
+        std::vector<uint64_t> path_name_offset(path_count + 1, 0);
+        std::vector<std::string> names(path_count);
+        for (uint64_t i = 0; i < path_count; ++i) {
+            path_step_offset[i + 1] = path_step_offset[i] + path(i + 1).handles.size();
+            path_length[i] = path(i + 1).offsets.size();
+            names[i] = get_path_name(as_path_handle(i + 1));
+            path_name_offset[i + 1] = path_name_offset[i] + names[i].size();
+        }
+        h.step_count = path_step_offset.back();
+        h.name_length = path_name_offset.back();
+        h.np_count = nr_iv.size();
+        std::vector<uint64_t> path_by_name(path_count);
+        for (uint64_t i = 0; i < path_count; ++i) {
+            path_by_name[i] = i + 1;
+        }
+        std::sort(path_by_name.begin(), path_by_name.end(), [&](const uint64_t& a, const uint64_t& b) {
+            return names[a - 1] < names[b - 1];
+        });
+
+        // steps and their positions, path by path
+        std::vector<uint64_t> steps(h.step_count);
+        std::vector<uint64_t> step_pos(h.step_count);
+#pragma omp parallel for schedule(dynamic, 1)
+        for (uint64_t i = 0; i < path_count; ++i) {
+            const XPPath& xppath = path(i + 1);
+            const uint64_t offset = path_step_offset[i];
+            for (uint64_t j = 0; j < xppath.handles.size(); ++j) {
+                steps[offset + j] = as_integer(xppath.handle(j));
+                step_pos[offset + j] = xppath.positions[j];
+            }
+        }
+
+        // the node->path entries, delimited by the node of each step, which np_bv
+        // cannot do for nodes that are on no path
+        std::vector<uint64_t> np_offset(h.node_count + 1, 0);
+        std::vector<uint64_t> np_path(h.np_count);
+        std::vector<uint64_t> np_rank(h.np_count);
+        for (uint64_t i = 0; i < h.np_count; ++i) {
+            np_path[i] = npi_iv[i];
+            np_rank[i] = nr_iv[i] - 1; // handle ranks in path are 1-based
+            const handle_t handle = as_handle(steps[path_step_offset[np_path[i] - 1] + np_rank[i]]);
+            ++np_offset[number_bool_packing::unpack_number(handle) + 1];
+        }
+        for (uint64_t i = 0; i < h.node_count; ++i) {
+            np_offset[i + 1] += np_offset[i];
+        }
+
+        std::vector<uint64_t> pos_map(h.node_count + 1);
+        for (uint64_t i = 0; i <= h.node_count; ++i) {
+            pos_map[i] = pos_map_iv[i];
+        }
+
+        auto write_words = [&](const std::vector<uint64_t>& v) {
+            out.write((const char*)v.data(), v.size() * sizeof(uint64_t));
+        };
+        out.write((const char*)&h, sizeof(h));
+        write_words(pos_map);
+        write_words(path_step_offset);
+        write_words(path_length);
+        write_words(path_name_offset);
+        write_words(path_by_name);
+        write_words(steps);
+        write_words(step_pos);
+        write_words(np_offset);
+        write_words(np_path);
+        write_words(np_rank);
+        for (auto& name : names) {
+            out.write(name.data(), name.size());
+        }
+    }
+
     ////////////////////////////////////////////////////////////////////////////
     // Here is XPPath
     ////////////////////////////////////////////////////////////////////////////
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <dirent.h>
 #include <omp.h>
 
@@ -17,6 +18,8 @@
 #include "mmmultimap.hpp"
 #include "odgi.hpp"
 #include "mutex"
+#include <atomic>
+#include <memory>
 
 namespace xp {
 
@@ -65,17 +68,29 @@ namespace xp {
         // Here is the handle graph API
         ////////////////////////////////////////////////////////////////////////////
 
-        /// Build the path index from a simple graph.
-        void from_handle_graph(odgi::graph_t &graph, const uint64_t& nthreads);
-        void from_handle_graph(odgi::graph_t &graph, std::string basename, const uint64_t& nthreads);
+        /// Build the path index from a simple graph. The index is built in memory, path by
+        /// path in parallel, unless external is set.
+        void from_handle_graph(odgi::graph_t &graph, const uint64_t& nthreads, const bool& external = false);
+        void from_handle_graph(odgi::graph_t &graph, std::string basename, const uint64_t& nthreads,
+                               const bool& external = false);
 
-        /// helper to builder
+        /// helper to builder, which builds one path at a time and keeps the node to step
+        /// mapping and the path names in temporary files, bounding the memory it needs
         void from_handle_graph_impl(odgi::graph_t &graph, const std::string& basename, const uint64_t& nthreads);
 
+        /// helper to builder, which builds the paths in parallel and places every step
+        /// directly into the node to step mapping, without temporary files
+        void from_handle_graph_in_memory(odgi::graph_t &graph, const uint64_t& nthreads);
+
         /// Load this XP index from a stream. Throw an XPFormatError if the stream
         /// does not produce a valid XP file.
         void load(std::istream &in);
 
+        /// Marker following the "XP" magic in indexes that end with a directory of their
+        /// paths, so that the paths can be read one by one. An older index continues with
+        /// the bit length of its position map here, which can never take this value.
+        static constexpr uint64_t path_directory_marker = 0xffffffffffff4450ull;
+
         /// Alias for load() to match the SerializableHandleGraph interface.
         void deserialize_members(std::istream &in);
 
@@ -89,6 +104,32 @@ namespace xp {
         /// Clean the paths of the index so a new one can be generated.
         void clean();
 
+        /// Magic bytes at the start of a flat XP file ("ODGIXPFL")
+        static constexpr uint64_t flat_magic_number = 0x4c4650584947444full;
+        /// Layout version written into the flat header
+        static constexpr uint64_t flat_layout_version = 1;
+
+        /// Returns true if the file starts with the flat XP magic bytes
+        static bool is_flat(const std::string &filename);
+
+        /// Load this XP index from a file, memory-mapping it in place if it was
+        /// written with serialize_flat(). Only the query methods below work on a
+        /// mapped index, the succinct members (get_path, get_np_bv, ...) stay empty.
+        /// Otherwise the paths of an index with a path directory are read from the
+        /// file when they are first queried, and kept from then on.
+        void load(const std::string &filename);
+
+        /// Number of paths that are held in memory, which is less than path_count
+        /// while a lazily loaded index has not seen queries on all its paths
+        size_t loaded_path_count() const;
+
+        /// Write this index in a flat layout of plain arrays that load() can
+        /// memory-map, so that processes on one machine share the pages.
+        void serialize_flat(std::ostream &out) const;
+
+        /// Is this index a read-only mapping of a flat file?
+        bool is_mapped() const;
+
         /// Is this path in the index?
         bool has_path(const std::string& path_name) const;
 
@@ -125,6 +166,25 @@ namespace xp {
         /// Will exit with (1) given position is not in the given path.
         size_t get_pangenome_pos(const std::string &path_name, const size_t &nuc_pos) const;
 
+        /// Look up the pangenome position of a nucleotide position on the given path
+        /// 0-base positioning! The path handle and the position must be in the index.
+        size_t get_pangenome_pos(const handlegraph::path_handle_t &path_handle, const size_t &nuc_pos) const;
+
+        /// Returns the total length of the pangenome sequence
+        size_t get_pangenome_length() const;
+
+        /// Returns the length of the node of the given handle
+        size_t get_length(const handlegraph::handle_t &handle) const;
+
+        /// Get the forward handle of the node covering the given pangenome position (0-based)
+        /// and the offset of the position in that node
+        handlegraph::handle_t get_handle_at_pangenome_pos(const size_t &pan_pos, size_t &offset_in_handle) const;
+
+        /// Iterate over the path positions (0-based) of every step covering the given pangenome position
+        void for_each_path_pos_at_pangenome_pos(const size_t &pan_pos,
+                                                const std::function<void(const handlegraph::path_handle_t &,
+                                                                         const size_t &)> &func) const;
+
         /// Get the path of the given path name
         const XPPath& get_path(const std::string& name) const;
 
@@ -162,7 +222,7 @@ namespace xp {
 
         sdsl::enc_vector<> pos_map_iv; // store each offset of each node in the sequence vector
 
-        std::vector<XPPath *> paths; // path structure
+        mutable std::vector<XPPath *> paths; // path structure, filled on first access when loaded lazily
 
         // node->path rank
         sdsl::int_vector<> nr_iv; // rank of step in path
@@ -172,6 +232,96 @@ namespace xp {
         sdsl::bit_vector np_bv;
         // sdsl::bit_vector::rank_1_type np_bv_rank;
         sdsl::bit_vector::select_1_type np_bv_select;
+        /// whether every node has its own start bit in np_bv, which is not the case when some nodes
+        /// have no steps, so that the entries of node rank r start at np_bv_select(r + 1)
+        bool np_bv_marks_every_node = false;
+        /// build np_bv_select and check whether it can find the entries of each node
+        void index_node_path_starts();
+
+        ////////////////////////////////////////////////////////////////////////////
+        // Here is lazy path loading
+        ////////////////////////////////////////////////////////////////////////////
+
+        /// Load everything up to the paths of an index with a path directory, leaving the
+        /// stream at the first path, and return true. Load an older index completely and
+        /// return false.
+        bool load_members(std::istream &in);
+
+        /// The path of the given id, read from the index file if it is not loaded yet
+        const XPPath& path(const uint64_t &path_id) const;
+
+        /// Read all paths that are not loaded yet
+        void load_all_paths() const;
+
+        /// Close the index file of a lazily loaded index
+        void close_lazy();
+
+        int lazy_fd = -1;
+        uint64_t lazy_paths_begin = 0; // file offset of the first path
+        sdsl::int_vector<> path_offsets; // byte offsets of the paths after the first one, path_count+1 entries
+        std::unique_ptr<std::once_flag[]> path_loaded;
+        mutable std::atomic<uint64_t> lazy_loaded_paths{0};
+
+        ////////////////////////////////////////////////////////////////////////////
+        // Here is the flat layout
+        ////////////////////////////////////////////////////////////////////////////
+
+        /// File layout (all integers are 64-bit, native byte order):
+        ///   flat_header_t
+        ///   pos_map[node_count+1]            -> pangenome start of each node
+        ///   path_step_offset[path_count+1]   -> into steps and step_pos
+        ///   path_length[path_count]          -> sequence length of each path
+        ///   path_name_offset[path_count+1]   -> into names
+        ///   path_by_name[path_count]         -> path ids sorted by name
+        ///   steps[step_count]                -> handle integers, path by path
+        ///   step_pos[step_count]             -> path position of each step
+        ///   np_offset[node_count+1]          -> into np_path and np_rank
+        ///   np_path[np_count]                -> path id of the steps on each node
+        ///   np_rank[np_count]                -> 0-based rank of the step in its path
+        ///   names[name_length]               -> bytes
+        struct flat_header_t {
+            uint64_t magic;
+            uint64_t version;
+            uint64_t node_count;
+            uint64_t path_count;
+            uint64_t step_count;
+            uint64_t np_count;
+            uint64_t name_length;
+        };
+
+        /// Total size in bytes of a flat layout with the counts given in the header
+        static uint64_t flat_layout_size(const flat_header_t &header);
+
+        /// Point the flat section pointers into a mapped layout
+        void set_flat_sections(const char *base);
+
+        /// Release the mapping of a flat file
+        void unmap_flat();
+
+        /// Path name of a path id in the flat layout
+        std::string_view flat_path_name(const uint64_t &path_id) const;
+
+        /// Start of the node of the given rank in the pangenome
+        uint64_t node_start(const uint64_t &rank) const;
+
+        /// Number of nodes in the pangenome
+        uint64_t node_count() const;
+
+        int flat_fd = -1;
+        char *flat_mapped = nullptr;
+        uint64_t flat_mapped_size = 0;
+        const flat_header_t *flat_header = nullptr;
+        const uint64_t *flat_pos_map = nullptr;
+        const uint64_t *flat_path_step_offset = nullptr;
+        const uint64_t *flat_path_length = nullptr;
+        const uint64_t *flat_path_name_offset = nullptr;
+        const uint64_t *flat_path_by_name = nullptr;
+        const uint64_t *flat_steps = nullptr;
+        const uint64_t *flat_step_pos = nullptr;
+        const uint64_t *flat_np_offset = nullptr;
+        const uint64_t *flat_np_path = nullptr;
+        const uint64_t *flat_np_rank = nullptr;
+        const char *flat_names = nullptr;
     };
 
     class XPPath {
@@ -0,0 +1,627 @@
+#include "edit_batch.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <omp.h>
+#include <deps/ips4o/ips4o.hpp>
+
+namespace odgi {
+
+/// The key of an edge record of the node with the given id, seen from the forward strand of the
+/// node. The two records that can stand for a self loop that keeps its orientation are folded
+/// into one key, as create_edge only ever stores one of them.
+static inline uint64_t edge_key(const uint64_t& id, const uint64_t& other_id,
+                                const bool& other_rev, const bool& to_curr, const bool& on_rev) {
+    const bool rev = other_rev ^ on_rev;
+    const bool curr = (to_curr ^ on_rev) && (other_id != id || rev);
+    return (other_id << 2) | ((uint64_t)rev << 1) | (uint64_t)curr;
+}
+
+edit_batch_t::edit_batch_t(graph_t& graph, const uint64_t& num_threads)
+    : graph(graph), num_threads(std::max((uint64_t)1, num_threads)), buckets(this->num_threads) { }
+
+edit_batch_t::bucket_t& edit_batch_t::lock_bucket(void) {
+    bucket_t& bucket = buckets[omp_get_thread_num() % buckets.size()];
+    while (bucket.lock.test_and_set(std::memory_order_acquire))
+        ; // spin
+    return bucket;
+}
+
+void edit_batch_t::unlock_bucket(bucket_t& bucket) {
+    bucket.lock.clear(std::memory_order_release);
+}
+
+void edit_batch_t::destroy_edge(const handle_t& left, const handle_t& right) {
+    bucket_t& bucket = lock_bucket();
+    bucket.destroyed_edges.emplace_back(left, right);
+    unlock_bucket(bucket);
+}
+
+void edit_batch_t::destroy_edge(const edge_t& edge) {
+    destroy_edge(edge.first, edge.second);
+}
+
+void edit_batch_t::create_edge(const handle_t& left, const handle_t& right) {
+    bucket_t& bucket = lock_bucket();
+    bucket.created_edges.emplace_back(left, right);
+    unlock_bucket(bucket);
+}
+
+void edit_batch_t::destroy_handle(const handle_t& handle) {
+    bucket_t& bucket = lock_bucket();
+    bucket.destroyed_handles.push_back(handle);
+    unlock_bucket(bucket);
+}
+
+void edit_batch_t::divide_handle(const handle_t& handle, const std::vector<size_t>& offsets) {
+    // convert the offsets to the forward strand, as divide_handle does
+    division_t division;
+    division.id = graph.get_id(handle);
+    const uint64_t length = graph.get_length(handle);
+    for (auto& o : offsets) {
+        division.offsets.push_back(graph.get_is_reverse(handle) ? length - o : o);
+    }
+    bucket_t& bucket = lock_bucket();
+    bucket.divisions.push_back(std::move(division));
+    unlock_bucket(bucket);
+}
+
+void edit_batch_t::append_steps(const path_handle_t& path, const std::vector<handle_t>& handles) {
+    if (handles.empty()) {
+        return;
+    }
+    bucket_t& bucket = lock_bucket();
+    bucket.appends.push_back({path, handles});
+    unlock_bucket(bucket);
+}
+
+void edit_batch_t::apply(void) {
+    apply_edge_edits();
+    apply_divisions();
+    apply_step_appends();
+}
+
+void edit_batch_t::apply_edge_edits(void) {
+    std::vector<edge_t> destroyed_edges;
+    std::vector<edge_t> created_edges;
+    std::vector<handle_t> destroyed_handles;
+    for (auto& bucket : buckets) {
+        destroyed_edges.insert(destroyed_edges.end(), bucket.destroyed_edges.begin(), bucket.destroyed_edges.end());
+        created_edges.insert(created_edges.end(), bucket.created_edges.begin(), bucket.created_edges.end());
+        destroyed_handles.insert(destroyed_handles.end(), bucket.destroyed_handles.begin(), bucket.destroyed_handles.end());
+        std::vector<edge_t>().swap(bucket.destroyed_edges);
+        std::vector<edge_t>().swap(bucket.created_edges);
+        std::vector<handle_t>().swap(bucket.destroyed_handles);
+    }
+    if (destroyed_edges.empty() && created_edges.empty() && destroyed_handles.empty()) {
+        return;
+    }
+
+    // the ranks of the destroyed nodes, and the edges they take with them
+    std::vector<uint8_t> destroyed(graph.node_v.size(), 0);
+    std::vector<uint64_t> destroyed_ranks;
+    for (auto& handle : destroyed_handles) {
+        const uint64_t rank = number_bool_packing::unpack_number(handle);
+        if (!destroyed[rank] && !graph.is_deleted(handle)) {
+            destroyed[rank] = 1;
+            destroyed_ranks.push_back(rank);
+        }
+    }
+    std::vector<std::vector<edge_t>> node_edges(num_threads);
+#pragma omp parallel for schedule(dynamic, 1 << 10) num_threads(num_threads)
+    for (uint64_t i = 0; i < destroyed_ranks.size(); ++i) {
+        auto& edges = node_edges[omp_get_thread_num()];
+        const handle_t handle = number_bool_packing::pack(destroyed_ranks[i], false);
+        graph.follow_edges(handle, false, [&](const handle_t& next) {
+            edges.emplace_back(handle, next);
+        });
+        graph.follow_edges(handle, true, [&](const handle_t& prev) {
+            edges.emplace_back(prev, handle);
+        });
+    }
+    for (auto& edges : node_edges) {
+        destroyed_edges.insert(destroyed_edges.end(), edges.begin(), edges.end());
+        std::vector<edge_t>().swap(edges);
+    }
+
+    // one edit for the record at each end of an edge, or a single one for a self loop
+    const uint64_t no_rank = std::numeric_limits<uint64_t>::max();
+    const uint64_t edge_count = destroyed_edges.size() + created_edges.size();
+    std::vector<edge_edit_t> edits(2 * edge_count);
+#pragma omp parallel for schedule(static, 1 << 12) num_threads(num_threads)
+    for (uint64_t i = 0; i < edge_count; ++i) {
+        const bool create = i >= destroyed_edges.size();
+        const edge_t& edge = create ? created_edges[i - destroyed_edges.size()] : destroyed_edges[i];
+        const uint64_t left_rank = number_bool_packing::unpack_number(edge.first);
+        const uint64_t right_rank = number_bool_packing::unpack_number(edge.second);
+        const uint64_t left_id = graph.get_id(edge.first);
+        const uint64_t right_id = graph.get_id(edge.second);
+        const bool left_rev = graph.get_is_reverse(edge.first);
+        const bool right_rev = graph.get_is_reverse(edge.second);
+        edge_edit_t& left = edits[2 * i];
+        edge_edit_t& right = edits[2 * i + 1];
+        left.rank = right.rank = no_rank;
+        if (create && (destroyed[left_rank] || destroyed[right_rank])) {
+            continue;
+        }
+        if (!destroyed[left_rank]) {
+            left = {left_rank, edge_key(left_id, right_id, right_rev, false, left_rev), create};
+        }
+        if (left_rank != right_rank && !destroyed[right_rank]) {
+            right = {right_rank, edge_key(right_id, left_id, left_rev, true, right_rev), create};
+        }
+    }
+    std::vector<edge_t>().swap(destroyed_edges);
+    std::vector<edge_t>().swap(created_edges);
+    ips4o::parallel::sort(edits.begin(), edits.end(), std::less<>(), num_threads);
+    while (!edits.empty() && edits.back().rank == no_rank) {
+        edits.pop_back();
+    }
+
+    // the edits of each node, removals before creations
+    std::vector<uint64_t> node_begin;
+    for (uint64_t i = 0; i < edits.size(); ++i) {
+        if (i == 0 || edits[i].rank != edits[i - 1].rank) {
+            node_begin.push_back(i);
+        }
+    }
+    node_begin.push_back(edits.size());
+    const uint64_t node_count = node_begin.size() - 1;
+
+    // re-encode the edges of every touched node once, counting the changed edges at their lower end
+    int64_t edge_count_change = 0;
+#pragma omp parallel for schedule(dynamic, 1 << 6) num_threads(num_threads) reduction(+:edge_count_change)
+    for (uint64_t n = 0; n < node_count; ++n) {
+        node_t& node = *graph.node_v[edits[node_begin[n]].rank];
+        const uint64_t id = node.get_id();
+        std::vector<uint64_t> removed;
+        std::vector<uint64_t> created;
+        for (uint64_t i = node_begin[n]; i < node_begin[n + 1]; ++i) {
+            (edits[i].create ? created : removed).push_back(edits[i].key);
+        }
+        std::sort(removed.begin(), removed.end());
+        std::sort(created.begin(), created.end());
+        created.erase(std::unique(created.begin(), created.end()), created.end());
+
+        struct record_t {
+            uint64_t other_id;
+            bool other_rev;
+            bool to_curr;
+            bool on_rev;
+        };
+        std::vector<record_t> kept;
+        std::vector<uint64_t> kept_keys;
+        bool changed = false;
+        node.for_each_edge([&](uint64_t other_id, bool other_rev, bool to_curr, bool on_rev) {
+            const uint64_t key = edge_key(id, other_id, other_rev, to_curr, on_rev);
+            if (std::binary_search(removed.begin(), removed.end(), key)) {
+                changed = true;
+                edge_count_change -= other_id >= id;
+            } else {
+                kept.push_back({other_id, other_rev, to_curr, on_rev});
+                kept_keys.push_back(key);
+            }
+            return true;
+        });
+        std::sort(kept_keys.begin(), kept_keys.end());
+        for (auto& key : created) {
+            if (!std::binary_search(kept_keys.begin(), kept_keys.end(), key)) {
+                changed = true;
+                kept.push_back({key >> 2, (bool)(key & 2), (bool)(key & 1), false});
+                edge_count_change += (key >> 2) >= id;
+            }
+        }
+        if (changed) {
+            node.clear_edges();
+            for (auto& record : kept) {
+                node.add_edge(record.other_id, record.other_rev, record.to_curr, record.on_rev);
+            }
+        }
+    }
+
+    // destroyed nodes take away the edges they are the lower end of
+#pragma omp parallel for schedule(dynamic, 1 << 10) num_threads(num_threads) reduction(+:edge_count_change)
+    for (uint64_t i = 0; i < destroyed_ranks.size(); ++i) {
+        node_t*& node = graph.node_v[destroyed_ranks[i]];
+        const uint64_t id = node->get_id();
+        node->for_each_edge([&](uint64_t other_id, bool other_rev, bool to_curr, bool on_rev) {
+            edge_count_change -= other_id >= id;
+            return true;
+        });
+        delete node;
+        node = nullptr;
+    }
+    for (auto& rank : destroyed_ranks) {
+        graph.deleted_nodes.insert(graph.get_id(number_bool_packing::pack(rank, false)));
+    }
+    graph._edge_count += edge_count_change;
+}
+
+void edit_batch_t::apply_divisions(void) {
+    std::vector<division_t> divisions;
+    for (auto& bucket : buckets) {
+        std::move(bucket.divisions.begin(), bucket.divisions.end(), std::back_inserter(divisions));
+        std::vector<division_t>().swap(bucket.divisions);
+    }
+    if (divisions.empty()) {
+        return;
+    }
+    const nid_t min_id = graph.min_node_id();
+    const uint64_t id_count = graph.max_node_id() - min_id + 1;
+
+    // the cut points of each node, including its ends
+    std::vector<std::vector<size_t>> cuts(id_count);
+    for (auto& division : divisions) {
+        if (graph.has_node(division.id)) {
+            auto& node_cuts = cuts[division.id - min_id];
+            node_cuts.insert(node_cuts.end(), division.offsets.begin(), division.offsets.end());
+        }
+    }
+    std::vector<division_t>().swap(divisions);
+#pragma omp parallel for schedule(dynamic, 1 << 10) num_threads(num_threads)
+    for (uint64_t i = 0; i < id_count; ++i) {
+        auto& node_cuts = cuts[i];
+        if (node_cuts.empty()) {
+            continue;
+        }
+        const uint64_t length = graph.get_length(graph.get_handle(min_id + (nid_t)i));
+        node_cuts.push_back(0);
+        node_cuts.push_back(length);
+        std::sort(node_cuts.begin(), node_cuts.end());
+        node_cuts.erase(std::unique(node_cuts.begin(), node_cuts.end()), node_cuts.end());
+        while (node_cuts.back() > length) {
+            node_cuts.pop_back();
+        }
+    }
+
+    // the first new id and the number of pieces of each node, by old id
+    std::vector<nid_t> first_id(id_count, 0);
+    std::vector<uint64_t> piece_count(id_count, 0);
+    nid_t next_id = 1;
+    graph.for_each_handle([&](const handle_t& handle) {
+        const uint64_t i = graph.get_id(handle) - min_id;
+        first_id[i] = next_id;
+        piece_count[i] = cuts[i].empty() ? 1 : cuts[i].size() - 1;
+        next_id += piece_count[i];
+    });
+
+    graph_t divided;
+    divided.set_number_of_threads(graph.get_number_of_threads());
+    divided.reserve_node_ids(next_id - 1);
+#pragma omp parallel for schedule(dynamic, 1 << 10) num_threads(num_threads)
+    for (uint64_t i = 0; i < id_count; ++i) {
+        if (piece_count[i] == 0) {
+            continue;
+        }
+        const std::string sequence = graph.get_sequence(graph.get_handle(min_id + (nid_t)i));
+        if (piece_count[i] == 1) {
+            divided.create_reserved_handle(sequence, first_id[i]);
+        } else {
+            for (uint64_t j = 0; j < piece_count[i]; ++j) {
+                divided.create_reserved_handle(sequence.substr(cuts[i][j], cuts[i][j + 1] - cuts[i][j]),
+                                               first_id[i] + (nid_t)j);
+            }
+        }
+    }
+    divided.sync_reserved_node_ids();
+
+    // the pieces of a node in the order a walk along it in the given orientation visits them
+    auto piece = [&](const uint64_t& i, const bool& is_reverse, const uint64_t& t) {
+        return divided.get_handle(is_reverse ? first_id[i] + (nid_t)(piece_count[i] - 1 - t)
+                                             : first_id[i] + (nid_t)t,
+                                  is_reverse);
+    };
+    auto first_piece = [&](const handle_t& handle) {
+        return piece(graph.get_id(handle) - min_id, graph.get_is_reverse(handle), 0);
+    };
+    auto last_piece = [&](const handle_t& handle) {
+        const uint64_t i = graph.get_id(handle) - min_id;
+        return piece(i, graph.get_is_reverse(handle), piece_count[i] - 1);
+    };
+
+    // the joins between the pieces of each node, and every edge carried over from the end of the
+    // node with the smaller id, listed node by node
+    std::vector<std::vector<edge_t>> node_edges(id_count);
+#pragma omp parallel for schedule(dynamic, 1 << 10) num_threads(num_threads)
+    for (uint64_t i = 0; i < id_count; ++i) {
+        if (piece_count[i] == 0) {
+            continue;
+        }
+        const nid_t id = min_id + (nid_t)i;
+        auto& edges = node_edges[i];
+        for (uint64_t j = 1; j < piece_count[i]; ++j) {
+            edges.emplace_back(divided.get_handle(first_id[i] + (nid_t)j - 1),
+                               divided.get_handle(first_id[i] + (nid_t)j));
+        }
+        for (const bool is_reverse : {false, true}) {
+            const handle_t handle = graph.get_handle(id, is_reverse);
+            graph.follow_edges(handle, false, [&](const handle_t& next) {
+                if (graph.get_id(next) >= id) {
+                    edges.emplace_back(last_piece(handle), first_piece(next));
+                }
+            });
+        }
+    }
+
+    // one record for each end of an edge, grouped by the node that holds it and kept in the order
+    // the edges were listed, so that every node is written by one thread and its records come out
+    // the same whatever the number of threads
+    struct edge_record_t {
+        uint64_t rank;
+        uint64_t order;
+        handle_t other;
+        bool to_curr;
+        bool on_rev;
+        bool operator<(const edge_record_t& other) const {
+            return rank < other.rank || (rank == other.rank && order < other.order);
+        }
+    };
+    std::vector<uint64_t> edge_offset(id_count + 1, 0);
+    for (uint64_t i = 0; i < id_count; ++i) {
+        edge_offset[i + 1] = edge_offset[i] + node_edges[i].size();
+    }
+    const uint64_t no_rank = std::numeric_limits<uint64_t>::max();
+    std::vector<edge_record_t> records(2 * edge_offset[id_count]);
+#pragma omp parallel for schedule(dynamic, 1 << 10) num_threads(num_threads)
+    for (uint64_t i = 0; i < id_count; ++i) {
+        for (uint64_t e = 0; e < node_edges[i].size(); ++e) {
+            const edge_t& edge = node_edges[i][e];
+            const uint64_t order = 2 * (edge_offset[i] + e);
+            const uint64_t left_rank = number_bool_packing::unpack_number(edge.first);
+            const uint64_t right_rank = number_bool_packing::unpack_number(edge.second);
+            records[order] = {left_rank, order, edge.second, false, divided.get_is_reverse(edge.first)};
+            records[order + 1] = {left_rank != right_rank ? right_rank : no_rank, order + 1,
+                                  edge.first, true, divided.get_is_reverse(edge.second)};
+        }
+        std::vector<edge_t>().swap(node_edges[i]);
+    }
+    ips4o::parallel::sort(records.begin(), records.end(), std::less<>(), num_threads);
+    while (!records.empty() && records.back().rank == no_rank) {
+        records.pop_back();
+    }
+    std::vector<uint64_t> node_begin;
+    for (uint64_t r = 0; r < records.size(); ++r) {
+        if (r == 0 || records[r].rank != records[r - 1].rank) {
+            node_begin.push_back(r);
+        }
+    }
+    node_begin.push_back(records.size());
+    const uint64_t touched_count = node_begin.size() - 1;
+
+    // an edge listed from both of its ends, like a self loop that keeps its orientation, is added once
+    uint64_t edge_count = 0;
+#pragma omp parallel for schedule(dynamic, 1 << 6) num_threads(num_threads) reduction(+:edge_count)
+    for (uint64_t n = 0; n < touched_count; ++n) {
+        node_t& node = *divided.node_v[records[node_begin[n]].rank];
+        const uint64_t id = node.get_id();
+        std::vector<std::pair<uint64_t, uint64_t>> keys;
+        for (uint64_t r = node_begin[n]; r < node_begin[n + 1]; ++r) {
+            const edge_record_t& record = records[r];
+            keys.emplace_back(edge_key(id, divided.get_id(record.other), divided.get_is_reverse(record.other),
+                                       record.to_curr, record.on_rev),
+                              r);
+        }
+        std::sort(keys.begin(), keys.end());
+        std::vector<uint8_t> repeated(node_begin[n + 1] - node_begin[n], 0);
+        for (uint64_t k = 1; k < keys.size(); ++k) {
+            if (keys[k].first == keys[k - 1].first) {
+                repeated[keys[k].second - node_begin[n]] = 1;
+            }
+        }
+        for (uint64_t r = node_begin[n]; r < node_begin[n + 1]; ++r) {
+            if (!repeated[r - node_begin[n]]) {
+                const edge_record_t& record = records[r];
+                const uint64_t other_id = divided.get_id(record.other);
+                node.add_edge(other_id, divided.get_is_reverse(record.other), record.to_curr, record.on_rev);
+                edge_count += other_id >= id;
+            }
+        }
+    }
+    std::vector<edge_record_t>().swap(records);
+    divided._edge_count += edge_count;
+
+    // the paths of the divided graph, in the same order, by the integer of the paths they come from
+    std::vector<path_handle_t> paths;
+    std::vector<path_handle_t> divided_paths;
+    graph.for_each_path_handle([&](const path_handle_t& path) {
+        paths.push_back(path);
+        divided_paths.push_back(divided.create_path_handle(graph.get_path_name(path),
+                                                           graph.get_is_circular(path)));
+    });
+    std::vector<uint64_t> divided_path_id;
+    for (uint64_t p = 0; p < paths.size(); ++p) {
+        const uint64_t old_id = as_integer(paths[p]);
+        if (divided_path_id.size() <= old_id) {
+            divided_path_id.resize(old_id + 1, 0);
+        }
+        divided_path_id[old_id] = as_integer(divided_paths[p]);
+    }
+
+    // every piece of a node takes a copy of each step record of the node, at the same rank, linked
+    // to the pieces walked before and after it, so the records of a node are written by one thread
+    // and in the order of the node's own records
+#pragma omp parallel for schedule(dynamic, 1 << 10) num_threads(num_threads)
+    for (uint64_t i = 0; i < id_count; ++i) {
+        if (piece_count[i] == 0) {
+            continue;
+        }
+        const nid_t id = min_id + (nid_t)i;
+        const node_t& node = graph.get_node_ref(graph.get_handle(id));
+        const uint64_t last = piece_count[i] - 1;
+        for (uint64_t r = 0; r < node.path_count(); ++r) {
+            const node_t::step_t step = node.get_path_step(r);
+            if (step.path_id == 0) {
+                // a record cleared by destroy_step
+                for (uint64_t t = 0; t <= last; ++t) {
+                    const handle_t h = piece(i, false, t);
+                    divided.get_node_ref(h).add_path_step(0, false, false, false,
+                                                          divided.get_id(h), 0, divided.get_id(h), 0);
+                }
+                continue;
+            }
+            // the steps before and after this one, in the orientation they walk their nodes
+            auto step_handle_at = [&](const nid_t& other_id, const uint64_t& rank) {
+                const node_t& other = graph.get_node_ref(graph.get_handle(other_id));
+                return graph.get_handle(other_id, other.step_is_rev(rank));
+            };
+            const uint64_t before_id = step.is_start ? 0
+                : divided.get_id(last_piece(step_handle_at(step.prev_id, step.prev_rank)));
+            const uint64_t after_id = step.is_end ? 0
+                : divided.get_id(first_piece(step_handle_at(step.next_id, step.next_rank)));
+            for (uint64_t t = 0; t <= last; ++t) {
+                const handle_t h = piece(i, step.is_rev, t);
+                divided.get_node_ref(h).add_path_step(
+                        divided_path_id[step.path_id], step.is_rev,
+                        t == 0 && step.is_start, t == last && step.is_end,
+                        t > 0 ? divided.get_id(piece(i, step.is_rev, t - 1)) : before_id,
+                        t > 0 ? r : step.prev_rank,
+                        t < last ? divided.get_id(piece(i, step.is_rev, t + 1)) : after_id,
+                        t < last ? r : step.next_rank);
+            }
+        }
+    }
+
+    // the ends of each path move to the first and the last of their pieces, and every step counts
+    // once per piece
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+    for (uint64_t p = 0; p < paths.size(); ++p) {
+        uint64_t length = 0;
+        graph.for_each_step_in_path(paths[p], [&](const step_handle_t& step) {
+            length += piece_count[graph.get_id(graph.get_handle_of_step(step)) - min_id];
+        });
+        if (length == 0) {
+            continue;
+        }
+        const step_handle_t first = graph.path_begin(paths[p]);
+        const step_handle_t back = graph.path_back(paths[p]);
+        step_handle_t divided_first;
+        step_handle_t divided_back;
+        as_integers(divided_first)[0] = as_integer(first_piece(graph.get_handle_of_step(first)));
+        as_integers(divided_first)[1] = as_integers(first)[1];
+        as_integers(divided_back)[0] = as_integer(last_piece(graph.get_handle_of_step(back)));
+        as_integers(divided_back)[1] = as_integers(back)[1];
+        auto& metadata = divided.get_path_metadata(divided_paths[p]);
+        metadata.first.store(divided_first);
+        metadata.last.store(divided_back);
+        metadata.length.store(length);
+    }
+
+    graph.swap(divided);
+}
+
+void edit_batch_t::apply_step_appends(void) {
+    std::vector<append_t> appends;
+    for (auto& bucket : buckets) {
+        std::move(bucket.appends.begin(), bucket.appends.end(), std::back_inserter(appends));
+        std::vector<append_t>().swap(bucket.appends);
+    }
+    if (appends.empty()) {
+        return;
+    }
+
+    // the new steps of each path, one path after the other in the order of the paths
+    std::stable_sort(appends.begin(), appends.end(), [](const append_t& a, const append_t& b) {
+        return as_integer(a.path) < as_integer(b.path);
+    });
+    std::vector<path_handle_t> paths;
+    std::vector<uint64_t> path_begin;
+    std::vector<handle_t> steps;
+    for (auto& append : appends) {
+        if (paths.empty() || paths.back() != append.path) {
+            paths.push_back(append.path);
+            path_begin.push_back(steps.size());
+        }
+        steps.insert(steps.end(), append.handles.begin(), append.handles.end());
+    }
+    path_begin.push_back(steps.size());
+    std::vector<append_t>().swap(appends);
+    std::vector<uint64_t> step_path(steps.size());
+    std::vector<uint8_t> had_steps(paths.size());
+    std::vector<step_handle_t> old_back(paths.size());
+    for (uint64_t p = 0; p < paths.size(); ++p) {
+        std::fill(step_path.begin() + path_begin[p], step_path.begin() + path_begin[p + 1], p);
+        had_steps[p] = !graph.is_empty(paths[p]);
+        if (had_steps[p]) {
+            old_back[p] = graph.path_back(paths[p]);
+        }
+    }
+
+    // the steps grouped by the node they go on, in the order of the paths, so that each node takes
+    // its new records from one thread and in the same order whatever the number of threads
+    std::vector<std::pair<uint64_t, uint64_t>> node_steps(steps.size());
+#pragma omp parallel for schedule(static, 1 << 12) num_threads(num_threads)
+    for (uint64_t i = 0; i < steps.size(); ++i) {
+        node_steps[i] = std::make_pair(number_bool_packing::unpack_number(steps[i]), i);
+    }
+    ips4o::parallel::sort(node_steps.begin(), node_steps.end(), std::less<>(), num_threads);
+    std::vector<uint64_t> node_begin;
+    for (uint64_t i = 0; i < node_steps.size(); ++i) {
+        if (i == 0 || node_steps[i].first != node_steps[i - 1].first) {
+            node_begin.push_back(i);
+        }
+    }
+    node_begin.push_back(node_steps.size());
+    const uint64_t node_count = node_begin.size() - 1;
+
+    // the rank each new step gets on its node
+    std::vector<uint64_t> step_rank(steps.size());
+#pragma omp parallel for schedule(dynamic, 1 << 6) num_threads(num_threads)
+    for (uint64_t n = 0; n < node_count; ++n) {
+        const uint64_t base = graph.node_v[node_steps[node_begin[n]].first]->path_count();
+        for (uint64_t i = node_begin[n]; i < node_begin[n + 1]; ++i) {
+            step_rank[node_steps[i].second] = base + i - node_begin[n];
+        }
+    }
+
+    // write the records, linked to the steps before and after them
+#pragma omp parallel for schedule(dynamic, 1 << 6) num_threads(num_threads)
+    for (uint64_t n = 0; n < node_count; ++n) {
+        node_t& node = *graph.node_v[node_steps[node_begin[n]].first];
+        for (uint64_t i = node_begin[n]; i < node_begin[n + 1]; ++i) {
+            const uint64_t j = node_steps[i].second;
+            const uint64_t p = step_path[j];
+            const bool is_start = j == path_begin[p] && !had_steps[p];
+            const bool is_end = j + 1 == path_begin[p + 1];
+            uint64_t prev_id = 0, prev_rank = 0, next_id = 0, next_rank = 0;
+            if (j > path_begin[p]) {
+                prev_id = graph.get_id(steps[j - 1]);
+                prev_rank = step_rank[j - 1];
+            } else if (had_steps[p]) {
+                prev_id = graph.get_id(graph.get_handle_of_step(old_back[p]));
+                prev_rank = as_integers(old_back[p])[1];
+            }
+            if (!is_end) {
+                next_id = graph.get_id(steps[j + 1]);
+                next_rank = step_rank[j + 1];
+            }
+            node.add_path_step(as_integer(paths[p]), graph.get_is_reverse(steps[j]), is_start, is_end,
+                               prev_id, prev_rank, next_id, next_rank);
+        }
+    }
+
+    // link the old ends of the paths to their new steps, and move the path ends
+    auto step_at = [&](const uint64_t& j) {
+        step_handle_t step;
+        as_integers(step)[0] = as_integer(steps[j]);
+        as_integers(step)[1] = step_rank[j];
+        return step;
+    };
+    for (uint64_t p = 0; p < paths.size(); ++p) {
+        const uint64_t begin = path_begin[p];
+        const uint64_t end = path_begin[p + 1];
+        auto& metadata = graph.get_path_metadata(paths[p]);
+        if (had_steps[p]) {
+            node_t& node = graph.get_node_ref(graph.get_handle_of_step(old_back[p]));
+            const uint64_t rank = as_integers(old_back[p])[1];
+            node.set_step_next_id(rank, graph.get_id(steps[begin]));
+            node.set_step_next_rank(rank, step_rank[begin]);
+            node.set_step_is_end(rank, false);
+        } else {
+            metadata.first.store(step_at(begin));
+        }
+        metadata.last.store(step_at(end - 1));
+        metadata.length += end - begin;
+    }
+}
+
+}
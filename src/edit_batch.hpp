@@ -0,0 +1,98 @@
+//
+//  odgi
+//
+//  edit_batch.hpp
+//
+//  Queues edits to a graph_t and applies them in one parallel pass
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include <handlegraph/types.hpp>
+
+#include "odgi.hpp"
+
+namespace odgi {
+
+/// A batch of edits to a graph_t. Edits can be queued from many threads at once, and take effect
+/// together in apply(): the edge records of every touched node are decoded and re-encoded once,
+/// in parallel over the nodes, instead of once per edit as destroy_edge and friends do. Node
+/// divisions then rebuild the graph in a single parallel pass, numbering the pieces of each node
+/// consecutively in the order of the nodes, as divide_handle followed by a compacting
+/// apply_ordering would. The records of every node are written by one thread, in the order of
+/// the nodes and of their own records, so the graph comes out the same with any number of
+/// threads. Like destroy_handle, destroying a node does not update the paths that step on it.
+/// Steps appended to paths are written last, in the same way, one thread per node.
+///
+/// The batch covers the edits the bulk commands need: edges, node removal, node division and
+/// appending steps. Creating nodes, and inserting, removing or rewriting the steps within a path
+/// (rewrite_segment), are not batched; do them on the graph before or after apply().
+class edit_batch_t {
+public:
+    explicit edit_batch_t(graph_t& graph, const uint64_t& num_threads = 1);
+
+    /// queue the removal of the edge; missing edges are ignored
+    void destroy_edge(const handle_t& left, const handle_t& right);
+    void destroy_edge(const edge_t& edge);
+    /// queue the creation of the edge, after all removals; existing edges are kept as they are,
+    /// and edges to destroyed nodes are not created
+    void create_edge(const handle_t& left, const handle_t& right);
+    /// queue the removal of the node and of all its edges
+    void destroy_handle(const handle_t& handle);
+    /// queue cutting the node at the offsets, given along the handle
+    void divide_handle(const handle_t& handle, const std::vector<size_t>& offsets);
+    /// queue appending steps on the handles to the end of the path, after all other edits; the
+    /// handles must not be divided or destroyed in the same batch, and steps queued for the same
+    /// path from several threads are appended in no particular order
+    void append_steps(const path_handle_t& path, const std::vector<handle_t>& handles);
+
+    /// apply the queued edits and empty the batch; divisions require that no path steps on a
+    /// node destroyed in this or in an earlier batch
+    void apply(void);
+
+private:
+    /// an edit to the edge records of one node, by its rank in the node vector
+    struct edge_edit_t {
+        uint64_t rank;
+        /// the other node id, its orientation and the side of the edge, seen from the forward
+        /// strand of this node, packed as in edge_key
+        uint64_t key;
+        bool create;
+        bool operator<(const edge_edit_t& other) const {
+            return rank < other.rank || (rank == other.rank && create < other.create);
+        }
+    };
+    struct division_t {
+        nid_t id;
+        /// the cut points on the forward strand
+        std::vector<size_t> offsets;
+    };
+    struct append_t {
+        path_handle_t path;
+        std::vector<handle_t> handles;
+    };
+    /// the edits queued by the threads that share a bucket
+    struct bucket_t {
+        std::atomic_flag lock = ATOMIC_FLAG_INIT;
+        std::vector<edge_t> destroyed_edges;
+        std::vector<edge_t> created_edges;
+        std::vector<handle_t> destroyed_handles;
+        std::vector<division_t> divisions;
+        std::vector<append_t> appends;
+    };
+
+    graph_t& graph;
+    uint64_t num_threads;
+    std::vector<bucket_t> buckets;
+
+    bucket_t& lock_bucket(void);
+    static void unlock_bucket(bucket_t& bucket);
+    void apply_edge_edits(void);
+    void apply_divisions(void);
+    void apply_step_appends(void);
+};
+
+}
@@ -0,0 +1,49 @@
+//
+//  odgi
+//
+//  fixed_vector.hpp
+//
+//  A fixed-width stand-in for dyn::hacked_vector in node records
+//
+
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+#include "dynamic.hpp"
+
+namespace odgi {
+
+/// A vector of 64-bit words with the interface node_t uses of dyn::hacked_vector. Reads and
+/// writes are plain word accesses instead of the shifts and masks of a bit-packed vector, at
+/// the cost of 8 bytes per entry. It serializes through a dyn::hacked_vector, so graphs
+/// written with either layout load with the other.
+class fixed_vector {
+    std::vector<uint64_t> v;
+public:
+    inline uint64_t size(void) const { return v.size(); }
+    inline uint64_t at(const uint64_t& i) const { return v[i]; }
+    inline uint64_t& operator[](const uint64_t& i) { return v[i]; }
+    inline uint64_t operator[](const uint64_t& i) const { return v[i]; }
+    inline void push_back(const uint64_t& x) { v.push_back(x); }
+    inline void remove(const uint64_t& i) { v.erase(v.begin() + i); }
+    uint64_t serialize(std::ostream& out) const {
+        dyn::hacked_vector packed;
+        for (auto& x : v) {
+            packed.push_back(x);
+        }
+        return packed.serialize(out);
+    }
+    void load(std::istream& in) {
+        dyn::hacked_vector packed;
+        packed.load(in);
+        v.resize(packed.size());
+        for (uint64_t i = 0; i < v.size(); ++i) {
+            v[i] = packed.at(i);
+        }
+    }
+};
+
+}
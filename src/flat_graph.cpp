@@ -0,0 +1,456 @@
+//
+//  flat_graph.cpp
+//
+
+#include "flat_graph.hpp"
+
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace odgi {
+
+flat_graph_t::~flat_graph_t(void) {
+    clear();
+}
+
+bool flat_graph_t::is_flat_graph(const std::string& filename) {
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    uint64_t magic = 0;
+    in.read((char*)&magic, sizeof(magic));
+    return in.gcount() == sizeof(magic) && magic == magic_number;
+}
+
+uint64_t flat_graph_t::layout_size(const header_t& h) {
+    const uint64_t words = (h.node_slots + 1)       // seq_offset
+        + (2 * h.node_slots + 1)                     // edge_offset
+        + (h.node_slots + 1)                         // node_step_offset
+        + (h.path_count + 1)                         // path_step_offset
+        + (h.path_count + 1)                         // path_name_offset
+        + h.path_count                               // path_flags
+        + h.edge_entries                             // edges
+        + h.step_count                               // steps
+        + 2 * h.step_count;                          // node_steps
+    return sizeof(header_t) + words * sizeof(uint64_t)
+        + h.node_slots + h.seq_length + h.name_length;
+}
+
+void flat_graph_t::from_graph(const graph_t& graph) {
+    clear();
+    header_t h;
+    h.magic = magic_number;
+    h.version = layout_version;
+    h.node_slots = graph.node_v.size();
+    h.node_count = graph.get_node_count();
+    h.edge_count = graph._edge_count;
+    h.id_increment = graph._id_increment;
+    h.min_node_id = graph.min_node_id();
+    h.max_node_id = graph.max_node_id();
+
+    // per-slot sequence lengths and edge counts, collected in parallel
+    std::vector<uint64_t> seq_offset_v(h.node_slots + 1, 0);
+    std::vector<uint64_t> edge_offset_v(2 * h.node_slots + 1, 0);
+#pragma omp parallel for schedule(dynamic, 4096)
+    for (uint64_t i = 0; i < h.node_slots; ++i) {
+        if (graph.node_v[i] == nullptr) continue;
+        const handle_t handle = number_bool_packing::pack(i, false);
+        seq_offset_v[i + 1] = graph.get_node_cref(handle).sequence_size();
+        uint64_t right = 0, left = 0;
+        graph.follow_edges(handle, false, [&](const handle_t& other) { ++right; });
+        graph.follow_edges(handle, true, [&](const handle_t& other) { ++left; });
+        edge_offset_v[2 * i + 1] = right;
+        edge_offset_v[2 * i + 2] = left;
+    }
+    for (uint64_t i = 0; i < h.node_slots; ++i) {
+        seq_offset_v[i + 1] += seq_offset_v[i];
+    }
+    for (uint64_t i = 0; i < 2 * h.node_slots; ++i) {
+        edge_offset_v[i + 1] += edge_offset_v[i];
+    }
+    h.seq_length = seq_offset_v.back();
+    h.edge_entries = edge_offset_v.back();
+
+    // path metadata
+    std::vector<path_handle_t> paths;
+    graph.for_each_path_handle([&](const path_handle_t& path) {
+        paths.push_back(path);
+    });
+    h.path_count = paths.size();
+    std::vector<uint64_t> path_step_offset_v(h.path_count + 1, 0);
+    std::vector<uint64_t> path_name_offset_v(h.path_count + 1, 0);
+    std::vector<uint64_t> path_flags_v(h.path_count, 0);
+    for (uint64_t i = 0; i < h.path_count; ++i) {
+        path_step_offset_v[i + 1] = path_step_offset_v[i] + graph.get_step_count(paths[i]);
+        path_name_offset_v[i + 1] = path_name_offset_v[i] + graph.get_path_name(paths[i]).size();
+        path_flags_v[i] = graph.get_is_circular(paths[i]) ? 1 : 0;
+    }
+    h.step_count = path_step_offset_v.back();
+    h.name_length = path_name_offset_v.back();
+
+    // allocate the whole layout at once and fill it in place
+    const uint64_t size = layout_size(h);
+    owned.resize((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    char* base = (char*)owned.data();
+    *(header_t*)base = h;
+    set_sections(base);
+    auto writable = [](const uint64_t* p) { return const_cast<uint64_t*>(p); };
+    std::copy(seq_offset_v.begin(), seq_offset_v.end(), writable(seq_offset));
+    std::copy(edge_offset_v.begin(), edge_offset_v.end(), writable(edge_offset));
+    std::copy(path_step_offset_v.begin(), path_step_offset_v.end(), writable(path_step_offset));
+    std::copy(path_name_offset_v.begin(), path_name_offset_v.end(), writable(path_name_offset));
+    std::copy(path_flags_v.begin(), path_flags_v.end(), writable(path_flags));
+
+    // node records: each slot owns its ranges of the edge and sequence arrays
+    uint64_t* edges_w = writable(edges);
+    uint8_t* deleted_w = const_cast<uint8_t*>(deleted);
+    char* seq_w = const_cast<char*>(seq);
+#pragma omp parallel for schedule(dynamic, 4096)
+    for (uint64_t i = 0; i < h.node_slots; ++i) {
+        deleted_w[i] = graph.node_v[i] == nullptr;
+        if (deleted_w[i]) continue;
+        const handle_t handle = number_bool_packing::pack(i, false);
+        uint64_t j = edge_offset[2 * i];
+        graph.follow_edges(handle, false, [&](const handle_t& other) { edges_w[j++] = as_integer(other); });
+        graph.follow_edges(handle, true, [&](const handle_t& other) { edges_w[j++] = as_integer(other); });
+        const std::string& s = graph.node_v[i]->get_sequence();
+        std::memcpy(seq_w + seq_offset[i], s.c_str(), s.size());
+    }
+
+    // the steps of each path, walked in parallel into their own ranges
+    uint64_t* steps_w = writable(steps);
+    char* names_w = const_cast<char*>(names);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (uint64_t i = 0; i < h.path_count; ++i) {
+        uint64_t j = path_step_offset[i];
+        graph.for_each_step_in_path(paths[i], [&](const step_handle_t& step) {
+            steps_w[j++] = as_integer(graph.get_handle_of_step(step));
+        });
+        const std::string name = graph.get_path_name(paths[i]);
+        std::memcpy(names_w + path_name_offset[i], name.c_str(), name.size());
+    }
+
+    // invert the steps to get the steps on each node, in path order
+    uint64_t* node_step_offset_w = writable(node_step_offset);
+    for (uint64_t j = 0; j < h.step_count; ++j) {
+        ++node_step_offset_w[number_bool_packing::unpack_number(as_handle(steps[j])) + 1];
+    }
+    for (uint64_t i = 0; i < h.node_slots; ++i) {
+        node_step_offset_w[i + 1] += node_step_offset_w[i];
+    }
+    uint64_t* node_steps_w = writable(node_steps);
+    std::vector<uint64_t> cursor(node_step_offset, node_step_offset + h.node_slots);
+    for (uint64_t i = 0; i < h.path_count; ++i) {
+        for (uint64_t j = path_step_offset[i]; j < path_step_offset[i + 1]; ++j) {
+            auto& c = cursor[number_bool_packing::unpack_number(as_handle(steps[j]))];
+            node_steps_w[2 * c] = i + 1;
+            node_steps_w[2 * c + 1] = j;
+            ++c;
+        }
+    }
+
+    index_path_names();
+}
+
+void flat_graph_t::serialize(std::ostream& out) const {
+    out.write((const char*)header, layout_size(*header));
+}
+
+void flat_graph_t::load(const std::string& filename) {
+    clear();
+    fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) {
+        std::cerr << "[odgi::flat_graph] error: could not open " << filename << std::endl;
+        exit(1);
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size < (off_t)sizeof(header_t)) {
+        std::cerr << "[odgi::flat_graph] error: " << filename << " is too small to be a flat graph" << std::endl;
+        exit(1);
+    }
+    mapped_size = st.st_size;
+    void* m = mmap(nullptr, mapped_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (m == MAP_FAILED) {
+        std::cerr << "[odgi::flat_graph] error: could not memory-map " << filename << std::endl;
+        exit(1);
+    }
+    mapped = (char*)m;
+    const header_t* h = (const header_t*)mapped;
+    if (h->magic != magic_number || h->version != layout_version) {
+        std::cerr << "[odgi::flat_graph] error: " << filename << " is not a flat graph of layout version "
+                  << layout_version << std::endl;
+        exit(1);
+    }
+    if (layout_size(*h) != mapped_size) {
+        std::cerr << "[odgi::flat_graph] error: " << filename << " is truncated or corrupted" << std::endl;
+        exit(1);
+    }
+    set_sections(mapped);
+    index_path_names();
+}
+
+void flat_graph_t::clear(void) {
+    if (mapped != nullptr) {
+        munmap(mapped, mapped_size);
+        mapped = nullptr;
+        mapped_size = 0;
+    }
+    if (fd != -1) {
+        close(fd);
+        fd = -1;
+    }
+    std::vector<uint64_t>().swap(owned);
+    header = nullptr;
+    seq_offset = edge_offset = node_step_offset = nullptr;
+    path_step_offset = path_name_offset = path_flags = nullptr;
+    edges = steps = node_steps = nullptr;
+    deleted = nullptr;
+    seq = names = nullptr;
+    path_name_index.clear();
+}
+
+void flat_graph_t::set_sections(const char* base) {
+    header = (const header_t*)base;
+    const header_t& h = *header;
+    const uint64_t* w = (const uint64_t*)(base + sizeof(header_t));
+    seq_offset = w;       w += h.node_slots + 1;
+    edge_offset = w;      w += 2 * h.node_slots + 1;
+    node_step_offset = w; w += h.node_slots + 1;
+    path_step_offset = w; w += h.path_count + 1;
+    path_name_offset = w; w += h.path_count + 1;
+    path_flags = w;       w += h.path_count;
+    edges = w;            w += h.edge_entries;
+    steps = w;            w += h.step_count;
+    node_steps = w;       w += 2 * h.step_count;
+    const char* b = (const char*)w;
+    deleted = (const uint8_t*)b; b += h.node_slots;
+    seq = b;                     b += h.seq_length;
+    names = b;
+}
+
+void flat_graph_t::index_path_names(void) {
+    path_name_index.reserve(header->path_count);
+    for (uint64_t i = 0; i < header->path_count; ++i) {
+        path_name_index[get_path_name(as_path_handle(i + 1))] = i + 1;
+    }
+}
+
+bool flat_graph_t::has_node(nid_t node_id) const {
+    const uint64_t rank = node_id - header->id_increment - 1;
+    return rank < header->node_slots && !deleted[rank];
+}
+
+handle_t flat_graph_t::get_handle(const nid_t& node_id, bool is_reverse) const {
+    return number_bool_packing::pack(node_id - header->id_increment - 1, is_reverse);
+}
+
+nid_t flat_graph_t::get_id(const handle_t& handle) const {
+    return number_bool_packing::unpack_number(handle) + 1 + header->id_increment;
+}
+
+bool flat_graph_t::get_is_reverse(const handle_t& handle) const {
+    return number_bool_packing::unpack_bit(handle);
+}
+
+handle_t flat_graph_t::flip(const handle_t& handle) const {
+    return number_bool_packing::toggle_bit(handle);
+}
+
+size_t flat_graph_t::get_length(const handle_t& handle) const {
+    const uint64_t rank = number_bool_packing::unpack_number(handle);
+    return seq_offset[rank + 1] - seq_offset[rank];
+}
+
+std::string flat_graph_t::get_sequence(const handle_t& handle) const {
+    const uint64_t rank = number_bool_packing::unpack_number(handle);
+    std::string s(seq + seq_offset[rank], seq_offset[rank + 1] - seq_offset[rank]);
+    return get_is_reverse(handle) ? reverse_complement(s) : s;
+}
+
+size_t flat_graph_t::get_node_count(void) const {
+    return header->node_count;
+}
+
+nid_t flat_graph_t::min_node_id(void) const {
+    return header->min_node_id;
+}
+
+nid_t flat_graph_t::max_node_id(void) const {
+    return header->max_node_id;
+}
+
+size_t flat_graph_t::get_degree(const handle_t& handle, bool go_left) const {
+    const uint64_t slot = 2 * number_bool_packing::unpack_number(handle)
+        + (go_left != get_is_reverse(handle));
+    return edge_offset[slot + 1] - edge_offset[slot];
+}
+
+size_t flat_graph_t::get_edge_count(void) const {
+    return header->edge_count;
+}
+
+bool flat_graph_t::follow_edges_impl(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const {
+    // the reverse strand sees the other side of the forward handle, flipped
+    const bool is_rev = get_is_reverse(handle);
+    const uint64_t slot = 2 * number_bool_packing::unpack_number(handle) + (go_left != is_rev);
+    for (uint64_t i = edge_offset[slot]; i < edge_offset[slot + 1]; ++i) {
+        const handle_t other = as_handle(edges[i]);
+        if (!iteratee(is_rev ? flip(other) : other)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool flat_graph_t::for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel) const {
+    const uint64_t n = header->node_slots;
+    if (parallel) {
+        volatile bool flag = true;
+#pragma omp parallel for
+        for (uint64_t i = 0; i < n; ++i) {
+            if (deleted[i] || !flag) continue;
+            bool result = iteratee(number_bool_packing::pack(i, false));
+#pragma omp atomic
+            flag &= result;
+        }
+        return flag;
+    } else {
+        for (uint64_t i = 0; i < n; ++i) {
+            if (deleted[i]) continue;
+            if (!iteratee(number_bool_packing::pack(i, false))) return false;
+        }
+        return true;
+    }
+}
+
+size_t flat_graph_t::get_path_count(void) const {
+    return header->path_count;
+}
+
+bool flat_graph_t::has_path(const std::string& path_name) const {
+    return path_name_index.find(path_name) != path_name_index.end();
+}
+
+path_handle_t flat_graph_t::get_path_handle(const std::string& path_name) const {
+    auto f = path_name_index.find(path_name);
+    if (f != path_name_index.end()) {
+        return as_path_handle(f->second);
+    } else {
+        assert(false);
+        return as_path_handle(0); // won't reach unless assert is disabled
+    }
+}
+
+std::string flat_graph_t::get_path_name(const path_handle_t& path_handle) const {
+    const uint64_t i = as_integer(path_handle) - 1;
+    return std::string(names + path_name_offset[i], path_name_offset[i + 1] - path_name_offset[i]);
+}
+
+bool flat_graph_t::get_is_circular(const path_handle_t& path_handle) const {
+    return path_flags[as_integer(path_handle) - 1] & 1;
+}
+
+size_t flat_graph_t::get_step_count(const path_handle_t& path_handle) const {
+    return path_step_end(path_handle) - path_step_begin(path_handle);
+}
+
+size_t flat_graph_t::get_step_count(const handle_t& handle) const {
+    const uint64_t rank = number_bool_packing::unpack_number(handle);
+    return node_step_offset[rank + 1] - node_step_offset[rank];
+}
+
+handle_t flat_graph_t::get_handle_of_step(const step_handle_t& step_handle) const {
+    return as_handle(steps[as_integers(step_handle)[1]]);
+}
+
+path_handle_t flat_graph_t::get_path_handle_of_step(const step_handle_t& step_handle) const {
+    return as_path_handle(as_integers(step_handle)[0]);
+}
+
+step_handle_t flat_graph_t::path_begin(const path_handle_t& path_handle) const {
+    return make_step(as_integer(path_handle), path_step_begin(path_handle));
+}
+
+step_handle_t flat_graph_t::path_end(const path_handle_t& path_handle) const {
+    return make_step(as_integer(path_handle), path_step_end(path_handle));
+}
+
+step_handle_t flat_graph_t::path_back(const path_handle_t& path_handle) const {
+    if (get_step_count(path_handle) == 0) {
+        return path_front_end(path_handle);
+    }
+    return make_step(as_integer(path_handle), path_step_end(path_handle) - 1);
+}
+
+step_handle_t flat_graph_t::path_front_end(const path_handle_t& path_handle) const {
+    return make_step(as_integer(path_handle), std::numeric_limits<uint64_t>::max());
+}
+
+bool flat_graph_t::has_next_step(const step_handle_t& step_handle) const {
+    const path_handle_t path = get_path_handle_of_step(step_handle);
+    const uint64_t idx = as_integers(step_handle)[1];
+    if (idx == std::numeric_limits<uint64_t>::max()) {
+        return get_step_count(path) > 0;
+    }
+    return idx + 1 < path_step_end(path) || (get_is_circular(path) && idx < path_step_end(path));
+}
+
+bool flat_graph_t::has_previous_step(const step_handle_t& step_handle) const {
+    const path_handle_t path = get_path_handle_of_step(step_handle);
+    const uint64_t idx = as_integers(step_handle)[1];
+    if (idx == std::numeric_limits<uint64_t>::max()) {
+        return false;
+    }
+    return idx > path_step_begin(path) || (get_is_circular(path) && get_step_count(path) > 0);
+}
+
+step_handle_t flat_graph_t::get_next_step(const step_handle_t& step_handle) const {
+    const path_handle_t path = get_path_handle_of_step(step_handle);
+    const uint64_t idx = as_integers(step_handle)[1];
+    if (idx == std::numeric_limits<uint64_t>::max()) {
+        return path_begin(path);
+    } else if (idx >= path_step_end(path)) {
+        return step_handle;
+    } else if (idx + 1 == path_step_end(path)) {
+        return get_is_circular(path) ? path_begin(path) : path_end(path);
+    }
+    return make_step(as_integer(path), idx + 1);
+}
+
+step_handle_t flat_graph_t::get_previous_step(const step_handle_t& step_handle) const {
+    const path_handle_t path = get_path_handle_of_step(step_handle);
+    const uint64_t idx = as_integers(step_handle)[1];
+    if (idx == std::numeric_limits<uint64_t>::max()) {
+        return step_handle;
+    } else if (idx == path_step_end(path)) {
+        return path_back(path);
+    } else if (idx == path_step_begin(path)) {
+        return get_is_circular(path) ? path_back(path) : path_front_end(path);
+    }
+    return make_step(as_integer(path), idx - 1);
+}
+
+bool flat_graph_t::for_each_path_handle_impl(const std::function<bool(const path_handle_t&)>& iteratee) const {
+    for (uint64_t i = 1; i <= header->path_count; ++i) {
+        if (!iteratee(as_path_handle(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool flat_graph_t::for_each_step_on_handle_impl(const handle_t& handle, const std::function<bool(const step_handle_t&)>& iteratee) const {
+    const uint64_t rank = number_bool_packing::unpack_number(handle);
+    for (uint64_t i = node_step_offset[rank]; i < node_step_offset[rank + 1]; ++i) {
+        if (!iteratee(make_step(node_steps[2 * i], node_steps[2 * i + 1]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
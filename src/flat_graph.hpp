@@ -0,0 +1,265 @@
+//
+//  odgi
+//
+//  flat_graph.hpp
+//
+//  read-only graph over a flat, memory-mappable layout
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <functional>
+#include <handlegraph/types.hpp>
+#include <handlegraph/iteratee.hpp>
+#include <handlegraph/util.hpp>
+#include <handlegraph/handle_graph.hpp>
+#include <handlegraph/path_handle_graph.hpp>
+#include "odgi.hpp"
+#include "hash_map.hpp"
+
+namespace odgi {
+
+using namespace handlegraph;
+
+/// A read-only PathHandleGraph stored as flat arrays with offset tables.
+///
+/// The graph is either built from a graph_t, which freezes it into a compact
+/// form with contiguous sequence, edge and step arrays, or memory-mapped from
+/// a file. The on-disk layout is the in-memory layout, so a file written with
+/// serialize can be mmapped and queried without building any per-node
+/// records. Handles are the same as those of the graph_t the file was written
+/// from: node ranks (deleted slots included) packed with the orientation bit.
+/// Path handles are renumbered 1..path_count in path order.
+///
+/// File layout (all integers are 64-bit, native byte order):
+///   header_t
+///   seq_offset[node_slots+1]         -> into seq
+///   edge_offset[2*node_slots+1]      -> into edges, right then left side of each forward handle
+///   node_step_offset[node_slots+1]   -> into node_steps
+///   path_step_offset[path_count+1]   -> into steps
+///   path_name_offset[path_count+1]   -> into names
+///   path_flags[path_count]           -> bit 0 is circularity
+///   edges[edge_entries]              -> handle integers
+///   steps[step_count]                -> handle integers, path by path
+///   node_steps[2*step_count]         -> (path id, index into steps) for the steps on each node
+///   deleted[node_slots]              -> bytes, 1 for deleted node slots
+///   seq[seq_length]                  -> bytes
+///   names[name_length]               -> bytes
+class flat_graph_t : public PathHandleGraph {
+
+public:
+
+    flat_graph_t(void) = default;
+    ~flat_graph_t(void);
+
+    flat_graph_t(const flat_graph_t& other) = delete;
+    flat_graph_t& operator=(const flat_graph_t& other) = delete;
+
+    /// Magic bytes at the start of a flat graph file ("ODGIFLAT")
+    static constexpr uint64_t magic_number = 0x54414c464947444full;
+    /// Layout version written into the header
+    static constexpr uint64_t layout_version = 1;
+
+    /// Returns true if the file starts with the flat graph magic bytes
+    static bool is_flat_graph(const std::string& filename);
+
+    /// Build the flat layout of the given graph in memory, filling the node
+    /// and path sections in parallel
+    void from_graph(const graph_t& graph);
+
+    /// Write the layout, which can later be memory-mapped with load()
+    void serialize(std::ostream& out) const;
+
+    /// Memory-map a flat graph file
+    void load(const std::string& filename);
+
+    /// Release the mapping and any owned storage
+    void clear(void);
+
+    /// Method to check if a node exists by ID
+    bool has_node(nid_t node_id) const;
+
+    /// Look up the handle for the node with the given ID in the given orientation
+    handle_t get_handle(const nid_t& node_id, bool is_reverse = false) const;
+
+    /// Get the ID from a handle
+    nid_t get_id(const handle_t& handle) const;
+
+    /// Get the orientation of a handle
+    bool get_is_reverse(const handle_t& handle) const;
+
+    /// Invert the orientation of a handle (potentially without getting its ID)
+    handle_t flip(const handle_t& handle) const;
+
+    /// Get the length of a node
+    size_t get_length(const handle_t& handle) const;
+
+    /// Get the sequence of a node, presented in the handle's local forward orientation.
+    std::string get_sequence(const handle_t& handle) const;
+
+    /// Return the number of nodes in the graph
+    size_t get_node_count(void) const;
+
+    /// Return the smallest ID in the graph
+    nid_t min_node_id(void) const;
+
+    /// Return the largest ID in the graph
+    nid_t max_node_id(void) const;
+
+    /// Get the number of edges on the right (go_left = false) or left (go_left
+    /// = true) side of the given handle, read from the offset table.
+    size_t get_degree(const handle_t& handle, bool go_left) const;
+
+    /// Return the total number of edges in the graph
+    size_t get_edge_count(void) const;
+
+protected:
+
+    /// Loop over all the handles to next/previous (right/left) nodes.
+    bool follow_edges_impl(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const;
+
+    /// Loop over all the nodes in the graph in their local forward orientations.
+    bool for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel = false) const;
+
+public:
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Path handle interface
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// Returns the number of paths stored in the graph
+    size_t get_path_count(void) const;
+
+    /// Determine if a path name exists and is legal to get a path handle for.
+    bool has_path(const std::string& path_name) const;
+
+    /// Look up the path handle for the given path name.
+    path_handle_t get_path_handle(const std::string& path_name) const;
+
+    /// Look up the name of a path from a handle to it
+    std::string get_path_name(const path_handle_t& path_handle) const;
+
+    /// Look up whether a path is circular
+    bool get_is_circular(const path_handle_t& path_handle) const;
+
+    /// Returns the number of node steps in the path
+    size_t get_step_count(const path_handle_t& path_handle) const;
+
+    /// Returns the number of node steps on the handle
+    size_t get_step_count(const handle_t& handle) const;
+
+    /// Get a node handle (node ID and orientation) from a handle to a step on a path
+    handle_t get_handle_of_step(const step_handle_t& step_handle) const;
+
+    /// Returns a handle to the path that a step is on
+    path_handle_t get_path_handle_of_step(const step_handle_t& step_handle) const;
+
+    /// Get a handle to the first step, or path_end() for an empty path.
+    step_handle_t path_begin(const path_handle_t& path_handle) const;
+
+    /// Get a handle to a fictitious position past the end of a path.
+    step_handle_t path_end(const path_handle_t& path_handle) const;
+
+    /// Get a handle to the last step, or path_front_end() for an empty path.
+    step_handle_t path_back(const path_handle_t& path_handle) const;
+
+    /// Get a handle to a fictitious position before the beginning of a path.
+    step_handle_t path_front_end(const path_handle_t& path_handle) const;
+
+    /// Returns true if the step is not the last step in a non-circular path.
+    bool has_next_step(const step_handle_t& step_handle) const;
+
+    /// Returns true if the step is not the first step in a non-circular path.
+    bool has_previous_step(const step_handle_t& step_handle) const;
+
+    /// Returns a handle to the next step on the path
+    step_handle_t get_next_step(const step_handle_t& step_handle) const;
+
+    /// Returns a handle to the previous step on the path
+    step_handle_t get_previous_step(const step_handle_t& step_handle) const;
+
+protected:
+
+    /// Execute a function on each path in the graph
+    bool for_each_path_handle_impl(const std::function<bool(const path_handle_t&)>& iteratee) const;
+
+    /// Enumerate the path steps on a given handle (strand agnostic)
+    bool for_each_step_on_handle_impl(const handle_t& handle, const std::function<bool(const step_handle_t&)>& iteratee) const;
+
+public:
+
+    /// The fixed-size header at the start of the layout
+    struct header_t {
+        uint64_t magic;
+        uint64_t version;
+        uint64_t node_slots;
+        uint64_t node_count;
+        uint64_t edge_count;
+        uint64_t edge_entries;
+        uint64_t step_count;
+        uint64_t path_count;
+        uint64_t seq_length;
+        uint64_t name_length;
+        int64_t id_increment;
+        int64_t min_node_id;
+        int64_t max_node_id;
+    };
+
+    /// Total size in bytes of a layout with the counts given in the header
+    static uint64_t layout_size(const header_t& header);
+
+private:
+
+    /// Point the section pointers into a buffer holding a complete layout
+    void set_sections(const char* base);
+
+    /// Build the path name index
+    void index_path_names(void);
+
+    /// The step index one past the end of the given path, which is also its path_end()
+    inline uint64_t path_step_end(const path_handle_t& path_handle) const {
+        return path_step_offset[as_integer(path_handle)];
+    }
+    inline uint64_t path_step_begin(const path_handle_t& path_handle) const {
+        return path_step_offset[as_integer(path_handle)-1];
+    }
+    inline step_handle_t make_step(const uint64_t& path_id, const uint64_t& idx) const {
+        step_handle_t step;
+        as_integers(step)[0] = path_id;
+        as_integers(step)[1] = idx;
+        return step;
+    }
+
+    /// storage of a layout built with from_graph
+    std::vector<uint64_t> owned;
+
+    /// mapping state
+    int fd = -1;
+    char* mapped = nullptr;
+    uint64_t mapped_size = 0;
+
+    /// section pointers into the mapping
+    const header_t* header = nullptr;
+    const uint64_t* seq_offset = nullptr;
+    const uint64_t* edge_offset = nullptr;
+    const uint64_t* node_step_offset = nullptr;
+    const uint64_t* path_step_offset = nullptr;
+    const uint64_t* path_name_offset = nullptr;
+    const uint64_t* path_flags = nullptr;
+    const uint64_t* edges = nullptr;
+    const uint64_t* steps = nullptr;
+    const uint64_t* node_steps = nullptr;
+    const uint8_t* deleted = nullptr;
+    const char* seq = nullptr;
+    const char* names = nullptr;
+
+    /// path name to path id
+    string_hash_map<std::string, uint64_t> path_name_index;
+
+};
+
+}
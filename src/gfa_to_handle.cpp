@@ -1,4 +1,11 @@
 #include "gfa_to_handle.hpp"
+#include "odgi.hpp"
+#include "pansn.hpp"
+#include "atomic_bitvector.hpp"
+#include "edit_batch.hpp"
+#include <omp.h>
+#include <cstdlib>
+#include <cerrno>
 
 namespace odgi {
 
@@ -29,6 +36,19 @@ void gfa_to_handle(const string& gfa_filename,
                    bool compact_ids,
                    uint64_t n_threads,
                    bool progress) {
+    graph_t* g = dynamic_cast<graph_t*>(graph);
+    if (g != nullptr && g->get_node_count() == 0 && g->get_path_count() == 0) {
+        gfa_to_graph_parallel(gfa_filename, g, compact_ids, n_threads, progress);
+    } else {
+        gfa_to_handle_kluge(gfa_filename, graph, compact_ids, n_threads, progress);
+    }
+}
+
+void gfa_to_handle_kluge(const string& gfa_filename,
+                         handlegraph::MutablePathMutableHandleGraph* graph,
+                         bool compact_ids,
+                         uint64_t n_threads,
+                         bool progress) {
 
     n_threads = (n_threads == 0 ? 1 : n_threads);
     char* filename = (char*) gfa_filename.c_str();
@@ -62,6 +82,10 @@ void gfa_to_handle(const string& gfa_filename,
     uint64_t node_count = line_counts['S'];
     uint64_t edge_count = line_counts['L'];
     uint64_t path_count = line_counts['P'];
+    if (line_counts['W'] > 0) {
+        std::cerr << "[odgi::gfa_to_handle] warning: skipping " << line_counts['W']
+                  << " W-lines, which are only read by the parallel parser." << std::endl;
+    }
     // build the nodes
     {
         std::unique_ptr<algorithms::progress_meter::ProgressMeter> progress_meter;
@@ -195,4 +219,325 @@ void gfa_to_handle(const string& gfa_filename,
     }
 
 }
+
+namespace {
+
+/// A run of whole lines in the mapped GFA
+struct gfa_chunk_t {
+    const char* begin;
+    const char* end;
+};
+
+/// Split the buffer into about n_chunks runs of whole lines
+std::vector<gfa_chunk_t> split_into_chunks(const char* buf, const uint64_t size, const uint64_t n_chunks) {
+    std::vector<gfa_chunk_t> chunks;
+    const char* end = buf + size;
+    const char* begin = buf;
+    for (uint64_t i = 1; i <= n_chunks && begin < end; ++i) {
+        const char* cut = (i == n_chunks ? end : buf + size / n_chunks * i);
+        if (cut <= begin) continue;
+        while (cut < end && *(cut - 1) != '\n') ++cut;
+        chunks.push_back({begin, cut});
+        begin = cut;
+    }
+    return chunks;
+}
+
+/// The end of the line starting at p
+inline const char* line_end(const char* p, const char* end) {
+    const char* e = (const char*)memchr(p, '\n', end - p);
+    return e == nullptr ? end : e;
+}
+
+/// Read the tab-separated field starting at p and move p past its tab
+inline std::string_view next_field(const char*& p, const char* end) {
+    const char* q = p;
+    while (q < end && *q != '\t') ++q;
+    std::string_view field(p, q - p);
+    p = (q < end ? q + 1 : q);
+    // tolerate Windows line endings in the last field
+    if (!field.empty() && field.back() == '\r') field.remove_suffix(1);
+    return field;
+}
+
+/// Parse a node id, returning false if the field is not a number
+inline bool parse_id(const std::string_view& field, uint64_t& id) {
+    if (field.empty()) return false;
+    id = 0;
+    for (const char c : field) {
+        if (c < '0' || c > '9') return false;
+        id = id * 10 + (c - '0');
+    }
+    return true;
+}
+
+/// Call the function on each line in the chunk starting with the given record type
+template<typename F>
+void for_each_record(const gfa_chunk_t& chunk, const char type, const F& f) {
+    const char* p = chunk.begin;
+    while (p < chunk.end) {
+        const char* e = line_end(p, chunk.end);
+        if (*p == type && p + 1 < e && p[1] == '\t') {
+            f(p + 2, e);
+        }
+        p = e + 1;
+    }
+}
+
+}
+
+void gfa_to_graph_parallel(const string& gfa_filename,
+                           graph_t* graph,
+                           bool compact_ids,
+                           uint64_t n_threads,
+                           bool progress) {
+
+    n_threads = (n_threads == 0 ? 1 : n_threads);
+    int gfa_fd = -1;
+    char* gfa_buf = nullptr;
+    const size_t gfa_filesize = gfak::mmap_open(gfa_filename, gfa_buf, gfa_fd);
+    if (gfa_fd == -1) {
+        std::cerr << "[odgi::gfa_to_handle] error: couldn't open GFA file " << gfa_filename << "." << std::endl;
+        exit(1);
+    }
+    // several chunks per thread so that dynamic scheduling can balance uneven line lengths
+    const std::vector<gfa_chunk_t> chunks = split_into_chunks(gfa_buf, gfa_filesize, n_threads * 16);
+
+    // first pass: count the records and find the id range of the segments
+    std::vector<uint64_t> chunk_min_id(chunks.size(), std::numeric_limits<uint64_t>::max());
+    std::vector<uint64_t> chunk_max_id(chunks.size(), 0);
+    std::atomic<uint64_t> node_count(0), edge_count(0), path_count(0);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+    for (uint64_t c = 0; c < chunks.size(); ++c) {
+        uint64_t nodes = 0, edges = 0, paths = 0;
+        const char* p = chunks[c].begin;
+        const char* end = chunks[c].end;
+        while (p < end) {
+            const char* e = line_end(p, end);
+            if (p + 1 < e && p[1] == '\t') {
+                if (*p == 'S') {
+                    const char* q = p + 2;
+                    const std::string_view name = next_field(q, e);
+                    uint64_t id;
+                    if (!parse_id(name, id) || id == 0) {
+                        std::cerr << "[odgi::gfa_to_handle] Error parsing segment '" << name
+                                  << "': segment names must be positive integers" << std::endl;
+                        exit(1);
+                    }
+                    chunk_min_id[c] = std::min(chunk_min_id[c], id);
+                    chunk_max_id[c] = std::max(chunk_max_id[c], id);
+                    ++nodes;
+                } else if (*p == 'L') {
+                    ++edges;
+                } else if (*p == 'P' || *p == 'W') {
+                    ++paths;
+                }
+            }
+            p = e + 1;
+        }
+        node_count += nodes;
+        edge_count += edges;
+        path_count += paths;
+    }
+    uint64_t min_id = std::numeric_limits<uint64_t>::max();
+    uint64_t max_id = 0;
+    for (uint64_t c = 0; c < chunks.size(); ++c) {
+        min_id = std::min(min_id, chunk_min_id[c]);
+        max_id = std::max(max_id, chunk_max_id[c]);
+    }
+    const uint64_t id_increment = (compact_ids && node_count > 0 ? min_id - 1 : 0);
+
+    // build the nodes, each thread filling its own slots of the presized node vector
+    if (node_count > 0) {
+        std::unique_ptr<algorithms::progress_meter::ProgressMeter> progress_meter;
+        if (progress) {
+            progress_meter = std::make_unique<algorithms::progress_meter::ProgressMeter>(
+                node_count, "[odgi::gfa_to_handle] building nodes:");
+        }
+        graph->reserve_node_ids(max_id - id_increment);
+        // claim each id atomically, so that exactly one of two segments with the same id wins
+        // and the other reports the duplicate before anything is written to the slot
+        atomicbitvector::atomic_bv_t seen_ids(max_id - id_increment + 1);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+        for (uint64_t c = 0; c < chunks.size(); ++c) {
+            uint64_t created = 0;
+            for_each_record(chunks[c], 'S', [&](const char* p, const char* e) {
+                uint64_t id;
+                parse_id(next_field(p, e), id);
+                const std::string_view sequence = next_field(p, e);
+                if (seen_ids.set(id - id_increment)) {
+                    std::cerr << "[odgi::gfa_to_handle] Error creating node '" << id << "': duplicate segment" << std::endl;
+                    exit(1);
+                }
+                graph->create_reserved_handle(std::string(sequence), id - id_increment);
+                ++created;
+            });
+            if (progress) progress_meter->increment(created);
+        }
+        graph->sync_reserved_node_ids();
+        if (progress) {
+            progress_meter->finish();
+        }
+    }
+
+    // build the edges; the L-lines are parsed in parallel and queued in a batch, which writes the
+    // edge records of each node from one thread, so the graph does not depend on the thread count
+    if (edge_count > 0) {
+        std::unique_ptr<algorithms::progress_meter::ProgressMeter> progress_meter;
+        if (progress) {
+            progress_meter = std::make_unique<algorithms::progress_meter::ProgressMeter>(
+                edge_count, "[odgi::gfa_to_handle] building edges:");
+        }
+        edit_batch_t batch(*graph, n_threads);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+        for (uint64_t c = 0; c < chunks.size(); ++c) {
+            uint64_t created = 0;
+            for_each_record(chunks[c], 'L', [&](const char* p, const char* e) {
+                const std::string_view source_name = next_field(p, e);
+                const std::string_view source_orientation = next_field(p, e);
+                const std::string_view sink_name = next_field(p, e);
+                const std::string_view sink_orientation = next_field(p, e);
+                uint64_t source_id, sink_id;
+                if (!parse_id(source_name, source_id) || !parse_id(sink_name, sink_id)) {
+                    std::cerr << "[odgi::gfa_to_handle] Error creating edge '" << source_name << " <--> " << sink_name
+                              << "': segment names must be positive integers" << std::endl;
+                    exit(1);
+                }
+                source_id -= id_increment;
+                sink_id -= id_increment;
+                if (graph->has_node(source_id) && graph->has_node(sink_id)) {
+                    batch.create_edge(graph->get_handle(source_id, source_orientation == "-"),
+                                      graph->get_handle(sink_id, sink_orientation == "-"));
+                } else {
+                    std::cerr << "[odgi::gfa_to_handle] Error creating edge '" << source_name << " <--> " << sink_name
+                              << "' due to missing node(s)" << std::endl;
+                    exit(1);
+                }
+                ++created;
+            });
+            if (progress) progress_meter->increment(created);
+        }
+        batch.apply();
+        if (progress) {
+            progress_meter->finish();
+        }
+    }
+
+    if (path_count > 0) {
+        // path handles are created in file order, so that path ranks follow the GFA;
+        // P-lines keep their name, W-lines are named after their PanSN fields
+        struct path_record_t {
+            path_handle_t path;
+            const char* steps;
+            const char* end;
+            bool is_walk;
+        };
+        std::vector<path_record_t> path_records;
+        path_records.reserve(path_count);
+        auto create_path = [&](const std::string& name) {
+            if (graph->has_path(name)) {
+                std::cerr << "[odgi::gfa_to_handle] Error creating path '" << name << "': duplicate path name" << std::endl;
+                exit(1);
+            }
+            return graph->create_path_handle(name);
+        };
+        for (auto& chunk : chunks) {
+            const char* p = chunk.begin;
+            while (p < chunk.end) {
+                const char* e = line_end(p, chunk.end);
+                if (p + 1 < e && p[1] == '\t') {
+                    const char* q = p + 2;
+                    if (*p == 'P') {
+                        const std::string_view name = next_field(q, e);
+                        const char* steps = q;
+                        next_field(q, e);
+                        path_records.push_back({create_path(std::string(name)), steps, q, false});
+                    } else if (*p == 'W') {
+                        const std::string_view sample = next_field(q, e);
+                        const std::string_view haplotype = next_field(q, e);
+                        const std::string_view contig = next_field(q, e);
+                        const std::string_view start = next_field(q, e);
+                        const std::string_view end = next_field(q, e);
+                        const char* steps = q;
+                        next_field(q, e);
+                        path_records.push_back({create_path(pansn_walk_name(sample, haplotype, contig, start, end)),
+                                                steps, q, true});
+                    }
+                }
+                p = e + 1;
+            }
+        }
+        std::unique_ptr<algorithms::progress_meter::ProgressMeter> progress_meter;
+        if (progress) {
+            progress_meter = std::make_unique<algorithms::progress_meter::ProgressMeter>(
+                path_count, "[odgi::gfa_to_handle] building paths:");
+        }
+        auto append_step = [&](const path_handle_t& path, const std::string_view& name, const bool is_rev) {
+            uint64_t id;
+            if (!parse_id(name, id)) {
+                std::cerr << "[odgi::gfa_to_handle] id parsing failure for path "
+                          << graph->get_path_name(path)
+                          << " attempting to parse node id from '" << name << "'" << std::endl;
+                exit(1);
+            }
+            id -= id_increment;
+            if (!graph->has_node(id)) {
+                std::cerr << "[odgi::gfa_to_handle] Error creating path '" << graph->get_path_name(path)
+                          << "' due to missing node '" << name << "'" << std::endl;
+                exit(1);
+            }
+            graph->append_step(path, graph->get_handle(id, is_rev));
+        };
+        // each path is extended by a single thread, paths are spread over all of them
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+        for (uint64_t i = 0; i < path_records.size(); ++i) {
+            const auto& record = path_records[i];
+            const char* p = record.steps;
+            const char* end = record.end;
+            // the steps field is followed by a tab unless it ends the line
+            while (end > p && (*(end - 1) == '\t' || *(end - 1) == '\r')) --end;
+            if (record.is_walk) {
+                // a walk is a run of segment names, each preceded by > (forward) or < (reverse)
+                while (p < end) {
+                    const char* q = p + 1;
+                    while (q < end && *q != '>' && *q != '<') ++q;
+                    if (*p != '>' && *p != '<') {
+                        std::cerr << "[odgi::gfa_to_handle] id parsing failure for path "
+                                  << graph->get_path_name(record.path)
+                                  << " attempting to parse node id from '" << std::string_view(p, q - p) << "'" << std::endl;
+                        exit(1);
+                    }
+                    append_step(record.path, std::string_view(p + 1, q - p - 1), *p == '<');
+                    p = q;
+                }
+            } else {
+                while (p < end) {
+                    const char* q = p;
+                    while (q < end && *q != ',') ++q;
+                    // each step is a segment name followed by its orientation
+                    const std::string_view step(p, q - p);
+                    if (step.size() < 2 || (step.back() != '+' && step.back() != '-')) {
+                        std::cerr << "[odgi::gfa_to_handle] id parsing failure for path "
+                                  << graph->get_path_name(record.path)
+                                  << " attempting to parse node id from '" << step << "'" << std::endl;
+                        exit(1);
+                    }
+                    append_step(record.path, step.substr(0, step.size() - 1), step.back() == '-');
+                    p = q + 1;
+                }
+            }
+            if (progress) progress_meter->increment(1);
+        }
+        if (progress) {
+            progress_meter->finish();
+        }
+    }
+
+    gfak::mmap_close(gfa_buf, gfa_fd, gfa_filesize);
+
+    if (compact_ids) {
+        graph->optimize();
+    }
+}
+
 }
@@ -15,11 +15,14 @@
 #include <thread>
 #include <mutex>
 #include <functional>
+#include <string_view>
 #include "atomic_queue.h"
 #include "progress.hpp"
 
 namespace odgi {
 
+class graph_t;
+
 struct path_elem_t {
     handlegraph::path_handle_t path;
     gfak::path_elem gfak;
@@ -37,4 +40,22 @@ void gfa_to_handle(const string& gfa_filename,
                    uint64_t n_threads,
                    bool show_progress);
 
+/// Fills a handle graph from a GFA file using gfakluge, building nodes and edges
+/// on a single thread. Used for handle graphs other than graph_t.
+void gfa_to_handle_kluge(const string& gfa_filename,
+                         handlegraph::MutablePathMutableHandleGraph* graph,
+                         bool compact_ids,
+                         uint64_t n_threads,
+                         bool show_progress);
+
+/// Fills an empty graph_t from a GFA file. The mapped file is split into chunks of whole
+/// lines that are parsed on all threads; nodes go into a presized node vector, edges
+/// and path steps are inserted concurrently. W-lines become paths named
+/// sample#haplotype#contig, with :start-end when the walk gives its coordinates.
+void gfa_to_graph_parallel(const string& gfa_filename,
+                           graph_t* graph,
+                           bool compact_ids,
+                           uint64_t n_threads,
+                           bool show_progress);
+
 }
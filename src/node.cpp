@@ -1,4 +1,5 @@
 #include "node.hpp"
+#include <algorithm>
 
 namespace odgi {
 
@@ -25,6 +26,11 @@ const std::string& node_t::get_sequence() const {
 // encode an internal representation of an external id (adding if none exists)
 uint64_t node_t::encode(const uint64_t& other_id) {
     uint64_t delta = to_delta(other_id);
+#ifdef ODGI_FIXED_WIDTH_NODES
+    if (decoding.size() >= DECODING_INDEX_MIN_SIZE) {
+        return encode_indexed(delta);
+    }
+#endif
     uint64_t i = 0;
     uint64_t s = decoding.size();
     while (i < s && decoding.at(i) != delta) {
@@ -36,6 +42,33 @@ uint64_t node_t::encode(const uint64_t& other_id) {
     return i;
 }
 
+#ifdef ODGI_FIXED_WIDTH_NODES
+// binary search the delta in the index, rebuilding it if the table has changed under it
+uint64_t node_t::encode_indexed(const uint64_t& delta) {
+    if (decoding_index.size() != decoding.size()) {
+        decoding_index.resize(decoding.size());
+        for (uint64_t i = 0; i < decoding_index.size(); ++i) {
+            decoding_index[i] = i;
+        }
+        std::sort(decoding_index.begin(), decoding_index.end(),
+                  [&](const uint64_t& a, const uint64_t& b) {
+                      return decoding.at(a) < decoding.at(b);
+                  });
+    }
+    auto f = std::lower_bound(decoding_index.begin(), decoding_index.end(), delta,
+                              [&](const uint64_t& i, const uint64_t& d) {
+                                  return decoding.at(i) < d;
+                              });
+    if (f != decoding_index.end() && decoding.at(*f) == delta) {
+        return *f;
+    }
+    uint64_t i = decoding.size();
+    decoding.push_back(delta);
+    decoding_index.insert(f, i);
+    return i;
+}
+#endif
+
 // decode an internal representation of an external id
 uint64_t node_t::decode(const uint64_t& idx) const {
     return from_delta(decoding.at(idx));
@@ -316,18 +349,21 @@ void node_t::clear() {
 }
 
 void node_t::clear_edges() {
-    dyn::hacked_vector null_iv;
+    record_vector_t null_iv;
     edges = null_iv;
 }
 
 void node_t::clear_paths() {
-    dyn::hacked_vector null_iv;
+    record_vector_t null_iv;
     paths = null_iv;
 }
 
 void node_t::clear_encoding() {
-    dyn::hacked_vector null_iv;
+    record_vector_t null_iv;
     decoding = null_iv;
+#ifdef ODGI_FIXED_WIDTH_NODES
+    std::vector<uint64_t>().swap(decoding_index);
+#endif
 }
 
 void node_t::copy(const node_t& other) {
@@ -388,7 +424,7 @@ void node_t::apply_ordering(
         }
     }
     // rewrite the edges, reflecting the orientation information we're given
-    dyn::hacked_vector new_edges;
+    record_vector_t new_edges;
     for_each_edge(
         [&](uint64_t other_id,
             bool other_rev,
@@ -439,6 +475,7 @@ void node_t::load(std::istream& in) {
     in.read((char*)sequence.c_str(), len*sizeof(uint8_t));
     in.read((char*)&id, sizeof(id));
     edges.load(in);
+    clear_encoding();
     decoding.load(in); 
     paths.load(in);
     //display();
@@ -14,6 +14,9 @@
 #include "dynamic.hpp"
 #include "varint.hpp"
 #include "dna.hpp"
+#ifdef ODGI_FIXED_WIDTH_NODES
+#include "fixed_vector.hpp"
+#endif
 
 namespace odgi {
 
@@ -22,14 +25,29 @@ using namespace handlegraph;
 const uint8_t EDGE_RECORD_LENGTH = 2;
 const uint8_t PATH_RECORD_LENGTH = 6;
 
+/// The storage of the edge, decoding and path step records of a node: bit-packed by default, or
+/// one word per entry when built with ODGI_FIXED_WIDTH_NODES (cmake -DFIXED_WIDTH_NODES=ON)
+#ifdef ODGI_FIXED_WIDTH_NODES
+typedef fixed_vector record_vector_t;
+/// the size of the decoding table from which encode() looks up ids through a sorted index
+const uint64_t DECODING_INDEX_MIN_SIZE = 16;
+#else
+typedef dyn::hacked_vector record_vector_t;
+#endif
+
 /// A node object with the sequence, its edge lists, and paths
 class node_t {
     uint64_t id = 0;
     std::atomic_flag lock = ATOMIC_FLAG_INIT;
     std::string sequence;
-    dyn::hacked_vector edges;
-    dyn::hacked_vector decoding;
-    dyn::hacked_vector paths;
+    record_vector_t edges;
+    record_vector_t decoding;
+    record_vector_t paths;
+#ifdef ODGI_FIXED_WIDTH_NODES
+    /// the positions in the decoding table ordered by delta, built on demand for large tables
+    std::vector<uint64_t> decoding_index;
+    uint64_t encode_indexed(const uint64_t& delta);
+#endif
     // relativistic conversions
     inline uint64_t to_delta(const uint64_t& other_id) const {
         if (other_id > id) {
@@ -541,6 +541,38 @@ handle_t graph_t::create_handle(const std::string& sequence, const nid_t& id) {
     return number_bool_packing::pack(handle_rank, 0);
 }
 
+void graph_t::reserve_node_ids(const nid_t& max_id) {
+    if ((uint64_t)max_id > node_v.size()) {
+        node_v.resize((uint64_t)max_id, nullptr);
+    }
+}
+
+handle_t graph_t::create_reserved_handle(const std::string& sequence, const nid_t& id) {
+    assert(id > 0 && (uint64_t)id <= node_v.size());
+    uint64_t handle_rank = (uint64_t)id-1;
+    assert(node_v[handle_rank] == nullptr);
+    node_t* n = new node_t();
+    n->set_id(id);
+    n->set_sequence(sequence);
+    node_v[handle_rank] = n;
+    return number_bool_packing::pack(handle_rank, 0);
+}
+
+void graph_t::sync_reserved_node_ids(void) {
+    deleted_nodes.clear();
+    uint64_t min_id = 0, max_id = 0;
+    for (uint64_t i = 0; i < node_v.size(); ++i) {
+        if (node_v[i] == nullptr) {
+            deleted_nodes.insert(i+1);
+        } else {
+            if (!min_id) min_id = i+1;
+            max_id = i+1;
+        }
+    }
+    _min_node_id = min_id;
+    _max_node_id = max_id;
+}
+
 /// Remove the node belonging to the given handle and all of its edges.
 /// Does not update any stored paths.
 /// Invalidates the destroyed handle.
@@ -625,7 +657,6 @@ void graph_t::create_edge(const handle_t& left_h, const handle_t& right_h) {
                            get_is_reverse(right_h),
                            false,
                            get_is_reverse(left_h));
-        left_node.clear_lock();
         // only insert the second side if it's on a different node
         if (left_rank != right_rank) {
             right_node.add_edge(get_id(left_h),
@@ -1727,4 +1758,20 @@ void graph_t::copy(const graph_t& other) {
         });
 }
 
+void graph_t::swap(graph_t& other) {
+    auto swap_atomic = [](auto& a, auto& b) {
+        a.store(b.exchange(a.load()));
+    };
+    std::swap(node_v, other.node_v);
+    std::swap(deleted_nodes, other.deleted_nodes);
+    std::swap(path_metadata_h, other.path_metadata_h);
+    std::swap(path_name_h, other.path_name_h);
+    swap_atomic(_max_node_id, other._max_node_id);
+    swap_atomic(_min_node_id, other._min_node_id);
+    swap_atomic(_id_increment, other._id_increment);
+    swap_atomic(_edge_count, other._edge_count);
+    swap_atomic(_path_count, other._path_count);
+    swap_atomic(_path_handle_next, other._path_handle_next);
+}
+
 }
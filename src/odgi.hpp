@@ -258,6 +258,18 @@ public:
     /// Create a new node with the given id and sequence, then return the handle.
     handle_t create_handle(const std::string& sequence, const nid_t& id);
 
+    /// Size the node vector for ids up to max_id, so that nodes can then be
+    /// created concurrently with create_reserved_handle.
+    void reserve_node_ids(const nid_t& max_id);
+
+    /// Create a node in a slot sized by reserve_node_ids. Safe to call from
+    /// many threads at once as long as the ids are distinct. The free slot
+    /// list and id range are only updated by sync_reserved_node_ids.
+    handle_t create_reserved_handle(const std::string& sequence, const nid_t& id);
+
+    /// Recompute the free slots and the id range after create_reserved_handle.
+    void sync_reserved_node_ids(void);
+
     /// Remove the node belonging to the given handle and all of its edges.
     /// Does not update any stored paths.
     /// Invalidates the destroyed handle.
@@ -421,6 +433,9 @@ public:
     /// copy the other graph into this one
     void copy(const graph_t& other);
 
+    /// exchange the nodes, edges and paths of this graph with those of the other one
+    void swap(graph_t& other);
+
 /// These are the backing data structures that we use to fulfill the above functions
 
     /// Records the handle to node_id mapping
@@ -0,0 +1,67 @@
+#include "ordered_output.hpp"
+
+#include <chrono>
+
+namespace odgi {
+
+/// Spin a little, then yield, then sleep, while waiting for another thread
+static void back_off(uint64_t& rounds) {
+    if (rounds < 64) {
+        ++rounds;
+    } else if (rounds < 256) {
+        ++rounds;
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+ordered_output_t::ordered_output_t(std::ostream& out, const uint64_t& ring_size)
+    : out(out), slots(ring_size) {
+    writer = std::thread(&ordered_output_t::drain, this);
+}
+
+ordered_output_t::~ordered_output_t() {
+    finish();
+}
+
+void ordered_output_t::write(const uint64_t& seq, std::string&& text) {
+    uint64_t rounds = 0;
+    while (seq >= next.load(std::memory_order_acquire) + slots.size()) {
+        back_off(rounds);
+    }
+    slot_t& slot = slots[seq % slots.size()];
+    slot.text = std::move(text);
+    slot.ready.store(true, std::memory_order_release);
+    written.fetch_add(1, std::memory_order_release);
+}
+
+void ordered_output_t::drain() {
+    uint64_t rounds = 0;
+    while (true) {
+        const uint64_t seq = next.load(std::memory_order_relaxed);
+        slot_t& slot = slots[seq % slots.size()];
+        if (slot.ready.load(std::memory_order_acquire)) {
+            out << slot.text;
+            slot.text.clear();
+            slot.text.shrink_to_fit();
+            slot.ready.store(false, std::memory_order_relaxed);
+            next.store(seq + 1, std::memory_order_release);
+            rounds = 0;
+        } else if (done.load(std::memory_order_acquire) && seq == written.load(std::memory_order_acquire)) {
+            break;
+        } else {
+            back_off(rounds);
+        }
+    }
+    out.flush();
+}
+
+void ordered_output_t::finish() {
+    if (writer.joinable()) {
+        done.store(true, std::memory_order_release);
+        writer.join();
+    }
+}
+
+}
@@ -0,0 +1,55 @@
+//
+//  odgi
+//
+//  ordered_output.hpp
+//
+//  Writes the output of parallel tasks to a stream in task order
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace odgi {
+
+/// Each task of a parallel loop fills its own string and hands it over under its sequence
+/// number, 0, 1, 2, ... with exactly one write per number. A writer thread drains the strings to
+/// the stream in sequence order, so the output does not depend on the scheduling and the tasks
+/// never wait on the stream. The hand-over goes through a ring of slots without locks; a task
+/// that runs more than a ring ahead of the writer waits for it to catch up, which bounds the
+/// buffered output. This cannot stall as long as each thread hands over its own numbers in
+/// increasing order, as the threads of an OpenMP loop do.
+class ordered_output_t {
+public:
+    explicit ordered_output_t(std::ostream& out, const uint64_t& ring_size = 1 << 12);
+    /// finishes the output
+    ~ordered_output_t();
+
+    /// hand over the output of the task with this sequence number; it may be empty
+    void write(const uint64_t& seq, std::string&& text);
+    /// wait until the writer has written every string handed over, then stop it
+    void finish();
+
+private:
+    struct slot_t {
+        std::atomic<bool> ready{false};
+        std::string text;
+    };
+
+    std::ostream& out;
+    std::vector<slot_t> slots;
+    /// the sequence number the writer waits for
+    std::atomic<uint64_t> next{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<bool> done{false};
+    std::thread writer;
+
+    void drain();
+};
+
+}
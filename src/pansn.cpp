@@ -0,0 +1,109 @@
+#include "pansn.hpp"
+
+#include <algorithm>
+#include <omp.h>
+
+namespace odgi {
+
+std::string pansn_walk_name(const std::string_view& sample,
+                            const std::string_view& haplotype,
+                            const std::string_view& contig,
+                            const std::string_view& start,
+                            const std::string_view& end) {
+    std::string name;
+    name.reserve(sample.size() + haplotype.size() + contig.size() + start.size() + end.size() + 4);
+    name.append(sample);
+    name.push_back(pansn_separator);
+    name.append(haplotype);
+    name.push_back(pansn_separator);
+    name.append(contig);
+    if (!start.empty() && start != "*" && !end.empty() && end != "*") {
+        name.push_back(':');
+        name.append(start);
+        name.push_back('-');
+        name.append(end);
+    }
+    return name;
+}
+
+pansn_index_t::pansn_index_t(const PathHandleGraph& graph, const uint64_t num_threads) : graph(graph) {
+    std::vector<path_handle_t> paths;
+    paths.reserve(graph.get_path_count());
+    uint64_t max_path = 0;
+    graph.for_each_path_handle([&](const path_handle_t& path) {
+        paths.push_back(path);
+        max_path = std::max(max_path, (uint64_t)as_integer(path));
+    });
+    path_sample.resize(max_path + 1, 0);
+    path_haplotype.resize(max_path + 1, 0);
+    path_contig_start.resize(max_path + 1, 0);
+
+    // split every name once
+    std::vector<std::string> samples(paths.size());
+    std::vector<std::string> haplotypes(paths.size());
+#pragma omp parallel for schedule(dynamic, 1024) num_threads(num_threads)
+    for (uint64_t i = 0; i < paths.size(); ++i) {
+        const std::string name = graph.get_path_name(paths[i]);
+        const size_t first = name.find(pansn_separator);
+        const size_t second = first == std::string::npos ? first : name.find(pansn_separator, first + 1);
+        uint64_t& contig_start = path_contig_start[as_integer(paths[i])];
+        if (first == std::string::npos) {
+            samples[i] = name;
+            haplotypes[i] = name;
+            contig_start = 0;
+        } else if (second == std::string::npos) {
+            samples[i] = name.substr(0, first);
+            haplotypes[i] = samples[i];
+            contig_start = first + 1;
+        } else {
+            samples[i] = name.substr(0, first);
+            haplotypes[i] = name.substr(0, second);
+            contig_start = second + 1;
+        }
+    }
+
+    auto sorted_unique = [](std::vector<std::string> v) {
+        std::sort(v.begin(), v.end());
+        v.erase(std::unique(v.begin(), v.end()), v.end());
+        return v;
+    };
+    sample_names = sorted_unique(samples);
+    haplotype_names = sorted_unique(haplotypes);
+
+#pragma omp parallel for schedule(dynamic, 1024) num_threads(num_threads)
+    for (uint64_t i = 0; i < paths.size(); ++i) {
+        const uint64_t p = as_integer(paths[i]);
+        path_sample[p] = std::lower_bound(sample_names.begin(), sample_names.end(), samples[i]) - sample_names.begin();
+        path_haplotype[p] = std::lower_bound(haplotype_names.begin(), haplotype_names.end(), haplotypes[i]) - haplotype_names.begin();
+    }
+}
+
+uint64_t pansn_index_t::sample_count(void) const {
+    return sample_names.size();
+}
+
+uint64_t pansn_index_t::haplotype_count(void) const {
+    return haplotype_names.size();
+}
+
+uint64_t pansn_index_t::sample_of(const path_handle_t& path) const {
+    return path_sample[as_integer(path)];
+}
+
+uint64_t pansn_index_t::haplotype_of(const path_handle_t& path) const {
+    return path_haplotype[as_integer(path)];
+}
+
+const std::string& pansn_index_t::sample_name(const uint64_t& sample) const {
+    return sample_names[sample];
+}
+
+const std::string& pansn_index_t::haplotype_name(const uint64_t& haplotype) const {
+    return haplotype_names[haplotype];
+}
+
+std::string pansn_index_t::contig_of(const path_handle_t& path) const {
+    return graph.get_path_name(path).substr(path_contig_start[as_integer(path)]);
+}
+
+}
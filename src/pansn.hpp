@@ -0,0 +1,81 @@
+//
+//  odgi
+//
+//  pansn.hpp
+//
+//  PanSN path naming (sample#haplotype#contig) and a per-graph index of its fields
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <handlegraph/types.hpp>
+#include <handlegraph/path_handle_graph.hpp>
+
+namespace odgi {
+
+using namespace handlegraph;
+
+/// Separator between the fields of a PanSN path name
+constexpr char pansn_separator = '#';
+
+/// Name the path of a GFA W-line following PanSN, sample#haplotype#contig.
+/// When the walk gives its coordinates on the contig, :start-end is appended.
+std::string pansn_walk_name(const std::string_view& sample,
+                            const std::string_view& haplotype,
+                            const std::string_view& contig,
+                            const std::string_view& start,
+                            const std::string_view& end);
+
+/// The PanSN fields of every path in a graph.
+///
+/// Each path name is split once, in parallel, when the index is built. Samples
+/// and haplotypes are numbered densely in the sorted order of their names, so
+/// grouping paths by sample or haplotype is a vector lookup. Names with a single
+/// field are their own sample; names with two fields (sample#contig) use the
+/// sample as their haplotype.
+class pansn_index_t {
+
+public:
+
+    pansn_index_t(const PathHandleGraph& graph, const uint64_t num_threads = 1);
+
+    /// Number of distinct samples
+    uint64_t sample_count(void) const;
+
+    /// Number of distinct haplotypes
+    uint64_t haplotype_count(void) const;
+
+    /// Dense id of the sample of the path
+    uint64_t sample_of(const path_handle_t& path) const;
+
+    /// Dense id of the haplotype of the path
+    uint64_t haplotype_of(const path_handle_t& path) const;
+
+    /// Name of the sample with the given id
+    const std::string& sample_name(const uint64_t& sample) const;
+
+    /// Name of the haplotype with the given id, sample#haplotype
+    const std::string& haplotype_name(const uint64_t& haplotype) const;
+
+    /// The contig field of the path name, including any :start-end suffix
+    std::string contig_of(const path_handle_t& path) const;
+
+private:
+
+    const PathHandleGraph& graph;
+
+    /// per path, indexed by the path handle's integer
+    std::vector<uint64_t> path_sample;
+    std::vector<uint64_t> path_haplotype;
+    std::vector<uint64_t> path_contig_start;
+
+    std::vector<std::string> sample_names;
+    std::vector<std::string> haplotype_names;
+
+};
+
+}
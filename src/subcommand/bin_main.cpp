@@ -47,6 +47,9 @@ int main_bin(int argc, char** argv) {
                                                           " Such links solely connecting a path from left to right may not be"
                                                           "relevant to understand a path's traveral through the bins. Therfore,"
                                                           " when this option is set, the gap-links are left out saving disk space.", {'g', "no-gap-links"});
+    args::Flag frozen(bin_opts, "frozen",
+                      "Load the graph into the compact read-only layout.",
+                      {"frozen"});
     args::Group haplo_blocker_opts(parser, "[ HaploBlocker Options ]");
     args::Flag haplo_blocker(haplo_blocker_opts, "haplo-blocker", "Write a TSV to stdout formatted in a "
                                                                   "way ready for HaploBlocker: Each row corresponds to a node. "
@@ -84,16 +87,11 @@ int main_bin(int argc, char** argv) {
 
 	const uint64_t num_threads = args::get(nthreads) ? args::get(nthreads) : 1;
 
-	graph_t graph;
+	graph_t dynamic_graph;
+	flat_graph_t flat_graph;
     assert(argc > 0);
-    if (!args::get(dg_in_file).empty()) {
-        std::string infile = args::get(dg_in_file);
-        if (infile == "-") {
-            graph.deserialize(std::cin);
-        } else {
-			utils::handle_gfa_odgi_input(infile, "bin", args::get(progress), num_threads, graph);
-        }
-    }
+    const PathHandleGraph& graph = utils::handle_read_only_input(args::get(dg_in_file), "bin", args::get(progress), num_threads,
+                                                                 args::get(frozen), dynamic_graph, flat_graph);
 
     std::string delim = args::get(path_delim);
     bool agg_delim = args::get(aggregate_delim);
@@ -165,57 +163,59 @@ int main_bin(int argc, char** argv) {
                     }
                 };
 
-        std::function<void(const vector<std::pair<uint64_t , uint64_t >>&)> write_ranges_json
-                = [&](const vector<std::pair<uint64_t , uint64_t >>& ranges) {
-                    std::cout << "[";
+        std::function<void(std::ostream&, const vector<std::pair<uint64_t , uint64_t >>&)> write_ranges_json
+                = [&](std::ostream& out, const vector<std::pair<uint64_t , uint64_t >>& ranges) {
+                    out << "[";
                     for (int i = 0; i < ranges.size(); i++) {
                         std::pair<uint64_t, uint64_t > range = ranges[i];
                         if (i == 0) {
-                            std::cout << "[" << range.first << "," << range.second << "]";
+                            out << "[" << range.first << "," << range.second << "]";
                         } else {
-                            std::cout << "," << "[" << range.first << "," << range.second << "]";
+                            out << "," << "[" << range.first << "," << range.second << "]";
                         }
                     }
-                    std::cout << "]";
+                    out << "]";
                 };
 
-        std::function<void(const std::string&,
+        std::function<void(std::ostream&,
+                           const std::string&,
                            const std::vector<std::pair<uint64_t, uint64_t>>&,
-                           const std::map<uint64_t, algorithms::path_info_t>&)> write_json
-                = [&](const std::string& path_name,
+                           const algorithms::path_bins_t&)> write_json
+                = [&](std::ostream& out,
+                      const std::string& path_name,
                       const std::vector<std::pair<uint64_t, uint64_t>>& links,
-                      const std::map<uint64_t, algorithms::path_info_t>& bins) {
+                      const algorithms::path_bins_t& bins) {
                     std::string name_prefix = get_path_prefix(path_name);
                     std::string name_suffix = get_path_suffix(path_name);
-                    std::cout << R"({"path_name":")" << path_name << "\",";
+                    out << R"({"path_name":")" << path_name << "\",";
                     if (!delim.empty()) {
-                        std::cout << "\"path_name_prefix\":\"" << name_prefix << "\","
-                                  << "\"path_name_suffix\":\"" << name_suffix << "\",";
+                        out << "\"path_name_prefix\":\"" << name_prefix << "\","
+                            << "\"path_name_suffix\":\"" << name_suffix << "\",";
                     }
-                    std::cout << "\"bins\":[";
+                    out << "\"bins\":[";
                     auto entry_it = bins.begin();
                     for (uint64_t i = 0; i < bins.size(); ++i) {
                         auto& bin_id = entry_it->first;
                         auto &info = entry_it->second;
-                        std::cout << "[" << bin_id << ","
-                                  << info.mean_depth << ","
-                                  << info.mean_inv << ","
-                                  << info.mean_pos << ",";
-                        write_ranges_json(info.ranges);
-                        std::cout << "]";
+                        out << "[" << bin_id << ","
+                            << info.mean_depth << ","
+                            << info.mean_inv << ","
+                            << info.mean_pos << ",";
+                        write_ranges_json(out, info.ranges);
+                        out << "]";
                         if (i+1 != bins.size()) {
-                            std::cout << ",";
+                            out << ",";
                         }
                         ++entry_it;
                     }
-                    std::cout << "]";
-                    std::cout << ",\"links\":[";
+                    out << "]";
+                    out << ",\"links\":[";
                     for (uint64_t i = 0; i < links.size(); ++i) {
                         auto &link = links[i];
-                        std::cout << "[" << link.first << "," << link.second << "]";
-                        if (i + 1 < links.size()) std::cout << ",";
+                        out << "[" << link.first << "," << link.second << "]";
+                        if (i + 1 < links.size()) out << ",";
                     }
-                    std::cout << "]}" << std::endl;
+                    out << "]}\n";
                 };
 
         std::function<void(const uint64_t&,
@@ -223,30 +223,32 @@ int main_bin(int argc, char** argv) {
                 = [&](const uint64_t& bin_id, const std::string& seq) {
                 };
 
-        std::function<void(const std::string&,
+        std::function<void(std::ostream&,
+                           const std::string&,
                            const std::vector<std::pair<uint64_t, uint64_t>>&,
-                           const std::map<uint64_t, algorithms::path_info_t>&)> write_tsv
-                = [&](const std::string& path_name,
+                           const algorithms::path_bins_t&)> write_tsv
+                = [&](std::ostream& out,
+                      const std::string& path_name,
                       const std::vector<std::pair<uint64_t, uint64_t>>& links,
-                      const std::map<uint64_t, algorithms::path_info_t>& bins) {
+                      const algorithms::path_bins_t& bins) {
                     std::string name_prefix = get_path_prefix(path_name);
                     std::string name_suffix = get_path_suffix(path_name);
                     for (auto& entry : bins) {
                         auto& bin_id = entry.first;
                         auto& info = entry.second;
                         if (info.mean_depth > 0) {
-                            std::cout << path_name << "\t"
-                                      << name_prefix << "\t"
-                                      << name_suffix << "\t"
-                                      << bin_id << "\t"
-                                      << info.mean_depth << "\t"
-                                      << info.mean_inv << "\t"
-                                      << info.mean_pos << "\t"
-                                      << info.ranges[0].first << "\t";
+                            out << path_name << "\t"
+                                << name_prefix << "\t"
+                                << name_suffix << "\t"
+                                << bin_id << "\t"
+                                << info.mean_depth << "\t"
+                                << info.mean_inv << "\t"
+                                << info.mean_pos << "\t"
+                                << info.ranges[0].first << "\t";
                             if (info.ranges[info.ranges.size() - 1].second == 0) {
-                                std::cout << info.ranges[info.ranges.size() - 1].first << std::endl;
+                                out << info.ranges[info.ranges.size() - 1].first << "\n";
                             } else {
-                                std::cout << info.ranges[info.ranges.size() - 1].second << std::endl;
+                                out << info.ranges[info.ranges.size() - 1].second << "\n";
                             }
                         }
                     }
@@ -255,8 +257,8 @@ int main_bin(int argc, char** argv) {
         if (args::get(output_json)) {
             algorithms::bin_path_info(graph, (args::get(aggregate_delim) ? args::get(path_delim) : ""),
                                       write_header_json,write_json, write_seq_json,
-                                      args::get(num_bins), args::get(bin_width), args::get(drop_gap_links),
-                                      args::get(progress));
+                                      std::cout, args::get(num_bins), args::get(bin_width), args::get(drop_gap_links),
+                                      args::get(progress), num_threads);
         } else {
             std::cout << "path.name" << "\t"
                       << "path.prefix" << "\t"
@@ -269,8 +271,8 @@ int main_bin(int argc, char** argv) {
                       << "last.nucl" << std::endl;
             algorithms::bin_path_info(graph, (args::get(aggregate_delim) ? args::get(path_delim) : ""),
                                       write_header_tsv,write_tsv, write_seq_noop,
-                                      args::get(num_bins), args::get(bin_width), args::get(drop_gap_links),
-                                      args::get(progress));
+                                      std::cout, args::get(num_bins), args::get(bin_width), args::get(drop_gap_links),
+                                      args::get(progress), num_threads);
         }
     }
     return 0;
@@ -95,7 +95,8 @@ int main_break(int argc, char** argv) {
         }
     } else {
         const uint64_t removed_edges
-            = algorithms::break_cycles(graph, args::get(max_cycle_size), args::get(max_search_bp), iter_max);
+            = algorithms::break_cycles(graph, args::get(max_cycle_size), args::get(max_search_bp), iter_max,
+                                        num_threads);
         if (removed_edges > 0) {
             graph.clear_paths();
         }
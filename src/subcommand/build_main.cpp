@@ -38,6 +38,8 @@ int main_build(int argc, char** argv) {
     args::Flag debug(processing_information, "debug", "Verbosely print graph information to stderr. This includes the maximum"
                                                       "  node_id, the minimum node_id, the handle to node_id mapping, the"
                                                       "  deleted nodes and the path metadata.", {'d', "debug"});
+    args::Flag legacy_parser(processing_information, "legacy-parser", "Read the GFA with the single-threaded gfakluge"
+                                                                       " parser instead of the chunked parallel parser.", {"legacy-parser"});
     args::Group program_information(parser, "[ Program Information ]");
     args::HelpFlag help(program_information, "help", "Print a help message for odgi build.", {'h', "help"});
     try {
@@ -74,7 +76,11 @@ int main_build(int argc, char** argv) {
             return 1;
         }
         if (!gfa_filename.empty()) {
-            gfa_to_handle(gfa_filename, &graph, args::get(optimize), args::get(nthreads), args::get(progress));
+            if (args::get(legacy_parser)) {
+                gfa_to_handle_kluge(gfa_filename, &graph, args::get(optimize), args::get(nthreads), args::get(progress));
+            } else {
+                gfa_to_handle(gfa_filename, &graph, args::get(optimize), args::get(nthreads), args::get(progress));
+            }
         }
     }
 
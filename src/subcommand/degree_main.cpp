@@ -2,6 +2,8 @@
 #include "odgi.hpp"
 #include "args.hxx"
 #include "split.hpp"
+#include "utils.hpp"
+#include "ordered_output.hpp"
 #include "subgraph/region.hpp"
 #include <omp.h>
 #include "algorithms/degree.hpp"
@@ -73,6 +75,9 @@ int main_degree(int argc, char** argv) {
                                               "Print to stdout a BED file of path intervals where the degree is outside of MIN and MAX, "
                                               "merging regions not separated by more than LEN bp.",
 											  {'W', "windows-out"});
+    args::Flag frozen(degree_opts, "frozen",
+                      "Load the graph into the compact read-only layout.",
+                      {"frozen"});
     args::Group threading_opts(parser, "[ Threading ]");
     args::ValueFlag<uint64_t> _num_threads(threading_opts, "N", "Number of threads to use for parallel operations.", {'t', "threads"});
 	args::Group processing_info_opts(parser, "[ Processing Information ]");
@@ -129,16 +134,11 @@ int main_degree(int argc, char** argv) {
 
 	const uint64_t num_threads = args::get(_num_threads) ? args::get(_num_threads) : 1;
 
-	odgi::graph_t graph;
+	odgi::graph_t dynamic_graph;
+	odgi::flat_graph_t flat_graph;
     assert(argc > 0);
-    if (!args::get(og_file).empty()) {
-        std::string infile = args::get(og_file);
-        if (infile == "-") {
-            graph.deserialize(std::cin);
-        } else {
-			utils::handle_gfa_odgi_input(infile, "degree", args::get(progress), num_threads, graph);
-        }
-    }
+    const PathHandleGraph& graph = utils::handle_read_only_input(args::get(og_file), "degree", args::get(progress), num_threads,
+                                                                 args::get(frozen), dynamic_graph, flat_graph);
 
     omp_set_num_threads((int) num_threads);
 	const uint64_t shift = graph.min_node_id();
@@ -175,7 +175,7 @@ int main_degree(int argc, char** argv) {
 	std::vector<odgi::path_range_t> path_ranges;
 
 	// TODO refactor this into a file, we are using this in odgi depth, odgi position, ....
-	auto add_graph_pos = [&graph_positions](const odgi::graph_t &graph,
+	auto add_graph_pos = [&graph_positions](const PathHandleGraph &graph,
 											const std::string &buffer) {
 		auto vals = split(buffer, ',');
 		uint64_t id = std::stoi(vals[0]);
@@ -201,7 +201,7 @@ int main_degree(int argc, char** argv) {
 	};
 
 	// TODO refactor this into a file, we are using this in odgi depth, odgi position, ....
-	auto add_path_pos = [&path_positions](const odgi::graph_t &graph,
+	auto add_path_pos = [&path_positions](const PathHandleGraph &graph,
 										  const std::string &buffer) {
 		if (!buffer.empty()) {
 			auto vals = split(buffer, ',');
@@ -262,8 +262,10 @@ int main_degree(int argc, char** argv) {
 					}
 				});
 		// for each path handle
+		ordered_output_t output(std::cout);
 #pragma omp parallel for schedule(dynamic, 1)
-		for (auto& path : paths) {
+		for (uint64_t i = 0; i < paths.size(); ++i) {
+			const path_handle_t& path = paths[i];
 			std::stringstream ss;
 			ss << graph.get_path_name(path);
 			// for each step
@@ -278,8 +280,8 @@ int main_degree(int argc, char** argv) {
 							ss << " " << degree;
 						}
 					});
-#pragma omp critical (cout)
-			std::cout << ss.str() << std::endl;
+			ss << "\n";
+			output.write(i, ss.str());
 		}
 	} else if (self_degree) {
 		std::vector<path_handle_t> paths;
@@ -290,8 +292,10 @@ int main_degree(int argc, char** argv) {
 					}
 				});
 		// for each path handle
+		ordered_output_t output(std::cout);
 #pragma omp parallel for schedule(dynamic, 1)
-		for (auto& path : paths) {
+		for (uint64_t i = 0; i < paths.size(); ++i) {
+			const path_handle_t& path = paths[i];
 			std::stringstream ss;
 			ss << graph.get_path_name(path);
 			// for each step
@@ -313,8 +317,8 @@ int main_degree(int argc, char** argv) {
 							ss << " " << degree;
 						}
 					});
-#pragma omp critical (cout)
-			std::cout << ss.str() << std::endl;
+			ss << "\n";
+			output.write(i, ss.str());
 		}
 	} else if (graph_pos) {
 		add_graph_pos(graph, args::get(graph_pos));
@@ -355,7 +359,7 @@ int main_degree(int argc, char** argv) {
 		        [&](const path_handle_t &path) { add_bed_range(path_ranges, graph, graph.get_path_name(path)); });
 	}
 
-	auto get_graph_pos = [](const odgi::graph_t &graph,
+	auto get_graph_pos = [](const PathHandleGraph &graph,
 							const path_pos_t &pos) {
 		const auto path_end = graph.path_end(pos.path);
 		uint64_t walked = 0;
@@ -375,7 +379,7 @@ int main_degree(int argc, char** argv) {
 		return make_pos_t(0, false, 0);
 	};
 
-	auto get_offset_in_path = [](const odgi::graph_t &graph,
+	auto get_offset_in_path = [](const PathHandleGraph &graph,
 								 const path_handle_t &path, const step_handle_t &target) {
 		const auto path_end = graph.path_end(path);
 		uint64_t walked = 0;
@@ -388,7 +392,7 @@ int main_degree(int argc, char** argv) {
 		return walked;
 	};
 
-	auto get_graph_node_degree = [](const odgi::graph_t &graph, const nid_t node_id,
+	auto get_graph_node_degree = [](const PathHandleGraph &graph, const nid_t node_id,
 									const std::vector<bool>& paths_to_consider) {
 
 		uint64_t node_degree = 0;
@@ -403,7 +407,7 @@ int main_degree(int argc, char** argv) {
 					if (paths_to_consider[
 							as_integer(graph.get_path_handle_of_step(occ))]) {
 						consider = true;
-						unique_paths.insert(as_integer(graph.get_path(occ)));
+						unique_paths.insert(as_integer(graph.get_path_handle_of_step(occ)));
 						return;
 					}
 				});
@@ -483,17 +487,18 @@ int main_degree(int argc, char** argv) {
 
 	if (!path_positions.empty()) {
 		std::cout << "#path.position\tdegree\tdegree.uniq" << std::endl;
+		ordered_output_t output(std::cout);
 #pragma omp parallel for schedule(dynamic, 1)
-		for (auto &path_pos : path_positions) {
+		for (uint64_t i = 0; i < path_positions.size(); ++i) {
+			const auto& path_pos = path_positions[i];
 			const pos_t pos = get_graph_pos(graph, path_pos);
 
 			const nid_t node_id = id(pos);
 			const auto degree = get_graph_node_degree(graph, node_id, paths_to_consider);
 
-#pragma omp critical (cout)
-			std::cout << (graph.get_path_name(path_pos.path)) << "," << path_pos.offset << ","
-					  << (path_pos.is_rev ? "-" : "+") << "\t"
-					  << degree.first << "\t" << degree.second << std::endl;
+			output.write(i, graph.get_path_name(path_pos.path) + "," + std::to_string(path_pos.offset) + ","
+							+ (path_pos.is_rev ? "-" : "+") + "\t"
+							+ std::to_string(degree.first) + "\t" + std::to_string(degree.second) + "\n");
 		}
 	}
 
@@ -3,6 +3,8 @@
 #include "position.hpp"
 #include "args.hxx"
 #include "split.hpp"
+#include "utils.hpp"
+#include "ordered_output.hpp"
 #include "algorithms/bfs.hpp"
 #include "algorithms/depth.hpp"
 #include "algorithms/path_length.hpp"
@@ -83,6 +85,13 @@ namespace odgi {
         args::Flag window_unique_depth(depth_opts, "window-unique-depth",
                               "For --window-in and --window-out, count UNIQUE depth, not total node depth",
                               {'U', "window-unique-depth"});
+        args::Flag depth_cache(depth_opts, "depth-cache",
+                               "Keep the depth and unique depth of each node next to the graph, in *FILE*.depth.*HASH*,"
+                               " and reuse them in later runs on the same graph with the same subset of paths.",
+                               {"depth-cache"});
+        args::Flag frozen(depth_opts, "frozen",
+                          "Load the graph into the compact read-only layout.",
+                          {"frozen"});
 
 
         args::Group threading_opts(parser, "[ Threading ] ");
@@ -111,6 +120,11 @@ namespace odgi {
             return 1;
         }
 
+        if (depth_cache && args::get(og_file) == "-") {
+            std::cerr << "[odgi::depth] error: --depth-cache needs the graph to be read from a file." << std::endl;
+            return 1;
+        }
+
         if (_windows_in && _windows_out) {
             std::cerr << "[odgi::depth] error: please specify -w/--windows-in or -W/--windows-out, not both." << std::endl;
             return 1;
@@ -138,16 +152,12 @@ namespace odgi {
 
 		const uint64_t num_threads = args::get(_num_threads) ? args::get(_num_threads) : 1;
 
-		odgi::graph_t graph;
+		odgi::graph_t dynamic_graph;
+		odgi::flat_graph_t flat_graph;
         assert(argc > 0);
-        if (!args::get(og_file).empty()) {
-            const std::string infile = args::get(og_file);
-            if (infile == "-") {
-                graph.deserialize(std::cin);
-            } else {
-				utils::handle_gfa_odgi_input(infile, "depth", args::get(progress), num_threads, graph);
-            }
-        }
+        // flat graphs are memory-mapped, everything else is loaded into a graph_t (and frozen on request)
+        const PathHandleGraph& graph = utils::handle_read_only_input(args::get(og_file), "depth", args::get(progress), num_threads,
+                                                                     args::get(frozen), dynamic_graph, flat_graph);
 
         omp_set_num_threads((int) num_threads);
 		const uint64_t shift = graph.min_node_id();
@@ -178,12 +188,20 @@ namespace odgi {
             paths_to_consider.resize(graph.get_path_count() + 1, true);
         }
 
+        // every mode but the per-base path vectors answers from the depths of the nodes, computed once
+        algorithms::node_depth_t node_depth;
+        if (summarize_depth || _windows_in || _windows_out || !(path_depth || self_depth)) {
+            algorithms::load_or_build_node_depth(node_depth, graph, paths_to_consider,
+                                                 depth_cache ? args::get(og_file) : "",
+                                                 args::get(progress));
+        }
+
         // these options are exclusive (probably we should say with a warning)
         std::vector<odgi::pos_t> graph_positions;
         std::vector<odgi::path_pos_t> path_positions;
         std::vector<odgi::path_range_t> path_ranges;
 
-        auto add_graph_pos = [&graph_positions](const odgi::graph_t &graph,
+        auto add_graph_pos = [&graph_positions](const PathHandleGraph &graph,
                                                 const std::string &buffer) {
             auto vals = split(buffer, ',');
             /*
@@ -215,7 +233,7 @@ namespace odgi {
             graph_positions.push_back(make_pos_t(id, is_rev, offset));
         };
 
-        auto add_path_pos = [&path_positions](const odgi::graph_t &graph,
+        auto add_path_pos = [&path_positions](const PathHandleGraph &graph,
                                               const std::string &buffer) {
             if (!buffer.empty()) {
                 auto vals = split(buffer, ',');
@@ -250,15 +268,7 @@ namespace odgi {
             std::cout << (og_file ? args::get(og_file) : "graph") << "_vec";
             graph.for_each_handle(
                 [&](const handle_t &h) {
-                    uint64_t depth = 0;
-                    graph.for_each_step_on_handle(
-                        h,
-                        [&](const step_handle_t &occ) {
-                            depth += paths_to_consider[
-                                as_integer(
-                                    graph.get_path_handle_of_step(occ))
-                                ];
-                        });
+                    const uint64_t depth = node_depth.depth(graph.get_id(h));
                     auto length = graph.get_length(h);
                     for (uint64_t i = 0; i < length; ++i) {
                         std::cout << " " << depth;
@@ -274,8 +284,10 @@ namespace odgi {
                     }
                 });
             // for each path handle
+            ordered_output_t output(std::cout);
 #pragma omp parallel for schedule(dynamic, 1)
-            for (auto& path : paths) {
+            for (uint64_t i = 0; i < paths.size(); ++i) {
+                const path_handle_t& path = paths[i];
                 std::stringstream ss;
                 ss << graph.get_path_name(path);
                 // for each step
@@ -290,8 +302,8 @@ namespace odgi {
                             ss << " " << depth;
                         }
                     });
-#pragma omp critical (cout)
-                std::cout << ss.str() << std::endl;
+                ss << "\n";
+                output.write(i, ss.str());
             }
         } else if (self_depth) {
             std::vector<path_handle_t> paths;
@@ -302,8 +314,10 @@ namespace odgi {
                     }
                 });
             // for each path handle
+            ordered_output_t output(std::cout);
 #pragma omp parallel for schedule(dynamic, 1)
-            for (auto& path : paths) {
+            for (uint64_t i = 0; i < paths.size(); ++i) {
+                const path_handle_t& path = paths[i];
                 std::stringstream ss;
                 ss << graph.get_path_name(path);
                 // for each step
@@ -323,8 +337,8 @@ namespace odgi {
                             ss << " " << depth;
                         }
                     });
-#pragma omp critical (cout)
-                std::cout << ss.str() << std::endl;
+                ss << "\n";
+                output.write(i, ss.str());
             }
         } else if (graph_pos) {
             // if we're given a graph_pos, we'll convert it into a path pos
@@ -366,7 +380,7 @@ namespace odgi {
                     [&](const path_handle_t &path) { add_bed_range(path_ranges, graph, graph.get_path_name(path)); });
         }
 
-        auto get_graph_pos = [](const odgi::graph_t &graph,
+        auto get_graph_pos = [](const PathHandleGraph &graph,
                                 const path_pos_t &pos) {
             const auto path_end = graph.path_end(pos.path);
             uint64_t walked = 0;
@@ -386,7 +400,7 @@ namespace odgi {
             return make_pos_t(0, false, 0);
         };
 
-        auto get_offset_in_path = [](const odgi::graph_t &graph,
+        auto get_offset_in_path = [](const PathHandleGraph &graph,
                                      const path_handle_t &path, const step_handle_t &target) {
             const auto path_end = graph.path_end(path);
             uint64_t walked = 0;
@@ -399,27 +413,6 @@ namespace odgi {
             return walked;
         };
 
-        auto get_graph_node_depth = [](const odgi::graph_t &graph, const nid_t node_id,
-                                       const std::vector<bool>& paths_to_consider) {
-
-            uint64_t node_depth = 0;
-            std::set<uint64_t> unique_paths;
-
-            const handle_t h = graph.get_handle(node_id);
-
-            graph.for_each_step_on_handle(
-                h,
-                [&](const step_handle_t &occ) {
-                    if (paths_to_consider[
-                            as_integer(graph.get_path_handle_of_step(occ))]) {
-                        ++node_depth;
-                        unique_paths.insert(as_integer(graph.get_path(occ)));
-                    }
-                });
-
-            return make_pair(node_depth, unique_paths.size());
-        };
-
         if (_windows_in || _windows_out) {
             std::vector<path_handle_t> paths;
             if (_subset_paths) {
@@ -435,22 +428,10 @@ namespace odgi {
                 });
             }
 
-            // precompute depths for all handles in parallel
-            std::vector<uint64_t> depths(graph.get_node_count() + 1);
-
-            graph.for_each_handle(
-                [&](const handle_t& h) {
-                    auto id = graph.get_id(h);
-                    if (window_unique_depth) {
-                        depths[id - shift] = get_graph_node_depth(graph, id, paths_to_consider).second; // Unique depth
-                    } else {
-                        depths[id - shift] = get_graph_node_depth(graph, id, paths_to_consider).first; // Total depth
-                    }
-                }, true);
-
             auto in_bounds =
                 [&](const handle_t &handle) {
-                    uint64_t depth = depths[graph.get_id(handle) - shift];
+                    const nid_t id = graph.get_id(handle);
+                    const uint64_t depth = window_unique_depth ? node_depth.unique_depth(id) : node_depth.depth(id);
                     return _windows_in ? (depth >= windows_in_min && depth <= windows_in_max) : (depth < windows_out_min || depth > windows_out_max);
                 };
 
@@ -481,13 +462,12 @@ namespace odgi {
             std::atomic<uint64_t> graph_length; graph_length.store(0);
             graph.for_each_handle(
                 [&](const handle_t& h) {
-                    const nid_t node_id = graph.get_id(h);
-                    const auto d = get_graph_node_depth(graph, node_id, paths_to_consider);
-                    step_count += d.first;
+                    const uint64_t d = node_depth.depth(graph.get_id(h));
+                    step_count += d;
                     ++node_count;
-                    const auto l = graph.get_length(graph.get_handle(node_id));
+                    const auto l = graph.get_length(h);
                     graph_length += l;
-                    path_length += l * d.first;
+                    path_length += l * d;
                 }, true);
             std::cout << node_count << "\t"
                       << graph_length << "\t"
@@ -499,48 +479,48 @@ namespace odgi {
 
         if (!graph_positions.empty()) {
             std::cout << "#node.id\tdepth\tdepth.uniq" << std::endl;
+            ordered_output_t output(std::cout);
 #pragma omp parallel for schedule(dynamic, 1)
-            for (auto &pos : graph_positions) {
-                const nid_t node_id = id(pos);
-                const auto depth = get_graph_node_depth(graph, node_id, paths_to_consider);
+            for (uint64_t i = 0; i < graph_positions.size(); ++i) {
+                const nid_t node_id = id(graph_positions[i]);
 
-#pragma omp critical (cout)
-                std::cout << node_id << "\t"
-                          << depth.first << "\t"
-                          << depth.second << std::endl;
+                output.write(i, std::to_string(node_id) + "\t"
+                                + std::to_string(node_depth.depth(node_id)) + "\t"
+                                + std::to_string(node_depth.unique_depth(node_id)) + "\n");
             }
         }
 
         if (!path_positions.empty()) {
             std::cout << "#path.position\tdepth\tdepth.uniq" << std::endl;
+            ordered_output_t output(std::cout);
 #pragma omp parallel for schedule(dynamic, 1)
-            for (auto &path_pos : path_positions) {
+            for (uint64_t i = 0; i < path_positions.size(); ++i) {
+                const auto& path_pos = path_positions[i];
                 const pos_t pos = get_graph_pos(graph, path_pos);
 
+                // positions outside of the path land on no node
                 const nid_t node_id = id(pos);
-                const auto depth = get_graph_node_depth(graph, node_id, paths_to_consider);
+                const bool on_node = graph.has_node(node_id);
 
-#pragma omp critical (cout)
-                std::cout << (graph.get_path_name(path_pos.path)) << "," << path_pos.offset << ","
-                          << (path_pos.is_rev ? "-" : "+") << "\t"
-                          << depth.first << "\t" << depth.second << std::endl;
+                output.write(i, graph.get_path_name(path_pos.path) + "," + std::to_string(path_pos.offset) + ","
+                                + (path_pos.is_rev ? "-" : "+") + "\t"
+                                + std::to_string(on_node ? node_depth.depth(node_id) : 0) + "\t"
+                                + std::to_string(on_node ? node_depth.unique_depth(node_id) : 0) + "\n");
             }
         }
 
         if (!path_ranges.empty()) {
             std::cout << "#path\tstart\tend\tmean.depth" << std::endl;
-            algorithms::for_each_path_range_depth(
-                graph,
-                path_ranges,
-                paths_to_consider,
-                [&](const path_range_t& range,
-                    const double& depth) {
-#pragma omp critical (cout)
+            const std::vector<double> range_depths = algorithms::get_path_range_depths(graph, path_ranges, node_depth);
+            for (uint64_t i = 0; i < path_ranges.size(); ++i) {
+                const path_range_t& range = path_ranges[i];
+                if (range_depths[i] >= 0) {
                     std::cout << (graph.get_path_name(range.begin.path)) << "\t"
                               << range.begin.offset << "\t"
                               << range.end.offset << "\t"
-                              << depth << std::endl;
-                });
+                              << range_depths[i] << "\n";
+                }
+            }
         }
 
         return 0;
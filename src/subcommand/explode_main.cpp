@@ -93,7 +93,7 @@ namespace odgi {
         }
 
         std::vector<ska::flat_hash_set<handlegraph::nid_t>> weak_components =
-                algorithms::weakly_connected_components(&graph);
+                algorithms::weakly_connected_components(&graph, num_threads);
 
 
         atomicbitvector::atomic_bv_t ignore_component(weak_components.size());
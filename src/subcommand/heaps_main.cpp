@@ -5,6 +5,7 @@
 #include "algorithms/heaps.hpp"
 #include "utils.hpp"
 #include "split.hpp"
+#include "pansn.hpp"
 
 namespace odgi {
 
@@ -34,6 +35,10 @@ int main_heaps(int argc, char **argv) {
                                              {'n', "n-permutations"});
     args::ValueFlag<uint64_t> _min_node_depth(heaps_opts, "N", "Exclude nodes with less than this path depth (default: 0).",
                                          {'d', "min-node-depth"});
+    args::Flag presence_cache(heaps_opts, "presence-cache",
+                              "Keep the path presence matrix next to the graph, in *FILE*.presence.*HASH*, and reuse it in later runs"
+                              " on the same graph with the same grouping.",
+                              {"presence-cache"});
     args::Group threading_opts(parser, "[ Threading ]");
     args::ValueFlag<uint64_t> nthreads(threading_opts, "N", "Number of threads to use for parallel operations.",
                                        {'t', "threads"});
@@ -64,6 +69,11 @@ int main_heaps(int argc, char **argv) {
         return 1;
     }
 
+    if (presence_cache && args::get(og_in_file) == "-") {
+        std::cerr << "[odgi::heaps] error: --presence-cache needs the graph to be read from a file." << std::endl;
+        return 1;
+    }
+
     const uint64_t num_threads = args::get(nthreads) ? args::get(nthreads) : 1;
     omp_set_num_threads(num_threads);
 
@@ -107,26 +117,13 @@ int main_heaps(int argc, char **argv) {
                     path_groups_map[group].push_back(graph.get_path_handle(path_name));
                 }
             }
-        } else if (group_by_haplotype) {
-            graph.for_each_path_handle([&](const path_handle_t& p) {
-                auto path_name = graph.get_path_name(p);
-                // split and decide
-                auto vals = split(path_name, '#');
-                if (vals.size() == 1) { // Assume ctg
-                    path_groups_map[vals.front()].push_back(p);
-                } else if (vals.size() == 2) { // Assume sample#ctg
-                    path_groups_map[vals.front()].push_back(p);
-                } else if (vals.size() == 3) { // Assume sample#hap#ctg
-                    auto key = vals[0] + vals[1];
-                    path_groups_map[key].push_back(p);
-                }
-            });
-        } else if (group_by_sample) {
+        } else if (group_by_haplotype || group_by_sample) {
+            const pansn_index_t pansn(graph, num_threads);
             graph.for_each_path_handle([&](const path_handle_t& p) {
-                auto path_name = graph.get_path_name(p);
-                // split and decide
-                auto vals = split(path_name, '#');
-                path_groups_map[vals.front()].push_back(p);
+                const std::string& group = group_by_haplotype
+                    ? pansn.haplotype_name(pansn.haplotype_of(p))
+                    : pansn.sample_name(pansn.sample_of(p));
+                path_groups_map[group].push_back(p);
             });
         } else {
             // no groups
@@ -186,7 +183,29 @@ int main_heaps(int argc, char **argv) {
         }
     };
 
-    algorithms::for_each_heap_permutation(graph, path_groups, intervals, n_permutations, min_node_depth, handle_output);
+    // The permutations add up the groups on the path presence matrix, when it fits in memory
+    // next to its transposed copy
+    std::unique_ptr<algorithms::path_presence_t> presence;
+    if (algorithms::path_presence_t::bytes_needed(graph.get_node_count(), path_groups.size()) * 2
+        <= algorithms::path_presence_t::default_max_bytes) {
+        uint64_t path_max = 0;
+        graph.for_each_path_handle([&](const path_handle_t& p) {
+            path_max = std::max(path_max, (uint64_t)as_integer(p));
+        });
+        std::vector<uint64_t> path_columns(path_max + 1, algorithms::path_presence_t::no_column);
+        for (uint64_t j = 0; j < path_groups.size(); ++j) {
+            for (auto& p : path_groups[j]) {
+                path_columns[as_integer(p)] = j;
+            }
+        }
+        presence = std::make_unique<algorithms::path_presence_t>();
+        algorithms::load_or_build_path_presence(*presence, graph, path_columns, path_groups.size(),
+                                                presence_cache ? args::get(og_in_file) : "",
+                                                args::get(progress));
+    }
+
+    algorithms::for_each_heap_permutation(graph, path_groups, intervals, n_permutations, min_node_depth, handle_output,
+                                          presence.get());
 
     return 0;
 }
@@ -83,7 +83,7 @@ int main_kmers(int argc, char** argv) {
     omp_set_num_threads(num_threads);
 
     if (args::get(max_degree)) {
-        algorithms::remove_high_degree_nodes(graph, args::get(max_degree));
+        algorithms::remove_high_degree_nodes(graph, args::get(max_degree), num_threads);
     }
 
     /*
@@ -6,6 +6,7 @@
 #include "algorithms/xp.hpp"
 #include "algorithms/sgd_layout.hpp"
 #include "algorithms/path_sgd_layout.hpp"
+#include "algorithms/path_sgd_layout_flat.hpp"
 #include "algorithms/draw.hpp"
 #include "algorithms/layout.hpp"
 #include "hilbert.hpp"
@@ -81,6 +82,22 @@ int main_layout(int argc, char **argv) {
     args::ValueFlag<std::string> p_sgd_snapshot(pg_sgd_opts, "STRING",
                                                 "Set the prefix to which each snapshot layout of a path guided 2D SGD iteration should be written to (default: NONE).",
                                                 {'u', "path-sgd-snapshot"});
+    args::ValueFlag<std::string> p_sgd_engine(pg_sgd_opts, "NAME",
+                                              "Run the path guided 2D SGD with this engine: 'atomic' updates the shared coordinates "
+                                              "thread by thread, 'flat' samples and updates terms in blocks on flat arrays of nodes and "
+                                              "path steps with float coordinates, which is faster on large graphs (default: atomic).",
+                                              {'e', "engine"});
+    args::ValueFlag<std::string> p_sgd_checkpoint(pg_sgd_opts, "FILE",
+                                                  "Write a checkpoint of the path guided 2D SGD to this FILE every --checkpoint-every iterations, "
+                                                  "from which --resume continues the layout.",
+                                                  {"checkpoint"});
+    args::ValueFlag<uint64_t> p_sgd_checkpoint_every(pg_sgd_opts, "N",
+                                                     "Write a checkpoint every N iterations (default: 1).",
+                                                     {"checkpoint-every"});
+    args::ValueFlag<std::string> p_sgd_resume(pg_sgd_opts, "FILE",
+                                              "Continue the path guided 2D SGD from the checkpoint in this FILE. The graph, the engine, "
+                                              "the PG-SGD options and the number of threads must be those of the run that wrote it.",
+                                              {"resume"});
     args::Group threading_opts(parser, "[ Threading ]");
     args::ValueFlag<uint64_t> nthreads(threading_opts, "N",
                                        "Number of threads to use for parallel operations.",
@@ -124,6 +141,40 @@ int main_layout(int argc, char **argv) {
         return 1;
     }
 
+    const std::string sgd_engine = p_sgd_engine ? args::get(p_sgd_engine) : "atomic";
+    if (sgd_engine != "atomic" && sgd_engine != "flat") {
+        std::cerr
+            << "[odgi::layout] error: Please specify 'atomic' or 'flat' as the engine via -e/--engine=[NAME]."
+            << std::endl;
+        return 1;
+    }
+    const bool flat_engine = sgd_engine == "flat";
+
+    algorithms::sgd_checkpointing_t checkpointing;
+    if (p_sgd_checkpoint) {
+        checkpointing.file = args::get(p_sgd_checkpoint);
+        checkpointing.every = p_sgd_checkpoint_every ? args::get(p_sgd_checkpoint_every) : 1;
+        if (checkpointing.every == 0) {
+            std::cerr << "[odgi::layout] error: Please specify a number of iterations greater than 0 via --checkpoint-every=[N]." << std::endl;
+            return 1;
+        }
+    }
+    algorithms::sgd_checkpoint_t resume_checkpoint;
+    if (p_sgd_resume) {
+        std::ifstream resume_in(args::get(p_sgd_resume), std::ios::binary);
+        if (!resume_in || !resume_checkpoint.load(resume_in)) {
+            std::cerr << "[odgi::layout] error: " << args::get(p_sgd_resume) << " is not a PG-SGD checkpoint." << std::endl;
+            return 1;
+        }
+        checkpointing.resume = &resume_checkpoint;
+    }
+#ifdef USE_GPU
+    if (gpu_compute && (p_sgd_checkpoint || p_sgd_resume)) {
+        std::cerr << "[odgi::layout] error: --checkpoint and --resume are not supported with --gpu." << std::endl;
+        return 1;
+    }
+#endif
+
 	const uint64_t num_threads = nthreads ? args::get(nthreads) : 1;
 
 	graph_t graph;
@@ -218,6 +269,11 @@ int main_layout(int argc, char **argv) {
 
     // take care of path index
     if (xp_in_file) {
+        if (xp::XP::is_flat(args::get(xp_in_file))) {
+            std::cerr << "[odgi::layout] error: the path index " << args::get(xp_in_file)
+                      << " is in the flat layout, please create it with odgi pathindex without -F, --flat." << std::endl;
+            exit(1);
+        }
         std::ifstream in;
         in.open(args::get(xp_in_file));
         path_index.load(in);
@@ -360,7 +416,10 @@ int main_layout(int argc, char **argv) {
 #ifdef USE_GPU
     if (!gpu_compute) { // run on CPU
 #endif
-        algorithms::path_linear_sgd_layout(
+        auto* const path_linear_sgd_layout_engine = flat_engine
+            ? algorithms::path_linear_sgd_layout_flat
+            : algorithms::path_linear_sgd_layout;
+        path_linear_sgd_layout_engine(
             graph,
             path_index,
             path_sgd_use_paths,
@@ -380,7 +439,8 @@ int main_layout(int argc, char **argv) {
             snapshot,
             snapshot_prefix,
             graph_X,
-            graph_Y
+            graph_Y,
+            checkpointing
             );
 #ifdef USE_GPU
     }
@@ -399,7 +459,7 @@ int main_layout(int argc, char **argv) {
     }
 
     // refine order by weakly connected components
-    std::vector<std::vector<handlegraph::handle_t>> weak_components = algorithms::weakly_connected_component_vectors(&graph);
+    std::vector<std::vector<handlegraph::handle_t>> weak_components = algorithms::weakly_connected_component_vectors(&graph, num_threads);
 
     //uint64_t num_components_on_each_dimension = std::ceil(sqrt(weak_components.size()));
     //std::cerr << " num_components_on_each_dimension " << num_components_on_each_dimension << std::endl;
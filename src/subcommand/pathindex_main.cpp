@@ -22,6 +22,12 @@ namespace odgi {
         args::Group mandatory_opts(parser, "[ MANDATORY OPTIONS ]");
         args::ValueFlag<std::string> dg_in_file(mandatory_opts, "FILE", "Load the succinct variation graph in ODGI format from this *FILE*. The file name usually ends with *.og*.", {'i', "idx"});
         args::ValueFlag<std::string> idx_out_file(mandatory_opts, "FILE", "Write the succinct variation graph index to this FILE. A file ending with *.xp* is recommended.", {'o', "out"});
+        args::Group index_opts(parser, "[ Index Options ]");
+        args::Flag flat(index_opts, "flat", "Write the index in a flat layout that *odgi server* and *odgi panpos* memory-map instead of loading it."
+                                               " Such an index is larger on disk, but processes on one machine share its pages and start instantly."
+                                               " It cannot be used with *odgi sort* or *odgi layout*.", {'F', "flat"});
+        args::Flag external(index_opts, "external", "Build the index one path at a time, keeping the mapping from nodes to path steps in temporary files."
+                                                   " This is slower, but bounds the memory needed by the index construction.", {'E', "external"});
         args::Group threading_opts(parser, "[ Threading ]");
         args::ValueFlag<std::uint64_t> nthreads(threading_opts, "N", "Number of threads to use for parallel operations.", {'t', "threads"});
 		args::Group processing_info_opts(parser, "[ Processing Information ]");
@@ -57,6 +63,7 @@ namespace odgi {
         }
 
 		const uint64_t num_threads = nthreads ? args::get(nthreads) : 1;
+		omp_set_num_threads(num_threads);
 
 		// read in the graph
         graph_t graph;
@@ -74,7 +81,7 @@ namespace odgi {
         }
 
         XP path_index;
-        path_index.from_handle_graph(graph, num_threads);
+        path_index.from_handle_graph(graph, num_threads, args::get(external));
 		if (progress) {
 			std::cout << "Indexed " << path_index.path_count << " path(s)." << std::endl;
 		}
@@ -98,7 +105,11 @@ namespace odgi {
         if (progress) {
 			std::cout << "Writing index to " << args::get(idx_out_file) << "." << std::endl;
 		}
-        path_index.serialize_members(out);
+        if (flat) {
+            path_index.serialize_flat(out);
+        } else {
+            path_index.serialize_members(out);
+        }
         out.close();
 
         return 0;
@@ -5,6 +5,7 @@
 #include "position.hpp"
 #include <omp.h>
 #include "utils.hpp"
+#include "ordered_output.hpp"
 #include "algorithms/path_keep.hpp"
 
 namespace odgi {
@@ -181,15 +182,16 @@ int main_paths(int argc, char** argv) {
 		graph.for_each_path_handle([&](const path_handle_t& p) {
 			paths.push_back(p);
 		});
+		ordered_output_t output(std::cout);
 #pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
-		for (auto path : paths) {
+		for (uint64_t i = 0; i < paths.size(); ++i) {
+			const path_handle_t path = paths[i];
 			uint64_t path_len = 0;
 			graph.for_each_step_in_path(path, [&](const step_handle_t& s) {
 				handle_t h = graph.get_handle_of_step(s);
 				path_len += graph.get_length(h);
 			});
-#pragma omp critical (cout)
-			std::cout << graph.get_path_name(path) << "\t" << 1 << "\t" << path_len << std::endl;
+			output.write(i, graph.get_path_name(path) + "\t1\t" + std::to_string(path_len) + "\n");
 		}
 	} else if (args::get(list_names)) {
         graph.for_each_path_handle([&](const path_handle_t& p) {
@@ -524,8 +526,11 @@ int main_paths(int argc, char** argv) {
             } else {
                 std::cout << "#path.name\tstart\tend" << std::endl;
             }
+            ordered_output_t output(std::cout);
     #pragma omp parallel for schedule(dynamic, 1)
-            for (auto& path : non_reference_paths) {
+            for (uint64_t path_rank = 0; path_rank < non_reference_paths.size(); ++path_rank) {
+                const path_handle_t& path = non_reference_paths[path_rank];
+                std::stringstream ss;
                 uint64_t start = 0, end = 0;
                 std::vector<step_handle_t> step_range;
                 graph.for_each_step_in_path(path, [&](const step_handle_t& step) {
@@ -540,11 +545,9 @@ int main_paths(int argc, char** argv) {
                                     const handle_t handle = graph.get_handle_of_step(step);
                                     step_range_str += std::to_string(graph.get_id(handle)) + (graph.get_is_reverse(handle) ? "-" : "+") + ",";
                                 }
-                                #pragma omp critical (cout)
-                                    std::cout << graph.get_path_name(path) << "\t" << start << "\t" << end << "\t" << step_range_str.substr(0, step_range_str.size() - 1) << std::endl; // trim the trailing comma from step_range
+                                ss << graph.get_path_name(path) << "\t" << start << "\t" << end << "\t" << step_range_str.substr(0, step_range_str.size() - 1) << "\n"; // trim the trailing comma from step_range
                             } else {
-                                #pragma omp critical (cout)
-                                    std::cout << graph.get_path_name(path) << "\t" << start << "\t" << end << std::endl;
+                                ss << graph.get_path_name(path) << "\t" << start << "\t" << end << "\n";
                             }
                         }
                         end += graph.get_length(handle);
@@ -568,13 +571,12 @@ int main_paths(int argc, char** argv) {
                             const handle_t handle = graph.get_handle_of_step(step);
                             step_range_str += std::to_string(graph.get_id(handle)) + (graph.get_is_reverse(handle) ? "-" : "+") + ",";
                         }
-                        #pragma omp critical (cout)
-                            std::cout << graph.get_path_name(path) << "\t" << start << "\t" << end << "\t" << step_range_str.substr(0, step_range_str.size() - 1) << std::endl; // trim the trailing comma from step_range
+                        ss << graph.get_path_name(path) << "\t" << start << "\t" << end << "\t" << step_range_str.substr(0, step_range_str.size() - 1) << "\n"; // trim the trailing comma from step_range
                     } else {
-                        #pragma omp critical (cout)
-                            std::cout << graph.get_path_name(path) << "\t" << start << "\t" << end << std::endl;
+                        ss << graph.get_path_name(path) << "\t" << start << "\t" << end << "\n";
                     }
                 }
+                output.write(path_rank, ss.str());
             }
         }
     }
@@ -665,8 +667,11 @@ int main_paths(int argc, char** argv) {
                 all_paths.push_back(path);
             });
 
+            ordered_output_t output(std::cout);
     #pragma omp parallel for schedule(dynamic, 1)
-            for (auto& path : all_paths) {
+            for (uint64_t path_rank = 0; path_rank < all_paths.size(); ++path_rank) {
+                const path_handle_t& path = all_paths[path_rank];
+                std::stringstream ss;
                 uint64_t start = 0, end = 0;
                 int64_t last_class = -1;
                 std::vector<step_handle_t> step_range;
@@ -703,11 +708,9 @@ int main_paths(int argc, char** argv) {
                                     step_range_str += std::to_string(graph.get_id(handle)) + (graph.get_is_reverse(handle) ? "-" : "+") + ",";
                                 }
                                 
-                                #pragma omp critical (cout)
-                                    std::cout << graph.get_path_name(path) << "\t" << start << "\t" << end << "\t" << seq_class << "\t" << step_range_str.substr(0, step_range_str.size() - 1) << std::endl; // trim the trailing comma from step_range
+                                ss << graph.get_path_name(path) << "\t" << start << "\t" << end << "\t" << seq_class << "\t" << step_range_str.substr(0, step_range_str.size() - 1) << "\n"; // trim the trailing comma from step_range
                             } else {
-                                #pragma omp critical (cout)
-                                    std::cout << graph.get_path_name(path) << "\t" << start << "\t" << end << "\t" << seq_class << std::endl;
+                                ss << graph.get_path_name(path) << "\t" << start << "\t" << end << "\t" << seq_class << "\n";
                             }
                         }
                         start = end;
@@ -741,13 +744,12 @@ int main_paths(int argc, char** argv) {
                             step_range_str += std::to_string(graph.get_id(handle)) + (graph.get_is_reverse(handle) ? "-" : "+") + ",";
                         }
                         
-                        #pragma omp critical (cout)
-                            std::cout << graph.get_path_name(path) << "\t" << start << "\t" << end << "\t" << seq_class << "\t" << step_range_str.substr(0, step_range_str.size() - 1) << std::endl; // trim the trailing comma from step_range
+                        ss << graph.get_path_name(path) << "\t" << start << "\t" << end << "\t" << seq_class << "\t" << step_range_str.substr(0, step_range_str.size() - 1) << "\n"; // trim the trailing comma from step_range
                     } else {
-                        #pragma omp critical (cout)
-                            std::cout << graph.get_path_name(path) << "\t" << start << "\t" << end << "\t" << seq_class << std::endl;
+                        ss << graph.get_path_name(path) << "\t" << start << "\t" << end << "\t" << seq_class << "\n";
                     }
                 }
+                output.write(path_rank, ss.str());
             }
         } else {
             std::cout << "#node.id\tnode.len\tclass" << std::endl;
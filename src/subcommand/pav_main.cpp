@@ -5,9 +5,12 @@
 #include <position.hpp>
 #include <subgraph/extract.hpp>
 #include "utils.hpp"
+#include "ordered_output.hpp"
 #include "split.hpp"
+#include "pansn.hpp"
 #include "subgraph/region.hpp"
 #include "IITree.h"
+#include "algorithms/path_presence.hpp"
 
 namespace odgi {
 
@@ -41,6 +44,13 @@ int main_pav(int argc, char **argv) {
                                        {'B', "binary-values"});
     args::Flag _matrix_output(pav_opts, "bool", "Emit the PAV ratios in a matrix, with path ranges as rows and paths/groups as columns.",
                                            {'M', "matrix-output"});
+    args::Flag frozen(pav_opts, "frozen",
+                      "Load the graph into the compact read-only layout.",
+                      {"frozen"});
+    args::Flag _presence_cache(pav_opts, "presence-cache",
+                               "Keep the path presence matrix next to the graph, in *FILE*.presence.*HASH*, and reuse it in later runs"
+                               " on the same graph with the same grouping.",
+                               {"presence-cache"});
     args::Group threading_opts(parser, "[ Threading ]");
     args::ValueFlag<uint64_t> nthreads(threading_opts, "N", "Number of threads to use for parallel operations.",
                                        {'t', "threads"});
@@ -71,24 +81,22 @@ int main_pav(int argc, char **argv) {
         return 1;
     }
 
+    if (_presence_cache && args::get(og_in_file) == "-") {
+        std::cerr << "[odgi::pav] error: --presence-cache needs the graph to be read from a file." << std::endl;
+        return 1;
+    }
+
     const uint64_t num_threads = args::get(nthreads) ? args::get(nthreads) : 1;
     omp_set_num_threads(num_threads);
 
     const bool show_progress = args::get(_progress);
 
-    graph_t graph;
+    graph_t dynamic_graph;
+    flat_graph_t flat_graph;
     assert(argc > 0);
-    {
-        const std::string infile = args::get(og_in_file);
-        if (!infile.empty()) {
-            if (infile == "-") {
-                graph.deserialize(std::cin);
-            } else {
-                utils::handle_gfa_odgi_input(infile, "pav", show_progress, num_threads, graph);
-            }
-        }
-    }
-    graph.set_number_of_threads(num_threads);
+    const PathHandleGraph& graph = utils::handle_read_only_input(args::get(og_in_file), "pav", show_progress, num_threads,
+                                                                 args::get(frozen), dynamic_graph, flat_graph);
+    dynamic_graph.set_number_of_threads(num_threads);
 
     if (args::get(_binary_values) && (args::get(_binary_values) < 0 || args::get(_binary_values) > 1)) {
         std::cerr
@@ -110,6 +118,7 @@ int main_pav(int argc, char **argv) {
     const bool group_paths = _path_groups || _group_by_sample || _group_by_haplotype;
     ska::flat_hash_map<path_handle_t, std::string> path_2_group; // General, but potentially heavy solution
     std::map<std::string, uint64_t> group_2_index;               // Ordered map to keep group names' order
+    ska::flat_hash_map<path_handle_t, uint64_t> path_2_group_rank;
     if (group_paths) {
         if (_path_groups) {
             std::ifstream refs(args::get(_path_groups).c_str());
@@ -140,40 +149,24 @@ int main_pav(int argc, char **argv) {
                         << std::endl;
                 return 1;
             }
-        } else if (_group_by_sample) {
+        } else {
+            const pansn_index_t pansn(graph, num_threads);
             graph.for_each_path_handle([&](const path_handle_t& p) {
-                auto path_name = graph.get_path_name(p);
-                // split and decide
-                const auto vals = split(path_name, '#');
-                const auto group = vals.front();
+                const std::string& group = _group_by_sample
+                    ? pansn.sample_name(pansn.sample_of(p))
+                    : pansn.haplotype_name(pansn.haplotype_of(p));
                 path_2_group[p] = group;
                 group_2_index[group] = 0;
             });
-        } else if (_group_by_haplotype) {
-            graph.for_each_path_handle([&](const path_handle_t& p) {
-                auto path_name = graph.get_path_name(p);
-                // split and decide
-                const auto vals = split(path_name, '#');
-                if (vals.size() == 1) { // Assume ctg
-                    const auto group = vals.front();
-                    path_2_group[p] = group;
-                    group_2_index[group] = 0;
-                } else if (vals.size() == 2) { // Assume sample#ctg
-                    const auto group = vals.front();
-                    path_2_group[p] = group;
-                    group_2_index[group] = 0;
-                } else if (vals.size() == 3) { // Assume sample#hap#ctg
-                    const auto group = vals[0] + '#' + vals[1];
-                    path_2_group[p] = group;
-                    group_2_index[group] = 0;
-                }
-            });
         }
 
         uint64_t group_index = 0;
         for (auto& x : group_2_index) {
             x.second = group_index++;
         }
+        for (auto& x : path_2_group) {
+            path_2_group_rank[x.first] = group_2_index[x.second];
+        }
     }
 
     // Read target paths from BED
@@ -262,6 +255,32 @@ int main_pav(int argc, char **argv) {
     if (show_progress) {
         operation_progress->finish();
     }
+    // The paths or groups on each node come from the path presence matrix, when it fits in memory
+    const uint64_t column_count = group_paths ? group_2_index.size() : graph.get_path_count();
+    const bool use_presence = algorithms::path_presence_t::bytes_needed(graph.get_node_count(), column_count)
+        <= algorithms::path_presence_t::default_max_bytes;
+    algorithms::path_presence_t presence;
+    if (use_presence) {
+        uint64_t path_max = 0;
+        graph.for_each_path_handle([&](const path_handle_t& p) {
+            path_max = std::max(path_max, (uint64_t)as_integer(p));
+        });
+        std::vector<uint64_t> path_columns(path_max + 1, algorithms::path_presence_t::no_column);
+        graph.for_each_path_handle([&](const path_handle_t& p) {
+            if (!group_paths) {
+                path_columns[as_integer(p)] = as_integer(p) - 1;
+            } else {
+                auto f = path_2_group_rank.find(p);
+                if (f != path_2_group_rank.end()) {
+                    path_columns[as_integer(p)] = f->second;
+                }
+            }
+        });
+        algorithms::load_or_build_path_presence(presence, graph, path_columns, column_count,
+                                                _presence_cache ? args::get(og_in_file) : "",
+                                                show_progress);
+    }
+
     const bool emit_matrix_else_table = args::get(_matrix_output);
 
     // Emit the PAV matrix
@@ -285,8 +304,8 @@ int main_pav(int argc, char **argv) {
     std::cout << std::endl;
 
     auto print_pav_table_row = [](
-            const basic_ostream<char>& stream,
-            graph_t& graph,
+            std::ostream& stream,
+            const PathHandleGraph& graph,
             const uint64_t len_unique_nodes_in_range,
             const std::vector<uint64_t>& len_unique_nodes_in_range_for_each_group,
             const std::string& group_name,
@@ -297,13 +316,13 @@ int main_pav(int argc, char **argv) {
         // Check if there were nodes in the range
         const double pav_ratio = len_unique_nodes_in_range == 0 ?
                                  0 : (double) len_unique_nodes_in_range_for_each_group[group_rank] / (double) len_unique_nodes_in_range;
-        std::cout << std::setprecision(5)
-                  << graph.get_path_name(path_range.begin.path) << "\t"
-                  << path_range.begin.offset << "\t"
-                  << path_range.end.offset << "\t"
-                  << path_range.name << "\t"
-                  << group_name << "\t"
-                  << (emit_binary_values ? pav_ratio >= binary_threshold : pav_ratio) << "\n";
+        stream << std::setprecision(5)
+               << graph.get_path_name(path_range.begin.path) << "\t"
+               << path_range.begin.offset << "\t"
+               << path_range.end.offset << "\t"
+               << path_range.name << "\t"
+               << group_name << "\t"
+               << (emit_binary_values ? pav_ratio >= binary_threshold : pav_ratio) << "\n";
     };
 
     if (show_progress) {
@@ -311,6 +330,7 @@ int main_pav(int argc, char **argv) {
 		operation_progress = std::make_unique<odgi::algorithms::progress_meter::ProgressMeter>(path_ranges.size(), banner);
     }
 
+    ordered_output_t output(std::cout);
 #pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
     for (uint64_t i = 0; i < path_ranges.size(); ++i) {
         auto &path_range = path_ranges[i];
@@ -333,75 +353,81 @@ int main_pav(int argc, char **argv) {
             const auto& node_id = tree.data(node_id_info);
             const auto& handle = graph.get_handle(node_id);
 
+            const uint64_t len_handle = graph.get_length(handle);
+            len_unique_nodes_in_range += len_handle;
+            if (use_presence) {
+                presence.for_each_column_on(algorithms::path_presence_t::rank_of(handle), [&](const uint64_t& group_rank) {
+                    len_unique_nodes_in_range_for_each_group[group_rank] += len_handle;
+                });
+                continue;
+            }
+
             // Get paths that cross the node
             unordered_set<uint64_t> group_ranks_on_node_handle;
             graph.for_each_step_on_handle(handle, [&](const step_handle_t &source_step) {
                 const auto& path_handle = graph.get_path_handle_of_step(source_step);
                 // Check if the paths are grouped and there are paths that do not belong to any group
-                if (!group_paths || path_2_group.find(path_handle) != path_2_group.end()) {
-                    const uint64_t group_rank = group_paths ?
-                            group_2_index[path_2_group[path_handle]] :
-                            as_integer(path_handle) - 1;
-                    group_ranks_on_node_handle.insert(group_rank);
+                if (!group_paths) {
+                    group_ranks_on_node_handle.insert(as_integer(path_handle) - 1);
+                } else {
+                    auto f = path_2_group_rank.find(path_handle);
+                    if (f != path_2_group_rank.end()) {
+                        group_ranks_on_node_handle.insert(f->second);
+                    }
                 }
             });
 
-            const uint64_t len_handle = graph.get_length(handle);
             for (const auto& group_rank: group_ranks_on_node_handle) {
                 len_unique_nodes_in_range_for_each_group[group_rank] += len_handle;
             }
-
-            len_unique_nodes_in_range += len_handle;
         }
 
-#pragma omp critical (cout)
-        {
-            if (emit_matrix_else_table) {
-                std::cout << std::setprecision(5)
-                          << graph.get_path_name(path_range.begin.path) << "\t"
-                          << path_range.begin.offset << "\t"
-                          << path_range.end.offset << "\t"
-                          << path_range.name;
-                for (auto& x: len_unique_nodes_in_range_for_each_group) {
-                    // Check if there were nodes in the range
-                    const double pav_ratio = len_unique_nodes_in_range == 0 ?
-                                             0 : (double) x / (double) len_unique_nodes_in_range;
-                    std::cout << "\t" << (emit_binary_values ? pav_ratio >= binary_threshold : pav_ratio);
+        std::stringstream ss;
+        if (emit_matrix_else_table) {
+            ss << std::setprecision(5)
+               << graph.get_path_name(path_range.begin.path) << "\t"
+               << path_range.begin.offset << "\t"
+               << path_range.end.offset << "\t"
+               << path_range.name;
+            for (auto& x: len_unique_nodes_in_range_for_each_group) {
+                // Check if there were nodes in the range
+                const double pav_ratio = len_unique_nodes_in_range == 0 ?
+                                         0 : (double) x / (double) len_unique_nodes_in_range;
+                ss << "\t" << (emit_binary_values ? pav_ratio >= binary_threshold : pav_ratio);
+            }
+            ss << "\n";
+        } else {
+            if (group_paths) {
+                for (auto& x : group_2_index) {
+                    const uint64_t group_rank = x.second;
+                    print_pav_table_row(
+                            ss,
+                            graph,
+                            len_unique_nodes_in_range,
+                            len_unique_nodes_in_range_for_each_group,
+                            x.first,
+                            group_rank,
+                            path_range,
+                            emit_binary_values,
+                            binary_threshold);
                 }
-                std::cout << std::endl;
             } else {
-                if (group_paths) {
-                    for (auto& x : group_2_index) {
-                        const uint64_t group_rank = x.second;
-                        print_pav_table_row(
-                                std::cout,
-                                graph,
-                                len_unique_nodes_in_range,
-                                len_unique_nodes_in_range_for_each_group,
-                                x.first,
-                                group_rank,
-                                path_range,
-                                emit_binary_values,
-                                binary_threshold);
-                    }
-                } else {
-                    graph.for_each_path_handle([&](const path_handle_t path_handle) {
-                        const uint64_t group_rank = as_integer(path_handle) - 1;
-                        print_pav_table_row(
-                                std::cout,
-                                graph,
-                                len_unique_nodes_in_range,
-                                len_unique_nodes_in_range_for_each_group,
-                                graph.get_path_name(path_handle),
-                                group_rank,
-                                path_range,
-                                emit_binary_values,
-                                binary_threshold);
-                    });
-                }
+                graph.for_each_path_handle([&](const path_handle_t path_handle) {
+                    const uint64_t group_rank = as_integer(path_handle) - 1;
+                    print_pav_table_row(
+                            ss,
+                            graph,
+                            len_unique_nodes_in_range,
+                            len_unique_nodes_in_range_for_each_group,
+                            graph.get_path_name(path_handle),
+                            group_rank,
+                            path_range,
+                            emit_binary_values,
+                            binary_threshold);
+                });
             }
         }
-
+        output.write(i, ss.str());
 
         if (show_progress) {
             operation_progress->increment(1);
@@ -6,8 +6,11 @@
 #include "subgraph/region.hpp"
 #include "algorithms/bfs.hpp"
 #include "algorithms/path_jaccard.hpp"
+#include "algorithms/stepindex.hpp"
+#include <numeric>
 #include <omp.h>
 #include "utils.hpp"
+#include "ordered_output.hpp"
 #include "picosha2.h"
 
 namespace odgi {
@@ -482,36 +485,73 @@ int main_position(int argc, char** argv) {
         lift_path_set_target.insert(as_integer(path));
     }
 
-    auto get_graph_pos =
+    // resolve many path positions into graph positions and the steps holding them; the queries are
+    // sorted by path and offset, so that each path is walked only once for all of its queries
+    auto get_graph_positions =
         [](const odgi::graph_t& graph,
-           const path_pos_t& pos,
-           step_handle_t& step) {
-            auto path_end = graph.path_end(pos.path);
-            uint64_t walked = 0;
-            for (step_handle_t s = graph.path_begin(pos.path);
-                 s != path_end; s = graph.get_next_step(s)) {
-                handle_t h = graph.get_handle_of_step(s);
-                uint64_t node_length = graph.get_length(h);
-                if (walked + node_length - 1 >= pos.offset) {
-                	step = s;
-                    return make_pos_t(graph.get_id(h), graph.get_is_reverse(h), pos.offset - walked);
+           const std::vector<path_pos_t>& path_positions,
+           std::vector<pos_t>& positions,
+           std::vector<step_handle_t>& steps,
+           const bool warn) {
+            const uint64_t n = path_positions.size();
+            positions.assign(n, make_pos_t(0, false, 0));
+            steps.resize(n);
+            std::vector<uint64_t> order(n);
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&](const uint64_t& a, const uint64_t& b) {
+                const path_pos_t& x = path_positions[a];
+                const path_pos_t& y = path_positions[b];
+                return as_integer(x.path) < as_integer(y.path)
+                    || (as_integer(x.path) == as_integer(y.path) && x.offset < y.offset);
+            });
+            // the runs of queries on the same path
+            std::vector<uint64_t> runs;
+            for (uint64_t k = 0; k < n; ++k) {
+                if (k == 0 || as_integer(path_positions[order[k]].path) != as_integer(path_positions[order[k - 1]].path)) {
+                    runs.push_back(k);
                 }
-                walked += node_length;
             }
+            runs.push_back(n);
+#pragma omp parallel for schedule(dynamic,1)
+            for (uint64_t r = 0; r < runs.size() - 1; ++r) {
+                const path_handle_t path = path_positions[order[runs[r]]].path;
+                const uint64_t run_end = runs[r + 1];
+                uint64_t k = runs[r];
+                uint64_t walked = 0;
+                const auto path_end = graph.path_end(path);
+                for (step_handle_t s = graph.path_begin(path);
+                     s != path_end && k < run_end; s = graph.get_next_step(s)) {
+                    const handle_t h = graph.get_handle_of_step(s);
+                    const uint64_t node_length = graph.get_length(h);
+                    while (k < run_end && walked + node_length - 1 >= path_positions[order[k]].offset) {
+                        const uint64_t i = order[k];
+                        positions[i] = make_pos_t(graph.get_id(h), graph.get_is_reverse(h), path_positions[i].offset - walked);
+                        steps[i] = s;
+                        ++k;
+                    }
+                    walked += node_length;
+                }
+                if (warn) {
+                    for ( ; k < run_end; ++k) {
 #pragma omp critical (cout)
-            std::cerr << "[odgi::position] warning: position " << graph.get_path_name(pos.path) << ":" << pos.offset << " outside of path. Walked " << walked << std::endl;
-            return make_pos_t(0, false, 0);
+                        std::cerr << "[odgi::position] warning: position " << graph.get_path_name(path) << ":" << path_positions[order[k]].offset << " outside of path. Walked " << walked << std::endl;
+                    }
+                }
+            }
         };
 
+	// steps before the one holding the range begin can't overlap the range, so we start there
 	auto get_graph_node_ids_annotation =
 			[](const odgi::graph_t& graph,
-			   const path_range_t& path_range) {
+			   const path_range_t& path_range,
+			   const step_handle_t& begin_step,
+			   const uint64_t& begin_walked) {
 				auto path_end = graph.path_end(path_range.begin.path);
 				std::unordered_map<uint64_t , std::set<std::string>> node_annotation_map;
-				uint64_t walked = 0;
+				uint64_t walked = begin_walked;
 				uint64_t path_pos_start = path_range.begin.offset;
 				uint64_t path_pos_end = path_range.end.offset;
-				for (step_handle_t s = graph.path_begin(path_range.begin.path);
+				for (step_handle_t s = begin_step;
 					 s != path_end; s = graph.get_next_step(s)) {
 					handle_t h = graph.get_handle_of_step(s);
 					uint64_t nid = graph.get_id(h);
@@ -540,9 +580,17 @@ int main_position(int argc, char** argv) {
 				return node_annotation_map;
 			};
 
+    // step indexes over the paths we report positions in, built once we know we have many queries
+    std::unique_ptr<algorithms::step_index_t> target_step_index;
+    std::unique_ptr<algorithms::step_index_t> source_step_index;
+
     auto get_offset_in_path =
-        [](const odgi::graph_t& graph,
+        [&target_graph,&target_step_index,&source_step_index](const odgi::graph_t& graph,
            const path_handle_t& path, const step_handle_t& target) {
+            const auto& step_index = (&graph == &target_graph ? target_step_index : source_step_index);
+            if (step_index) {
+                return (uint64_t)step_index->get_position(target, graph);
+            }
             auto path_end = graph.path_end(path);
             uint64_t walked = 0;
             step_handle_t s = graph.path_begin(path);
@@ -722,6 +770,100 @@ int main_position(int argc, char** argv) {
             }
         };
 
+    // with more than a single query, the step indexes pay for themselves: they replace a walk from the
+    // start of the path for every position we report
+    const uint64_t query_count = graph_positions.size() + path_positions.size() + path_ranges.size();
+    if (query_count > 1 && !gff_input) {
+        if (!give_graph_pos || args::get(all_immediate)) {
+            target_step_index = std::make_unique<algorithms::step_index_t>(target_graph, ref_paths, num_threads, args::get(progress), 8);
+        }
+        if (lifting) {
+            source_step_index = std::make_unique<algorithms::step_index_t>(source_graph, lift_paths_source, num_threads, args::get(progress), 8);
+        }
+    }
+
+    // visit the queries by node, so that neighbouring searches touch the same part of the graph
+    auto by_node = [](const std::vector<pos_t>& positions) {
+        std::vector<uint64_t> order(positions.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](const uint64_t& a, const uint64_t& b) {
+            return id(positions[a]) < id(positions[b]);
+        });
+        return order;
+    };
+
+    // the queries are answered in batches of consecutive inputs, each batch by node, and written
+    // in input order as the batches complete, so only a bounded number of records is held
+    auto write_in_batches =
+        [&by_node](const std::vector<pos_t>& positions,
+                   const std::function<void(const uint64_t&, std::stringstream&)>& write_record) {
+            const uint64_t batch_size = 1024;
+            const uint64_t batch_count = (positions.size() + batch_size - 1) / batch_size;
+            ordered_output_t output(std::cout, 256);
+#pragma omp parallel for schedule(dynamic,1)
+            for (uint64_t b = 0; b < batch_count; ++b) {
+                const uint64_t begin = b * batch_size;
+                const uint64_t end = std::min((uint64_t)positions.size(), begin + batch_size);
+                const std::vector<uint64_t> order = by_node(
+                        std::vector<pos_t>(positions.begin() + begin, positions.begin() + end));
+                std::vector<std::string> records(end - begin);
+                for (auto& k : order) {
+                    std::stringstream out;
+                    write_record(begin + k, out);
+                    records[k] = out.str();
+                }
+                std::string text;
+                for (auto& record : records) {
+                    text += record;
+                }
+                output.write(b, std::move(text));
+            }
+        };
+
+    // lift source graph positions onto the lift paths, then resolve the lifted path positions in the target;
+    // positions that can't be lifted become 0
+    auto lift_to_target =
+        [&](const std::vector<pos_t>& source_positions,
+            std::vector<step_handle_t>& steps,
+            const bool path_jaccard,
+            std::vector<pos_t>& target_positions) {
+            const uint64_t n = source_positions.size();
+            std::vector<path_pos_t> lifted(n);
+            std::vector<uint8_t> ok(n, 0);
+            const std::vector<uint64_t> order = by_node(source_positions);
+#pragma omp parallel for schedule(dynamic,64)
+            for (uint64_t k = 0; k < n; ++k) {
+                const uint64_t i = order[k];
+                lift_result_t source_result;
+                if (id(source_positions[i])
+                    && get_position(source_graph, lift_path_set_source, source_positions[i], source_result, steps[i], path_jaccard)) {
+                    lifted[i] = { target_graph.get_path_handle(
+                                      source_graph.get_path_name(
+                                          source_graph.get_path_handle_of_step(
+                                              source_result.ref_hit))),
+                                  (uint64_t)source_result.path_offset,
+                                  source_result.is_rev_vs_ref };
+                    ok[i] = 1;
+                }
+            }
+            std::vector<path_pos_t> target_path_positions;
+            std::vector<uint64_t> targets;
+            for (uint64_t i = 0; i < n; ++i) {
+                if (ok[i]) {
+                    target_path_positions.push_back(lifted[i]);
+                    targets.push_back(i);
+                }
+            }
+            std::vector<pos_t> resolved;
+            std::vector<step_handle_t> resolved_steps;
+            get_graph_positions(target_graph, target_path_positions, resolved, resolved_steps, true);
+            target_positions.assign(n, make_pos_t(0, false, 0)); // couldn't lift
+            for (uint64_t j = 0; j < targets.size(); ++j) {
+                target_positions[targets[j]] = resolved[j];
+                steps[targets[j]] = resolved_steps[j];
+            }
+        };
+
     if (graph_positions.size()) {
         if (lifting) {
             std::cout << "#source.graph.pos\ttarget.graph.pos\t";
@@ -740,196 +882,155 @@ int main_position(int argc, char** argv) {
         	}
         }
     }
-    // for each position that we want to look up
-#pragma omp parallel for schedule(dynamic,1)
-    for (auto& _pos : graph_positions) {
-        // go to the graph
-        // do a little BFS, bounded by our limit
-        // now, if we found our hit, print
-        // optionally, we will translate from a source graph into a target graph
-        lift_result_t source_result;
-        //bool ok = false;
-        pos_t pos;
-        // empty step handle
-		step_handle_t step_handle_graph_pos;
+    // each batch computes its records in parallel and writes them in input order
+    {
+        const uint64_t n = graph_positions.size();
+        // empty step handles, there is no path jaccard for graph positions
+        std::vector<step_handle_t> steps(n);
+        std::vector<pos_t> positions;
         if (lifting) {
-            if (get_position(source_graph, lift_path_set_source, _pos, source_result, step_handle_graph_pos, false)) {
-                pos = get_graph_pos(target_graph,
-                                    { target_graph.get_path_handle(
-                                            source_graph.get_path_name(
-                                                source_graph.get_path_handle_of_step(
-                                                    source_result.ref_hit))),
-                                      (uint64_t)source_result.path_offset,
-                                      source_result.is_rev_vs_ref },
-                                      step_handle_graph_pos);
-            } else {
-                pos = make_pos_t(0,false,0); // couldn't lift
-            }
+            lift_to_target(graph_positions, steps, false, positions);
         } else {
-            pos = _pos;
+            positions = graph_positions;
         }
-        //= (lifting ? ok = get_position(source_graph, lay_path_set
-        lift_result_t result;
-        std::vector<lift_result_t> result_v;
-        if (id(pos) && give_graph_pos) {
-            // force graph position in target
-#pragma omp critical (cout)
-            {
+        write_in_batches(positions, [&](const uint64_t& i, std::stringstream& out) {
+            const pos_t& _pos = graph_positions[i];
+            const pos_t& pos = positions[i];
+            if (!id(pos)) {
+                return;
+            }
+            lift_result_t result;
+            std::vector<lift_result_t> result_v;
+            if (give_graph_pos) {
+                // force graph position in target
                 if (lifting) {
-                    std::cout << id(_pos) << "," << offset(_pos) << "," << (is_rev(_pos) ? "-" : "+") << "\t";
+                    out << id(_pos) << "," << offset(_pos) << "," << (is_rev(_pos) ? "-" : "+") << "\t";
                 }
-                std::cout << id(pos) << "," << offset(pos) << "," << (is_rev(pos) ? "-" : "+") << "\t"
-                          << "\t" << id(pos) << "," << offset(pos) << "," << (is_rev(pos) ? "-" : "+") << std::endl;
-            }
-        } else if (args::get(all_immediate) && get_immediate(target_graph, ref_path_set, pos, result_v)) {
-            bool ref_is_rev = false;
-            for (auto& result : result_v) {
-                path_handle_t p = target_graph.get_path_handle_of_step(result.ref_hit);
-#pragma omp critical (cout)
-                {
+                out << id(pos) << "," << offset(pos) << "," << (is_rev(pos) ? "-" : "+") << "\t"
+                    << "\t" << id(pos) << "," << offset(pos) << "," << (is_rev(pos) ? "-" : "+") << "\n";
+            } else if (args::get(all_immediate) && get_immediate(target_graph, ref_path_set, pos, result_v)) {
+                bool ref_is_rev = false;
+                for (auto& result : result_v) {
+                    path_handle_t p = target_graph.get_path_handle_of_step(result.ref_hit);
                     if (lifting) {
-                        std::cout << id(_pos) << "," << offset(_pos) << "," << (is_rev(_pos) ? "-" : "+") << "\t";
+                        out << id(_pos) << "," << offset(_pos) << "," << (is_rev(_pos) ? "-" : "+") << "\t";
                     }
-                    std::cout << id(pos) << "," << offset(pos) << "," << (is_rev(pos) ? "-" : "+") << "\t"
-                              << target_graph.get_path_name(p) << "," << result.path_offset << "," << (ref_is_rev ? "-" : "+") << "\t"
-                              << result.walked_to_hit_ref << "\t" << (result.is_rev_vs_ref ? "-" : "+") << std::endl;
+                    out << id(pos) << "," << offset(pos) << "," << (is_rev(pos) ? "-" : "+") << "\t"
+                        << target_graph.get_path_name(p) << "," << result.path_offset << "," << (ref_is_rev ? "-" : "+") << "\t"
+                        << result.walked_to_hit_ref << "\t" << (result.is_rev_vs_ref ? "-" : "+") << "\n";
                 }
-            }
-        } else if (get_position(target_graph, ref_path_set, pos, result, step_handle_graph_pos, false)) {
-            bool ref_is_rev = false;
-            path_handle_t p = target_graph.get_path_handle_of_step(result.ref_hit);
-#pragma omp critical (cout)
-            {
+            } else if (get_position(target_graph, ref_path_set, pos, result, steps[i], false)) {
+                bool ref_is_rev = false;
+                path_handle_t p = target_graph.get_path_handle_of_step(result.ref_hit);
                 if (lifting) {
-                    std::cout << id(_pos) << "," << offset(_pos) << "," << (is_rev(_pos) ? "-" : "+") << "\t";
+                    out << id(_pos) << "," << offset(_pos) << "," << (is_rev(_pos) ? "-" : "+") << "\t";
                 }
-                std::cout << id(pos) << "," << offset(pos) << "," << (is_rev(pos) ? "-" : "+") << "\t"
-                          << target_graph.get_path_name(p) << "," << result.path_offset << "," << (ref_is_rev ? "-" : "+") << "\t"
-                          << result.walked_to_hit_ref << "\t" << (result.is_rev_vs_ref ? "-" : "+") << std::endl;
+                out << id(pos) << "," << offset(pos) << "," << (is_rev(pos) ? "-" : "+") << "\t"
+                    << target_graph.get_path_name(p) << "," << result.path_offset << "," << (ref_is_rev ? "-" : "+") << "\t"
+                    << result.walked_to_hit_ref << "\t" << (result.is_rev_vs_ref ? "-" : "+") << "\n";
             }
-        }
+        });
     }
 
-#pragma omp parallel for schedule(dynamic,1)
-    for (auto& path_pos : path_positions) {
+    {
         // TODO we need a better input format
-        pos_t pos;
-		step_handle_t step_handle_graph_pos;
+        std::vector<pos_t> positions;
+        std::vector<step_handle_t> steps;
+        get_graph_positions(lifting ? source_graph : target_graph, path_positions, positions, steps, true);
         // handle the lift into the target graph
         if (lifting) {
-            lift_result_t source_result;
-            pos_t _pos = get_graph_pos(source_graph, path_pos, step_handle_graph_pos);
-            if (id(_pos) && get_position(source_graph, lift_path_set_source, _pos, source_result, step_handle_graph_pos, true)) {
-                pos = get_graph_pos(target_graph,
-                                    { target_graph.get_path_handle(
-                                            source_graph.get_path_name(
-                                                source_graph.get_path_handle_of_step(
-                                                    source_result.ref_hit))),
-                                      (uint64_t)source_result.path_offset,
-                                      source_result.is_rev_vs_ref },
-                                      step_handle_graph_pos);
-            } else {
-                pos = make_pos_t(0,false,0); // couldn't lift
-            }
-
-        } else {
-            //path_pos = _path_pos;
-            pos = get_graph_pos(target_graph, path_pos, step_handle_graph_pos);
+            const std::vector<pos_t> source_positions = positions;
+            lift_to_target(source_positions, steps, true, positions);
         }
-        lift_result_t result;
-        //std::cerr << "Got graph pos " << id(pos) << std::endl;
-        if (id(pos)) {
+        write_in_batches(positions, [&](const uint64_t& i, std::stringstream& out) {
+            const path_pos_t& path_pos = path_positions[i];
+            const pos_t& pos = positions[i];
+            lift_result_t result;
+            if (!id(pos)) {
+                return;
+            }
             if (give_graph_pos) {
-#pragma omp critical (cout)
-                std::cout << "#source.path.pos\ttarget.graph.pos" << std::endl
-                          << (lifting ? source_graph.get_path_name(path_pos.path) : target_graph.get_path_name(path_pos.path))
-                          << "," << path_pos.offset << "," << (path_pos.is_rev ? "-" : "+")
-                          << "\t" << id(pos) << "," << offset(pos) << "," << (is_rev(pos) ? "-" : "+") << std::endl;
-            } else if (get_position(target_graph, ref_path_set, pos, result, step_handle_graph_pos, true)) {
+                out << "#source.path.pos\ttarget.graph.pos" << "\n"
+                    << (lifting ? source_graph.get_path_name(path_pos.path) : target_graph.get_path_name(path_pos.path))
+                    << "," << path_pos.offset << "," << (path_pos.is_rev ? "-" : "+")
+                    << "\t" << id(pos) << "," << offset(pos) << "," << (is_rev(pos) ? "-" : "+") << "\n";
+            } else if (get_position(target_graph, ref_path_set, pos, result, steps[i], true)) {
                 bool ref_is_rev = false;
                 path_handle_t p = target_graph.get_path_handle_of_step(result.ref_hit);
-#pragma omp critical (cout)
-                std::cout << "#source.path.pos\ttarget.path.pos\tdist.to.ref\tstrand.vs.ref" << std::endl
-                          << (lifting ? source_graph.get_path_name(path_pos.path) : target_graph.get_path_name(path_pos.path)) << ","
-                          << path_pos.offset << "," << (path_pos.is_rev ? "-" : "+") << "\t"
-                          << target_graph.get_path_name(p) << "," << result.path_offset << "," << (ref_is_rev ? "-" : "+") << "\t"
-                          << result.walked_to_hit_ref << "\t" << (result.is_rev_vs_ref ? "-" : "+") << std::endl;
+                out << "#source.path.pos\ttarget.path.pos\tdist.to.ref\tstrand.vs.ref" << "\n"
+                    << (lifting ? source_graph.get_path_name(path_pos.path) : target_graph.get_path_name(path_pos.path)) << ","
+                    << path_pos.offset << "," << (path_pos.is_rev ? "-" : "+") << "\t"
+                    << target_graph.get_path_name(p) << "," << result.path_offset << "," << (ref_is_rev ? "-" : "+") << "\t"
+                    << result.walked_to_hit_ref << "\t" << (result.is_rev_vs_ref ? "-" : "+") << "\n";
             }
-        }
+        });
     }
 
 	std::vector<std::unordered_map<uint64_t , std::set<std::string>>> node_annotation_maps;
 
-#pragma omp parallel for schedule(dynamic,1)
-    for (auto& path_range : path_ranges) {
-		pos_t pos_begin, pos_end;
-        // handle the lift into the target graph
-		step_handle_t step_handle_graph_pos_begin;
-		step_handle_t step_handle_graph_pos_end;
-        if (lifting) {
-            lift_result_t source_begin_result, source_end_result;
-            pos_t _pos_begin = get_graph_pos(source_graph, path_range.begin, step_handle_graph_pos_begin);
-            pos_t _pos_end = get_graph_pos(source_graph, path_range.end, step_handle_graph_pos_end);
-            if (id(_pos_begin) && get_position(source_graph, lift_path_set_source, _pos_begin, source_begin_result, step_handle_graph_pos_begin, true)
-                && id(_pos_end) && get_position(source_graph, lift_path_set_source, _pos_end, source_end_result, step_handle_graph_pos_end, true)) {
-                pos_begin = get_graph_pos(target_graph,
-                                          { target_graph.get_path_handle(
-                                                  source_graph.get_path_name(
-                                                      source_graph.get_path_handle_of_step(
-                                                          source_begin_result.ref_hit))),
-                                            (uint64_t)source_begin_result.path_offset,
-                                            source_begin_result.is_rev_vs_ref },
-										  step_handle_graph_pos_begin);
-                pos_end = get_graph_pos(target_graph,
-                                        { target_graph.get_path_handle(
-                                                source_graph.get_path_name(
-                                                    source_graph.get_path_handle_of_step(
-                                                        source_end_result.ref_hit))),
-                                          (uint64_t)source_end_result.path_offset,
-                                          source_end_result.is_rev_vs_ref },
-										step_handle_graph_pos_end);
-            } else {
-                pos_begin = make_pos_t(0,false,0); // couldn't lift
-                pos_end = make_pos_t(0,false,0); // couldn't lift
+    {
+        const uint64_t n = path_ranges.size();
+        std::vector<path_pos_t> begins, ends;
+        begins.reserve(n);
+        ends.reserve(n);
+        for (auto& path_range : path_ranges) {
+            begins.push_back(path_range.begin);
+            ends.push_back(path_range.end);
+        }
+        const odgi::graph_t& graph = lifting ? source_graph : target_graph;
+        std::vector<pos_t> pos_begins, pos_ends;
+        std::vector<step_handle_t> step_begins, step_ends;
+        get_graph_positions(graph, begins, pos_begins, step_begins, !gff_input);
+        if (gff_input) {
+            if (!lifting) {
+                node_annotation_maps.resize(n);
+#pragma omp parallel for schedule(dynamic,64)
+                for (uint64_t i = 0; i < n; ++i) {
+                    if (id(pos_begins[i])) {
+                        node_annotation_maps[i] = get_graph_node_ids_annotation(
+                            target_graph, path_ranges[i], step_begins[i], path_ranges[i].begin.offset - offset(pos_begins[i]));
+                    }
+                }
             }
         } else {
-            //path_pos = _path_pos;
-			if (gff_input) {
-				std::unordered_map<uint64_t , std::set<std::string>> node_annotation_map = get_graph_node_ids_annotation(target_graph, path_range);
-#pragma omp critical (node_annotation_maps)
-				node_annotation_maps.push_back(node_annotation_map);
-			} else {
-				pos_begin = get_graph_pos(target_graph, path_range.begin, step_handle_graph_pos_begin);
-				pos_end = get_graph_pos(target_graph, path_range.end, step_handle_graph_pos_end);
-			}
-        }
-        if (id(pos_begin) && id(pos_end) && !gff_input) {
-            lift_result_t lift_begin;
-            lift_result_t lift_end;
-            // TODO add a GAF-style path to the record to say where the BED range walks in the graph
-            // TODO optionally list out the nodes in this particular range (e.g. those within it in our sort order)
-            if (give_graph_pos) {
-#pragma omp critical (cout)
-                std::cout << path_range.data << "\t"
-                          << id(pos_begin) << "," << offset(pos_begin) << "," << (is_rev(pos_begin)?"-":"+") << "\t"
-                          << id(pos_end) << "," << offset(pos_end) << "," << (is_rev(pos_end)?"-":"+") << std::endl;
-            } else if (get_position(target_graph, ref_path_set, pos_begin, lift_begin, step_handle_graph_pos_begin, true)
-                       && get_position(target_graph, ref_path_set, pos_end, lift_end, step_handle_graph_pos_end, true)) {
-                bool ref_is_rev = false;
-                path_handle_t p_begin = target_graph.get_path_handle_of_step(lift_begin.ref_hit);
-                path_handle_t p_end = target_graph.get_path_handle_of_step(lift_end.ref_hit);
-                // XXX TODO assert these to be equal......
-#pragma omp critical (cout)
-                std::cout << path_range.data << "\t"
-                          << target_graph.get_path_name(p_begin) << ","
-                          << lift_begin.path_offset << ","
-                          << (lift_begin.is_rev_vs_ref ? "-" : "+") << "\t"
-                          << target_graph.get_path_name(p_end) << ","
-                          << lift_end.path_offset << ","
-                          << (lift_end.is_rev_vs_ref ? "-" : "+") << "\t"
-                          << (lift_begin.is_rev_vs_ref ^ path_range.is_rev ? "-" : "+") << std::endl;
-                    //<< walked_to_hit_ref << "\t" << (is_rev_vs_ref ? "-" : "+") << std::endl;
+            get_graph_positions(graph, ends, pos_ends, step_ends, true);
+            // handle the lift into the target graph
+            if (lifting) {
+                const std::vector<pos_t> source_begins = pos_begins;
+                const std::vector<pos_t> source_ends = pos_ends;
+                lift_to_target(source_begins, step_begins, true, pos_begins);
+                lift_to_target(source_ends, step_ends, true, pos_ends);
             }
+            write_in_batches(pos_begins, [&](const uint64_t& i, std::stringstream& out) {
+                const path_range_t& path_range = path_ranges[i];
+                const pos_t& pos_begin = pos_begins[i];
+                const pos_t& pos_end = pos_ends[i];
+                if (!id(pos_begin) || !id(pos_end)) {
+                    return;
+                }
+                lift_result_t lift_begin;
+                lift_result_t lift_end;
+                // TODO add a GAF-style path to the record to say where the BED range walks in the graph
+                // TODO optionally list out the nodes in this particular range (e.g. those within it in our sort order)
+                if (give_graph_pos) {
+                    out << path_range.data << "\t"
+                        << id(pos_begin) << "," << offset(pos_begin) << "," << (is_rev(pos_begin)?"-":"+") << "\t"
+                        << id(pos_end) << "," << offset(pos_end) << "," << (is_rev(pos_end)?"-":"+") << "\n";
+                } else if (get_position(target_graph, ref_path_set, pos_begin, lift_begin, step_begins[i], true)
+                           && get_position(target_graph, ref_path_set, pos_end, lift_end, step_ends[i], true)) {
+                    path_handle_t p_begin = target_graph.get_path_handle_of_step(lift_begin.ref_hit);
+                    path_handle_t p_end = target_graph.get_path_handle_of_step(lift_end.ref_hit);
+                    // XXX TODO assert these to be equal......
+                    out << path_range.data << "\t"
+                        << target_graph.get_path_name(p_begin) << ","
+                        << lift_begin.path_offset << ","
+                        << (lift_begin.is_rev_vs_ref ? "-" : "+") << "\t"
+                        << target_graph.get_path_name(p_end) << ","
+                        << lift_end.path_offset << ","
+                        << (lift_end.is_rev_vs_ref ? "-" : "+") << "\t"
+                        << (lift_begin.is_rev_vs_ref ^ path_range.is_rev ? "-" : "+") << "\n";
+                }
+            });
         }
     }
 	if (gff_input) {
@@ -1,5 +1,6 @@
 #include "subcommand.hpp"
 #include "odgi.hpp"
+#include "edit_batch.hpp"
 #include "args.hxx"
 #include <omp.h>
 #include "algorithms/prune.hpp"
@@ -108,14 +109,16 @@ int main_prune(int argc, char** argv) {
 
     if (args::get(max_degree)) {
         graph.clear_paths();
-        algorithms::remove_high_degree_nodes(graph, args::get(max_degree));
+        algorithms::remove_high_degree_nodes(graph, args::get(max_degree), n_threads);
     }
     if (args::get(max_furcations)) {
         std::vector<edge_t> to_prune = algorithms::find_edges_to_prune(graph, args::get(kmer_length), args::get(max_furcations), n_threads);
         //std::cerr << "edges to prune: " << to_prune.size() << std::endl;
+        edit_batch_t batch(graph, n_threads);
         for (auto& edge : to_prune) {
-            graph.destroy_edge(edge);
+            batch.destroy_edge(edge);
         }
+        batch.apply();
         // we're just removing edges, so paths shouldn't be damaged
         //std::cerr << "done prune" << std::endl;
     }
@@ -144,15 +147,17 @@ int main_prune(int argc, char** argv) {
                     graph.clear_paths();
                 }
                 //std::cerr << "got " << to_drop.size() << " handles to drop" << std::endl;
+                edit_batch_t batch(graph, n_threads);
                 for (auto& edge : edges_to_drop_depth) {
-                    graph.destroy_edge(edge);
+                    batch.destroy_edge(edge);
                 }
                 for (auto& edge : edges_to_drop_best) {
-                    graph.destroy_edge(edge);
+                    batch.destroy_edge(edge);
                 }
                 for (auto& handle : handles_to_drop) {
-                    graph.destroy_handle(handle);
+                    batch.destroy_handle(handle);
                 }
+                batch.apply();
             };
         if (args::get(expand_steps)) {
             graph_t source;
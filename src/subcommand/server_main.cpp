@@ -3,6 +3,17 @@
 #include "algorithms/xp.hpp"
 #include <httplib.h>
 #include <filesystem>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <type_traits>
+#include <unistd.h>
 
 namespace odgi {
 
@@ -10,6 +21,131 @@ namespace odgi {
     using namespace xp;
     using namespace httplib;
 
+    /// Parse a 1-based position, returning 0 if the field is not a positive number
+    static size_t parse_pos_1(const std::string& field) {
+        if (field.empty()) {
+            return 0;
+        }
+        char* end = nullptr;
+        const unsigned long long v = std::strtoull(field.c_str(), &end, 10);
+        return (*end == '\0' || *end == '\r') ? v : 0;
+    }
+
+    /// Call the function with each line of a request body, without the trailing newline
+    static void for_each_body_line(const std::string& body, const std::function<void(const std::string&)>& func) {
+        size_t begin = 0;
+        while (begin < body.size()) {
+            size_t end = body.find('\n', begin);
+            if (end == std::string::npos) {
+                end = body.size();
+            }
+            size_t len = end - begin;
+            if (len > 0 && body[end - 1] == '\r') {
+                --len;
+            }
+            if (len > 0) {
+                func(body.substr(begin, len));
+            }
+            begin = end + 1;
+        }
+    }
+
+    /// Request counts and latency histogram of one route. Everything is a relaxed atomic,
+    /// so recording a request never makes the handlers wait on each other.
+    struct alignas(64) route_metrics_t {
+        /// microsecond buckets: exact below 4, then 4 linear sub-buckets per power of two
+        static constexpr uint64_t bucket_count = 4 * 40;
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> queries{0};
+        std::atomic<uint64_t> latency_us_sum{0};
+        std::array<std::atomic<uint64_t>, bucket_count> latency_us{};
+
+        static uint64_t bucket_of(const uint64_t& us) {
+            if (us < 4) {
+                return us;
+            }
+            const uint64_t e = 63 - __builtin_clzll(us);
+            return std::min(4 * (e - 1) + ((us >> (e - 2)) & 3), bucket_count - 1);
+        }
+
+        /// exclusive upper bound of a bucket in microseconds
+        static uint64_t bucket_end(const uint64_t& b) {
+            if (b < 4) {
+                return b + 1;
+            }
+            return (5 + b % 4) << (b / 4 - 1);
+        }
+
+        void record(const uint64_t& us, const uint64_t& n) {
+            requests.fetch_add(1, std::memory_order_relaxed);
+            queries.fetch_add(n, std::memory_order_relaxed);
+            latency_us_sum.fetch_add(us, std::memory_order_relaxed);
+            latency_us[bucket_of(us)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /// Latency in seconds under which the given fraction of the requests were answered,
+        /// to the resolution of the histogram
+        double quantile(const double& q) const {
+            std::array<uint64_t, bucket_count> counts;
+            uint64_t total = 0;
+            for (uint64_t b = 0; b < bucket_count; ++b) {
+                counts[b] = latency_us[b].load(std::memory_order_relaxed);
+                total += counts[b];
+            }
+            if (total == 0) {
+                return 0;
+            }
+            const uint64_t target = std::max<uint64_t>(1, std::ceil(q * total));
+            uint64_t seen = 0;
+            for (uint64_t b = 0; b < bucket_count; ++b) {
+                seen += counts[b];
+                if (seen >= target) {
+                    return bucket_end(b) / 1e6;
+                }
+            }
+            return bucket_end(bucket_count - 1) / 1e6;
+        }
+    };
+
+    /// Worker pool counting the connections waiting for a worker and those being served
+    class counting_thread_pool_t : public ThreadPool {
+    public:
+        counting_thread_pool_t(const size_t& n, std::atomic<int64_t>& queued, std::atomic<int64_t>& active)
+            : ThreadPool(n), queued(queued), active(active) { }
+
+        // the return type of enqueue differs between httplib versions
+        using enqueue_result_t = decltype(std::declval<ThreadPool&>().enqueue(std::function<void()>()));
+
+        enqueue_result_t enqueue(std::function<void()> fn) override {
+            return enqueue_counted<enqueue_result_t>(fn);
+        }
+
+    private:
+        template<typename result_t>
+        result_t enqueue_counted(const std::function<void()>& fn) {
+            queued.fetch_add(1, std::memory_order_relaxed);
+            auto counted = [this, fn]() {
+                queued.fetch_sub(1, std::memory_order_relaxed);
+                active.fetch_add(1, std::memory_order_relaxed);
+                fn();
+                active.fetch_sub(1, std::memory_order_relaxed);
+            };
+            if constexpr (std::is_same<result_t, bool>::value) {
+                // a full queue rejects the connection
+                const bool ok = ThreadPool::enqueue(counted);
+                if (!ok) {
+                    queued.fetch_sub(1, std::memory_order_relaxed);
+                }
+                return ok;
+            } else {
+                ThreadPool::enqueue(counted);
+            }
+        }
+
+        std::atomic<int64_t>& queued;
+        std::atomic<int64_t>& active;
+    };
+
     int main_server(int argc, char** argv) {
 
         for (uint64_t i = 1; i < argc-1; ++i) {
@@ -25,6 +161,10 @@ namespace odgi {
         args::ValueFlag<std::string> port(mandatory_opts, "N", "Run the server under this port.", {'p', "port"});
         args::Group http_opts(parser, "[ HTTP Options ]");
         args::ValueFlag<std::string> ip_address(http_opts, "IP", "Run the server under this IP address. If not specified, *IP* will be *localhost*.", {'a', "ip"});
+        args::ValueFlag<uint64_t> keep_alive_max(http_opts, "N", "Serve up to *N* requests on one keep-alive connection before closing it (default: 1000).", {'k', "keep-alive-max"});
+        args::ValueFlag<uint64_t> keep_alive_timeout(http_opts, "N", "Close keep-alive connections that have been idle for *N* seconds (default: 5).", {'T', "keep-alive-timeout"});
+        args::Group threading_opts(parser, "[ Threading ]");
+        args::ValueFlag<uint64_t> threads(threading_opts, "N", "Number of worker threads answering requests (default: the number of hardware threads, at least 8).", {'t', "threads"});
         args::Group program_information(parser, "[ Program Information ]");
         args::HelpFlag help(program_information, "help", "Print a help message for odgi server.", {'h', "help"});
 
@@ -58,67 +198,259 @@ namespace odgi {
 			std::cerr << "[odgi::" << "panpos" << "] error: the given file \"" << args::get(dg_in_file) << "\" does not exist. Please specify an existing input file in xp format via -i=[FILE], --idx=[FILE]." << std::endl;
 			return 1;
 		}
-        std::ifstream in;
-        in.open(args::get(dg_in_file));
-        path_index.load(in);
-        in.close();
-
-        /*
-        const char* pattern = R"(/(\d+)/(\w+))";
-        std::regex regexi = std::regex(pattern);
-        std::cmatch cm;    // same as std::match_results<const char*> cm;
-        std::regex_match ("/3/test",cm,regexi);
-        std::cout << "the matches were: " << std::endl;
-        for (unsigned i=0; i<cm.size(); ++i) {
-            std::cout << "[" << cm[i] << "] " << std::endl;
-        }
-        std::cout << std::endl;
-
-        // const char* pattern1 = R"(/(\w+)/(\d+))";
-        // const char* pattern1 = R"(/([a-zA-Z]*[0-9]*)/(\d+))";
-        const char* pattern1 = R"(/(\w*.*)/(\d+))";
-        std::regex regexi1 = std::regex(pattern1);
-        std::cmatch cm1;    // same as std::match_results<const char*> cm;
-        std::regex_match ("/5-/3",cm1,regexi1); // /1741.hr2/3
-        std::cout << "the matches were: " << std::endl;
-        for (unsigned i=0; i<cm1.size(); ++i) {
-            std::cout << "[" << cm1[i] << "] " << std::endl;
-        }
-        */
+        path_index.load(args::get(dg_in_file));
+        // the size of the index file, as measuring the loaded index would read every path
+        // of a lazily loaded one
+        const uint64_t index_bytes = std::filesystem::file_size(args::get(dg_in_file));
 
         Server svr;
 
-        svr.Get("/hi", [](const Request& req, Response& res) {
+        const uint64_t num_threads = args::get(threads)
+                ? args::get(threads)
+                : std::max<uint64_t>(8, std::thread::hardware_concurrency());
+        std::atomic<int64_t> queued_connections{0};
+        std::atomic<int64_t> active_connections{0};
+        svr.new_task_queue = [&] {
+            return new counting_thread_pool_t(num_threads, queued_connections, active_connections);
+        };
+        svr.set_keep_alive_max_count(keep_alive_max ? args::get(keep_alive_max) : 1000);
+        svr.set_keep_alive_timeout(keep_alive_timeout ? args::get(keep_alive_timeout) : 5);
+
+        auto set_headers = [](Response& res) {
             res.set_header("Access-Control-Allow-Origin", "*");
             res.set_header("Access-Control-Expose-Headers", "text/plain");
             res.set_header("Access-Control-Allow-Methods", "GET, POST, DELETE, PUT");
+        };
+
+        const std::array<std::string, 7> route_names = {
+                "GET /hi", "GET /path_name/pos", "POST /pangenome_pos", "GET /path_pos",
+                "POST /path_pos", "GET /node", "POST /node"};
+        enum route_t { HI, GET_PANGENOME_POS, POST_PANGENOME_POS, GET_PATH_POS, POST_PATH_POS, GET_NODE, POST_NODE };
+        std::array<route_metrics_t, 7> metrics;
+        const auto start_time = std::chrono::steady_clock::now();
+
+        // time a handler that returns the number of positions it answered
+        auto timed = [&](const route_t& route, const std::function<uint64_t(const Request&, Response&)>& handler) {
+            route_metrics_t& m = metrics[route];
+            return [&m, handler](const Request& req, Response& res) {
+                const auto begin = std::chrono::steady_clock::now();
+                const uint64_t n = handler(req, res);
+                const auto end = std::chrono::steady_clock::now();
+                m.record(std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count(), n);
+            };
+        };
+
+        // path name lookups go through the compressed suffix array, so each batch
+        // resolves every distinct name only once
+        using path_cache_t = std::unordered_map<std::string, path_handle_t>;
+        auto lookup_path = [&](path_cache_t& cache, const std::string& path_name) {
+            auto f = cache.find(path_name);
+            if (f == cache.end()) {
+                f = cache.emplace(path_name, path_index.get_path_handle(path_name)).first;
+            }
+            return f->second;
+        };
+
+        // 1-based pangenome position of a 1-based path position, 0 if it is not in the index
+        auto pangenome_pos = [&](const path_handle_t& path, const size_t& nuc_pos_1) -> size_t {
+            if (path == as_path_handle(0) || nuc_pos_1 == 0
+                || nuc_pos_1 > path_index.get_path_length(path)) {
+                return 0;
+            }
+            return path_index.get_pangenome_pos(path, nuc_pos_1 - 1) + 1;
+        };
+
+        // tab-separated path names and 1-based path positions at a 1-based pangenome position
+        auto path_positions = [&](const size_t& pan_pos_1, std::string& out) {
+            if (pan_pos_1 == 0 || pan_pos_1 > path_index.get_pangenome_length()) {
+                return;
+            }
+            bool first = true;
+            path_index.for_each_path_pos_at_pangenome_pos(
+                    pan_pos_1 - 1, [&](const path_handle_t& path, const size_t& nuc_pos) {
+                        if (!first) {
+                            out.push_back('\t');
+                        }
+                        first = false;
+                        out.append(path_index.get_path_name(path));
+                        out.push_back('\t');
+                        out.append(std::to_string(nuc_pos + 1));
+                    });
+        };
+
+        // node id, 0-based offset in the node, strand and 0-based step rank at a 1-based path position
+        auto node_at = [&](const path_handle_t& path, const size_t& nuc_pos_1, std::string& out) {
+            if (path == as_path_handle(0) || nuc_pos_1 == 0
+                || nuc_pos_1 > path_index.get_path_length(path)) {
+                out.append("0\t0\t+\t0");
+                return;
+            }
+            const step_handle_t step = path_index.get_step_at_position(path, nuc_pos_1 - 1);
+            const handle_t h = path_index.get_handle_of_step(step);
+            const uint64_t rank = number_bool_packing::unpack_number(h);
+            const bool is_rev = number_bool_packing::unpack_bit(h);
+            const size_t node_length = path_index.get_length(h);
+            size_t offset = nuc_pos_1 - 1 - path_index.get_position_of_step(step);
+            if (is_rev) {
+                offset = node_length - offset - 1;
+            }
+            out.append(std::to_string(rank + 1));
+            out.push_back('\t');
+            out.append(std::to_string(offset));
+            out.push_back('\t');
+            out.push_back(is_rev ? '-' : '+');
+            out.push_back('\t');
+            out.append(std::to_string(as_integers(step)[1]));
+        };
+
+        svr.Get("/hi", timed(HI, [&](const Request& req, Response& res) -> uint64_t {
+            set_headers(res);
             res.set_content("Hello World!", "text/plain");
-            std::cout << "GOT REQUEST : HELLO WORLD!" << std::endl;
-        });
+            return 0;
+        }));
+
+        // batch path:position -> pangenome:position, one "path<TAB>position" per line
+        svr.Post("/pangenome_pos", timed(POST_PANGENOME_POS, [&](const Request& req, Response& res) -> uint64_t {
+            path_cache_t cache;
+            std::string out;
+            uint64_t n = 0;
+            out.reserve(req.body.size());
+            for_each_body_line(req.body, [&](const std::string& line) {
+                const size_t tab = line.rfind('\t');
+                size_t pan_pos = 0;
+                if (tab != std::string::npos) {
+                    pan_pos = pangenome_pos(lookup_path(cache, line.substr(0, tab)),
+                                            parse_pos_1(line.substr(tab + 1)));
+                }
+                out.append(std::to_string(pan_pos));
+                out.push_back('\n');
+                ++n;
+            });
+            set_headers(res);
+            res.set_content(out, "text/plain");
+            return n;
+        }));
+
+        // pangenome:position -> path:position
+        svr.Get(R"(/path_pos/(\d+))", timed(GET_PATH_POS, [&](const Request& req, Response& res) -> uint64_t {
+            std::string out;
+            path_positions(parse_pos_1(req.matches[1]), out);
+            set_headers(res);
+            res.set_content(out, "text/plain");
+            return 1;
+        }));
 
-        svr.Get(R"(/(\w*.*)/(\d+))", [&](const Request& req, Response& res) {
-            /*
-            for (size_t i = 0; i < req.matches.size(); i++) {
-                std::cout << req.matches[i] << std::endl;
-            }
-             */
-            auto path_name = req.matches[1];
-            auto nuc_pos_1 = req.matches[2];
-            std::cout << "GOT REQUEST : path name: " << path_name << "; 1-based nucleotide position: " << nuc_pos_1 << std::endl;
-            size_t nuc_pos_0 = std::stoi(nuc_pos_1) - 1;
-            size_t pan_pos = 0;
-            if (path_index.has_path(path_name)) {
-                if (path_index.has_position(path_name, nuc_pos_0)) {
-                    pan_pos = path_index.get_pangenome_pos(path_name, nuc_pos_0) + 1;
+        // batch pangenome:position -> path:position, one position per line
+        svr.Post("/path_pos", timed(POST_PATH_POS, [&](const Request& req, Response& res) -> uint64_t {
+            std::string out;
+            uint64_t n = 0;
+            for_each_body_line(req.body, [&](const std::string& line) {
+                path_positions(parse_pos_1(line), out);
+                out.push_back('\n');
+                ++n;
+            });
+            set_headers(res);
+            res.set_content(out, "text/plain");
+            return n;
+        }));
+
+        // path:position -> node and step
+        svr.Get(R"(/node/(.+)/(\d+))", timed(GET_NODE, [&](const Request& req, Response& res) -> uint64_t {
+            std::string out;
+            node_at(path_index.get_path_handle(req.matches[1]), parse_pos_1(req.matches[2]), out);
+            set_headers(res);
+            res.set_content(out, "text/plain");
+            return 1;
+        }));
+
+        // batch path:position -> node and step, one "path<TAB>position" per line
+        svr.Post("/node", timed(POST_NODE, [&](const Request& req, Response& res) -> uint64_t {
+            path_cache_t cache;
+            std::string out;
+            uint64_t n = 0;
+            for_each_body_line(req.body, [&](const std::string& line) {
+                const size_t tab = line.rfind('\t');
+                if (tab != std::string::npos) {
+                    node_at(lookup_path(cache, line.substr(0, tab)), parse_pos_1(line.substr(tab + 1)), out);
+                } else {
+                    node_at(as_path_handle(0), 0, out);
                 }
+                out.push_back('\n');
+                ++n;
+            });
+            set_headers(res);
+            res.set_content(out, "text/plain");
+            return n;
+        }));
+
+        // Prometheus text format
+        svr.Get("/metrics", [&](const Request& req, Response& res) {
+            std::stringstream out;
+            out << "# HELP odgi_server_requests_total Requests answered, by route.\n"
+                << "# TYPE odgi_server_requests_total counter\n";
+            for (uint64_t r = 0; r < metrics.size(); ++r) {
+                out << "odgi_server_requests_total{route=\"" << route_names[r] << "\"} "
+                    << metrics[r].requests.load(std::memory_order_relaxed) << "\n";
             }
-            std::cout << "SEND RESPONSE: pangenome position: " << pan_pos << std::endl;
-            res.set_header("Access-Control-Allow-Origin", "*");
-            res.set_header("Access-Control-Expose-Headers", "text/plain");
-            res.set_header("Access-Control-Allow-Methods", "GET, POST, DELETE, PUT");
-            res.set_content(std::to_string(pan_pos), "text/plain");
+            out << "# HELP odgi_server_positions_total Positions answered, by route.\n"
+                << "# TYPE odgi_server_positions_total counter\n";
+            for (uint64_t r = 0; r < metrics.size(); ++r) {
+                out << "odgi_server_positions_total{route=\"" << route_names[r] << "\"} "
+                    << metrics[r].queries.load(std::memory_order_relaxed) << "\n";
+            }
+            out << "# HELP odgi_server_request_seconds Request latency, by route.\n"
+                << "# TYPE odgi_server_request_seconds summary\n";
+            for (uint64_t r = 0; r < metrics.size(); ++r) {
+                for (const double q : {0.5, 0.99}) {
+                    out << "odgi_server_request_seconds{route=\"" << route_names[r] << "\",quantile=\"" << q << "\"} "
+                        << metrics[r].quantile(q) << "\n";
+                }
+                out << "odgi_server_request_seconds_sum{route=\"" << route_names[r] << "\"} "
+                    << metrics[r].latency_us_sum.load(std::memory_order_relaxed) / 1e6 << "\n"
+                    << "odgi_server_request_seconds_count{route=\"" << route_names[r] << "\"} "
+                    << metrics[r].requests.load(std::memory_order_relaxed) << "\n";
+            }
+            // resident set size from the second field of /proc/self/statm, in pages
+            uint64_t resident_bytes = 0;
+            std::ifstream statm("/proc/self/statm");
+            uint64_t pages = 0;
+            if (statm >> pages >> pages) {
+                resident_bytes = pages * sysconf(_SC_PAGESIZE);
+            }
+            out << "# HELP odgi_server_queued_connections Connections waiting for a worker thread.\n"
+                << "# TYPE odgi_server_queued_connections gauge\n"
+                << "odgi_server_queued_connections " << queued_connections.load(std::memory_order_relaxed) << "\n"
+                << "# HELP odgi_server_active_connections Connections being served by a worker thread.\n"
+                << "# TYPE odgi_server_active_connections gauge\n"
+                << "odgi_server_active_connections " << active_connections.load(std::memory_order_relaxed) << "\n"
+                << "# HELP odgi_server_worker_threads Worker threads answering requests.\n"
+                << "# TYPE odgi_server_worker_threads gauge\n"
+                << "odgi_server_worker_threads " << num_threads << "\n"
+                << "# HELP odgi_server_index_bytes Size of the loaded path index.\n"
+                << "# TYPE odgi_server_index_bytes gauge\n"
+                << "odgi_server_index_bytes " << index_bytes << "\n"
+                << "# HELP odgi_server_loaded_paths Paths of the index that have been read into memory.\n"
+                << "# TYPE odgi_server_loaded_paths gauge\n"
+                << "odgi_server_loaded_paths " << path_index.loaded_path_count() << "\n"
+                << "# HELP odgi_server_resident_bytes Resident memory of the server process.\n"
+                << "# TYPE odgi_server_resident_bytes gauge\n"
+                << "odgi_server_resident_bytes " << resident_bytes << "\n"
+                << "# HELP odgi_server_uptime_seconds Time since the server started.\n"
+                << "# TYPE odgi_server_uptime_seconds counter\n"
+                << "odgi_server_uptime_seconds "
+                << std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count() << "\n";
+            res.set_content(out.str(), "text/plain; version=0.0.4");
         });
 
+        // path:position -> pangenome:position
+        svr.Get(R"(/(\w*.*)/(\d+))", timed(GET_PANGENOME_POS, [&](const Request& req, Response& res) -> uint64_t {
+            const size_t pan_pos = pangenome_pos(path_index.get_path_handle(req.matches[1]),
+                                                 parse_pos_1(req.matches[2]));
+            set_headers(res);
+            res.set_content(std::to_string(pan_pos), "text/plain");
+            return 1;
+        }));
+
         svr.Get("/stop", [&](const Request& req, Response& res) {
             svr.stop();
         });
@@ -131,7 +463,8 @@ namespace odgi {
             ip = args::get(ip_address);
         }
 
-        std::cout << "http server listening on http://" << ip << ":" << args::get(port) << std::endl;
+        std::cout << "http server listening on http://" << ip << ":" << args::get(port)
+                  << " with " << num_threads << " worker threads" << std::endl;
         svr.listen(ip.c_str(), p);
 
         /*
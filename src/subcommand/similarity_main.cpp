@@ -2,22 +2,16 @@
 #include "odgi.hpp"
 #include "args.hxx"
 #include "split.hpp"
+#include "pansn.hpp"
 #include <omp.h>
 #include "utils.hpp"
+#include "algorithms/path_intersection.hpp"
+#include "algorithms/path_sketch.hpp"
 
 namespace odgi {
 
 using namespace odgi::subcommand;
 
-// Functions used for the distance matrix generation
-inline uint64_t encode_pair(uint32_t v, uint32_t h) {
-    return ((uint64_t)v << 32) | (uint64_t)h;
-}
-inline void decode_pair(uint64_t pair, uint32_t *v, uint32_t *h) {
-    *v = pair >> 32;
-    *h = pair & 0x00000000FFFFFFFF;
-}
-
 int main_similarity(int argc, char** argv) {
 
     // trick argumentparser to do the right thing with the subcommand
@@ -39,9 +33,24 @@ int main_similarity(int argc, char** argv) {
     args::ValueFlag<std::uint16_t> path_delim_pos(path_investigation_opts, "N", "Consider the N-th occurrence of the delimiter specified with **-D, --delim**"
                                                     " to obtain the group identifier. Specify 1 for the 1st occurrence (default).",
                                                         {'p', "delim-pos"});   
+    args::Flag group_by_sample(path_investigation_opts, "bool", "Following PanSN naming (sample#hap#ctg), group by sample (1st field).", {'S', "group-by-sample"});
+    args::Flag group_by_haplotype(path_investigation_opts, "bool", "Following PanSN naming (sample#hap#ctg), group by haplotype (2nd field).", {'H', "group-by-haplotype"});
     args::Flag distances(path_investigation_opts, "distances", "Provide distances (dissimilarities) instead of similarities. "
                                                              "Outputs additional columns with the Euclidean and Manhattan distances." , {'d', "distances"});
     args::Flag all_pairs(path_investigation_opts, "all", "Emit entries for all pairs of paths/groups, including those with zero intersection.", {'a', "all"});
+    args::Flag frozen(path_investigation_opts, "frozen",
+                      "Load the graph into the compact read-only layout.",
+                      {"frozen"});
+    args::Flag presence_cache(path_investigation_opts, "presence-cache",
+                              "Keep the path presence matrix next to the graph, in *FILE*.presence.*HASH*, and reuse it in later runs"
+                              " on the same graph with the same grouping.",
+                              {"presence-cache"});
+    args::ValueFlag<uint64_t> sketch_size(path_investigation_opts, "N",
+                                          "Estimate the similarities from MinHash sketches of N bins (e.g. 1024) per path or group,"
+                                          " weighted by node length, instead of computing them exactly. The standard error of an"
+                                          " estimated Jaccard J is about sqrt(J*(1-J)/N). The intersection column then holds the"
+                                          " length implied by the estimate.",
+                                          {'k', "sketch-size"});
     
     args::Group threading_opts(parser, "[ Threading ]");
     args::ValueFlag<uint64_t> threads(threading_opts, "N", "Number of threads to use for parallel operations.", {'t', "threads"});
@@ -75,20 +84,34 @@ int main_similarity(int argc, char** argv) {
 		return 1;
 	}
 
+    if (path_delim + group_by_sample + group_by_haplotype > 1) {
+        std::cerr << "[odgi::similarity] error: select only one grouping option (-D/--delim, -S/--group-by-sample, or -H/--group-by-haplotype)." << std::endl;
+        return 1;
+    }
+
+    if (sketch_size && args::get(sketch_size) == 0) {
+        std::cerr << "[odgi::similarity] error: -k,--sketch-size has to specify a value greater than 0." << std::endl;
+        return 1;
+    }
+
+    if (presence_cache && args::get(dg_in_file) == "-") {
+        std::cerr << "[odgi::similarity] error: --presence-cache needs the graph to be read from a file." << std::endl;
+        return 1;
+    }
+
 	const uint64_t num_threads = args::get(threads) ? args::get(threads) : 1;
     omp_set_num_threads(num_threads);
 
-	graph_t graph;
+	graph_t dynamic_graph;
+	flat_graph_t flat_graph;
     assert(argc > 0);
-    {
-        const std::string infile = args::get(dg_in_file);
-        if (infile.size()) {
-            if (infile == "-") {
-                graph.deserialize(std::cin);
-            } else {
-                utils::handle_gfa_odgi_input(infile, "similarity", args::get(progress), num_threads, graph);
-            }
-        }
+    const PathHandleGraph& graph = utils::handle_read_only_input(args::get(dg_in_file), "similarity", args::get(progress), num_threads,
+                                                                 args::get(frozen), dynamic_graph, flat_graph);
+
+    // the node mask and the path presence matrix rank the nodes by id - 1
+    if (graph.get_node_count() > 0 && (graph.min_node_id() != 1 || graph.max_node_id() != graph.get_node_count())) {
+        std::cerr << "[odgi::similarity] error: the node IDs are not compacted. Please run 'odgi sort' using -O, --optimize to optimize the graph." << std::endl;
+        exit(1);
     }
 
     const uint16_t delim_pos = path_delim_pos ? args::get(path_delim_pos) - 1 : 0;
@@ -115,6 +138,7 @@ int main_similarity(int argc, char** argv) {
     // We support up to 4 billion paths (there are uint32_t variables in the implementation)
 
     bool using_delim = !args::get(path_delim).empty();
+    const bool group_paths = using_delim || group_by_sample || group_by_haplotype;
     char delim = '\0';
     ska::flat_hash_map<std::string, uint32_t> path_group_ids;
     ska::flat_hash_map<path_handle_t, uint32_t> path_handle_group_ids;
@@ -140,6 +164,17 @@ int main_similarity(int argc, char** argv) {
                 }
                 path_handle_group_ids[p] = path_group_ids[group_name];
             });
+    } else if (group_paths) {
+        // PanSN groups come numbered from the index, no names need to be split again
+        const pansn_index_t pansn(graph, num_threads);
+        const uint64_t group_count = group_by_sample ? pansn.sample_count() : pansn.haplotype_count();
+        for (uint64_t i = 0; i < group_count; ++i) {
+            path_groups.push_back(group_by_sample ? pansn.sample_name(i) : pansn.haplotype_name(i));
+        }
+        graph.for_each_path_handle(
+            [&](const path_handle_t& p) {
+                path_handle_group_ids[p] = group_by_sample ? pansn.sample_of(p) : pansn.haplotype_of(p);
+            });
     }
 
     // ska::flat_hash_map<std::pair<uint64_t, uint64_t>, uint64_t> leads to huge memory usage with deep graphs
@@ -173,7 +208,7 @@ int main_similarity(int argc, char** argv) {
     }
 
     auto get_path_name
-        = (using_delim ?
+        = (group_paths ?
             (std::function<std::string(const uint32_t&)>)
             [&](const uint32_t& id) { return path_groups[id]; }
             :
@@ -181,7 +216,7 @@ int main_similarity(int argc, char** argv) {
             [&](const uint32_t& id) { return graph.get_path_name(as_path_handle(id)); });
 
     auto get_path_id
-        = (using_delim ?
+        = (group_paths ?
             (std::function<uint32_t(const path_handle_t&)>)
             [&](const path_handle_t& p) {
                 return path_handle_group_ids[p];
@@ -193,7 +228,7 @@ int main_similarity(int argc, char** argv) {
             });
 
     std::vector<uint64_t> bp_count;
-    if (using_delim) {
+    if (group_paths) {
         bp_count.resize(path_groups.size());
     } else {
         bp_count.resize(graph.get_path_count() + 1);
@@ -229,78 +264,44 @@ int main_similarity(int argc, char** argv) {
         bp_count[get_path_id(p)] += path_length;
     }
 
-    const bool show_progress = args::get(progress);
-    std::unique_ptr<algorithms::progress_meter::ProgressMeter> progress_meter;
-    if (show_progress) {
-        progress_meter = std::make_unique<algorithms::progress_meter::ProgressMeter>(
-                graph.get_node_count(), "[odgi::similarity] collecting path intersection lengths");
-    }
-
-    ska::flat_hash_map<uint64_t, uint64_t> path_intersection_length;
-
-    const bool emit_all_pairs = args::get(all_pairs);
-    if (emit_all_pairs) {
-        if (show_progress) {
-            std::cerr << "[odgi::similarity] Pre-populating pair map for --all output..." << std::endl;
-        }
-        if (using_delim) {
-            const uint32_t num_groups = path_groups.size();
-            for (uint32_t i = 0; i < num_groups; ++i) {
-                for (uint32_t j = 0; j < num_groups; ++j) {
-                    // Initialize with 0 intersection. Will be updated later if intersection > 0.
-                    path_intersection_length[encode_pair(i, j)] = 0;
-                }
-            }
+    // The row of each path (by as_integer) in the intersection matrix: its group, or itself
+    std::vector<uint32_t> path_ids(path_max + 1, 0);
+    std::vector<uint32_t> actual_path_ids; // Stores individual path integer IDs if not grouping
+    actual_path_ids.reserve(graph.get_path_count());
+    graph.for_each_path_handle([&](const path_handle_t& p) {
+        path_ids[as_integer(p)] = get_path_id(p);
+        actual_path_ids.push_back((uint32_t)as_integer(p));
+    });
+    std::sort(actual_path_ids.begin(), actual_path_ids.end());
+
+    const uint64_t id_count = group_paths ? path_groups.size() : path_max + 1;
+    const uint64_t sketch_bins = args::get(sketch_size);
+    std::unique_ptr<algorithms::path_sketches_t> sketches;
+    std::unique_ptr<algorithms::path_intersection_matrix_t> path_intersection_length;
+    if (sketch_bins) {
+        // Only the sketches are kept, the pairs are estimated when they are written
+        sketches = std::make_unique<algorithms::path_sketches_t>(id_count, sketch_bins);
+        algorithms::build_path_sketches(graph, node_mask, path_ids, *sketches, num_threads, args::get(progress));
+    } else {
+        // Each thread adds up the pairs of its own rows, in a dense matrix if it fits and in sparse maps otherwise
+        path_intersection_length = std::make_unique<algorithms::path_intersection_matrix_t>(id_count, num_threads);
+        // the presence matrix is transposed for the popcounts, so it must fit twice
+        if (algorithms::path_presence_t::bytes_needed(graph.get_node_count(), id_count) * 2
+            <= algorithms::path_presence_t::default_max_bytes) {
+            const std::vector<uint64_t> path_columns(path_ids.begin(), path_ids.end());
+            algorithms::path_presence_t presence;
+            algorithms::load_or_build_path_presence(presence, graph, path_columns, id_count,
+                                                    presence_cache ? args::get(dg_in_file) : "",
+                                                    args::get(progress));
+            algorithms::collect_path_intersections(graph, node_mask, path_ids, presence, *path_intersection_length,
+                                                   args::get(progress));
         } else {
-            std::vector<uint32_t> actual_path_ids; // Stores individual path integer IDs if not grouping
-            // If not grouping, collect the actual integer path handles used
-            actual_path_ids.reserve(graph.get_path_count());
-            graph.for_each_path_handle([&](const path_handle_t& p) {
-                actual_path_ids.push_back((uint32_t)as_integer(p));
-            });
-
-            // Iterate through all actual path integer IDs collected earlier
-            for (const uint32_t id_i : actual_path_ids) {
-                for (const uint32_t id_j : actual_path_ids) {
-                     // Initialize with 0 intersection.
-                    path_intersection_length[encode_pair(id_i, id_j)] = 0;
-                }
-            }
-        }
-        if (show_progress) {
-             std::cerr << "[odgi::similarity] Pre-population complete. Map size: " << path_intersection_length.size() << std::endl;
+            algorithms::collect_path_intersections(graph, node_mask, path_ids, *path_intersection_length,
+                                                   args::get(progress));
         }
     }
 
-    graph.for_each_handle(
-        [&](const handle_t& h) {
-            // Skip masked-out nodes
-            if (!node_mask[graph.get_id(h) - 1]) {
-                return;
-            }
-            ska::flat_hash_map<uint32_t, uint64_t> local_path_lengths;
-            size_t l = graph.get_length(h);
-            graph.for_each_step_on_handle(
-                h,
-                [&](const step_handle_t& s) {
-                    local_path_lengths[get_path_id(graph.get_path_handle_of_step(s))] += l;
-                });
-
-#pragma omp critical (path_intersection_length)
-            for (auto& p : local_path_lengths) {
-                for (auto& q : local_path_lengths) {
-                    path_intersection_length[encode_pair(p.first, q.first)] += std::min(p.second, q.second);
-                }
-            }
-
-            if (show_progress) {
-                progress_meter->increment(1);
-            }
-        }, true);
-
-    if (show_progress) {
-        progress_meter->finish();
-    }
+    const bool emit_all_pairs = args::get(all_pairs);
 
     /*if (using_delim) {
         std::cout << "group.a" << "\t"
@@ -335,12 +336,7 @@ int main_similarity(int argc, char** argv) {
     }
 
     std::cout << std::endl;
-    for (auto& p : path_intersection_length) {
-        uint32_t id_a, id_b;
-        decode_pair(p.first, &id_a, &id_b);
-
-        auto& intersection = p.second;
-
+    auto emit_pair = [&](const uint32_t& id_a, const uint32_t& id_b, const uint64_t& intersection) {
         // From https://stats.stackexchange.com/questions/58706/distance-metrics-for-binary-vectors
         const double jaccard = (double)intersection / (double)(bp_count[id_a] + bp_count[id_b] - intersection);
         const double cosine = (double)intersection / std::sqrt((double)(bp_count[id_a] * bp_count[id_b]));
@@ -368,6 +364,56 @@ int main_similarity(int argc, char** argv) {
                       << dice << "\t"
                       << estimated_identity << std::endl;
         }
+    };
+
+    std::vector<uint32_t> ids;
+    if (group_paths) {
+        for (uint32_t i = 0; i < path_groups.size(); ++i) {
+            ids.push_back(i);
+        }
+    } else {
+        ids = actual_path_ids;
+    }
+    if (sketches) {
+        // Estimate blocks of rows in parallel, then write them, so that memory stays linear in the ids
+        const uint64_t block_rows = num_threads * 4;
+        std::vector<uint64_t> estimates;
+        for (uint64_t block = 0; block < ids.size(); block += block_rows) {
+            const uint64_t rows = std::min(block_rows, ids.size() - block);
+            estimates.resize(rows * ids.size());
+#pragma omp parallel for schedule(dynamic, 1)
+            for (uint64_t r = 0; r < rows; ++r) {
+                const uint32_t id_a = ids[block + r];
+                for (uint64_t j = 0; j < ids.size(); ++j) {
+                    estimates[r * ids.size() + j] = sketches->intersection(id_a, ids[j], bp_count[id_a], bp_count[ids[j]]);
+                }
+            }
+            for (uint64_t r = 0; r < rows; ++r) {
+                for (uint64_t j = 0; j < ids.size(); ++j) {
+                    const uint64_t intersection = estimates[r * ids.size() + j];
+                    if (intersection || emit_all_pairs) {
+                        emit_pair(ids[block + r], ids[j], intersection);
+                    }
+                }
+            }
+        }
+    } else if (emit_all_pairs || path_intersection_length->is_dense()) {
+        for (const uint32_t id_a : ids) {
+            for (const uint32_t id_b : ids) {
+                const uint64_t intersection = path_intersection_length->get(id_a, id_b);
+                if (intersection || emit_all_pairs) {
+                    emit_pair(id_a, id_b, intersection);
+                }
+            }
+        }
+    } else {
+        path_intersection_length->for_each_pair(
+            [&](const uint32_t& id_a, const uint32_t& id_b, const uint64_t& intersection) {
+                emit_pair(id_a, id_b, intersection);
+                if (id_a != id_b) {
+                    emit_pair(id_b, id_a, intersection);
+                }
+            });
     }
 
     return 0;
@@ -93,6 +93,12 @@ int main_sort(int argc, char** argv) {
                                                                        " in a pipeline of sorts.", {'u', "path-sgd-snapshot"});
 	args::ValueFlag<std::string> _p_sgd_target_paths(pg_sgd_opts, "FILE", "Read the paths that should be considered as target paths (references) from this *FILE*. PG-SGD will keep the nodes of the given paths fixed. A path's rank determines it's weight for decision making and is given by its position in the given *FILE*.", {'H', "target-paths"});
 	args::ValueFlag<std::string> p_sgd_layout(pg_sgd_opts, "STRING", "write the layout of a sorted, path guided 1D SGD graph to this file, no default", {'e', "path-sgd-layout"});
+    args::ValueFlag<std::string> p_sgd_checkpoint(pg_sgd_opts, "FILE", "Write a checkpoint of the path guided 1D SGD to this *FILE* every"
+                                                                       " *--checkpoint-every* iterations, from which *--resume* continues the sort.", {"checkpoint"});
+    args::ValueFlag<uint64_t> p_sgd_checkpoint_every(pg_sgd_opts, "N", "Write a checkpoint every *N* iterations (default: *1*).", {"checkpoint-every"});
+    args::ValueFlag<std::string> p_sgd_resume(pg_sgd_opts, "FILE", "Continue the path guided 1D SGD from the checkpoint in this *FILE*. The graph, the"
+                                                                   " sorts before it, the PG-SGD options and the number of threads must be those of the run"
+                                                                   " that wrote it.", {"resume"});
 
 	/// pipeline
     args::Group pipeline_sort_opts(parser, "[ Pipeline Sorting Options ]");
@@ -148,6 +154,32 @@ int main_sort(int argc, char** argv) {
         return 1;
     }
 
+    algorithms::sgd_checkpointing_t checkpointing;
+    algorithms::sgd_checkpoint_t resume_checkpoint;
+    if (p_sgd_checkpoint || p_sgd_resume) {
+        const std::string &sorts = args::get(pipeline);
+        if (std::count(sorts.begin(), sorts.end(), 'Y') + (p_sgd && sorts.empty() ? 1 : 0) != 1) {
+            std::cerr << "[odgi::sort] error: --checkpoint and --resume need exactly one path guided 1D SGD sort, via -Y/--path-sgd or in -p/--pipeline." << std::endl;
+            return 1;
+        }
+    }
+    if (p_sgd_checkpoint) {
+        checkpointing.file = args::get(p_sgd_checkpoint);
+        checkpointing.every = p_sgd_checkpoint_every ? args::get(p_sgd_checkpoint_every) : 1;
+        if (checkpointing.every == 0) {
+            std::cerr << "[odgi::sort] error: please specify a number of iterations greater than 0 via --checkpoint-every=[N]." << std::endl;
+            return 1;
+        }
+    }
+    if (p_sgd_resume) {
+        std::ifstream resume_in(args::get(p_sgd_resume), std::ios::binary);
+        if (!resume_in || !resume_checkpoint.load(resume_in)) {
+            std::cerr << "[odgi::sort] error: " << args::get(p_sgd_resume) << " is not a PG-SGD checkpoint." << std::endl;
+            return 1;
+        }
+        checkpointing.resume = &resume_checkpoint;
+    }
+
 	const uint64_t num_threads = args::get(nthreads) ? args::get(nthreads) : 1;
 
 	graph_t graph;
@@ -338,6 +370,11 @@ int main_sort(int argc, char** argv) {
 		}
         // take care of path index
         if (xp_in_file) {
+            if (xp::XP::is_flat(args::get(xp_in_file))) {
+                std::cerr << "[odgi::sort] error: the path index " << args::get(xp_in_file)
+                          << " is in the flat layout, please create it with odgi pathindex without -F, --flat." << std::endl;
+                exit(1);
+            }
             std::ifstream in;
             in.open(args::get(xp_in_file));
             path_index.load(in);
@@ -471,7 +508,8 @@ int main_sort(int argc, char** argv) {
 															  p_sgd_layout,
 															  layout_out,
 															  _p_sgd_target_paths,
-															  is_ref);
+															  is_ref,
+															  checkpointing);
 					// reset is_ref or we will break when we apply it again
                     break;
                 }
@@ -539,7 +577,8 @@ int main_sort(int argc, char** argv) {
 												  p_sgd_layout,
 												  layout_out,
 												  _p_sgd_target_paths,
-												  is_ref);
+												  is_ref,
+												  checkpointing);
         graph.apply_ordering(order, true);
     } else if (args::get(breadth_first)) {
         graph.apply_ordering(algorithms::breadth_first_topological_order(graph, bf_chunk_size), true);
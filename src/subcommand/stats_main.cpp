@@ -224,7 +224,7 @@ int main_stats(int argc, char** argv) {
     }
 
     if (args::get(_weakly_connected_components) || _multiqc) {
-        std::vector<ska::flat_hash_set<handlegraph::nid_t>> weak_components = algorithms::weakly_connected_components(&graph);
+        std::vector<ska::flat_hash_set<handlegraph::nid_t>> weak_components = algorithms::weakly_connected_components(&graph, num_threads);
 		if (_multiqc || _yaml) {
 			std::cout << "num_weakly_connected_components: " << weak_components.size() << std::endl;
 			std::cout << "weakly_connected_components: " << std::endl;
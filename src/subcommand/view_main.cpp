@@ -2,6 +2,8 @@
 #include "odgi.hpp"
 #include "args.hxx"
 #include "utils.hpp"
+#include "flat_graph.hpp"
+#include <omp.h>
 
 namespace odgi {
 
@@ -23,6 +25,9 @@ int main_view(int argc, char** argv) {
     args::Group out_opts(parser, "[ Output Options ]");
     args::Flag to_gfa(out_opts, "to_gfa", "Write the graph in GFAv1 format to standard output.", {'g', "to-gfa"});
     args::Flag emit_node_annotation(out_opts, "node_annotation", "Emit node annotations for the graph in GFAv1 format.", {'a', "node-annotation"});
+    args::ValueFlag<std::string> to_flat(out_opts, "FILE", "Write the graph in the flat, memory-mappable layout to *FILE*. Read-only"
+                                         " subcommands such as odgi depth map such a file instead of parsing it, so it loads"
+                                         " almost instantly.", {'F', "to-flat"});
     args::Flag display(out_opts, "display", "Show the internal structures of a graph. Print to stderr the maximum"
                                           " node identifier, the minimum node identifier, the nodes vector, the"
                                           " delete nodes bit vector and the path metadata, each in a separate"
@@ -75,6 +80,21 @@ int main_view(int argc, char** argv) {
     if (args::get(to_gfa)) {
         graph.to_gfa(std::cout, args::get(emit_node_annotation));
     }
+    if (!args::get(to_flat).empty()) {
+        omp_set_num_threads((int) num_threads);
+        std::ofstream f(args::get(to_flat).c_str(), std::ios::binary);
+        if (!f) {
+            std::cerr << "[odgi::view] error: could not open \"" << args::get(to_flat) << "\" for writing." << std::endl;
+            return 1;
+        }
+        if (args::get(progress)) {
+            std::cerr << "[odgi::view] writing flat graph to \"" << args::get(to_flat) << "\"" << std::endl;
+        }
+        flat_graph_t flat_graph;
+        flat_graph.from_graph(graph);
+        flat_graph.serialize(f);
+        f.close();
+    }
 
     return 0;
 }
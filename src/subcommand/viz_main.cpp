@@ -918,19 +918,37 @@ namespace odgi {
 
 		// Compressed-Mode part starts here :)
 		if (compress) {
-			std::map <uint64_t, algorithms::path_info_t> bins;
-			graph.for_each_path_handle([&](const path_handle_t &path) {
-				graph.for_each_step_in_path(path, [&](const step_handle_t &occ) {
-					handle_t h = graph.get_handle_of_step(occ);
-					uint64_t hl = graph.get_length(h);
-
-					uint64_t p = position_map[number_bool_packing::unpack_number(h) - shift];
-					for (uint64_t k = 0; k < hl; ++k) {
-						int64_t curr_bin = (p + k) / _bin_width + 1;
-						++bins[curr_bin].mean_depth;
+			// Every path step adds the bases of its node to the bins, so walking the nodes once with their
+			// step counts gives the same sums without walking the paths. The threads take blocks of nodes,
+			// which only share the bins at the block ends.
+			std::vector<double> bin_depths((uint64_t)(position_map.back() / _bin_width) + 2, 0);
+			const nid_t min_id = graph.min_node_id();
+#pragma omp parallel for schedule(dynamic, 1024) num_threads(num_threads)
+			for (uint64_t rank = 0; rank < graph.get_node_count(); ++rank) {
+				const handle_t h = graph.get_handle(rank + min_id);
+				const uint64_t step_count = graph.get_step_count(h);
+				if (!step_count) {
+					continue;
+				}
+				const uint64_t hl = graph.get_length(h);
+				const uint64_t p = position_map[rank];
+				int64_t last_bin = -1;
+				uint64_t bases = 0;
+				for (uint64_t k = 0; k < hl; ++k) {
+					int64_t curr_bin = (p + k) / _bin_width + 1;
+					if (curr_bin != last_bin && bases) {
+#pragma omp atomic
+						bin_depths[last_bin] += (double) (bases * step_count);
+						bases = 0;
 					}
-				});
-			});
+					last_bin = curr_bin;
+					++bases;
+				}
+				if (bases) {
+#pragma omp atomic
+					bin_depths[last_bin] += (double) (bases * step_count);
+				}
+			}
 
 			/// path name part
 
@@ -992,12 +1010,12 @@ namespace odgi {
 				depth += 1;
 			}
 
-			for (auto &entry: bins) {
-				auto &sec = entry.second;
-				auto &curr_bin = entry.first;
-				sec.mean_depth /= _bin_width;
-				// std::cerr << "MEAN DEPTH OF BIN: " << v.mean_depth << std::endl;
-				auto &mean_depth = sec.mean_depth;
+			for (uint64_t curr_bin = 0; curr_bin < bin_depths.size(); ++curr_bin) {
+				if (bin_depths[curr_bin] == 0) {
+					continue;
+				}
+				const double mean_depth = bin_depths[curr_bin] / _bin_width;
+				// std::cerr << "MEAN DEPTH OF BIN: " << mean_depth << std::endl;
 				uint64_t j = 0;
 				for (; j < cov_cuts.size(); ++j) {
 					if (mean_depth <= cov_cuts[j]) {
@@ -1024,7 +1042,7 @@ namespace odgi {
 			/// default case:
 		} else {
 
-			graph.for_each_path_handle([&](const path_handle_t &path) {
+			auto draw_path = [&](const path_handle_t &path) {
 				int64_t path_rank = get_path_idx(path);
 				//std::cerr << graph.get_path_name(path) << " -> " << path_rank << std::endl;
 				if (path_rank >= 0 && path_layout_y[path_rank] >= 0) {
@@ -1373,8 +1391,26 @@ namespace odgi {
 					}
 				}
 				//add_point(curr_bin - 1 - pangenomic_start_pos, 0, RGB_BIN_LINKS, RGB_BIN_LINKS, RGB_BIN_LINKS);
-			});
+			};
 
+			// A path only draws into the band of pixel rows of its layout row, in the image and in the
+			// path names, so the layout rows are drawn in parallel. The paths sharing a row (packed or
+			// grouped) are drawn one after the other, in the order they always were.
+			std::vector<std::vector<path_handle_t>> paths_by_row(path_layout_y.size());
+			graph.for_each_path_handle([&](const path_handle_t &path) {
+				const int64_t path_rank = get_path_idx(path);
+				if (path_rank >= 0 && path_layout_y[path_rank] >= 0) {
+					paths_by_row[path_layout_y[path_rank]].push_back(path);
+				}
+			});
+			// links thicker than a path would reach into the neighboring rows
+			const uint64_t row_threads = pix_per_link <= pix_per_path ? num_threads : 1;
+#pragma omp parallel for schedule(dynamic, 1) num_threads(row_threads)
+			for (uint64_t row = 0; row < paths_by_row.size(); ++row) {
+				for (auto &path : paths_by_row[row]) {
+					draw_path(path);
+				}
+			}
 		}
 
         /*
@@ -1391,6 +1427,7 @@ namespace odgi {
         uint64_t max_x = std::numeric_limits<uint64_t>::min(); // 0
         uint64_t min_y = height + path_space;
         uint64_t max_y = std::numeric_limits<uint64_t>::min(); // 0
+#pragma omp parallel for schedule(static) num_threads(num_threads) reduction(min:min_x,min_y) reduction(max:max_x,max_y)
         for (uint64_t y = 0; y < height + path_space; ++y) {
             for (uint64_t x = 0; x < width; ++x) {
                 uint8_t r = image[4 * width * y + 4 * x + 0];
@@ -1425,6 +1462,7 @@ namespace odgi {
 
         std::vector<uint8_t> crop;
         crop.resize(crop_width * crop_height * 4, 255);
+#pragma omp parallel for schedule(static) num_threads(num_threads)
         for (uint64_t y = 0; y < crop_height; ++y) {
             for (uint64_t x = 0; x < crop_width; ++x) {
                 for (uint8_t z = 0; z < 4; z++){
@@ -1436,7 +1474,7 @@ namespace odgi {
         }
 
         const char *filename = args::get(png_out_file).c_str();
-        png::encodeOneStep(filename, crop, crop_width, crop_height);
+        png::encodeParallel(filename, crop, crop_width, crop_height, num_threads);
 
         return 0;
     }
@@ -0,0 +1,94 @@
+/**
+ * \file
+ * unittest/chop.cpp: test cases for dividing the nodes of a graph in bulk.
+ */
+
+#include "catch.hpp"
+
+#include "odgi.hpp"
+#include "algorithms/chop.hpp"
+#include "random_graph.hpp"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+/// a random graph with long nodes, inversions and paths walking both strands
+static void build_random_graph(graph_t& graph) {
+    random_graph_params_t params;
+    params.seed = 11;
+    params.node_count = 300;
+    params.max_node_length = 40;
+    params.edge_count = 600;
+    params.inverting_loops = 10;
+    params.path_count = 20;
+    params.steps_per_path = 100;
+    params.circular_path = 3;
+    build_random_graph(graph, params);
+}
+
+TEST_CASE("Chopping in bulk divides nodes like divide_handle", "[chop]") {
+    const uint64_t max_node_length = 8;
+
+    // divide the long nodes one at a time, and compact the ids in the order of the nodes
+    graph_t expected;
+    build_random_graph(expected);
+    std::vector<handle_t> to_chop;
+    expected.for_each_handle([&](const handle_t& handle) {
+        to_chop.push_back(handle);
+    });
+    std::vector<handle_t> order;
+    for (const handle_t& handle : to_chop) {
+        const uint64_t length = expected.get_length(handle);
+        if (length > max_node_length) {
+            std::vector<size_t> offsets;
+            for (uint64_t i = max_node_length; i < length; i += max_node_length) {
+                offsets.push_back(i);
+            }
+            for (const handle_t& piece : expected.divide_handle(handle, offsets)) {
+                order.push_back(piece);
+            }
+        } else {
+            order.push_back(handle);
+        }
+    }
+    expected.apply_ordering(order, true);
+
+    graph_t chopped;
+    build_random_graph(chopped);
+    algorithms::chop(chopped, max_node_length, 4, false);
+
+    REQUIRE(chopped.get_node_count() == expected.get_node_count());
+    REQUIRE(chopped.get_edge_count() == expected.get_edge_count());
+    REQUIRE(describe(chopped) == describe(expected));
+    chopped.for_each_handle([&](const handle_t& handle) {
+        REQUIRE(chopped.get_length(handle) <= max_node_length);
+    });
+}
+
+TEST_CASE("Chopping in bulk keeps a self loop as an edge from the last piece to the first", "[chop]") {
+    graph_t graph;
+    const handle_t n1 = graph.create_handle("ACGTACGTAA");
+    graph.create_edge(n1, n1);
+    const path_handle_t path = graph.create_path_handle("loop");
+    graph.append_step(path, n1);
+    graph.append_step(path, n1);
+    algorithms::chop(graph, 4, 2, false);
+
+    REQUIRE(graph.get_node_count() == 3);
+    REQUIRE(graph.has_edge(graph.get_handle(3), graph.get_handle(1)));
+    REQUIRE(graph.has_edge(graph.get_handle(1), graph.get_handle(2)));
+    REQUIRE(graph.has_edge(graph.get_handle(2), graph.get_handle(3)));
+    REQUIRE(graph.get_edge_count() == 3);
+    REQUIRE(graph.get_step_count(path) == 6);
+}
+
+}
+}
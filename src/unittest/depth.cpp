@@ -0,0 +1,99 @@
+#include "catch.hpp"
+
+#include <handlegraph/handle_graph.hpp>
+#include <handlegraph/util.hpp>
+#include "odgi.hpp"
+#include "position.hpp"
+#include "algorithms/depth.hpp"
+
+#include <sstream>
+#include <vector>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+TEST_CASE("Node depths answer node and path range queries", "[depth]") {
+    // 3 nodes of 1, 2 and 4 bp; path a walks them all, path b the last two, and path c the last one twice
+    graph_t graph;
+    const handle_t n1 = graph.create_handle("A");
+    const handle_t n2 = graph.create_handle("CG");
+    const handle_t n3 = graph.create_handle("TTAA");
+    graph.create_edge(n1, n2);
+    graph.create_edge(n2, n3);
+    graph.create_edge(n3, n3);
+    const path_handle_t a = graph.create_path_handle("a");
+    const path_handle_t b = graph.create_path_handle("b");
+    const path_handle_t c = graph.create_path_handle("c");
+    for (auto& h : {n1, n2, n3}) {
+        graph.append_step(a, h);
+    }
+    graph.append_step(b, n2);
+    graph.append_step(b, n3);
+    graph.append_step(c, n3);
+    graph.append_step(c, n3);
+
+    const std::vector<bool> all_paths(4, true);
+    algorithms::node_depth_t node_depth;
+    node_depth.build(graph, all_paths, false);
+    const nid_t id1 = graph.get_id(n1), id2 = graph.get_id(n2), id3 = graph.get_id(n3);
+
+    SECTION("depth and unique depth of each node") {
+        REQUIRE(node_depth.depth(id1) == 1);
+        REQUIRE(node_depth.depth(id2) == 2);
+        REQUIRE(node_depth.depth(id3) == 4);
+        REQUIRE(node_depth.unique_depth(id1) == 1);
+        REQUIRE(node_depth.unique_depth(id2) == 2);
+        REQUIRE(node_depth.unique_depth(id3) == 3);
+    }
+
+    SECTION("depths of a subset of the paths") {
+        std::vector<bool> only_b(4, false);
+        only_b[as_integer(b)] = true;
+        algorithms::node_depth_t subset_depth;
+        subset_depth.build(graph, only_b, false);
+        REQUIRE(subset_depth.depth(id1) == 0);
+        REQUIRE(subset_depth.depth(id2) == 1);
+        REQUIRE(subset_depth.depth(id3) == 1);
+    }
+
+    SECTION("mean depth of path ranges") {
+        const std::vector<path_range_t> ranges = {
+            {{a, 0, false}, {a, 7, false}, false, "", ""},
+            {{a, 2, false}, {a, 5, false}, false, "", ""},
+            {{a, 5, false}, {a, 10, false}, false, "", ""},
+            {{a, 7, false}, {a, 9, false}, false, "", ""},
+            {{c, 3, false}, {c, 6, false}, false, "", ""},
+        };
+        const std::vector<double> depths = algorithms::get_path_range_depths(graph, ranges, node_depth);
+        REQUIRE(depths.size() == ranges.size());
+        REQUIRE(depths[0] == 3.0);
+        REQUIRE(depths[1] == 10.0 / 3.0);
+        REQUIRE(depths[2] == 8.0 / 5.0);
+        REQUIRE(depths[3] == -1);
+        REQUIRE(depths[4] == 4.0);
+    }
+
+    SECTION("cached depths are only loaded for the same graph and paths") {
+        const uint64_t fingerprint = algorithms::node_depth_t::fingerprint(graph, all_paths);
+        std::stringstream cache;
+        node_depth.serialize(cache, fingerprint);
+        const std::string bytes = cache.str();
+
+        algorithms::node_depth_t loaded;
+        std::stringstream in(bytes);
+        REQUIRE(loaded.load(in, fingerprint));
+        REQUIRE(loaded.depth(id3) == 4);
+        REQUIRE(loaded.unique_depth(id3) == 3);
+
+        std::vector<bool> only_b(4, false);
+        only_b[as_integer(b)] = true;
+        std::stringstream other(bytes);
+        REQUIRE(!loaded.load(other, algorithms::node_depth_t::fingerprint(graph, only_b)));
+    }
+}
+
+}
+}
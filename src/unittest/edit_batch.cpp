@@ -0,0 +1,305 @@
+/**
+ * \file
+ * unittest/edit_batch.cpp: test cases for applying batches of graph edits.
+ */
+
+#include "catch.hpp"
+
+#include "odgi.hpp"
+#include "edit_batch.hpp"
+#include "random_graph.hpp"
+
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+/// a random graph with inversions, and either inverting self loops or paths
+static void build_random_graph(graph_t& graph, const bool& with_paths) {
+    random_graph_params_t params;
+    params.seed = 17;
+    params.inverting_loops = with_paths ? 0 : 10;
+    params.path_count = with_paths ? 10 : 0;
+    params.circular_path = 2;
+    build_random_graph(graph, params);
+}
+
+/// the edges of the graph, both ways round
+static std::vector<edge_t> all_edges(const graph_t& graph) {
+    std::vector<edge_t> edges;
+    graph.for_each_handle([&](const handle_t& handle) {
+        for (const handle_t& h : {handle, graph.flip(handle)}) {
+            graph.follow_edges(h, false, [&](const handle_t& next) {
+                edges.emplace_back(h, next);
+            });
+        }
+    });
+    return edges;
+}
+
+TEST_CASE("A batch of edge and node edits matches applying them one at a time", "[edit_batch]") {
+    graph_t expected;
+    build_random_graph(expected, false);
+    graph_t batched;
+    build_random_graph(batched, false);
+
+    // pick the edits on one graph, as both were built the same way
+    std::mt19937_64 rng(5);
+    std::vector<edge_t> to_destroy;
+    for (auto& edge : all_edges(expected)) {
+        if (rng() % 4 == 0) {
+            to_destroy.push_back(edge);
+        }
+    }
+    std::vector<handle_t> handles;
+    expected.for_each_handle([&](const handle_t& handle) {
+        handles.push_back(handle);
+    });
+    std::vector<handle_t> nodes_to_destroy;
+    for (uint64_t i = 0; i < 20; ++i) {
+        nodes_to_destroy.push_back(handles[rng() % handles.size()]);
+    }
+    std::vector<edge_t> to_create;
+    for (uint64_t i = 0; i < 100; ++i) {
+        const handle_t from = handles[rng() % handles.size()];
+        const handle_t to = handles[rng() % handles.size()];
+        if (from == to) {
+            continue;
+        }
+        to_create.emplace_back(rng() % 2 ? expected.flip(from) : from, rng() % 2 ? expected.flip(to) : to);
+    }
+
+    for (auto& edge : to_destroy) {
+        expected.destroy_edge(edge);
+    }
+    for (auto& handle : nodes_to_destroy) {
+        expected.destroy_handle(handle);
+    }
+    for (auto& edge : to_create) {
+        if (expected.has_node(expected.get_id(edge.first)) && expected.has_node(expected.get_id(edge.second))) {
+            expected.create_edge(edge);
+        }
+    }
+
+    edit_batch_t batch(batched, 4);
+#pragma omp parallel for num_threads(4)
+    for (uint64_t i = 0; i < to_destroy.size(); ++i) {
+        batch.destroy_edge(to_destroy[i]);
+    }
+    for (auto& handle : nodes_to_destroy) {
+        batch.destroy_handle(handle);
+    }
+    for (auto& edge : to_create) {
+        batch.create_edge(edge.first, edge.second);
+    }
+    batch.apply();
+
+    REQUIRE(batched.get_node_count() == expected.get_node_count());
+    REQUIRE(batched.get_edge_count() == expected.get_edge_count());
+    REQUIRE(describe(batched) == describe(expected));
+}
+
+TEST_CASE("A batch of divisions matches divide_handle and a compacting apply_ordering", "[edit_batch]") {
+    graph_t expected;
+    build_random_graph(expected, true);
+    graph_t batched;
+    build_random_graph(batched, true);
+
+    std::mt19937_64 rng(3);
+    std::vector<std::pair<handle_t, std::vector<size_t>>> divisions;
+    expected.for_each_handle([&](const handle_t& handle) {
+        const uint64_t length = expected.get_length(handle);
+        if (length > 1 && rng() % 2) {
+            std::vector<size_t> offsets;
+            for (uint64_t i = 1; i < length; ++i) {
+                if (rng() % 4 == 0) {
+                    offsets.push_back(i);
+                }
+            }
+            divisions.emplace_back(rng() % 2 ? expected.flip(handle) : handle, offsets);
+        }
+    });
+
+    std::vector<handle_t> order;
+    uint64_t next = 0;
+    std::vector<handle_t> handles;
+    expected.for_each_handle([&](const handle_t& handle) {
+        handles.push_back(handle);
+    });
+    for (const handle_t& handle : handles) {
+        if (next < divisions.size() && expected.get_id(divisions[next].first) == expected.get_id(handle)) {
+            std::vector<handle_t> pieces = expected.divide_handle(divisions[next].first, divisions[next].second);
+            if (expected.get_is_reverse(divisions[next].first)) {
+                std::reverse(pieces.begin(), pieces.end());
+                for (auto& piece : pieces) {
+                    piece = expected.flip(piece);
+                }
+            }
+            order.insert(order.end(), pieces.begin(), pieces.end());
+            ++next;
+        } else {
+            order.push_back(handle);
+        }
+    }
+    expected.apply_ordering(order, true);
+
+    edit_batch_t batch(batched, 4);
+    for (auto& division : divisions) {
+        batch.divide_handle(division.first, division.second);
+    }
+    batch.apply();
+
+    REQUIRE(batched.get_node_count() == expected.get_node_count());
+    REQUIRE(batched.get_edge_count() == expected.get_edge_count());
+    REQUIRE(describe(batched) == describe(expected));
+}
+
+TEST_CASE("A batch of divisions writes the same graph with any number of threads", "[edit_batch]") {
+    std::vector<std::string> serialized;
+    for (const uint64_t num_threads : {1, 4}) {
+        // enough nodes and paths for every thread to get some
+        graph_t graph;
+        random_graph_params_t params;
+        params.seed = 23;
+        params.node_count = 8000;
+        params.edge_count = 16000;
+        params.path_count = 16;
+        params.steps_per_path = 1000;
+        params.circular_path = 2;
+        build_random_graph(graph, params);
+        std::mt19937_64 rng(7);
+        edit_batch_t batch(graph, num_threads);
+        graph.for_each_handle([&](const handle_t& handle) {
+            if (graph.get_length(handle) > 1 && rng() % 2) {
+                batch.divide_handle(handle, {1 + rng() % (graph.get_length(handle) - 1)});
+            }
+        });
+        batch.apply();
+
+        // the steps are linked both ways
+        graph.for_each_path_handle([&](const path_handle_t& path) {
+            std::vector<step_handle_t> forward;
+            graph.for_each_step_in_path(path, [&](const step_handle_t& step) {
+                forward.push_back(step);
+            });
+            REQUIRE(forward.size() == graph.get_step_count(path));
+            std::vector<step_handle_t> backward = {graph.path_back(path)};
+            while (graph.has_previous_step(backward.back())) {
+                backward.push_back(graph.get_previous_step(backward.back()));
+            }
+            std::reverse(backward.begin(), backward.end());
+            REQUIRE(backward == forward);
+        });
+
+        std::stringstream out;
+        graph.serialize(out);
+        serialized.push_back(out.str());
+    }
+    REQUIRE(serialized[0] == serialized[1]);
+}
+
+TEST_CASE("A batch of step appends matches append_step", "[edit_batch]") {
+    graph_t expected;
+    build_random_graph(expected, true);
+    graph_t batched;
+    build_random_graph(batched, true);
+
+    // extend half of the paths, and walk new ones along stretches of the old ones
+    std::mt19937_64 rng(13);
+    std::vector<handle_t> handles;
+    expected.for_each_handle([&](const handle_t& handle) {
+        handles.push_back(handle);
+    });
+    std::vector<std::pair<std::string, std::vector<handle_t>>> appends;
+    expected.for_each_path_handle([&](const path_handle_t& path) {
+        if (rng() % 2) {
+            std::vector<handle_t> extension;
+            for (uint64_t i = 0; i < 20; ++i) {
+                const handle_t h = handles[rng() % handles.size()];
+                extension.push_back(rng() % 3 == 0 ? expected.flip(h) : h);
+            }
+            appends.emplace_back(expected.get_path_name(path), extension);
+        }
+        std::vector<handle_t> walk;
+        expected.for_each_step_in_path(path, [&](const step_handle_t& step) {
+            if (walk.size() < 30) {
+                walk.push_back(expected.get_handle_of_step(step));
+            }
+        });
+        appends.emplace_back("copy of " + expected.get_path_name(path), walk);
+    });
+
+    for (auto& append : appends) {
+        if (!expected.has_path(append.first)) {
+            expected.create_path_handle(append.first);
+            batched.create_path_handle(append.first);
+        }
+        const path_handle_t path = expected.get_path_handle(append.first);
+        for (auto& h : append.second) {
+            expected.append_step(path, h);
+        }
+    }
+    edit_batch_t batch(batched, 4);
+#pragma omp parallel for num_threads(4)
+    for (uint64_t i = 0; i < appends.size(); ++i) {
+        batch.append_steps(batched.get_path_handle(appends[i].first), appends[i].second);
+    }
+    batch.apply();
+
+    REQUIRE(describe(batched) == describe(expected));
+    batched.for_each_path_handle([&](const path_handle_t& path) {
+        REQUIRE(batched.get_step_count(path) == expected.get_step_count(expected.get_path_handle(batched.get_path_name(path))));
+        // the steps are linked both ways
+        std::vector<step_handle_t> forward;
+        batched.for_each_step_in_path(path, [&](const step_handle_t& step) {
+            forward.push_back(step);
+        });
+        std::vector<step_handle_t> backward = {batched.path_back(path)};
+        while (batched.has_previous_step(backward.back())) {
+            backward.push_back(batched.get_previous_step(backward.back()));
+        }
+        std::reverse(backward.begin(), backward.end());
+        REQUIRE(backward == forward);
+    });
+}
+
+TEST_CASE("A batch removes a self loop from either strand", "[edit_batch]") {
+    graph_t graph;
+    const handle_t n1 = graph.create_handle("ACGT");
+    const handle_t n2 = graph.create_handle("GGCC");
+    graph.create_edge(n1, n1);
+    graph.create_edge(n2, n2);
+    graph.create_edge(n1, n2);
+    REQUIRE(graph.get_edge_count() == 3);
+
+    edit_batch_t batch(graph, 2);
+    batch.destroy_edge(graph.flip(n1), graph.flip(n1));
+    batch.destroy_edge(n2, n2);
+    batch.apply();
+    REQUIRE(!graph.has_edge(n1, n1));
+    REQUIRE(!graph.has_edge(n2, n2));
+    REQUIRE(graph.has_edge(n1, n2));
+    REQUIRE(graph.get_edge_count() == 1);
+
+    batch.create_edge(graph.flip(n2), graph.flip(n2));
+    batch.create_edge(n2, n2);
+    batch.apply();
+    REQUIRE(graph.has_edge(n2, n2));
+    REQUIRE(graph.get_edge_count() == 2);
+
+    batch.destroy_handle(n2);
+    batch.apply();
+    REQUIRE(graph.get_node_count() == 1);
+    REQUIRE(graph.get_edge_count() == 0);
+    REQUIRE(graph.get_degree(n1, false) == 0);
+}
+
+}
+}
@@ -0,0 +1,165 @@
+/**
+ * \file
+ * unittest/flat_graph.cpp: test cases for the flat, memory-mappable graph layout.
+ */
+
+#include "catch.hpp"
+
+#include <handlegraph/util.hpp>
+#include "odgi.hpp"
+#include "flat_graph.hpp"
+#include "algorithms/temp_file.hpp"
+
+#include <fstream>
+#include <vector>
+#include <algorithm>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+TEST_CASE("Flat graphs mirror the graph they were built from", "[flat_graph]") {
+
+    graph_t graph;
+    handle_t n1 = graph.create_handle("CAA");
+    handle_t n2 = graph.create_handle("A");
+    handle_t n3 = graph.create_handle("G");
+    handle_t n4 = graph.create_handle("T");
+    handle_t n5 = graph.create_handle("GAT");
+    graph.create_edge(n1, n2);
+    graph.create_edge(n1, n3);
+    graph.create_edge(n2, n4);
+    graph.create_edge(n3, graph.flip(n4));
+    graph.create_edge(n4, n5);
+    // leave a hole in the node ranks
+    handle_t n6 = graph.create_handle("C");
+    graph.create_edge(n5, n6);
+    graph.destroy_handle(n6);
+
+    path_handle_t p1 = graph.create_path_handle("p1");
+    graph.append_step(p1, n1);
+    graph.append_step(p1, n2);
+    graph.append_step(p1, n4);
+    graph.append_step(p1, n5);
+    path_handle_t p2 = graph.create_path_handle("p2", true);
+    graph.append_step(p2, n1);
+    graph.append_step(p2, n3);
+    graph.append_step(p2, graph.flip(n4));
+    graph.create_path_handle("p3");
+
+    auto require_mirrors_graph = [&](const flat_graph_t& flat) {
+        // nodes and sequences
+        REQUIRE(flat.get_node_count() == graph.get_node_count());
+        REQUIRE(flat.min_node_id() == graph.min_node_id());
+        REQUIRE(flat.max_node_id() == graph.max_node_id());
+        REQUIRE(!flat.has_node(graph.get_id(n6)));
+        graph.for_each_handle([&](const handle_t& h) {
+            const nid_t id = graph.get_id(h);
+            REQUIRE(flat.has_node(id));
+            REQUIRE(flat.get_sequence(flat.get_handle(id)) == graph.get_sequence(h));
+            REQUIRE(flat.get_sequence(flat.get_handle(id, true)) == graph.get_sequence(graph.flip(h)));
+        });
+
+        // edges on both strands
+        REQUIRE(flat.get_edge_count() == graph.get_edge_count());
+        graph.for_each_handle([&](const handle_t& h) {
+            for (bool is_rev : {false, true}) {
+                for (bool go_left : {false, true}) {
+                    const handle_t g = is_rev ? graph.flip(h) : h;
+                    const handle_t f = flat.get_handle(graph.get_id(h), is_rev);
+                    vector<nid_t> from_graph, from_flat;
+                    graph.follow_edges(g, go_left, [&](const handle_t& o) {
+                        from_graph.push_back(graph.get_id(o) * (graph.get_is_reverse(o) ? -1 : 1));
+                    });
+                    flat.follow_edges(f, go_left, [&](const handle_t& o) {
+                        from_flat.push_back(flat.get_id(o) * (flat.get_is_reverse(o) ? -1 : 1));
+                    });
+                    std::sort(from_graph.begin(), from_graph.end());
+                    std::sort(from_flat.begin(), from_flat.end());
+                    REQUIRE(from_graph == from_flat);
+                    REQUIRE(flat.get_degree(f, go_left) == from_flat.size());
+                }
+            }
+        });
+
+        // paths and steps
+        REQUIRE(flat.get_path_count() == 3);
+        REQUIRE(flat.has_path("p2"));
+        REQUIRE(!flat.has_path("p4"));
+        REQUIRE(flat.get_is_circular(flat.get_path_handle("p2")));
+        REQUIRE(!flat.get_is_circular(flat.get_path_handle("p1")));
+        REQUIRE(flat.get_step_count(flat.get_path_handle("p3")) == 0);
+        REQUIRE(flat.path_begin(flat.get_path_handle("p3")) == flat.path_end(flat.get_path_handle("p3")));
+        for (auto& name : {"p1", "p2"}) {
+            const path_handle_t gp = graph.get_path_handle(name);
+            const path_handle_t fp = flat.get_path_handle(name);
+            REQUIRE(flat.get_path_name(fp) == name);
+            REQUIRE(flat.get_step_count(fp) == graph.get_step_count(gp));
+            vector<handle_t> from_graph, from_flat;
+            graph.for_each_step_in_path(gp, [&](const step_handle_t& s) {
+                from_graph.push_back(graph.get_handle_of_step(s));
+            });
+            flat.for_each_step_in_path(fp, [&](const step_handle_t& s) {
+                from_flat.push_back(flat.get_handle_of_step(s));
+            });
+            REQUIRE(from_graph == from_flat);
+            // walk backwards from the last step
+            vector<handle_t> backwards;
+            step_handle_t s = flat.path_back(fp);
+            backwards.push_back(flat.get_handle_of_step(s));
+            while (s != flat.path_begin(fp)) {
+                s = flat.get_previous_step(s);
+                backwards.push_back(flat.get_handle_of_step(s));
+            }
+            std::reverse(backwards.begin(), backwards.end());
+            REQUIRE(backwards == from_flat);
+        }
+        REQUIRE(flat.get_next_step(flat.path_back(flat.get_path_handle("p2"))) == flat.path_begin(flat.get_path_handle("p2")));
+        REQUIRE(!flat.has_next_step(flat.path_back(flat.get_path_handle("p1"))));
+
+        // steps on handles
+        graph.for_each_handle([&](const handle_t& h) {
+            const handle_t f = flat.get_handle(graph.get_id(h));
+            REQUIRE(flat.get_step_count(f) == graph.get_step_count(h));
+            vector<std::string> from_flat;
+            flat.for_each_step_on_handle(f, [&](const step_handle_t& s) {
+                REQUIRE(flat.get_id(flat.get_handle_of_step(s)) == graph.get_id(h));
+                from_flat.push_back(flat.get_path_name(flat.get_path_handle_of_step(s)));
+            });
+            vector<std::string> from_graph;
+            graph.for_each_step_on_handle(h, [&](const step_handle_t& s) {
+                from_graph.push_back(graph.get_path_name(graph.get_path_handle_of_step(s)));
+            });
+            std::sort(from_graph.begin(), from_graph.end());
+            std::sort(from_flat.begin(), from_flat.end());
+            REQUIRE(from_graph == from_flat);
+        });
+    };
+
+    SECTION("A graph frozen in memory mirrors the graph") {
+        flat_graph_t flat;
+        flat.from_graph(graph);
+        require_mirrors_graph(flat);
+    }
+
+    SECTION("A memory-mapped flat graph file mirrors the graph") {
+        std::string filename = algorithms::temp_file::create() + "unittest_flat_graph.og";
+        {
+            flat_graph_t frozen;
+            frozen.from_graph(graph);
+            std::ofstream out(filename.c_str(), std::ios::binary);
+            frozen.serialize(out);
+        }
+        REQUIRE(flat_graph_t::is_flat_graph(filename));
+        flat_graph_t flat;
+        flat.load(filename);
+        require_mirrors_graph(flat);
+        flat.clear();
+        algorithms::temp_file::remove(filename);
+    }
+}
+
+}
+}
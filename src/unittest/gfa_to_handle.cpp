@@ -0,0 +1,62 @@
+/**
+ * \file
+ * unittest/gfa_to_handle.cpp: test cases for reading GFA files in parallel.
+ */
+
+#include "catch.hpp"
+
+#include "odgi.hpp"
+#include "gfa_to_handle.hpp"
+#include "algorithms/temp_file.hpp"
+#include "random_graph.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+TEST_CASE("Reading a GFA file builds the same graph with any number of threads", "[gfa_to_handle]") {
+    graph_t source;
+    random_graph_params_t params;
+    params.seed = 29;
+    params.node_count = 2000;
+    params.edge_count = 8000;
+    params.self_edges = true;
+    params.path_count = 8;
+    params.steps_per_path = 300;
+    build_random_graph(source, params);
+    // a hub that many L-lines in different chunks share
+    source.for_each_handle([&](const handle_t& handle) {
+        if (source.get_id(handle) % 3 == 0) {
+            source.create_edge(source.get_handle(1), handle);
+        }
+    });
+
+    std::string filename = algorithms::temp_file::create() + "unittest_gfa_to_handle.gfa";
+    {
+        std::ofstream out(filename.c_str());
+        source.to_gfa(out);
+    }
+    std::vector<std::string> serialized;
+    for (const uint64_t num_threads : {1, 4, 8}) {
+        graph_t graph;
+        gfa_to_handle(filename, &graph, false, num_threads, false);
+        REQUIRE(graph.get_edge_count() == source.get_edge_count());
+        REQUIRE(describe(graph) == describe(source));
+        std::stringstream out;
+        graph.serialize(out);
+        serialized.push_back(out.str());
+    }
+    algorithms::temp_file::remove(filename);
+    REQUIRE(serialized[0] == serialized[1]);
+    REQUIRE(serialized[0] == serialized[2]);
+}
+
+}
+}
@@ -0,0 +1,160 @@
+#include "catch.hpp"
+
+#include <handlegraph/handle_graph.hpp>
+#include <handlegraph/util.hpp>
+#include "odgi.hpp"
+#include "algorithms/xp.hpp"
+#include "algorithms/path_sgd_layout.hpp"
+#include "algorithms/path_sgd_layout_flat.hpp"
+#include "algorithms/sgd_term_batch.hpp"
+#include "algorithms/sgd_checkpoint.hpp"
+#include "algorithms/temp_file.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <vector>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+TEST_CASE("Vectorized PG-SGD term updates agree with the scalar ones", "[layout]") {
+    // 37 terms, so that each kernel also leaves a tail to the scalar code
+    const uint64_t n = 37;
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> coordinate(-100, 100);
+    std::uniform_int_distribution<uint64_t> distance(1, 200);
+    std::vector<double> d(n), dx(n), dy(n);
+    for (uint64_t k = 0; k < n; ++k) {
+        d[k] = distance(rng);
+        dx[k] = k % 5 == 0 ? 0 : coordinate(rng);
+        dy[k] = coordinate(rng);
+    }
+    const auto kernels = algorithms::supported_sgd_term_batch_kernels();
+    REQUIRE(kernels.front().name == "scalar");
+    std::vector<double> scalar_r_x_1d(n), scalar_r_x(n), scalar_r_y(n);
+    const double scalar_Delta_max_1d = kernels.front().update_1d(n, 30, d.data(), dx.data(), scalar_r_x_1d.data());
+    const double scalar_Delta_max_2d = kernels.front().update_2d(n, 30, d.data(), dx.data(), dy.data(),
+                                                                 scalar_r_x.data(), scalar_r_y.data());
+    for (auto &kernel : kernels) {
+        std::vector<double> r_x_1d(n), r_x(n), r_y(n);
+        REQUIRE(kernel.update_1d(n, 30, d.data(), dx.data(), r_x_1d.data()) == Approx(scalar_Delta_max_1d));
+        REQUIRE(kernel.update_2d(n, 30, d.data(), dx.data(), dy.data(), r_x.data(), r_y.data())
+                == Approx(scalar_Delta_max_2d));
+        for (uint64_t k = 0; k < n; ++k) {
+            REQUIRE(r_x_1d[k] == Approx(scalar_r_x_1d[k]));
+            REQUIRE(r_x[k] == Approx(scalar_r_x[k]));
+            REQUIRE(r_y[k] == Approx(scalar_r_y[k]));
+        }
+    }
+}
+
+TEST_CASE("Path guided 2D SGD layout of a linear graph", "[layout]") {
+    // 20 nodes of 10 bp in a chain, walked forward by one path and backward by another
+    graph_t graph;
+    std::vector<handle_t> handles;
+    for (uint64_t i = 0; i < 20; ++i) {
+        handles.push_back(graph.create_handle("ACGTACGTAC"));
+        if (i > 0) {
+            graph.create_edge(handles[i - 1], handles[i]);
+        }
+    }
+    path_handle_t forward = graph.create_path_handle("forward");
+    path_handle_t backward = graph.create_path_handle("backward");
+    for (uint64_t i = 0; i < 20; ++i) {
+        graph.append_step(forward, handles[i]);
+        graph.append_step(backward, graph.flip(handles[19 - i]));
+    }
+    xp::XP path_index;
+    path_index.from_handle_graph(graph, 1);
+    const std::vector<path_handle_t> paths = {forward, backward};
+
+    std::vector<std::atomic<double>> X(graph.get_node_count() * 2);
+    std::vector<std::atomic<double>> Y(graph.get_node_count() * 2);
+    std::mt19937 rng(42);
+    std::normal_distribution<double> gaussian_noise(0, sqrt(graph.get_node_count() * 2));
+    for (uint64_t i = 0; i < X.size(); ++i) {
+        X[i].store(gaussian_noise(rng));
+        Y[i].store(gaussian_noise(rng));
+    }
+
+    SECTION("The flat arrays hold the steps of the paths") {
+        algorithms::flat_sgd::layout_data_t data;
+        algorithms::flat_sgd::build_layout_data(data, graph, path_index, paths, X, Y, 2);
+        REQUIRE(data.nodes.size() == 20);
+        REQUIRE(data.paths.size() == 2);
+        REQUIRE(data.steps.size() == 40);
+        REQUIRE(data.paths[1].first_step == 20);
+        REQUIRE(data.nodes[3].seq_length == 10);
+        REQUIRE(data.steps[3].node_id == 3);
+        REQUIRE(data.steps[3].pos == 31);
+        REQUIRE(data.steps[20].node_id == 19);
+        REQUIRE(data.steps[20].pos == -1);
+        REQUIRE(data.steps[20].pidx == 1);
+        REQUIRE(data.nodes[5].coords[2].load() == (float) X[11].load());
+    }
+
+    SECTION("Both engines lay out the chain by its path distances") {
+        for (const bool flat : {false, true}) {
+            std::vector<std::atomic<double>> X_layout(X.size());
+            std::vector<std::atomic<double>> Y_layout(Y.size());
+            for (uint64_t i = 0; i < X.size(); ++i) {
+                X_layout[i].store(X[i].load());
+                Y_layout[i].store(Y[i].load());
+            }
+            auto *const engine = flat
+                ? algorithms::path_linear_sgd_layout_flat
+                : algorithms::path_linear_sgd_layout;
+            engine(graph, path_index, paths, 30, 0, 400, 0, 0.01, 400, 0.99, 20, 1000, 100, 0.5, 1,
+                   false, false, "", X_layout, Y_layout, algorithms::sgd_checkpointing_t());
+            // the start of the first node and the end of the last one are 200 bp apart
+            const double dx = X_layout[0].load() - X_layout[39].load();
+            const double dy = Y_layout[0].load() - Y_layout[39].load();
+            REQUIRE(std::abs(std::sqrt(dx * dx + dy * dy) - 200) < 20);
+        }
+    }
+
+    SECTION("A flat layout resumed from a checkpoint ends like the uninterrupted one") {
+        auto run = [&](const algorithms::sgd_checkpointing_t &checkpointing, std::vector<double> &X_out) {
+            std::vector<std::atomic<double>> X_layout(X.size());
+            std::vector<std::atomic<double>> Y_layout(Y.size());
+            for (uint64_t i = 0; i < X.size(); ++i) {
+                X_layout[i].store(X[i].load());
+                Y_layout[i].store(Y[i].load());
+            }
+            algorithms::path_linear_sgd_layout_flat(graph, path_index, paths, 30, 0, 400, 0, 0.01, 400, 0.99, 20,
+                                                    1000, 100, 0.5, 1, false, false, "", X_layout, Y_layout,
+                                                    checkpointing);
+            for (uint64_t i = 0; i < X.size(); ++i) {
+                X_out.push_back(X_layout[i].load());
+                X_out.push_back(Y_layout[i].load());
+            }
+        };
+        std::vector<double> uninterrupted, checkpointed, resumed;
+        run(algorithms::sgd_checkpointing_t(), uninterrupted);
+
+        algorithms::sgd_checkpointing_t checkpointing;
+        checkpointing.file = xp::temp_file::create("checkpoint");
+        checkpointing.every = 12;
+        run(checkpointing, checkpointed);
+        REQUIRE(checkpointed == uninterrupted);
+
+        algorithms::sgd_checkpoint_t checkpoint;
+        std::ifstream checkpoint_in(checkpointing.file, std::ios::binary);
+        REQUIRE(checkpoint.load(checkpoint_in));
+        REQUIRE(checkpoint.engine == "path_linear_sgd_layout_flat");
+        REQUIRE(checkpoint.iteration == 24);
+        REQUIRE(checkpoint.rng_states.size() == 1);
+        algorithms::sgd_checkpointing_t resume;
+        resume.resume = &checkpoint;
+        run(resume, resumed);
+        REQUIRE(resumed == uninterrupted);
+        xp::temp_file::remove(checkpointing.file);
+    }
+}
+
+}
+}
@@ -0,0 +1,150 @@
+/**
+ * \file
+ * unittest/node_records.cpp: test cases and microbenchmarks for the edge and path step records of nodes.
+ */
+
+#include "catch.hpp"
+
+#include "odgi.hpp"
+#include "node.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+#ifdef ODGI_FIXED_WIDTH_NODES
+static const std::string node_record_layout = "fixed";
+#else
+static const std::string node_record_layout = "packed";
+#endif
+
+TEST_CASE("Node records encode many neighbours consistently", "[node_records]") {
+    node_t node;
+    node.set_id(5000);
+    std::vector<uint64_t> others;
+    for (uint64_t i = 1; i <= 1000; ++i) {
+        others.push_back(i * 7 % 9973 + 1);
+    }
+    std::mt19937_64 rng(7);
+    std::shuffle(others.begin(), others.end(), rng);
+    std::vector<uint64_t> codes;
+    for (auto& other : others) {
+        codes.push_back(node.encode(other));
+    }
+    // the codes are dense, stable and decode to the ids they were made from
+    std::shuffle(others.begin(), others.end(), rng);
+    for (auto& other : others) {
+        const uint64_t code = node.encode(other);
+        REQUIRE(code < others.size());
+        REQUIRE(node.decode(code) == other);
+    }
+    REQUIRE(node.encode(20000) == others.size());
+}
+
+TEST_CASE("Node records survive serialization and reordering", "[node_records]") {
+    graph_t graph;
+    std::vector<handle_t> handles;
+    for (uint64_t i = 0; i < 100; ++i) {
+        handles.push_back(graph.create_handle("ACGT"));
+    }
+    const handle_t hub = handles[50];
+    for (uint64_t i = 0; i < handles.size(); ++i) {
+        graph.create_edge(hub, i % 2 ? graph.flip(handles[i]) : handles[i]);
+    }
+    const path_handle_t path = graph.create_path_handle("hub");
+    for (uint64_t i = 0; i < handles.size(); ++i) {
+        graph.append_step(path, hub);
+        graph.append_step(path, handles[(i * 31) % handles.size()]);
+    }
+
+    std::stringstream ss;
+    graph.serialize(ss);
+    graph_t loaded;
+    loaded.deserialize(ss);
+    REQUIRE(loaded.get_degree(loaded.get_handle(graph.get_id(hub)), false) == graph.get_degree(hub, false));
+    REQUIRE(loaded.get_step_count(loaded.get_handle(graph.get_id(hub))) == graph.get_step_count(hub));
+
+    // reversing the order renumbers every neighbour of the hub
+    std::vector<handle_t> order(handles.rbegin(), handles.rend());
+    graph.apply_ordering(order, true);
+    const path_handle_t reordered = graph.get_path_handle("hub");
+    std::vector<nid_t> walk;
+    graph.for_each_step_in_path(reordered, [&](const step_handle_t& step) {
+        walk.push_back(graph.get_id(graph.get_handle_of_step(step)));
+    });
+    REQUIRE(walk.size() == 2 * handles.size());
+    for (uint64_t i = 0; i < handles.size(); ++i) {
+        REQUIRE(walk[2 * i] == (nid_t)(handles.size() - 50));
+        REQUIRE(walk[2 * i + 1] == (nid_t)(handles.size() - (i * 31) % handles.size()));
+    }
+    REQUIRE(graph.get_degree(graph.get_handle(handles.size() - 50), false) == handles.size());
+}
+
+/// Time edge iteration, step lookup and path appends on a hub node, for comparing the packed and
+/// the fixed-width node records: odgi test "[node_records_bench]" on a build of each layout.
+TEST_CASE("Node record microbenchmarks", "[.][node_records_bench]") {
+    const uint64_t neighbours = 5000;
+    const uint64_t passes = 20;
+    graph_t graph;
+    const handle_t hub = graph.create_handle("ACGTACGT");
+    std::vector<handle_t> handles;
+    for (uint64_t i = 0; i < neighbours; ++i) {
+        handles.push_back(graph.create_handle("ACGT"));
+        graph.create_edge(hub, handles.back());
+        graph.create_edge(handles.back(), hub);
+    }
+
+    auto seconds_since = [](const std::chrono::steady_clock::time_point& start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // append: every path crosses the hub between two of its neighbours
+    auto start = std::chrono::steady_clock::now();
+    std::vector<path_handle_t> paths;
+    for (uint64_t p = 0; p < 100; ++p) {
+        paths.push_back(graph.create_path_handle("path" + std::to_string(p)));
+        for (uint64_t i = 0; i < 200; ++i) {
+            graph.append_step(paths.back(), handles[(p * 200 + i) % neighbours]);
+            graph.append_step(paths.back(), hub);
+        }
+    }
+    const double append_seconds = seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    uint64_t edges_seen = 0;
+    for (uint64_t i = 0; i < passes; ++i) {
+        for (const bool go_left : {false, true}) {
+            graph.follow_edges(hub, go_left, [&](const handle_t& next) {
+                edges_seen += graph.get_id(next) & 1;
+            });
+        }
+    }
+    const double edge_seconds = seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    uint64_t steps_seen = 0;
+    for (uint64_t i = 0; i < passes; ++i) {
+        graph.for_each_step_on_handle(hub, [&](const step_handle_t& step) {
+            steps_seen += graph.get_id(graph.get_handle_of_step(graph.get_next_step(step))) & 1;
+        });
+    }
+    const double step_seconds = seconds_since(start);
+
+    std::cout << "layout\toperation\tseconds" << std::endl
+              << node_record_layout << "\tappend\t" << append_seconds << std::endl
+              << node_record_layout << "\tedge_iteration\t" << edge_seconds << std::endl
+              << node_record_layout << "\tstep_lookup\t" << step_seconds << std::endl;
+    REQUIRE(edges_seen + steps_seen > 0);
+}
+
+}
+}
@@ -0,0 +1,55 @@
+/**
+ * \file
+ * unittest/ordered_output.cpp: test cases for writing the output of parallel tasks in order.
+ */
+
+#include "catch.hpp"
+
+#include "ordered_output.hpp"
+
+#include <omp.h>
+#include <sstream>
+#include <string>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+
+TEST_CASE("Parallel tasks are written in sequence order", "[ordered_output]") {
+
+    const uint64_t task_count = 10000;
+    std::string expected;
+    for (uint64_t i = 0; i < task_count; ++i) {
+        if (i % 7 != 0) {
+            expected += std::to_string(i) + "\n";
+        }
+    }
+
+    SECTION("with a ring larger than the task count") {
+        std::stringstream out;
+        {
+            ordered_output_t output(out, 1 << 14);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(4)
+            for (uint64_t i = 0; i < task_count; ++i) {
+                // some tasks have nothing to say
+                output.write(i, i % 7 == 0 ? std::string() : std::to_string(i) + "\n");
+            }
+        }
+        REQUIRE(out.str() == expected);
+    }
+
+    SECTION("with a ring much smaller than the task count") {
+        std::stringstream out;
+        ordered_output_t output(out, 4);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(4)
+        for (uint64_t i = 0; i < task_count; ++i) {
+            output.write(i, i % 7 == 0 ? std::string() : std::to_string(i) + "\n");
+        }
+        output.finish();
+        REQUIRE(out.str() == expected);
+    }
+}
+
+}
+}
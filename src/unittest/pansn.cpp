@@ -0,0 +1,93 @@
+/**
+ * \file
+ * unittest/pansn.cpp: test cases for reading GFA walks and indexing PanSN path names.
+ */
+
+#include "catch.hpp"
+
+#include "odgi.hpp"
+#include "gfa_to_handle.hpp"
+#include "pansn.hpp"
+#include "algorithms/temp_file.hpp"
+
+#include <fstream>
+#include <vector>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+TEST_CASE("GFA walks are read into PanSN-named paths", "[pansn]") {
+
+    std::string filename = algorithms::temp_file::create() + "unittest_pansn.gfa";
+    {
+        std::ofstream out(filename.c_str());
+        out << "H\tVN:Z:1.1\n"
+            << "S\t1\tCAA\n"
+            << "S\t2\tA\n"
+            << "S\t3\tG\n"
+            << "S\t4\tT\n"
+            << "L\t1\t+\t2\t+\t0M\n"
+            << "L\t1\t+\t3\t+\t0M\n"
+            << "L\t2\t+\t4\t+\t0M\n"
+            << "L\t3\t+\t4\t-\t0M\n"
+            << "P\tref\t1+,2+,4+\t*\n"
+            << "W\tHG1\t1\tchr1\t0\t5\t>1>3<4\n"
+            << "W\tHG1\t2\tchr1\t*\t*\t>1>2>4\n"
+            << "W\tHG2\t1\tchr1\t10\t15\t<4<2<1\n";
+    }
+    graph_t graph;
+    gfa_to_handle(filename, &graph, false, 2, false);
+    algorithms::temp_file::remove(filename);
+
+    auto steps_of = [&](const std::string& name) {
+        std::vector<handle_t> steps;
+        graph.for_each_step_in_path(graph.get_path_handle(name), [&](const step_handle_t& s) {
+            steps.push_back(graph.get_handle_of_step(s));
+        });
+        return steps;
+    };
+
+    SECTION("Walks are named and stepped like the equivalent P-lines") {
+        REQUIRE(graph.get_path_count() == 4);
+        REQUIRE(graph.has_path("HG1#1#chr1:0-5"));
+        REQUIRE(graph.has_path("HG1#2#chr1"));
+        REQUIRE(graph.has_path("HG2#1#chr1:10-15"));
+        REQUIRE(steps_of("HG1#1#chr1:0-5") == std::vector<handle_t>(
+            {graph.get_handle(1), graph.get_handle(3), graph.get_handle(4, true)}));
+        REQUIRE(steps_of("HG2#1#chr1:10-15") == std::vector<handle_t>(
+            {graph.get_handle(4, true), graph.get_handle(2, true), graph.get_handle(1, true)}));
+        REQUIRE(steps_of("ref") == std::vector<handle_t>(
+            {graph.get_handle(1), graph.get_handle(2), graph.get_handle(4)}));
+        // paths are ranked in file order
+        std::vector<std::string> names;
+        graph.for_each_path_handle([&](const path_handle_t& p) {
+            names.push_back(graph.get_path_name(p));
+        });
+        REQUIRE(names == std::vector<std::string>({"ref", "HG1#1#chr1:0-5", "HG1#2#chr1", "HG2#1#chr1:10-15"}));
+    }
+
+    SECTION("The PanSN index groups paths by sample and haplotype") {
+        pansn_index_t pansn(graph, 2);
+        REQUIRE(pansn.sample_count() == 3);
+        REQUIRE(pansn.haplotype_count() == 4);
+        const path_handle_t hg1_1 = graph.get_path_handle("HG1#1#chr1:0-5");
+        const path_handle_t hg1_2 = graph.get_path_handle("HG1#2#chr1");
+        const path_handle_t hg2_1 = graph.get_path_handle("HG2#1#chr1:10-15");
+        const path_handle_t ref = graph.get_path_handle("ref");
+        REQUIRE(pansn.sample_of(hg1_1) == pansn.sample_of(hg1_2));
+        REQUIRE(pansn.sample_of(hg1_1) != pansn.sample_of(hg2_1));
+        REQUIRE(pansn.haplotype_of(hg1_1) != pansn.haplotype_of(hg1_2));
+        REQUIRE(pansn.sample_name(pansn.sample_of(hg2_1)) == "HG2");
+        REQUIRE(pansn.haplotype_name(pansn.haplotype_of(hg1_2)) == "HG1#2");
+        REQUIRE(pansn.sample_name(pansn.sample_of(ref)) == "ref");
+        REQUIRE(pansn.haplotype_name(pansn.haplotype_of(ref)) == "ref");
+        REQUIRE(pansn.contig_of(hg1_1) == "chr1:0-5");
+        REQUIRE(pansn.contig_of(ref) == "ref");
+    }
+}
+
+}
+}
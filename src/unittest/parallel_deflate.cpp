@@ -0,0 +1,101 @@
+/**
+ * \file
+ * unittest/parallel_deflate.cpp: test cases for the parallel zlib compression of PNG images.
+ */
+
+#include "catch.hpp"
+
+#include "algorithms/parallel_deflate.hpp"
+#include "lodepng.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+
+/// Compress the bytes and inflate them again with the zlib decoder of lodepng, which also checks the Adler-32
+static std::vector<uint8_t> round_trip(const std::vector<uint8_t>& bytes, const uint64_t& num_threads,
+                                       const size_t& chunk_size) {
+    const std::vector<uint8_t> compressed =
+            algorithms::parallel_zlib_compress(bytes.data(), bytes.size(), num_threads, chunk_size);
+    std::vector<unsigned char> inflated;
+    REQUIRE(lodepng::decompress(inflated, compressed.data(), compressed.size()) == 0);
+    return std::vector<uint8_t>(inflated.begin(), inflated.end());
+}
+
+TEST_CASE("Adler-32 checksums of byte ranges combine into the checksum of their concatenation", "[parallel_deflate]") {
+    const std::string text = "Wikipedia";
+    const uint8_t* bytes = (const uint8_t*)text.data();
+    REQUIRE(algorithms::adler32(bytes, text.size()) == 0x11E60398);
+    for (size_t split = 0; split <= text.size(); ++split) {
+        const uint32_t left = algorithms::adler32(bytes, split);
+        const uint32_t right = algorithms::adler32(bytes + split, text.size() - split);
+        REQUIRE(algorithms::adler32_combine(left, right, text.size() - split) == 0x11E60398);
+    }
+}
+
+TEST_CASE("The zlib stream does not depend on the number of threads", "[parallel_deflate]") {
+    // rows of a striped image, so that the chunks find matches both within and before themselves
+    std::vector<uint8_t> image(200000);
+    for (size_t i = 0; i < image.size(); ++i) {
+        image[i] = (i / 4000) % 3 == 0 ? 0 : (uint8_t)(i % 97);
+    }
+    const std::vector<uint8_t> serial = algorithms::parallel_zlib_compress(image.data(), image.size(), 1, 1 << 15);
+    const std::vector<uint8_t> parallel = algorithms::parallel_zlib_compress(image.data(), image.size(), 4, 1 << 15);
+    REQUIRE(serial == parallel);
+    REQUIRE(serial.size() < image.size() / 4);
+
+    // the zlib header, and the Adler-32 of the image at the end in big-endian order
+    REQUIRE(serial[0] == 0x78);
+    REQUIRE(serial[1] == 0x9C);
+    const uint32_t adler = algorithms::adler32(image.data(), image.size());
+    const size_t n = serial.size();
+    REQUIRE((((uint32_t)serial[n - 4] << 24) | ((uint32_t)serial[n - 3] << 16)
+             | ((uint32_t)serial[n - 2] << 8) | (uint32_t)serial[n - 1]) == adler);
+}
+
+TEST_CASE("The zlib stream inflates back to its input", "[parallel_deflate]") {
+    std::mt19937_64 rng(11);
+    SECTION("empty") {
+        const std::vector<uint8_t> bytes;
+        REQUIRE(round_trip(bytes, 1, 1 << 15) == bytes);
+        REQUIRE(round_trip(bytes, 4, 1 << 15) == bytes);
+    }
+    SECTION("incompressible") {
+        std::vector<uint8_t> bytes(100000);
+        for (auto& b : bytes) {
+            b = (uint8_t)rng();
+        }
+        REQUIRE(round_trip(bytes, 1, 1 << 15) == bytes);
+        REQUIRE(round_trip(bytes, 4, 1 << 15) == bytes);
+    }
+    SECTION("long runs") {
+        // runs far longer than the longest match, some crossing the chunk boundaries
+        std::vector<uint8_t> bytes;
+        for (uint64_t i = 0; i < 40; ++i) {
+            bytes.insert(bytes.end(), 1 + rng() % 20000, (uint8_t)(i % 3 ? 0 : 255));
+        }
+        REQUIRE(round_trip(bytes, 1, 1 << 15) == bytes);
+        REQUIRE(round_trip(bytes, 4, 1 << 15) == bytes);
+    }
+    SECTION("multi-block") {
+        // many chunks, smaller than the window, each one block that refers back into the ones before
+        std::vector<uint8_t> bytes(300000);
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            bytes[i] = rng() % 8 == 0 ? (uint8_t)rng() : (uint8_t)(i % 251);
+        }
+        REQUIRE(round_trip(bytes, 1, 1 << 12) == bytes);
+        REQUIRE(round_trip(bytes, 4, 1 << 12) == bytes);
+        REQUIRE(round_trip(bytes, 4, 1 << 16) == bytes);
+        // a last chunk of a single byte
+        bytes.resize(3 * (1 << 12) + 1);
+        REQUIRE(round_trip(bytes, 4, 1 << 12) == bytes);
+    }
+}
+
+}
+}
@@ -9,6 +9,8 @@
 #include "odgi.hpp"
 #include "algorithms/xp.hpp"
 #include <sdsl/bit_vectors.hpp>
+#include <sstream>
+#include <algorithm>
 
 namespace odgi {
     namespace unittest {
@@ -70,6 +72,19 @@ namespace odgi {
             // graph.destroy_handle(n2); // this leads to a 'exit(1)' as we don't create an index of an optimized graph anymore
             path_index.from_handle_graph(graph, 1);
 
+            SECTION("The in-memory and the disk-backed builders agree") {
+                XP external_path_index;
+                external_path_index.from_handle_graph(graph, 1, true);
+                XP parallel_path_index;
+                parallel_path_index.from_handle_graph(graph, 4);
+                std::stringstream in_memory_out, external_out, parallel_out;
+                path_index.serialize_members(in_memory_out);
+                external_path_index.serialize_members(external_out);
+                parallel_path_index.serialize_members(parallel_out);
+                REQUIRE(in_memory_out.str() == external_out.str());
+                REQUIRE(parallel_out.str() == external_out.str());
+            }
+
             SECTION("The index mirrors the actual graph") {
                 REQUIRE(path_index.path_count == graph.get_path_count());
                 REQUIRE(path_index.has_path("5"));
@@ -305,6 +320,118 @@ namespace odgi {
                 // REQUIRE(loaded_path_index.get_pangenome_pos("5", 24) == 0);
                 // REQUIRE(loaded_path_index.get_pangenome_pos("4", 1) == 0);
             }
+
+            SECTION("Lifting pangenome positions back to path positions") {
+                REQUIRE(loaded_path_index.get_pangenome_length() == 14);
+                size_t offset = 0;
+                REQUIRE(loaded_path_index.get_handle_at_pangenome_pos(0, offset) == number_bool_packing::pack(0, false));
+                REQUIRE(offset == 0);
+                REQUIRE(loaded_path_index.get_handle_at_pangenome_pos(6, offset) == number_bool_packing::pack(2, false));
+                REQUIRE(offset == 1);
+                REQUIRE(loaded_path_index.get_handle_at_pangenome_pos(13, offset) == number_bool_packing::pack(3, false));
+                REQUIRE(offset == 6);
+                // the second node is on no path
+                uint64_t hits = 0;
+                loaded_path_index.for_each_path_pos_at_pangenome_pos(4, [&](const path_handle_t &p, const size_t &pos) {
+                    ++hits;
+                });
+                REQUIRE(hits == 0);
+                // every path position is found again from its pangenome position
+                for (auto &name : {"5", "5-", "5-m"}) {
+                    const path_handle_t p_h = loaded_path_index.get_path_handle(name);
+                    for (size_t pos = 0; pos < loaded_path_index.get_path_length(p_h); ++pos) {
+                        const size_t pan_pos = loaded_path_index.get_pangenome_pos(name, pos);
+                        REQUIRE(loaded_path_index.get_pangenome_pos(p_h, pos) == pan_pos);
+                        bool found = false;
+                        hits = 0;
+                        loaded_path_index.for_each_path_pos_at_pangenome_pos(pan_pos, [&](const path_handle_t &p, const size_t &q) {
+                            found |= (p == p_h && q == pos);
+                            ++hits;
+                        });
+                        REQUIRE(found);
+                        REQUIRE(hits == 3);
+                    }
+                }
+            }
+
+            SECTION("A memory-mapped flat index answers like the loaded index") {
+                std::string flat_filename = basename + "unittest_pathindex_flat.xp";
+                {
+                    std::ofstream flat_out(flat_filename, std::ios::binary);
+                    loaded_path_index.serialize_flat(flat_out);
+                }
+                REQUIRE(XP::is_flat(flat_filename));
+                REQUIRE(!XP::is_flat(basename + "unittest_pathindex.xp"));
+                XP flat_path_index;
+                flat_path_index.load(flat_filename);
+                REQUIRE(flat_path_index.is_mapped());
+                REQUIRE(flat_path_index.path_count == loaded_path_index.path_count);
+                REQUIRE(!flat_path_index.has_path("4"));
+                REQUIRE(!flat_path_index.has_position("5", 44));
+                REQUIRE(flat_path_index.get_pangenome_length() == loaded_path_index.get_pangenome_length());
+                for (auto &name : {"5", "5-", "5-m"}) {
+                    REQUIRE(flat_path_index.has_path(name));
+                    const path_handle_t p_h = flat_path_index.get_path_handle(name);
+                    REQUIRE(p_h == loaded_path_index.get_path_handle(name));
+                    REQUIRE(flat_path_index.get_path_name(p_h) == name);
+                    REQUIRE(flat_path_index.get_path_length(p_h) == loaded_path_index.get_path_length(p_h));
+                    REQUIRE(flat_path_index.get_path_step_count(p_h) == loaded_path_index.get_path_step_count(p_h));
+                    for (size_t pos = 0; pos < loaded_path_index.get_path_length(p_h); ++pos) {
+                        REQUIRE(flat_path_index.has_position(name, pos));
+                        const step_handle_t step = flat_path_index.get_step_at_position(p_h, pos);
+                        REQUIRE(step == loaded_path_index.get_step_at_position(p_h, pos));
+                        REQUIRE(flat_path_index.get_handle_of_step(step) == loaded_path_index.get_handle_of_step(step));
+                        REQUIRE(flat_path_index.get_position_of_step(step) == loaded_path_index.get_position_of_step(step));
+                        REQUIRE(flat_path_index.get_pangenome_pos(name, pos) == loaded_path_index.get_pangenome_pos(name, pos));
+                    }
+                }
+                for (size_t pan_pos = 0; pan_pos < loaded_path_index.get_pangenome_length(); ++pan_pos) {
+                    std::vector<std::pair<uint64_t, size_t>> from_flat, from_loaded;
+                    flat_path_index.for_each_path_pos_at_pangenome_pos(pan_pos, [&](const path_handle_t &p, const size_t &pos) {
+                        from_flat.push_back(std::make_pair(as_integer(p), pos));
+                    });
+                    loaded_path_index.for_each_path_pos_at_pangenome_pos(pan_pos, [&](const path_handle_t &p, const size_t &pos) {
+                        from_loaded.push_back(std::make_pair(as_integer(p), pos));
+                    });
+                    std::sort(from_flat.begin(), from_flat.end());
+                    std::sort(from_loaded.begin(), from_loaded.end());
+                    REQUIRE(from_flat == from_loaded);
+                }
+                // a flat index can be written again as it is
+                std::stringstream copy;
+                flat_path_index.serialize_flat(copy);
+                std::ifstream flat_in(flat_filename, std::ios::binary);
+                std::stringstream original;
+                original << flat_in.rdbuf();
+                REQUIRE(copy.str() == original.str());
+                flat_path_index.clean();
+                REQUIRE(!flat_path_index.is_mapped());
+                temp_file::remove(flat_filename);
+            }
+
+            SECTION("Paths of an index file are read on first access") {
+                XP lazy_path_index;
+                lazy_path_index.load(basename + "unittest_pathindex.xp");
+                REQUIRE(!lazy_path_index.is_mapped());
+                REQUIRE(lazy_path_index.path_count == 3);
+                REQUIRE(lazy_path_index.loaded_path_count() == 0);
+                REQUIRE(lazy_path_index.has_path("5-"));
+                REQUIRE(lazy_path_index.loaded_path_count() == 0);
+                REQUIRE(lazy_path_index.get_pangenome_pos("5-", 3) == loaded_path_index.get_pangenome_pos("5-", 3));
+                REQUIRE(lazy_path_index.loaded_path_count() == 1);
+                for (auto &name : {"5", "5-", "5-m"}) {
+                    const path_handle_t p_h = lazy_path_index.get_path_handle(name);
+                    for (size_t pos = 0; pos < loaded_path_index.get_path_length(p_h); ++pos) {
+                        REQUIRE(lazy_path_index.get_pangenome_pos(p_h, pos) == loaded_path_index.get_pangenome_pos(p_h, pos));
+                    }
+                }
+                REQUIRE(lazy_path_index.loaded_path_count() == 3);
+                // the index writes back the file it was read from
+                std::stringstream copy, original;
+                lazy_path_index.serialize_members(copy);
+                loaded_path_index.serialize_members(original);
+                REQUIRE(copy.str() == original.str());
+            }
         }
     }
 }
@@ -0,0 +1,102 @@
+/**
+ * \file
+ * unittest/random_graph.hpp: random graphs for checking bulk graph edits against the serial ones.
+ */
+
+#pragma once
+
+#include "odgi.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+/// The shape of a random graph
+struct random_graph_params_t {
+    uint64_t seed = 0;
+    uint64_t node_count = 200;
+    uint64_t max_node_length = 30;
+    uint64_t edge_count = 500;
+    /// let the random edges join a node to itself
+    bool self_edges = false;
+    /// edges from a random side of a node to its other side
+    uint64_t inverting_loops = 0;
+    uint64_t path_count = 10;
+    uint64_t steps_per_path = 50;
+    /// the rank of the circular path, if it is below path_count
+    uint64_t circular_path = std::numeric_limits<uint64_t>::max();
+};
+
+/// Fill the graph with random nodes, edges and paths, a third of them on the reverse strand.
+/// destroy_edge can miss self loops that keep the orientation, and divide_handle misplaces the
+/// loops of a reversed handle, so tests comparing against those leave self_edges off and do not
+/// mix inverting_loops with paths.
+inline void build_random_graph(graph_t& graph, const random_graph_params_t& params) {
+    std::mt19937_64 rng(params.seed);
+    const std::string bases = "ACGT";
+    std::vector<handle_t> handles;
+    for (uint64_t i = 0; i < params.node_count; ++i) {
+        std::string sequence(1 + rng() % params.max_node_length, 'A');
+        for (auto& c : sequence) {
+            c = bases[rng() % 4];
+        }
+        handles.push_back(graph.create_handle(sequence));
+    }
+    auto random_handle = [&](void) {
+        const handle_t h = handles[rng() % handles.size()];
+        return rng() % 3 == 0 ? graph.flip(h) : h;
+    };
+    for (uint64_t i = 0; i < params.edge_count; ++i) {
+        const handle_t from = random_handle();
+        const handle_t to = random_handle();
+        if (params.self_edges || graph.get_id(from) != graph.get_id(to)) {
+            graph.create_edge(from, to);
+        }
+    }
+    for (uint64_t i = 0; i < params.inverting_loops; ++i) {
+        const handle_t h = random_handle();
+        graph.create_edge(h, graph.flip(h));
+    }
+    for (uint64_t p = 0; p < params.path_count; ++p) {
+        const path_handle_t path = graph.create_path_handle("path" + std::to_string(p), p == params.circular_path);
+        for (uint64_t i = 0; i < params.steps_per_path; ++i) {
+            graph.append_step(path, random_handle());
+        }
+    }
+}
+
+/// The nodes, the edges and the paths of the graph, in a form that can be compared
+inline std::vector<std::string> describe(const graph_t& graph) {
+    std::vector<std::string> lines;
+    auto side = [&](const handle_t& h) {
+        return std::to_string(graph.get_id(h)) + (graph.get_is_reverse(h) ? "-" : "+");
+    };
+    graph.for_each_handle([&](const handle_t& handle) {
+        lines.push_back("S " + std::to_string(graph.get_id(handle)) + " " + graph.get_sequence(handle));
+        for (const handle_t& h : {handle, graph.flip(handle)}) {
+            graph.follow_edges(h, false, [&](const handle_t& next) {
+                lines.push_back("L " + side(h) + " " + side(next));
+            });
+        }
+    });
+    std::sort(lines.begin(), lines.end());
+    graph.for_each_path_handle([&](const path_handle_t& path) {
+        std::string line = "P " + graph.get_path_name(path) + (graph.get_is_circular(path) ? " circular" : "");
+        graph.for_each_step_in_path(path, [&](const step_handle_t& step) {
+            line += " " + side(graph.get_handle_of_step(step));
+        });
+        lines.push_back(line);
+    });
+    return lines;
+}
+
+}
+}
@@ -0,0 +1,217 @@
+#include "catch.hpp"
+
+#include <handlegraph/handle_graph.hpp>
+#include <handlegraph/util.hpp>
+#include "odgi.hpp"
+#include "algorithms/path_intersection.hpp"
+#include "algorithms/path_presence.hpp"
+#include "algorithms/path_sketch.hpp"
+#include "algorithms/index_cache.hpp"
+#include "algorithms/temp_file.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+TEST_CASE("Path intersection lengths are the same in dense and sparse matrices", "[similarity]") {
+    // 3 nodes of 1, 2 and 4 bp; path a walks them all, path b the last two, and path c the last one twice
+    graph_t graph;
+    const handle_t n1 = graph.create_handle("A");
+    const handle_t n2 = graph.create_handle("CG");
+    const handle_t n3 = graph.create_handle("TTAA");
+    graph.create_edge(n1, n2);
+    graph.create_edge(n2, n3);
+    graph.create_edge(n3, n3);
+    const path_handle_t a = graph.create_path_handle("a");
+    const path_handle_t b = graph.create_path_handle("b");
+    const path_handle_t c = graph.create_path_handle("c");
+    for (auto& h : {n1, n2, n3}) {
+        graph.append_step(a, h);
+    }
+    graph.append_step(b, n2);
+    graph.append_step(b, n3);
+    graph.append_step(c, n3);
+    graph.append_step(c, n3);
+
+    std::vector<uint32_t> path_ids(4, 0);
+    graph.for_each_path_handle([&](const path_handle_t& p) {
+        path_ids[as_integer(p)] = as_integer(p);
+    });
+    const std::vector<bool> node_mask(graph.get_node_count(), true);
+
+    for (const uint64_t dense_pair_limit : {(uint64_t)10, (uint64_t)0}) {
+        algorithms::path_intersection_matrix_t matrix(4, 3, dense_pair_limit);
+        REQUIRE(matrix.is_dense() == (dense_pair_limit > 0));
+        algorithms::collect_path_intersections(graph, node_mask, path_ids, matrix, false);
+        const uint32_t ia = as_integer(a), ib = as_integer(b), ic = as_integer(c);
+        REQUIRE(matrix.get(ia, ia) == 7);
+        REQUIRE(matrix.get(ib, ib) == 6);
+        REQUIRE(matrix.get(ic, ic) == 8);
+        REQUIRE(matrix.get(ia, ib) == 6);
+        REQUIRE(matrix.get(ib, ia) == 6);
+        REQUIRE(matrix.get(ia, ic) == 4);
+        REQUIRE(matrix.get(ib, ic) == 4);
+        uint64_t pairs = 0;
+        matrix.for_each_pair([&](const uint32_t& id_a, const uint32_t& id_b, const uint64_t& intersection) {
+            REQUIRE(id_a <= id_b);
+            REQUIRE(intersection == matrix.get(id_a, id_b));
+            ++pairs;
+        });
+        REQUIRE(pairs == 6);
+    }
+
+    SECTION("The presence matrix marks the paths on each node and the repeats") {
+        const std::vector<uint64_t> path_columns(path_ids.begin(), path_ids.end());
+        algorithms::path_presence_t presence;
+        presence.build(graph, path_columns, 4, false);
+        const uint64_t ia = as_integer(a), ib = as_integer(b), ic = as_integer(c);
+        REQUIRE(presence.is_present(0, ia));
+        REQUIRE_FALSE(presence.is_present(0, ib));
+        REQUIRE(presence.column_count_on(2) == 3);
+        REQUIRE_FALSE(presence.has_repeats(1));
+        REQUIRE(presence.has_repeats(2));
+        const std::vector<uint64_t> columns = presence.column_rows();
+        REQUIRE(columns[ia] == 7);
+        REQUIRE(columns[ib] == 6);
+        REQUIRE(columns[ic] == 4);
+
+        std::stringstream cached;
+        presence.serialize(cached, 42);
+        algorithms::path_presence_t loaded;
+        REQUIRE_FALSE(loaded.load(cached, 43));
+        cached.seekg(0);
+        REQUIRE(loaded.load(cached, 42));
+        REQUIRE(loaded.column_rows() == columns);
+
+        // matrices with other columns are cached in their own files
+        const std::string graph_file = algorithms::temp_file::create();
+        std::vector<uint64_t> other_columns = path_columns;
+        std::swap(other_columns[ia], other_columns[ib]);
+        algorithms::path_presence_t first, second, reloaded;
+        algorithms::load_or_build_path_presence(first, graph, path_columns, 4, graph_file, false);
+        algorithms::load_or_build_path_presence(second, graph, other_columns, 4, graph_file, false);
+        const std::string first_file = algorithms::index_cache_file(
+                graph_file, "presence", algorithms::path_presence_t::fingerprint(graph, path_columns, 4));
+        const std::string second_file = algorithms::index_cache_file(
+                graph_file, "presence", algorithms::path_presence_t::fingerprint(graph, other_columns, 4));
+        REQUIRE(first_file != second_file);
+        {
+            std::ifstream in(first_file, std::ios::binary);
+            REQUIRE(reloaded.load(in, algorithms::path_presence_t::fingerprint(graph, path_columns, 4)));
+            REQUIRE(reloaded.column_rows() == columns);
+        }
+        REQUIRE(second.column_rows() != columns);
+        algorithms::temp_file::remove(first_file);
+        algorithms::temp_file::remove(second_file);
+        algorithms::temp_file::remove(graph_file);
+
+        // the popcounts cover the nodes without repeats, the pairs the one that c walks twice
+        algorithms::path_intersection_matrix_t matrix(4, 2);
+        algorithms::collect_presence_intersections(graph, presence, {true, true, false}, matrix);
+        algorithms::collect_path_intersections(graph, {false, false, true}, path_ids, matrix, false);
+        REQUIRE(matrix.get(ia, ia) == 7);
+        REQUIRE(matrix.get(ib, ia) == 6);
+        REQUIRE(matrix.get(ic, ic) == 8);
+        REQUIRE(matrix.get(ic, ib) == 4);
+    }
+}
+
+TEST_CASE("Index caches tell apart graphs whose paths are re-routed", "[similarity]") {
+    // the same nodes, and the same number of steps on every node and path, walked differently
+    auto build = [](graph_t& graph, const std::vector<std::pair<nid_t, bool>>& walk) {
+        for (const std::string sequence : {"A", "CG", "TTAA"}) {
+            graph.create_handle(sequence);
+        }
+        const path_handle_t a = graph.create_path_handle("a");
+        const path_handle_t b = graph.create_path_handle("b");
+        for (auto& step : walk) {
+            graph.append_step(a, graph.get_handle(step.first, step.second));
+        }
+        graph.append_step(b, graph.get_handle(2));
+    };
+    graph_t forward, backward, flipped;
+    build(forward, {{1, false}, {2, false}, {3, false}});
+    build(backward, {{3, false}, {2, false}, {1, false}});
+    build(flipped, {{1, false}, {2, true}, {3, false}});
+    const uint64_t fingerprint = algorithms::graph_fingerprint(forward);
+    REQUIRE(fingerprint == algorithms::graph_fingerprint(forward));
+    REQUIRE(fingerprint != algorithms::graph_fingerprint(backward));
+    REQUIRE(fingerprint != algorithms::graph_fingerprint(flipped));
+    // the paths are numbered from 1
+    const std::vector<uint64_t> path_columns = {0, 0, 1};
+    REQUIRE(algorithms::path_presence_t::fingerprint(forward, path_columns, 2)
+            != algorithms::path_presence_t::fingerprint(flipped, path_columns, 2));
+}
+
+TEST_CASE("The presence matrix ranks the nodes by handle on graphs with gaps in their ids", "[similarity]") {
+    graph_t graph;
+    const handle_t n3 = graph.create_handle("A", 3);
+    const handle_t n5 = graph.create_handle("CG", 5);
+    const handle_t n8 = graph.create_handle("TTAA", 8);
+    const path_handle_t a = graph.create_path_handle("a");
+    const path_handle_t b = graph.create_path_handle("b");
+    graph.append_step(a, n3);
+    graph.append_step(a, n8);
+    graph.append_step(b, n8);
+    graph.destroy_handle(n5);
+    std::vector<uint64_t> path_columns(3, algorithms::path_presence_t::no_column);
+    path_columns[as_integer(a)] = 0;
+    path_columns[as_integer(b)] = 1;
+
+    algorithms::path_presence_t presence;
+    presence.build(graph, path_columns, 2, false);
+    const uint64_t r3 = algorithms::path_presence_t::rank_of(n3);
+    const uint64_t r8 = algorithms::path_presence_t::rank_of(n8);
+    REQUIRE(presence.get_node_count() == r8 + 1);
+    REQUIRE(presence.is_present(r3, 0));
+    REQUIRE_FALSE(presence.is_present(r3, 1));
+    REQUIRE(presence.column_count_on(r8) == 2);
+    REQUIRE(presence.column_count_on(algorithms::path_presence_t::rank_of(n5)) == 0);
+}
+
+TEST_CASE("Path sketches estimate the weighted Jaccard of paths", "[similarity]") {
+    // 200 nodes of 1 to 50 bp; path a walks the first 150 and path b the last 150, the middle twice
+    graph_t graph;
+    std::vector<handle_t> handles;
+    for (uint64_t i = 0; i < 200; ++i) {
+        handles.push_back(graph.create_handle(std::string(1 + (i * 7) % 50, 'A')));
+    }
+    const path_handle_t a = graph.create_path_handle("a");
+    const path_handle_t b = graph.create_path_handle("b");
+    for (uint64_t i = 0; i < 150; ++i) {
+        graph.append_step(a, handles[i]);
+        graph.append_step(b, handles[50 + i]);
+    }
+    for (uint64_t i = 80; i < 120; ++i) {
+        graph.append_step(b, handles[i]);
+    }
+    std::vector<uint32_t> path_ids(3, 0);
+    path_ids[as_integer(a)] = as_integer(a);
+    path_ids[as_integer(b)] = as_integer(b);
+    const std::vector<bool> node_mask(graph.get_node_count(), true);
+
+    algorithms::path_intersection_matrix_t matrix(3, 2);
+    algorithms::collect_path_intersections(graph, node_mask, path_ids, matrix, false);
+    algorithms::path_sketches_t sketches(3, 2048);
+    algorithms::build_path_sketches(graph, node_mask, path_ids, sketches, 2, false);
+
+    const uint32_t ia = as_integer(a), ib = as_integer(b);
+    const uint64_t length_a = matrix.get(ia, ia), length_b = matrix.get(ib, ib);
+    const uint64_t intersection = matrix.get(ia, ib);
+    const double jaccard = (double)intersection / (double)(length_a + length_b - intersection);
+    REQUIRE(sketches.jaccard(ia, ia) == 1.0);
+    REQUIRE(std::abs(sketches.jaccard(ia, ib) - jaccard) < 0.05);
+    REQUIRE(sketches.jaccard(ia, ib) == sketches.jaccard(ib, ia));
+    const double estimated = sketches.intersection(ia, ib, length_a, length_b);
+    REQUIRE(std::abs(estimated - intersection) < 0.1 * intersection);
+}
+
+}
+}
@@ -0,0 +1,106 @@
+/**
+ * \file
+ * unittest/unchop.cpp: test cases for merging the simple components of a graph in bulk.
+ */
+
+#include "catch.hpp"
+
+#include "odgi.hpp"
+#include "algorithms/chop.hpp"
+#include "algorithms/unchop.hpp"
+#include "random_graph.hpp"
+
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+/// a random graph with inversions and paths walking both strands, chopped into many simple components
+static void build_chopped_graph(graph_t& graph) {
+    random_graph_params_t params;
+    params.seed = 5;
+    params.edge_count = 150;
+    params.self_edges = true;
+    build_random_graph(graph, params);
+    algorithms::chop(graph, 3, 2, false);
+}
+
+TEST_CASE("Unchopping in bulk merges simple components like concat_nodes", "[unchop]") {
+    // merge the components one at a time, and order the nodes by the mean rank of their parts
+    graph_t expected;
+    build_chopped_graph(expected);
+    ska::flat_hash_map<nid_t, uint64_t> node_rank;
+    uint64_t rank = 0;
+    expected.for_each_handle([&](const handle_t& h) {
+        node_rank[expected.get_id(h)] = rank++;
+    });
+    const auto components = algorithms::simple_components(expected, 2, true, 1);
+    ska::flat_hash_set<nid_t> to_merge;
+    for (auto& comp : components) {
+        for (auto& handle : comp) {
+            to_merge.insert(expected.get_id(handle));
+        }
+    }
+    std::vector<std::pair<double, handle_t>> ordered_handles;
+    expected.for_each_handle([&](const handle_t& handle) {
+        if (!to_merge.count(expected.get_id(handle))) {
+            ordered_handles.emplace_back(node_rank[expected.get_id(handle)], handle);
+        }
+    });
+    for (auto& comp : components) {
+        double rank_sum = 0;
+        for (auto& handle : comp) {
+            rank_sum += node_rank[expected.get_id(handle)];
+        }
+        ordered_handles.emplace_back(rank_sum / comp.size(), algorithms::concat_nodes(expected, comp));
+    }
+    std::sort(ordered_handles.begin(), ordered_handles.end());
+    std::vector<handle_t> order;
+    for (auto& h : ordered_handles) {
+        order.push_back(h.second);
+    }
+    expected.apply_ordering(order, true);
+
+    graph_t unchopped;
+    build_chopped_graph(unchopped);
+    const uint64_t chopped_node_count = unchopped.get_node_count();
+    REQUIRE(algorithms::unchop(unchopped, 4, false));
+
+    REQUIRE(components.size() > 10);
+    REQUIRE(unchopped.get_node_count() < chopped_node_count);
+    REQUIRE(unchopped.get_node_count() == expected.get_node_count());
+    REQUIRE(unchopped.get_edge_count() == expected.get_edge_count());
+    REQUIRE(describe(unchopped) == describe(expected));
+}
+
+TEST_CASE("Unchopping in bulk writes the same graph with any number of threads", "[unchop]") {
+    std::vector<std::string> serialized;
+    for (const uint64_t num_threads : {1, 4, 8}) {
+        // enough components sharing neighbours for every thread to get some
+        graph_t graph;
+        random_graph_params_t params;
+        params.seed = 19;
+        params.node_count = 4000;
+        params.edge_count = 6000;
+        params.path_count = 16;
+        params.steps_per_path = 400;
+        build_random_graph(graph, params);
+        algorithms::chop(graph, 3, 2, false);
+        REQUIRE(algorithms::unchop(graph, num_threads, false));
+        std::stringstream out;
+        graph.serialize(out);
+        serialized.push_back(out.str());
+    }
+    REQUIRE(serialized[0] == serialized[1]);
+    REQUIRE(serialized[0] == serialized[2]);
+}
+
+}
+}
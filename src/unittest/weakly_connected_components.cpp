@@ -0,0 +1,89 @@
+/**
+ * \file
+ * unittest/weakly_connected_components.cpp: test cases for the labelling of weakly connected components.
+ */
+
+#include "catch.hpp"
+
+#include "odgi.hpp"
+#include "algorithms/weakly_connected_components.hpp"
+
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace odgi {
+namespace unittest {
+
+using namespace std;
+using namespace handlegraph;
+
+TEST_CASE("Weakly connected components are labelled in parallel", "[weakly_connected_components]") {
+    // 200 chains of 50 nodes, with gaps in the IDs, joined at random into fewer components, in
+    // both orientations
+    graph_t graph;
+    std::mt19937_64 rng(3);
+    std::vector<handle_t> handles;
+    for (nid_t id = 1; handles.size() < 10000; id += 1 + (rng() % 5 == 0)) {
+        handles.push_back(graph.create_handle("ACGT", id));
+        if (handles.size() % 50 != 1) {
+            graph.create_edge(handles[handles.size() - 2], handles.back());
+        }
+    }
+    std::vector<std::pair<uint64_t, uint64_t>> joins;
+    for (uint64_t i = 0; i < 120; ++i) {
+        joins.emplace_back(rng() % handles.size(), rng() % handles.size());
+        const handle_t b = handles[joins.back().second];
+        graph.create_edge(handles[joins.back().first], i % 2 ? graph.flip(b) : b);
+    }
+
+    // a plain union of the chains joined by the random edges
+    std::vector<uint64_t> chain_parent(handles.size() / 50);
+    for (uint64_t c = 0; c < chain_parent.size(); ++c) {
+        chain_parent[c] = c;
+    }
+    std::function<uint64_t(uint64_t)> find = [&](uint64_t c) {
+        return chain_parent[c] == c ? c : find(chain_parent[c]);
+    };
+    for (auto& join : joins) {
+        const uint64_t a = find(join.first / 50);
+        const uint64_t b = find(join.second / 50);
+        chain_parent[std::max(a, b)] = std::min(a, b);
+    }
+
+    const algorithms::weak_components_t serial = algorithms::weakly_connected_component_labels(&graph, 1);
+    const algorithms::weak_components_t parallel = algorithms::weakly_connected_component_labels(&graph, 4);
+
+    SECTION("nodes share a component exactly when they are connected") {
+        for (uint64_t i = 0; i < handles.size(); i += 7) {
+            for (uint64_t j = 0; j < handles.size(); j += 131) {
+                const bool connected = find(i / 50) == find(j / 50);
+                REQUIRE((parallel.component_of(graph.get_id(handles[i]))
+                         == parallel.component_of(graph.get_id(handles[j]))) == connected);
+            }
+        }
+    }
+
+    SECTION("the labels do not depend on the number of threads") {
+        REQUIRE(serial.component == parallel.component);
+        REQUIRE(serial.offsets == parallel.offsets);
+        REQUIRE(serial.node_ids == parallel.node_ids);
+        REQUIRE(parallel.node_ids.size() == handles.size());
+    }
+
+    SECTION("the set adapter keeps the order and the contents of the components") {
+        const auto sets = algorithms::weakly_connected_components(&graph, 4);
+        REQUIRE(sets.size() == parallel.size());
+        REQUIRE(parallel.component_of(graph.get_id(handles[0])) == 0);
+        for (uint64_t c = 0; c < sets.size(); ++c) {
+            REQUIRE(sets[c].size() == parallel.size(c));
+            for (uint64_t j = parallel.offsets[c]; j < parallel.offsets[c + 1]; ++j) {
+                REQUIRE(sets[c].count(parallel.node_ids[j]));
+                REQUIRE(parallel.component_of(parallel.node_ids[j]) == c);
+            }
+        }
+    }
+}
+
+}
+}
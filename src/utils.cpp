@@ -1,6 +1,7 @@
 #include <string>
 #include <algorithm>
 #include "utils.hpp"
+#include <omp.h>
 
 namespace utils {
     bool is_number(const std::string &s) {
@@ -105,6 +106,32 @@ namespace utils {
 		return 0;
     }
 
+	const handlegraph::PathHandleGraph& handle_read_only_input(const std::string infile, const std::string subcommmand_name,
+															   const bool progress, const uint64_t num_threads, const bool freeze,
+															   odgi::graph_t &graph, odgi::flat_graph_t &flat_graph) {
+		if (infile == "-") {
+			graph.deserialize(std::cin);
+		} else if (std::filesystem::exists(infile) && odgi::flat_graph_t::is_flat_graph(infile)) {
+			if (progress) {
+				std::cerr << "[odgi::" << subcommmand_name << "] memory-mapping flat graph \"" << infile << "\"" << std::endl;
+			}
+			flat_graph.load(infile);
+			return flat_graph;
+		} else {
+			handle_gfa_odgi_input(infile, subcommmand_name, progress, num_threads, graph);
+		}
+		if (freeze) {
+			if (progress) {
+				std::cerr << "[odgi::" << subcommmand_name << "] freezing the graph into a compact read-only layout" << std::endl;
+			}
+			omp_set_num_threads((int) num_threads);
+			flat_graph.from_graph(graph);
+			graph.clear();
+			return flat_graph;
+		}
+		return graph;
+	}
+
 	uint64_t modulo(const uint64_t n, const uint64_t d) {
 		return (n & (d - 1));
 	}
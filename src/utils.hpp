@@ -1,5 +1,6 @@
 #include "odgi.hpp"
 #include "gfa_to_handle.hpp"
+#include "flat_graph.hpp"
 
 #include <filesystem>
 
@@ -16,6 +17,12 @@ namespace utils {
 	bool ends_with(const std::string &fullString, const std::string &ending);
 	int handle_gfa_odgi_input(const std::string infile, const std::string subcommmand_name, const bool progress,
 							  const uint64_t num_threads, odgi::graph_t &graph);
+	/// load a graph for a read-only subcommand: files in the flat layout are memory-mapped into flat_graph,
+	/// anything else ("-" for stdin) is loaded into graph; with freeze set, a loaded graph is then converted
+	/// into flat_graph and released; returns the graph to query
+	const handlegraph::PathHandleGraph& handle_read_only_input(const std::string infile, const std::string subcommmand_name,
+															   const bool progress, const uint64_t num_threads, const bool freeze,
+															   odgi::graph_t &graph, odgi::flat_graph_t &flat_graph);
 	/// this function will return n % d
 	/// it is assumed that d is one of 1, 2, 4, 8, 16, 32, ....
 	uint64_t modulo(const uint64_t n, const uint64_t d);